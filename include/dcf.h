@@ -26,6 +26,10 @@
 #include "systemclock.h"
 #include "settings.h"
 
+// Edge timing error of the demodulated DCF77 second marks after the
+// configured offset is applied; handed to the clock discipline.
+#define DCF_EDGE_ERROR_US 10000
+
 class DCF
 {
 public:
@@ -0,0 +1,97 @@
+/*
+ *  dcf_decoder.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <time.h>
+
+// Soft-decision DCF77 decoder.
+//
+// Instead of classifying each pulse against fixed length windows and dropping
+// the minute on the first miss, every second gets a signed likelihood for
+// "1" derived from the carrier-reduction time integrated over the first
+// DCF_PULSE_WINDOW_US of the second, so split or stretched pulses still
+// count and unreadable ones become erasures. Second marks are tracked on a
+// one-second grid that tolerates missing pulses; the minute marker phase is
+// voted over all gaps seen. At each minute mark, candidate times decoded from
+// the last DCF_VOTE_MINUTES frames are correlated against all of them (shifted
+// by the minutes in between), and a candidate is accepted only if every time
+// and parity bit is supported on balance. Frames are aligned retroactively,
+// so a receiver switched on before second 17 syncs at the first marker.
+//
+// Pure logic without ESP-IDF dependencies so it can be replayed on the host.
+#define DCF_VOTE_MINUTES 4
+#define DCF_RING_SECONDS (60 * (DCF_VOTE_MINUTES + 1))
+#define DCF_SLOT_TOLERANCE_US 60000
+#define DCF_PULSE_WINDOW_US 300000
+// Longest gap between accepted second marks before the grid is rebuilt.
+#define DCF_MAX_GAP_SECONDS 30
+// Off-grid marks this long after the last accepted one move the grid.
+#define DCF_REANCHOR_US 2500000
+// Net agreement every time/parity bit needs; a clean pulse scores 100.
+#define DCF_MIN_BIT_SUPPORT 50
+
+typedef struct
+{
+    time_t epoch;    // UTC time at the minute mark
+    int64_t mark_us; // edge timestamp of the minute mark, caller's time base
+    bool cest;       // transmitted time zone was CEST
+} dcf_time_t;
+
+class DcfDecoder
+{
+private:
+    int8_t _llr[DCF_RING_SECONDS] = {};
+    uint8_t _markerVotes[60] = {};
+
+    bool _anchored = false;
+    uint32_t _second = 0;     // slot number of the last accepted second mark
+    uint32_t _anchorSlot = 0; // slots before this carry no information
+    int64_t _lastMark_us = 0;
+
+    // Pulse integration for the open slot.
+    bool _slotOpen = false;
+    int64_t _slotStart_us = 0;
+    int64_t _lowTime_us = 0;
+    int _level = 1;
+    int64_t _levelSince_us = 0;
+
+    bool _synced = false;
+    time_t _lastEpoch = 0;
+    uint32_t _lastSyncSlot = 0;
+
+    void anchor(int64_t t_us);
+    void integrateLow(int64_t until_us);
+    void finishSlot();
+    void openSlot(uint32_t slot, int64_t t_us);
+    int minutePhase();
+    bool evaluate(uint32_t slot0, int64_t mark_us, dcf_time_t *out);
+
+public:
+    void reset();
+    // Feed one edge of the demodulated signal. `state` is the pin level after
+    // the edge: 0 starts a carrier reduction (second mark), 1 ends it.
+    // Returns true with `out` filled when a minute mark was decoded.
+    bool edge(int64_t t_us, int state, dcf_time_t *out);
+};
@@ -0,0 +1,82 @@
+/*
+ *  duty_cycle.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "hmframe.h"
+
+// Transmit airtime over the sliding hour against the 1 % duty cycle the
+// 868 MHz SRD band allows (36 s per hour). The hour is a ring of BUCKETS
+// buckets with a running total, so add() and the queries are O(1)
+// amortised: advancing clears at most the buckets that elapsed.
+//
+// Two thresholds, in percent of the budget, raise the level; add() reports
+// the level it has just entered so the caller can notify once per
+// crossing. The level only falls back once usage is REARM_MARGIN points
+// below a threshold, so usage hovering around it does not repeat the
+// warning. A threshold of 0 is off. Not thread-safe.
+class DutyCycleBudget {
+public:
+    static constexpr uint32_t WINDOW_S = 3600;
+    static constexpr uint32_t BUCKET_S = 10;
+    static constexpr uint32_t BUCKETS = WINDOW_S / BUCKET_S;
+    static constexpr uint32_t BUDGET_US = WINDOW_S * 10000;   // 1 % of the window
+    static constexpr uint32_t REARM_MARGIN = 10;
+    // Shortest payload that can carry a radio telegram; shorter frames to
+    // the module are configuration commands.
+    static constexpr uint16_t MIN_TELEGRAM_BYTES = 9;
+
+    enum Level : uint8_t {
+        LEVEL_OK,
+        LEVEL_WARN,
+        LEVEL_ALARM,
+    };
+
+    void configure(uint8_t warn_percent, uint8_t alarm_percent);
+
+    // Returns the level entered by this frame, LEVEL_OK if it did not rise.
+    Level add(uint32_t now_s, uint32_t airtime_us);
+    uint32_t usedUs(uint32_t now_s);
+    // Share of the budget used, in percent; above 100 once exhausted.
+    uint32_t usedPercent(uint32_t now_s);
+    Level level() const { return _level; }
+    uint8_t warnPercent() const { return _warn; }
+    uint8_t alarmPercent() const { return _alarm; }
+
+    // A frame to the module that the module will put on air.
+    static bool isTransmission(const HMFrame &frame);
+
+private:
+    void advance(uint32_t now_s);
+    Level levelFor(uint32_t percent) const;
+
+    uint32_t _buckets[BUCKETS] = {};
+    uint32_t _total_us = 0;
+    uint32_t _tag = 0;   // now_s / BUCKET_S + 1 of the newest bucket, 0 before the first
+    uint8_t _warn = 50;
+    uint8_t _alarm = 80;
+    Level _level = LEVEL_OK;
+};
@@ -50,6 +50,7 @@ typedef enum : uint8_t {
     EVENT_CCU_CONNECTED      = 11,
     EVENT_CCU_DISCONNECTED   = 12,
     EVENT_LOW_HEAP           = 13,
+    EVENT_DUTY_CYCLE         = 14,
     EVENT_TEST               = 254, // emitted by the diagnostic endpoint
 } Event;
 
@@ -84,6 +85,11 @@ bool events_is_running(void);
 // than 128 bytes (longer values are truncated).
 void events_emit(Event event, const char *detail);
 
+// Close the webhook/Telegram connections the worker keeps alive between
+// deliveries. Call while holding g_net_fetch_mutex, before any TLS work of
+// your own; the worker only touches those connections under the gate.
+void events_close_idle_connections(void);
+
 // Emit a test notification on every enabled channel. Used by the
 // /api/monitoring/test?target=notify endpoint.
 void events_emit_test(void);
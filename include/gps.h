@@ -29,6 +29,26 @@
 #include "settings.h"
 #include "linereader.h"
 
+// NMEA sentences trail the second they describe by a receiver-specific,
+// jittery delay; this is the error bound handed to the clock discipline.
+#define GPS_NMEA_ERROR_US 50000
+
+// Pulse-per-second support. A receiver PPS output wired to GPS_PPS_PIN is
+// picked up automatically once GPS_PPS_LOCK_PULSES consecutive rising edges
+// have arrived one second (+/- GPS_PPS_TOLERANCE_US) apart. The next valid RMC, ZDA
+// or GGA sentence with a whole-second time then labels that edge, and the
+// clock is set from the edge timestamp instead of the sentence arrival.
+#define GPS_PPS_LOCK_PULSES 3
+#define GPS_PPS_TOLERANCE_US 1000
+#define GPS_PPS_ERROR_US 100
+// Sentences arriving later than this after the edge belong to no edge.
+#define GPS_PPS_MAX_SENTENCE_DELAY_US 900000
+
+#define GPS_SYNC_INTERVAL_US (300LL * 1000 * 1000)
+#define GPS_PPS_SYNC_INTERVAL_US (64LL * 1000 * 1000)
+// Larger offsets are stepped, smaller ones slewed once the clock was set.
+#define GPS_STEP_THRESHOLD_US 128000
+
 class GPS
 {
 private:
@@ -37,7 +57,18 @@ private:
     TaskHandle_t _tHandle = NULL;
     QueueHandle_t _uart_queue = NULL;
     LineReader *_lineReader;
-    uint64_t _nextSync = 0;
+    int64_t _nextSync = 0;
+    bool _synced = false;
+    bool _ppsSynced = false;
+
+    // Written by the PPS ISR, guarded by _ppsMux.
+    portMUX_TYPE _ppsMux = portMUX_INITIALIZER_UNLOCKED;
+    int64_t _ppsEdge_us = 0;
+    uint8_t _ppsPulses = 0;
+    bool _ppsIsr = false;
+
+    bool ppsEdge(int64_t now_us, int64_t *edge_us);
+    void syncClock(struct timeval *tv, uint32_t error_us);
 
 public:
     GPS(Settings *settings, SystemClock *clk);
@@ -49,5 +80,6 @@ public:
     void stop(void);
 
     void _gpsSerialQueueHandler();
+    void _ppsInterrupt();
     void _handleLine(unsigned char *buffer, uint16_t len);
 };
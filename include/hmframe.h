@@ -30,6 +30,13 @@ class HMFrame
 public:
     static bool TryParse(unsigned char *buffer, uint16_t len, HMFrame *frame);
     static uint16_t crc(unsigned char *buffer, uint16_t len);
+    // Undo the 0xfc escaping of a frame as the module sends it. Returns the
+    // decoded length, 0 if it does not fit into cap.
+    static uint16_t unescape(const unsigned char *buffer, uint16_t len, unsigned char *out, uint16_t cap);
+    // unescape() into scratch, then TryParse(); frame->data points into
+    // scratch. For the traffic and duty-cycle analytics on relayed frames.
+    static bool TryDecode(const unsigned char *buffer, uint16_t len, unsigned char *scratch,
+                          uint16_t cap, HMFrame *frame);
 
     HMFrame();
     uint8_t counter;
@@ -0,0 +1,90 @@
+/*
+ *  json_writer.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Streaming JSON writer into a caller-provided buffer: no heap, no tree.
+// Values are appended in order; commas, quoting and escaping are handled
+// here. Once the buffer is full every further call is ignored and ok()
+// turns false, so a caller checks once at the end instead of after every
+// field.
+//
+//   char buf[256];
+//   JsonWriter json(buf, sizeof(buf));
+//   json.beginObject();
+//   json.string("ip", "192.168.1.10");
+//   json.number("uptime", "3600");
+//   json.endObject();
+//   if (json.ok()) publish(buf, json.length());
+class JsonWriter {
+public:
+    static constexpr int MAX_DEPTH = 8;
+
+    JsonWriter(char *buffer, size_t capacity);
+
+    // key is only used inside an object; pass nullptr at the top level and
+    // inside arrays.
+    void beginObject(const char *key = nullptr);
+    void endObject();
+    void beginArray(const char *key = nullptr);
+    void endArray();
+
+    void string(const char *key, const char *value);
+    void string(const char *key, const char *value, size_t len);
+    // value must already be a valid JSON number, e.g. from snprintf("%.1f").
+    void number(const char *key, const char *value);
+    void number(const char *key, uint64_t value);
+    void number(const char *key, int64_t value);
+    void boolean(const char *key, bool value);
+    void null(const char *key);
+    // A complete JSON value rendered elsewhere, inserted verbatim.
+    void raw(const char *key, const char *json, size_t len);
+
+    // True once the document is complete: everything fit, and every object
+    // and array was closed, in order.
+    bool ok() const { return !_full && !_misused && _depth == 0; }
+    // Bytes written; the buffer is always NUL-terminated behind them.
+    size_t length() const { return _len; }
+    const char *c_str() const { return _buf; }
+
+private:
+    void put(const char *text, size_t len);
+    void escaped(const char *text, size_t len);
+    void member(const char *key);
+    void open(const char *key, char bracket);
+    void close(char bracket);
+
+    char *_buf;
+    size_t _cap;
+    size_t _len = 0;
+    int _depth = 0;
+    // Per nesting level: a value has been written (needs a comma) / the
+    // level is an array.
+    uint8_t _has_value = 0;
+    uint8_t _is_array = 0;
+    bool _full = false;
+    bool _misused = false;
+};
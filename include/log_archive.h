@@ -0,0 +1,125 @@
+/*
+ *  log_archive.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Compressed history behind the LogManager ring.
+//
+// Entries that were drained from the live ring are collected in a staging
+// segment. A full segment is compressed with a small LZ77 coder (LZ4-style
+// sequences, 16-bit offsets) whose window is primed with a fixed dictionary
+// of common ESP-IDF log fragments, so even the first line of a segment finds
+// matches. Compressed segments are kept in a byte pool as a FIFO; the oldest
+// ones are evicted when a new segment does not fit.
+//
+// Segments hold whole entries at their original stream offsets, so reading
+// the archive yields exactly the bytes the ring held. A gap (the ring
+// overwrote entries before they were drained) simply starts a new segment.
+//
+// Nothing here is thread-safe; LogManager serialises every call with its
+// mutex. No allocation after attach().
+class LogArchive {
+public:
+    // Uncompressed bytes per segment.
+    static constexpr size_t SEGMENT_SIZE = 1024;
+    static constexpr size_t MAX_SEGMENTS = 64;
+
+    // Bytes of storage attach() needs for a pool of pool_size bytes. The
+    // remainder holds the staging window, the decode cache and the match
+    // finder's hash table.
+    static size_t storageSize(size_t pool_size);
+
+    void attach(uint8_t *storage, size_t pool_size);
+    // Forget everything and return the storage.
+    uint8_t *detach();
+    bool active() const { return _pool != nullptr; }
+
+    // Forget the contents; the next entry may start anywhere.
+    void reset();
+
+    // Append one whole entry that starts at stream offset position. A
+    // position other than end() seals the staging segment and starts a new
+    // one there.
+    void append(uint64_t position, const uint8_t *entry, size_t len);
+
+    // Oldest stream offset still held (== end() if empty) and the offset
+    // just past the newest staged entry.
+    uint64_t oldest() const;
+    uint64_t end() const;
+
+    // Copy up to max bytes starting at *offset. *offset is clamped to
+    // oldest() and to the start of the next held range if it falls in a
+    // gap, and advanced past the returned bytes. Never crosses a segment
+    // boundary, so every call returns whole-entry aligned runs.
+    size_t read(uint64_t *offset, uint8_t *dst, size_t max);
+
+    // Uncompressed and compressed bytes currently held in sealed segments.
+    size_t rawBytes() const { return _raw_bytes; }
+    size_t compressedBytes() const { return _compressed_bytes; }
+    size_t poolSize() const { return _pool_size; }
+
+    // The segment coder, exposed for the host benchmark. compress() needs
+    // compressBound(len) bytes of output; decompress() returns 0 on corrupt
+    // input or if the result would exceed cap.
+    static size_t compressBound(size_t len);
+    size_t compress(const uint8_t *src, size_t len, uint8_t *out);
+    size_t decompress(const uint8_t *src, size_t len, uint8_t *out, size_t cap);
+
+private:
+    struct Segment {
+        uint64_t start;
+        uint32_t pool_offset;
+        uint16_t raw_len;
+        uint16_t compressed_len;
+    };
+
+    void seal();
+    bool reservePool(size_t len, uint32_t *offset);
+    void dropOldest();
+    const Segment &segmentAt(size_t index) const;
+
+    uint8_t *_storage = nullptr;
+    uint8_t *_pool = nullptr;
+    size_t _pool_size = 0;
+    // Dictionary followed by the staging segment, so matches reach back
+    // into the dictionary without a second code path.
+    uint8_t *_window = nullptr;
+    // Dictionary followed by the most recently decoded segment.
+    uint8_t *_cache = nullptr;
+    uint16_t *_hash = nullptr;
+
+    Segment _segments[MAX_SEGMENTS] = {};
+    size_t _first = 0;
+    size_t _count = 0;
+    size_t _raw_bytes = 0;
+    size_t _compressed_bytes = 0;
+
+    uint64_t _staging_start = 0;
+    size_t _staging_len = 0;
+    // Stream offset of the segment held in _cache, UINT64_MAX if none.
+    uint64_t _cached_start = UINT64_MAX;
+    size_t _cached_len = 0;
+};
@@ -0,0 +1,114 @@
+/*
+ *  log_entry.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdarg.h>
+
+// Framed log entries as stored in the LogManager ring and handed to
+// subscribers.
+//
+// A deferred entry records the format-string pointer, a timestamp and the raw
+// argument words instead of the formatted text. vsnprintf() then runs only
+// when a consumer renders the entry, on the consumer's task. This works
+// because ESP_LOG format strings (and the TAG strings passed for %s) are
+// literals in flash that stay mapped for the whole boot; the capture path
+// decides that with a caller-supplied predicate. Any other %s argument is
+// copied inline. Lines that cannot be deferred exactly (format in RAM, %n,
+// long double, arguments too large) are stored as formatted text instead.
+//
+// Layout, little-endian:
+//   [0]    LOG_ENTRY_MAGIC
+//   [1]    kind (LOG_ENTRY_TEXT / LOG_ENTRY_DEFERRED)
+//   [2..3] total entry length including this header
+//   [4]    check byte, ~(magic ^ kind ^ len_lo ^ len_hi)
+//   [5..8] timestamp, milliseconds since boot
+//   text:     the formatted line
+//   deferred: format pointer, then per conversion the star width/precision
+//             as int, then the value in its native size. %s stores a one
+//             byte tag followed by a pointer (flash) or a NUL-terminated copy.
+// The magic and check byte let a reader that lands mid-entry after a ring
+// overwrite find the next entry boundary again.
+#define LOG_ENTRY_MAGIC 0x1E
+#define LOG_ENTRY_HEADER_SIZE 9
+// Largest entry the capture path produces. A text entry carries at most
+// LOG_ENTRY_MAX - LOG_ENTRY_HEADER_SIZE bytes of the line, as before.
+#define LOG_ENTRY_MAX 256
+// Rendered lines are capped here; a cut line keeps its trailing newline.
+#define LOG_LINE_MAX 384
+
+enum log_entry_kind_t : uint8_t {
+    LOG_ENTRY_TEXT = 0,
+    LOG_ENTRY_DEFERRED = 1,
+};
+
+// True if the pointer refers to memory that stays valid and unchanged for
+// the rest of the boot (on the ESP32: the flash-mapped DROM segment).
+typedef bool (*log_entry_static_fn)(const void *ptr);
+
+// Predicate applied to every format and string pointer read back out of a
+// deferred entry, normally the one the capture path encodes with. An entry
+// with a pointer that fails it reads as corrupt: it renders to nothing and
+// has no level or tag. Until this is set, every deferred entry does.
+void log_entry_set_static_fn(log_entry_static_fn is_static);
+
+// Encode fmt/args as a deferred entry. Returns the entry length, or 0 if the
+// line cannot be deferred exactly; args is consumed either way.
+size_t log_entry_encode_deferred(uint8_t *out, size_t cap, uint32_t timestamp_ms,
+                                 const char *fmt, va_list args,
+                                 log_entry_static_fn is_static);
+
+// Wrap already formatted text. text may point at out + LOG_ENTRY_HEADER_SIZE
+// so callers can format straight into the entry. Text beyond cap is cut.
+size_t log_entry_encode_text(uint8_t *out, size_t cap, uint32_t timestamp_ms,
+                             const char *text, size_t len);
+
+// Validate the header at p. Returns the declared entry length (which may be
+// larger than avail), or 0 if p does not start a plausible entry. At least
+// LOG_ENTRY_HEADER_SIZE bytes are needed to decide.
+size_t log_entry_length(const uint8_t *p, size_t avail);
+
+uint32_t log_entry_timestamp(const uint8_t *entry);
+
+// First character of the rendered line, without rendering it (0 if unknown).
+char log_entry_first_char(const uint8_t *entry, size_t len);
+
+// ESP_LOGx level letter (E/W/I/D/V) of the line, behind the colour escape
+// CONFIG_LOG_COLORS puts in front of it; 0 for anything else.
+char log_entry_level(const uint8_t *entry, size_t len);
+
+// Tag of an ESP_LOGx line ("L (time) TAG: ...") into out, NUL-terminated and
+// cut to cap - 1 characters; returns its length, 0 if the line has no tag.
+// Deferred entries are not rendered for this.
+size_t log_entry_tag(const uint8_t *entry, size_t len, char *out, size_t cap);
+
+// Render one entry as text into out (NUL-terminated). Returns the number of
+// characters written, at most min(cap, LOG_LINE_MAX) - 1.
+size_t log_entry_render(const uint8_t *entry, size_t len, char *out, size_t cap);
+
+// Only the message of an ESP_LOGx line: what follows "TAG: ", without the
+// colour reset and the newline. Deferred entries render just that part of
+// the format. Other lines are rendered whole, without the newline.
+size_t log_entry_message(const uint8_t *entry, size_t len, char *out, size_t cap);
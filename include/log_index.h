@@ -0,0 +1,102 @@
+/*
+ *  log_index.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Side index over the LogManager entry stream, for filtered log queries.
+//
+// write() records every captured line here: where it ends in the stream, its
+// length, its level and a hash of its tag. A query walks the index instead of
+// the entries and reads back only the lines that can match, straight from
+// their offsets, so "errors only" no longer means decompressing and
+// rendering the whole history.
+//
+// The index is a hint. A slot is two 32-bit words, published seqlock-style
+// (end cleared, metadata, end stored last); a reader that sees the end word
+// change skips the slot. Candidates are checked against the entry itself
+// before they are returned, so a torn or lapped slot can only ever hide a
+// line, and coveredFrom() notices that: the query then scans instead.
+//
+// record() and clear() may run concurrently with everything; the readers
+// need no lock against record() but are serialised by LogManager.
+class LogIndex {
+public:
+    // 2 KiB: the live ring several times over plus the newest part of the
+    // compressed history. Older lines are found by scanning.
+    static constexpr size_t SLOTS = 256;
+    static constexpr unsigned TAG_BITS = 20;
+    // find() wildcard for the tag.
+    static constexpr uint32_t ANY_TAG = UINT32_MAX;
+
+    struct Hit {
+        uint64_t start;
+        uint16_t len;
+    };
+
+    // Any task, lock-free. end is the stream offset just past the entry,
+    // rank its log_level_rank().
+    void record(uint64_t end, size_t len, uint8_t rank, uint32_t tag_hash);
+    void clear();
+
+    // Lowest offset, not below from, from which every entry that ends at or
+    // before end is in the index; end itself if the index cannot vouch for
+    // the whole range.
+    uint64_t coveredFrom(uint64_t from, uint64_t end) const;
+
+    // Up to max entries in [from, end) of rank 1..max_rank (0: any level,
+    // unlevelled lines included) whose tag hash matches, lowest offset first.
+    size_t find(uint64_t from, uint64_t end, uint8_t max_rank, uint32_t tag_hash,
+                Hit *out, size_t max) const;
+
+private:
+    struct Slot {
+        std::atomic<uint32_t> end{0};
+        std::atomic<uint32_t> meta{0};
+    };
+    struct Record {
+        uint64_t start;
+        uint64_t end;
+        uint32_t meta;
+    };
+
+    bool load(size_t slot, uint64_t end, Record *record) const;
+
+    Slot _slots[SLOTS];
+    std::atomic<uint32_t> _next{0};
+};
+
+// Tags are compared and hashed up to this many characters, terminator
+// included.
+static constexpr size_t LOG_INDEX_TAG_MAX = 32;
+
+// Severity order for filtering, most severe first: E=1, W=2, I=3, D=4, V=5;
+// 0 for anything that is not an ESP_LOGx level letter.
+uint8_t log_level_rank(char level);
+
+// FNV-1a over the tag text.
+uint32_t log_tag_hash(const char *tag, size_t len);
@@ -0,0 +1,58 @@
+/*
+ *  log_journal.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#ifndef LOG_JOURNAL_H
+#define LOG_JOURNAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "esp_err.h"
+
+// Persistent log journal: captured log lines written to flash so the history
+// before a reboot survives it. The files live beside the standalone WebUI in
+// the WWW partition (there is no flash left for a partition of their own),
+// so the journal is kept only while that partition is mounted, and a WebUI
+// image update erases it.
+//
+// A low-priority writer collects rendered lines from the LogManager and
+// writes them as one append per 4 KiB batch, or once the oldest pending line
+// is 30 s old. Flash writes are held to a byte budget per hour; while it
+// runs low only warnings and errors are journalled, and a batch that does
+// not fit it is dropped and marked in the journal. Each boot starts with a
+// marker line carrying the reset reason.
+
+// Start the writer task. Safe to call once; the journal records while the
+// system log is enabled.
+esp_err_t log_journal_start(void);
+
+// Write pending lines now, e.g. right before a planned restart. Bounded by
+// the write budget like any batch.
+void log_journal_flush(void);
+
+// Copy journal text from *position (clamped to the oldest byte held) and
+// advance it; *end receives the journal end. Returns 0 at the end or while
+// the journal is unavailable.
+size_t log_journal_read(uint64_t *position, char *dst, size_t max, uint64_t *end);
+
+#endif // LOG_JOURNAL_H
@@ -0,0 +1,98 @@
+/*
+ *  log_journal_store.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Files behind the persistent log journal (see log_journal.h), plain stdio so
+// the host tests run it against a temporary directory.
+//
+// The journal is two files, the current one and the one before it. A batch
+// that does not fit the current file any more retires it: the previous file
+// is deleted and the current one renamed in its place, so the journal never
+// holds more than two files and never rewrites a byte. Every file starts
+// with a small header carrying the journal position of its first byte;
+// positions therefore stay valid across rotations and reboots, and a reader
+// resumes with the position it was last given, like the in-memory log.
+//
+// Nothing is cached between calls: the files may disappear underneath (the
+// WWW partition they live in is erased by an image update) and the next
+// call simply starts a new journal.
+class LogJournalStore {
+public:
+    static constexpr size_t HEADER_SIZE = 16;
+    static constexpr size_t PATH_MAX_LEN = 48;
+
+    // Journal in directory dir, each file holding at most file_max bytes.
+    void configure(const char *dir, size_t file_max);
+
+    // Append a batch as one write, rotating first if it would overflow the
+    // current file. Bytes beyond one file's capacity are cut.
+    bool append(const char *data, size_t len);
+
+    // Copy up to max bytes starting at *position. *position is clamped to
+    // the oldest byte held and advanced past the returned bytes. Never
+    // crosses a file boundary; 0 at the end.
+    size_t read(uint64_t *position, char *dst, size_t max);
+
+    uint64_t oldest();
+    uint64_t end();
+    // Journal bytes held, headers excluded.
+    size_t size();
+
+private:
+    struct FileInfo {
+        bool present;
+        uint64_t base;
+        size_t data;
+    };
+
+    bool inspect(const char *path, FileInfo *info);
+    bool create(const char *path, uint64_t base);
+    void files(FileInfo *previous, FileInfo *current);
+
+    char _current[PATH_MAX_LEN] = {};
+    char _previous[PATH_MAX_LEN] = {};
+    size_t _file_max = 0;
+};
+
+// Byte budget for flash writes: a token bucket that refills at
+// bytes_per_hour up to burst. Callers on one task only.
+class LogWriteBudget {
+public:
+    void configure(uint32_t bytes_per_hour, uint32_t burst, int64_t now_us);
+    // Take len bytes if the bucket holds them.
+    bool take(size_t len, int64_t now_us);
+    uint32_t available(int64_t now_us);
+
+private:
+    void refill(int64_t now_us);
+
+    uint32_t _rate = 0;
+    uint32_t _burst = 0;
+    uint32_t _tokens = 0;
+    int64_t _last_us = 0;
+};
@@ -0,0 +1,99 @@
+/*
+ *  log_limiter.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Per-tag token bucket in front of the log capture path.
+//
+// Each tag gets a bucket of `burst` lines refilled at `rate` lines per
+// second, kept as a single theoretical-arrival time (GCRA) that admit()
+// advances with one compare-exchange. A line over its budget is dropped
+// before anything is formatted and counted; the caller periodically asks
+// for "N lines suppressed" summaries instead.
+//
+// Tags are keyed by pointer, which is what ESP_LOGx passes (one TAG literal
+// per module). The table is fixed; tags seen after it filled up share one
+// overflow bucket. Everything is lock-free and allocation-free, so admit()
+// may run on any task that logs.
+//
+// Times are 32-bit microsecond values (esp_timer_get_time() truncated) and
+// only ever compared as wrapping differences. A bucket idle for longer than
+// half the wrap period is recognised as stale and starts full.
+class LogLimiter {
+public:
+    static constexpr size_t TAG_SLOTS = 32;
+    static constexpr uint16_t MAX_RATE = 1000;
+    static constexpr uint16_t MAX_BURST = 1000;
+    static constexpr uint32_t SUMMARY_INTERVAL_US = 5 * 1000 * 1000;
+    // How far a caller's clock reading may lag behind another task's.
+    static constexpr uint32_t REORDER_SLACK_US = 1000 * 1000;
+
+    // lines_per_second 0 disables limiting; burst is clamped to
+    // [1, MAX_BURST]. Buckets are refilled as of now_us, counters are kept.
+    void configure(uint16_t lines_per_second, uint16_t burst, uint32_t now_us);
+    bool enabled() const { return _interval_us.load(std::memory_order_relaxed) != 0; }
+    uint16_t rate() const { return _rate.load(std::memory_order_relaxed); }
+    uint16_t burst() const { return _burst.load(std::memory_order_relaxed); }
+
+    // True if a line with this tag may be logged now.
+    bool admit(const char *tag, uint32_t now_us);
+
+    // True at most once per SUMMARY_INTERVAL_US, and only while lines were
+    // suppressed since the last summary. The caller then walks
+    // takeSummary() until it returns false.
+    bool summaryDue(uint32_t now_us);
+    // Next tag with lines suppressed since its last summary; *cursor starts
+    // at 0. The pending count is handed over and reset. tag is nullptr for
+    // the overflow bucket.
+    bool takeSummary(size_t *cursor, const char **tag, uint32_t *count);
+
+    // Lifetime suppressed lines per slot, for metrics. index runs from 0 to
+    // TAG_SLOTS inclusive; the last one is the overflow bucket (tag nullptr).
+    // Returns false for a slot no tag has claimed yet.
+    bool slotTotal(size_t index, const char **tag, uint32_t *suppressed) const;
+    uint32_t suppressedTotal() const { return _suppressed_total.load(std::memory_order_relaxed); }
+
+private:
+    struct Bucket {
+        std::atomic<const char *> tag{nullptr};
+        std::atomic<uint32_t> tat{0};
+        std::atomic<uint32_t> pending{0};
+        std::atomic<uint32_t> total{0};
+    };
+
+    Bucket &bucketFor(const char *tag, uint32_t now_us);
+
+    Bucket _buckets[TAG_SLOTS];
+    Bucket _overflow;
+    std::atomic<uint32_t> _interval_us{0};
+    std::atomic<uint32_t> _tolerance_us{0};
+    std::atomic<uint16_t> _rate{0};
+    std::atomic<uint16_t> _burst{0};
+    std::atomic<uint32_t> _suppressed_total{0};
+    std::atomic<bool> _summary_pending{false};
+    std::atomic<uint32_t> _last_summary_us{0};
+};
@@ -19,46 +19,85 @@
 #include <atomic>
 #include <freertos/FreeRTOS.h>
 #include <freertos/semphr.h>
-
-typedef void (*log_line_subscriber_t)(const char *line, size_t len, uint64_t end_offset);
+#include <freertos/task.h>
+#include "log_entry.h"
+#include "log_archive.h"
+#include "log_index.h"
+#include "log_limiter.h"
+#include "log_ring.h"
+
+// Subscribers receive one framed entry (see log_entry.h), not text: lines are
+// captured with deferred formatting. Copy the entry and call
+// log_entry_render() on the consumer's own task.
+typedef void (*log_line_subscriber_t)(const uint8_t *entry, size_t len, uint64_t end_offset);
 
 class LogManager {
 public:
     static LogManager& instance();
 
     static constexpr size_t DEFAULT_BUFFER_SIZE = 4096;
+    // Compressed history kept behind the live ring (see log_archive.h); 0
+    // disables it. Only allocated while the heap has room to spare.
+    static constexpr size_t DEFAULT_HISTORY_SIZE = 8192;
 
     static void init();
-    static void begin(size_t size = DEFAULT_BUFFER_SIZE);
+    static void begin(size_t size = DEFAULT_BUFFER_SIZE,
+                      size_t history_size = DEFAULT_HISTORY_SIZE);
     static void stop();
     static void clear();
 
     bool isEnabled() const;
 
+    // Per-tag rate limit applied to every ESP_LOGx line before it is
+    // captured or printed (see log_limiter.h); 0 lines per second disables
+    // it. The limiter's counters are exported as metrics.
+    static void setRateLimit(uint16_t lines_per_second, uint16_t burst);
+    const LogLimiter &limiter() const { return _limiter; }
+
     static constexpr int LOG_MAX_SUBSCRIBERS = 4;
     void addSubscriber(log_line_subscriber_t sub);
     void removeSubscriber(log_line_subscriber_t sub);
     int subscriberCount() const;
 
+    // Offsets are positions in the entry stream, not in the rendered text.
+    // Both readers render the entries to text under the mutex, reading the
+    // compressed history first and the live ring after it.
     std::string getLogContent(uint64_t offset = 0);
     std::string getLogSnapshot(uint64_t offset, uint64_t *total_written);
 
     /**
-     * Copy one stable snapshot chunk directly from the ring buffer.
+     * Render whole lines from the ring buffer into `destination`.
      *
      * `absolute_offset` is both input and output. Lagging readers are clamped to
-     * the oldest byte still present in the ring. No heap allocation is used,
+     * the oldest entry still present in the history or the ring. No heap allocation is used,
      * which makes this the preferred path for HTTP downloads on the WROOM-32.
+     * Only a single line longer than `maximum_length` is ever cut.
      */
     size_t readChunk(uint64_t *absolute_offset, char *destination,
                      size_t maximum_length);
 
+    // Lines at least as severe as a level (log_level_rank(), 0 = any) and
+    // from one tag (empty = any).
+    struct LogFilter {
+        uint8_t max_rank = 0;
+        char tag[LOG_INDEX_TAG_MAX] = {};
+    };
+
+    /**
+     * Like readChunk(), but only lines that pass `filter`, and never past
+     * `end` (a getTotalWritten() snapshot). Candidates are looked up in the
+     * side index and read from their offsets; only lines older than the
+     * index are walked. `absolute_offset` may advance without any output.
+     */
+    size_t readFiltered(const LogFilter &filter, uint64_t *absolute_offset,
+                        uint64_t end, char *destination, size_t maximum_length);
+
     uint64_t getTotalWritten() const;
 
-    /** Current allocated ring-buffer capacity in bytes. */
+    /** Current allocated ring-buffer plus compressed-history pool in bytes. */
     size_t getBufferSize() const;
 
-    /** Bytes currently available to a new reader after ring-buffer overwrite. */
+    /** Entry bytes currently available to a new reader, history included. */
     size_t getBufferedBytes() const;
 
     static constexpr size_t CRASH_TAIL_MAX = 1024;
@@ -68,29 +107,58 @@ public:
 private:
     LogManager();
 
-    void _begin(size_t size);
+    void _begin(size_t size, size_t history_size);
     void _stop();
     void _clear();
-    void write(const char* data, size_t len);
-
-    char *log_buffer = nullptr;
-    size_t log_buffer_size = 0;
-    // Absolute stream position at which the current ring contents begin.
-    // Both fields are plain 64-bit values protected by _mutex.
-    uint64_t ring_start_offset = 0;
-    uint64_t total_written = 0;
+    void _releaseBuffer();
+    void _beginHistory(size_t history_size);
+    void _releaseHistory();
+    void _drainHistory();
+    uint64_t _oldest() const;
+    size_t _readRaw(uint64_t *offset, uint8_t *destination, size_t maximum_length);
+    bool _nextEntry(uint64_t from, uint64_t end, uint64_t *next, size_t *at, size_t *len);
+    bool _renderNext(uint64_t from, uint64_t end, uint64_t *next, size_t *line_len);
+    size_t _copyEntries(uint64_t *position, uint64_t end, uint8_t *out, size_t cap);
+    static void _historyTask(void *);
+    void write(const uint8_t *entry, size_t len, const char *tag);
+    int _forward(const char *fmt, va_list args);
+    void _forwardf(const char *fmt, ...);
+    void _reportSuppressed();
+
+    // Captured lines go through the lock-free ring; write() never takes the
+    // mutex. The mutex serialises the control path (begin/stop/clear,
+    // subscriber changes) and readers, which must not race a buffer free.
+    LogRing _ring;
+    char *log_buffer = nullptr;   // owned allocation, guarded by _mutex
+    // Level and tag of every line captured while the ring is active, written
+    // lock-free next to the ring (see log_index.h).
+    LogIndex _index;
+    // Entries leave the ring for the compressed history on a low-priority
+    // task; _history_position is the next ring offset it drains. Both guarded
+    // by _mutex like the ring storage.
+    LogArchive _history;
+    uint64_t _history_position = 0;
+    TaskHandle_t _history_task = nullptr;
     // The logger is constructed once and lives for the whole boot. Static
     // semaphore storage avoids a boot-time heap allocation and, importantly,
     // cannot leave the singleton permanently mutex-less after transient OOM.
     mutable StaticSemaphore_t _mutex_storage = {};
     mutable SemaphoreHandle_t _mutex = nullptr;
-
-    log_line_subscriber_t _subscribers[LOG_MAX_SUBSCRIBERS] = {};
+    // Reader scratch, guarded by _mutex: raw entries are copied out of the
+    // ring into _raw and rendered into _line, off every task's stack.
+    uint8_t _raw[2 * LOG_ENTRY_MAX] = {};
+    char _line[LOG_LINE_MAX] = {};
+
+    // Slots are written under _mutex and read lock-free by write(); an empty
+    // slot is nullptr.
+    std::atomic<log_line_subscriber_t> _subscribers[LOG_MAX_SUBSCRIBERS] = {};
     int _subscriber_count = 0;
     std::atomic<uint32_t> _subscriber_count_fast{0};
     std::atomic<bool> _capture_active{false};
     std::atomic<bool> _hook_installed{false};
 
+    LogLimiter _limiter;
+
     using vprintf_fn_t = int (*)(const char *, va_list);
     std::atomic<vprintf_fn_t> _orig_vprintf{nullptr};
 
@@ -0,0 +1,106 @@
+/*
+ *  log_ring.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Lock-free multi-producer byte ring behind LogManager.
+//
+// Producers never wait: a line reserves its byte range with one fetch_add on
+// the reserve word, copies itself into the ring and adds its length to the
+// done word. Whichever producer finds done == reserve afterwards (nobody else
+// in flight) publishes that position as the new commit point, so readers only
+// ever see a contiguous, fully written prefix of the stream, in reservation
+// order. Overwrite of the oldest bytes is the usual ring behaviour; readers
+// copy optimistically and then re-read the reserve word to discard whatever a
+// producer may have overwritten meanwhile (a sequence check on the stream
+// position itself).
+//
+// Stream offsets are 64-bit but every shared word is a native lock-free
+// 32-bit atomic (see metrics.cpp for why 64-bit atomics are avoided on the
+// ESP32). The high part of the commit position is reconstructed from a
+// half-wrap counter whose parity must match bit 31 of the commit word.
+//
+// write() may run concurrently with everything. attach(), detach(), clear(),
+// oldest() and read() must be serialised by the caller (LogManager holds its
+// mutex), and the storage handed to attach() must stay valid until detach()
+// has returned it and busy() has been observed false.
+class LogRing {
+public:
+    // Capacity must be a power of two so that 32-bit positions index the
+    // ring identically across the 2^32 wrap.
+    static bool validCapacity(size_t size) {
+        return size >= 2 && size <= 0x10000000u && (size & (size - 1)) == 0;
+    }
+
+    // Publish zeroed storage. The caller then waits for !busy() and calls
+    // markStart(), so no byte from a producer that still saw the old (null)
+    // storage can appear inside the readable window.
+    void attach(char *storage, size_t size);
+    void markStart();
+    // Unpublish the storage and return it. Free only after !busy().
+    char *detach();
+    bool busy() const;
+
+    // Append bytes; never blocks and never drops. Returns the absolute stream
+    // offset just past this write. Only the last capacity() bytes of an
+    // oversized write are kept, and nothing is copied while detached, but
+    // the stream position always advances by len.
+    uint64_t write(const char *data, size_t len);
+
+    // Forget the current contents; subsequent reads start at committed().
+    void clear();
+
+    // Absolute end of the fully written prefix of the stream.
+    uint64_t committed() const;
+    // Oldest absolute offset that is still readable (== committed() if none).
+    uint64_t oldest() const;
+    size_t capacity() const;
+
+    // Copy up to max bytes starting at *offset into dst. *offset is clamped
+    // to [oldest(), committed()] and advanced past the returned bytes. Every
+    // returned byte was verified not to have been overwritten during the copy.
+    size_t read(uint64_t *offset, char *dst, size_t max) const;
+
+private:
+    uint64_t extend(uint32_t position) const;
+    uint64_t validFrom(uint64_t commit, uint32_t reserve) const;
+    void publish();
+
+    std::atomic<char *> _storage{nullptr};
+    std::atomic<uint32_t> _mask{0};
+    std::atomic<uint32_t> _writers{0};
+    std::atomic<uint32_t> _reserve{0};
+    std::atomic<uint32_t> _done{0};
+    std::atomic<uint32_t> _commit{0};
+    std::atomic<uint32_t> _half_wraps{0};
+    // Raised by a producer that was lapped by a full ring before it copied:
+    // the slots it wrote may belong to newer lines, so everything before
+    // this position is treated as overwritten.
+    std::atomic<uint32_t> _floor{0};
+    // Caller-serialised; see the class comment.
+    uint64_t _start = 0;
+};
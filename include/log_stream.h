@@ -48,11 +48,12 @@ esp_err_t log_stream_handler(httpd_req_t *req);
 // contract. Safe for non-WebSocket HTTP sessions as well.
 void log_stream_close_socket(httpd_handle_t handle, int fd);
 
-// Queue a captured log line for every connected subscriber. `end_offset` is
-// the absolute LogManager ring-stream position immediately after the line.
-// A full queue forces clients to reconnect and recover from the ring snapshot
-// instead of silently losing data.
-void log_stream_publish(const char *message, size_t len, uint64_t end_offset);
+// Queue a captured log entry (see log_entry.h) for every connected subscriber;
+// the worker renders it to text. `end_offset` is the absolute LogManager
+// ring-stream position immediately after the entry. A full queue forces
+// clients to reconnect and recover from the ring snapshot instead of silently
+// losing data.
+void log_stream_publish(const uint8_t *entry, size_t len, uint64_t end_offset);
 
 // Number of currently snapshot-synchronised WebSocket subscribers. Exposed via
 // /api/log/status so the UI can show "live" indicator.
@@ -0,0 +1,83 @@
+/*
+ *  log_stream_batch.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Rendered log lines collected by the log stream worker during one flush
+// interval, turned into as few WebSocket frames as the stream protocol
+// allows.
+//
+// A frame is "stream data <end-offset> <span>\n" followed by the text of
+// every entry in [end-offset - span, end-offset). Offsets are positions in
+// the LogManager entry stream, not text bytes, so a frame may only merge
+// entries that are adjacent there. Lines arrive in the order the logging
+// tasks published them, which under concurrent logging is not quite stream
+// order; the batch keeps them sorted by offset so such pairs still merge.
+// A range that really is missing ends the frame: the next one then starts
+// past the client's offset and makes it resynchronise, exactly as a single
+// missing line did before.
+class LogStreamBatch {
+public:
+    // Largest frame, header included; also the send slot payload size.
+    static constexpr size_t FRAME_MAX = 1024;
+    static constexpr size_t HEADER_MAX = 48;
+    static constexpr size_t TEXT_MAX = FRAME_MAX - HEADER_MAX;
+    static constexpr size_t LINES_MAX = 32;
+
+    void clear() { _count = 0; _text_len = 0; }
+    bool empty() const { return _count == 0; }
+    size_t lines() const { return _count; }
+
+    // Add the rendered text of the entry ending at end_offset that occupies
+    // span bytes of the stream. Text may be empty; the range is still
+    // covered. Returns false if the batch is full: flush it and retry.
+    bool append(const char *text, size_t len, uint64_t end_offset, uint32_t span);
+
+    // True if a subscriber that has everything up to position gets a frame.
+    bool hasFrameAfter(uint64_t position) const;
+
+    // Write the next frame for a subscriber that has everything up to
+    // *position (its snapshot checkpoint, then the end of its previous
+    // frame) and advance *position past it. out must hold FRAME_MAX bytes.
+    // Returns the frame length, 0 if nothing is left; *lines is the number of
+    // entries in the frame.
+    size_t nextFrame(uint64_t *position, char *out, size_t cap, uint32_t *lines) const;
+
+private:
+    struct Piece {
+        uint64_t end;
+        uint32_t span;
+        uint16_t text_at;
+        uint16_t text_len;
+    };
+
+    size_t firstAfter(uint64_t position) const;
+
+    Piece _pieces[LINES_MAX];   // sorted by end offset
+    size_t _count = 0;
+    char _text[TEXT_MAX];       // in arrival order
+    size_t _text_len = 0;
+};
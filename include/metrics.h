@@ -91,6 +91,10 @@ void metrics_gauge_reset(metrics_gauge_t gauge);
 // length.
 size_t metrics_render_prometheus(char *out, size_t cap, size_t offset);
 
+// The same in pieces of cap bytes, one counter or gauge at a time; see
+// PrometheusText for the resume contract.
+size_t metrics_render_prometheus_part(char *out, size_t cap, size_t offset, size_t *resume);
+
 #ifdef __cplusplus
 }
 #endif
@@ -69,11 +69,21 @@ typedef struct {
     // (or in a "token" JSON field) for a command to be accepted. Empty means
     // "no token required" - in that case rely on broker-side ACL + TLS/mTLS.
     char command_token[65];
+    // Retained status topics are only republished when their value changed;
+    // unchanged ones are refreshed after this many minutes (default 15,
+    // 0 = publish every topic on every cycle, max 1440).
+    uint16_t status_refresh_minutes;
+    // Publish the status values as one retained JSON document on
+    // <prefix>/state instead of one <prefix>/status/* topic each.
+    bool state_document;
+    // Connect with MQTT 5: topic aliases for the status and event topics,
+    // a message expiry on events and a "unit" user property on values.
+    bool protocol_v5;
 } mqtt_config_t;
 
 // Syslog forwarding configuration (Phase B). When enabled, every line written
 // to the LogManager ring buffer is also forwarded to the configured remote
-// syslog server using RFC 5424 framing.
+// server, as RFC 5424 syslog or as structured GELF / JSON lines.
 typedef struct {
     bool enabled;
     char server[65];        // host or IP
@@ -81,6 +91,12 @@ typedef struct {
     uint8_t transport;      // 0 = UDP, 1 = TCP, 2 = TLS (TCP+TLS)
     uint8_t min_severity;   // 0=EMERG .. 7=DEBUG (default 6 = INFO)
     char hostname[32];      // override; empty = Settings::getHostname()
+    uint8_t format;         // 0 = RFC 5424, 1 = GELF, 2 = JSON lines (syslog_format_t)
+    // Per-tag log rate limit. Unlike the fields above it applies to every
+    // captured line (ring, syslog, WebSocket and UART), whether or not
+    // forwarding is enabled; 0 lines per second disables it.
+    uint16_t rate_limit;    // lines per second per tag (default 20, max 1000)
+    uint16_t rate_burst;    // lines a tag may log at once (default 50, max 1000)
 } syslog_config_t;
 
 // Bit positions for notify_config_t.event_mask — one per notifiable event.
@@ -101,11 +117,12 @@ typedef struct {
 #define NOTIFY_EVENT_CCU_CONNECTED     (1u << 8)
 #define NOTIFY_EVENT_CCU_DISCONNECTED  (1u << 9)
 #define NOTIFY_EVENT_LOW_HEAP          (1u << 10)
+#define NOTIFY_EVENT_DUTY_CYCLE        (1u << 11)
 
 // Every currently defined event. This is the factory default and also what a
 // device upgrading from a firmware without the mask keeps, because the NVS
 // loader leaves the field untouched when its key is missing.
-#define NOTIFY_EVENT_ALL ((uint16_t)0x07FFu)
+#define NOTIFY_EVENT_ALL ((uint16_t)0x0FFFu)
 
 // Event notification configuration (Phase C/D). Multi-channel: any subset of
 // webhook / telegram / email can be enabled via the `channels` bitmask, and
@@ -126,6 +143,9 @@ typedef struct {
     char smtp_to[49];
     uint16_t cooldown_seconds; // per-event-type debounce window (default 300)
     uint16_t event_mask;       // NOTIFY_EVENT_* bitmask; 0 = notify nothing
+    uint8_t duty_cycle_warn;   // % of the hourly transmit budget; 0 = off (default 50)
+    uint8_t duty_cycle_alarm;  // % of the hourly transmit budget; 0 = off (default 80)
+    uint16_t digest_seconds;   // collect events into one notification per window; 0 = off
 } notify_config_t;
 
 // Monitoring configuration
@@ -246,6 +266,9 @@ esp_err_t checkmk_stop(void);
 // (syslog/events and MQTT TLS) so two TLS connections never
 // occupy the heap at once. It is intentionally not a FreeRTOS mutex because
 // MQTT teardown may need to release a gate acquired by its library task.
+// Every holder calls events_close_idle_connections() right after taking it:
+// the notification connections kept alive between deliveries would
+// otherwise be a second TLS context.
 extern SemaphoreHandle_t g_net_fetch_mutex;
 
 // Manual firmware-upload activity flag. Lower-priority outbound TLS consumers
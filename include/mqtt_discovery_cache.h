@@ -0,0 +1,80 @@
+/*
+ *  mqtt_discovery_cache.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// What the broker holds for each retained Home Assistant discovery config,
+// as a content hash per entity, so a reconnect only republishes the configs
+// that changed. Entities are keyed by a hash of their discovery topic and
+// the broker address: a new discovery prefix or a different broker starts
+// out empty.
+//
+// The table is persisted (serialize()/deserialize()) so that a reboot does
+// not resend everything either. Home Assistant announcing itself online
+// (its birth message) calls for a full republish: clear().
+//
+// A pass over all entities starts with beginPass(); endPass() then drops
+// entities that were not seen, i.e. that the firmware no longer publishes.
+//
+// Not thread-safe: the MQTT publish task owns it.
+class MqttDiscoveryCache {
+public:
+    static constexpr size_t MAX_ENTITIES = 48;
+
+    void clear();
+
+    void beginPass();
+    // True when content is not what was last recorded under key. Marks the
+    // entity as seen in this pass.
+    bool changed(uint32_t key, uint32_t content);
+    // Record a successful publish. False when the table is full; such an
+    // entity is then republished on every pass.
+    bool record(uint32_t key, uint32_t content);
+    void endPass();
+
+    size_t size() const { return _count; }
+    // Set by changes to the table since the last markClean().
+    bool dirty() const { return _dirty; }
+    void markClean() { _dirty = false; }
+
+    size_t serializedSize() const;
+    size_t serialize(uint8_t *out, size_t capacity) const;
+    // Replaces the table; false (table left empty) for malformed data.
+    bool deserialize(const uint8_t *data, size_t len);
+
+private:
+    struct Entry {
+        uint32_t key;
+        uint32_t content;
+    };
+
+    int find(uint32_t key) const;
+
+    Entry _entries[MAX_ENTITIES] = {};
+    bool _seen[MAX_ENTITIES] = {};
+    size_t _count = 0;
+    bool _dirty = false;
+};
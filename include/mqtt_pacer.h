@@ -0,0 +1,72 @@
+/*
+ *  mqtt_pacer.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Admission control in front of every paced MQTT publish.
+//
+// A token bucket spreads publishes over time instead of handing the client
+// a whole batch back-to-back, and the state of the ESP-MQTT outbox (bytes
+// held, QoS 1 messages awaiting their PUBACK) decides what may be queued at
+// all: above the soft limits low-priority topics wait for a later cycle,
+// above the hard limits everything but high-priority topics does. A slow
+// broker therefore costs publishes, not heap.
+//
+// High-priority publishes (the online marker, events) bypass the bucket:
+// they are small, rare and QoS 0, which ESP-MQTT does not keep in the
+// outbox.
+//
+// Not thread-safe; the MQTT handler serialises callers.
+class MqttPacer {
+public:
+    enum Priority : uint8_t { HIGH, NORMAL, LOW };
+    enum Decision : uint8_t { ADMIT, WAIT, DEFER };
+
+    struct Limits {
+        uint32_t rate_per_s;        // bucket refill
+        uint32_t burst;             // bucket size
+        size_t soft_bytes;          // outbox bytes deferring LOW
+        size_t hard_bytes;          // outbox bytes deferring NORMAL too
+        uint32_t soft_in_flight;    // unacknowledged QoS 1 messages, likewise
+        uint32_t hard_in_flight;
+    };
+
+    // The bucket starts full.
+    void configure(const Limits &limits, uint32_t now_ms);
+
+    // ADMIT consumes a token. WAIT: no token yet, *wait_ms until there is
+    // one; a caller that cannot sleep treats it as DEFER. DEFER: the outbox
+    // is under pressure, try again next cycle.
+    Decision decide(Priority priority, uint32_t now_ms, size_t outbox_bytes,
+                    uint32_t in_flight, uint32_t *wait_ms);
+
+private:
+    void refill(uint32_t now_ms);
+
+    Limits _limits = {};
+    uint32_t _tokens_milli = 0;   // tokens * 1000, so slow rates refill smoothly
+    uint32_t _refilled_ms = 0;
+};
@@ -0,0 +1,85 @@
+/*
+ *  mqtt_topic_aliases.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include <atomic>
+
+// Outgoing MQTT 5 topic aliases of one broker session.
+//
+// A topic is sent in full once together with its alias; later publishes
+// carry only the two-byte alias and an empty topic. Brokers grant few
+// aliases (Mosquitto: 10) and binding one costs three bytes more than a
+// plain publish, so only topics published again within HOT_WINDOW publishes
+// get one. Values that change every cycle qualify; topics only seen on a
+// refresh pass do not, so they cannot evict the hot ones. When all aliases
+// are taken the least recently used one is rebound.
+//
+// Topics are identified by their MqttTopicTable id. Not thread-safe, except
+// for endSession().
+class MqttTopicAliases {
+public:
+    static constexpr uint16_t MAX_ALIASES = 16;
+    static constexpr uint16_t MAX_TOPICS = 64;
+    static constexpr uint32_t HOT_WINDOW = 64;
+
+    // A new session: the broker knows no alias. maximum is the number of
+    // aliases to use, 0 disables them.
+    void reset(uint16_t maximum);
+
+    // The broker session ended (disconnect, or a new connect). Safe from
+    // any task: the next assign() starts over as after reset() with the
+    // last maximum given to it.
+    void endSession() { _session.fetch_add(1, std::memory_order_acq_rel); }
+
+    // False once the session of the last assign() has ended. An alias-only
+    // publish picked in it must then carry its full topic, which binds the
+    // alias on the new session.
+    bool sameSession() const { return _session.load(std::memory_order_acquire) == _assigned; }
+
+    // The broker refused alias numbers above maximum; forget them.
+    void limit(uint16_t maximum);
+
+    // The alias to publish topic_id with, 0 for none. *bind is set when the
+    // full topic must go along with it.
+    uint16_t assign(uint16_t topic_id, bool *bind);
+
+    // A publish using alias did not reach the broker: bind it again next time.
+    void drop(uint16_t alias);
+
+    uint16_t maximum() const { return _maximum; }
+
+private:
+    static constexpr uint16_t UNBOUND = 0xFFFF;
+
+    uint16_t _maximum = 0;
+    uint16_t _configured = 0;            // maximum of the last reset()
+    std::atomic<uint32_t> _session{0};
+    uint32_t _assigned = 0;              // _session at the last assign()
+    uint16_t _topic[MAX_ALIASES] = {};   // topic id bound to alias i + 1
+    uint32_t _used[MAX_ALIASES] = {};    // _clock at the alias' last use
+    uint32_t _seen[MAX_TOPICS] = {};     // _clock at the topic's last publish
+    uint32_t _clock = 0;
+};
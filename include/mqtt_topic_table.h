@@ -0,0 +1,65 @@
+/*
+ *  mqtt_topic_table.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// The full MQTT topic strings of a publisher, "<prefix>/<subtopic>" for a
+// fixed list of subtopics, formatted once into a single heap arena and
+// looked up by the publisher's topic enum. Publishing then needs no
+// snprintf and no topic buffer on the publisher's stack.
+//
+// Built when the MQTT client starts, i.e. on every configuration change.
+// The returned strings stay valid until the next build(), so one of them
+// can serve as the client's LWT topic.
+//
+// Not thread-safe: build() must not race with lookups.
+class MqttTopicTable {
+public:
+    static constexpr size_t MAX_TOPICS = 64;
+
+    MqttTopicTable() = default;
+    ~MqttTopicTable();
+    MqttTopicTable(const MqttTopicTable &) = delete;
+    MqttTopicTable &operator=(const MqttTopicTable &) = delete;
+
+    // Replace the table with "<prefix>/<subtopics[i]>" under id i. On failure
+    // (too many topics, out of memory) the table is left empty.
+    bool build(const char *prefix, const char *const *subtopics, size_t count);
+
+    // "" for an id that was not built.
+    const char *topic(size_t id) const;
+    size_t length(size_t id) const;
+
+    size_t count() const { return _count; }
+    size_t bytes() const { return _count ? _offsets[_count] : 0; }
+
+private:
+    void clear();
+
+    char *_arena = nullptr;
+    uint16_t _offsets[MAX_TOPICS + 1] = {};
+    size_t _count = 0;
+};
@@ -0,0 +1,80 @@
+/*
+ *  mqtt_value_cache.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Last value published on each retained MQTT status topic, so a publish
+// cycle only sends the topics whose payload changed. Topics are identified by
+// a small integer id (the publisher's topic enum); per id the cache keeps a
+// 32-bit hash of the payload, the numeric value for deadband comparisons and
+// when it was published.
+//
+// Unchanged values are still republished once they are older than the
+// refresh interval, so a broker that lost its retained store (restart
+// without persistence) is repopulated, and a hash collision cannot hide a
+// change for longer than that either.
+//
+// Not thread-safe: the MQTT publisher serialises callers.
+class MqttValueCache {
+public:
+    static constexpr size_t SLOTS = 64;
+
+    // 0 republishes every value on every cycle, i.e. disables the cache.
+    void setRefreshInterval(uint32_t seconds) { _refresh_s = seconds; }
+
+    // Forget everything: the next cycle publishes every topic. Called on
+    // each broker (re)connect.
+    void invalidate();
+
+    // True if payload should be published under id: it differs from the last
+    // published payload, or that one is older than the refresh interval.
+    bool wants(uint8_t id, const char *payload, size_t len, uint32_t now_s) const;
+
+    // As wants(), for a number rendered as payload: a change smaller than
+    // deadband against the last published value is not worth a publish.
+    bool wantsNumber(uint8_t id, double value, double deadband, const char *payload,
+                     size_t len, uint32_t now_s) const;
+
+    // Record a successful publish. Not called when the publish failed, so
+    // the value is tried again next cycle.
+    void published(uint8_t id, const char *payload, size_t len, uint32_t now_s,
+                   double value = 0);
+
+    static uint32_t hash(const char *data, size_t len);
+
+private:
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t published_s = 0;
+        float value = 0;
+        bool valid = false;
+    };
+
+    bool due(const Slot &slot, uint32_t now_s) const;
+
+    Slot _slots[SLOTS];
+    uint32_t _refresh_s = 0;
+};
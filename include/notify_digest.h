@@ -0,0 +1,100 @@
+/*
+ *  notify_digest.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Events collected by the notification worker in digest mode and delivered
+// as one notification per channel when the window closes. The window opens
+// with the first event and does not slide, so a steady trickle is still
+// reported every window_us.
+//
+// Repeats of an event type fold into its entry: a flapping link produces
+// one "link down (12x)" line, not twelve, and the digest never needs more
+// than one entry per type. Types beyond SLOTS are only counted.
+class NotifyDigest {
+public:
+    static constexpr size_t SLOTS = 8;
+    static constexpr size_t DETAIL_MAX = 128;   // EventEntry::detail
+
+    struct Entry {
+        uint8_t id;
+        uint16_t count;             // saturates
+        int64_t first_us;
+        int64_t last_us;
+        char detail[DETAIL_MAX];    // of the latest occurrence
+    };
+
+    void clear();
+    bool empty() const { return _events == 0; }
+    bool contains(uint8_t id) const;
+
+    // Add an event that happened at timestamp_us. The first event of a
+    // digest closes it at now_us + window_us.
+    void add(uint8_t id, int64_t timestamp_us, const char *detail,
+             int64_t now_us, int64_t window_us);
+
+    bool due(int64_t now_us) const { return !empty() && now_us >= _deadline_us; }
+    int64_t deadline() const { return _deadline_us; }
+
+    size_t size() const { return _count; }
+    const Entry &entry(size_t i) const { return _entries[i]; }
+    // Every event added, including the folded and the unlisted ones.
+    uint32_t events() const { return _events; }
+    // Events of types that found no free entry.
+    uint32_t unlisted() const { return _unlisted; }
+
+private:
+    Entry _entries[SLOTS];
+    size_t _count = 0;
+    uint32_t _events = 0;
+    uint32_t _unlisted = 0;
+    int64_t _deadline_us = 0;
+};
+
+// Idle window of a kept-alive notification connection. The worker keeps
+// one HTTP client per channel open after a delivery and reuses it for the
+// next one if that comes within idle_us and targets the same endpoint,
+// identified by a hash of its URL and credentials.
+class NotifyKeepAlive {
+public:
+    explicit NotifyKeepAlive(int64_t idle_us) : _idle_us(idle_us) {}
+
+    static uint32_t key(const char *url, const char *secret);
+
+    bool open() const { return _open; }
+    bool reusable(int64_t now_us, uint32_t key) const;
+    // True once an open connection has been idle for longer than idle_us.
+    bool expired(int64_t now_us) const;
+
+    void used(int64_t now_us, uint32_t key);
+    void reset() { _open = false; }
+
+private:
+    int64_t _idle_us;
+    int64_t _last_us = 0;
+    uint32_t _key = 0;
+    bool _open = false;
+};
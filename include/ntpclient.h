@@ -23,13 +23,101 @@
 
 #pragma once
 
+#include <stdint.h>
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "lwip/sockets.h"
 #include "settings.h"
 #include "systemclock.h"
 
+// Multi-server NTP client.
+//
+// Every configured server (the NTP server setting takes a comma-separated
+// list) is polled from one task and one socket per address family. Samples
+// run through the RFC 5905 clock filter (eight-stage shift register, minimum
+// delay sample wins, RMS jitter) per peer, then through the intersection and
+// combine algorithms across peers, so a single falseticker or a congested
+// path cannot pull the clock. Offsets below NTP_STEP_THRESHOLD_US are slewed
+// with adjtime(); only the initial sync and gross errors step the clock.
+// The poll interval follows the observed stability between 2^NTP_MIN_POLL and
+// 2^NTP_MAX_POLL seconds.
+#define NTP_MAX_PEERS 4
+#define NTP_FILTER_STAGES 8
+#define NTP_MIN_POLL 6  // 64 s
+#define NTP_MAX_POLL 12 // 68 min
+#define NTP_BURST_SAMPLES 4
+#define NTP_STEP_THRESHOLD_US 128000
+
+typedef struct
+{
+    int64_t offset_us;
+    int64_t delay_us;
+    int64_t dispersion_us;
+    int64_t epoch_us; // esp_timer time the sample was taken
+} ntp_sample_t;
+
+typedef struct
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    char name[65];
+
+    ntp_sample_t filter[NTP_FILTER_STAGES];
+    uint8_t filter_count;
+    uint8_t filter_next;
+
+    // Clock filter output.
+    int64_t offset_us;
+    int64_t delay_us;
+    int64_t dispersion_us;
+    int64_t jitter_us;
+    int64_t update_us;    // epoch of the selected sample
+    // From the last valid response: root delay / 2 + root dispersion.
+    int64_t root_distance_us;
+    uint8_t stratum;
+
+    uint8_t reach;        // 8-bit reachability shift register
+    uint8_t burst;        // requests left at the short burst interval
+    int8_t poll;          // per-peer floor raised by RATE kisses
+    bool spike;           // last sample was discarded as a popcorn spike
+    bool denied;          // DENY/RSTR kiss: never poll again
+    uint64_t xmt;         // transmit timestamp of the outstanding request
+    int64_t t1_us;        // local send time, unix microseconds
+    int64_t next_poll_us; // esp_timer deadline for the next request
+} ntp_peer_t;
+
 class NtpClient
 {
+private:
+    Settings *_settings;
+    SystemClock *_clk;
+    TaskHandle_t _tHandle = NULL;
+    volatile bool _running = false;
+
+    ntp_peer_t _peers[NTP_MAX_PEERS] = {};
+    int _peerCount = 0;
+    int _sock4 = -1;
+    int _sock6 = -1;
+
+    int8_t _poll = NTP_MIN_POLL;
+    int _pollCounter = 0;
+    bool _synced = false;
+    int64_t _lastApplied_us = 0;
+    int64_t _lastResolve_us = 0;
+    int64_t _nextResolve_us = 0;
+
+    void resolvePeers();
+    void sendRequest(ntp_peer_t *peer, int64_t now_us);
+    void receiveResponse(int sock);
+    void clockFilter(ntp_peer_t *peer, const ntp_sample_t *sample);
+    void clockSelect();
+    void adjustPoll(int64_t offset_us, int64_t jitter_us);
+    int64_t peerInterval(const ntp_peer_t *peer);
+
 public:
     NtpClient(Settings *settings, SystemClock *clk);
     void start();
     void stop();
+
+    void _run();
 };
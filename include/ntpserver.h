@@ -27,7 +27,9 @@
 #include "lwip/inet.h"
 #include "lwip/udp.h"
 #include "lwip/priv/tcpip_priv.h"
+#include "freertos/queue.h"
 #include "systemclock.h"
+#include <stddef.h>
 
 typedef unsigned long long tstamp;
 
@@ -46,6 +48,58 @@ typedef struct ntp_packet
     tstamp   trns_time;
 } ntp_packet_t;
 
+// Per-client accounting for the NTP responder.
+//
+// Every request is admitted or refused in the lwIP receive callback, before it
+// can occupy a slot in the handler queue, so one misconfigured client polling
+// in a tight loop cannot starve the other clients or keep the tcpip thread
+// busy at the expense of the raw-UART bridge. Clients live in a fixed
+// open-addressed table hashed by IPv4 address: a lookup probes at most
+// NTP_CLIENT_PROBE_LIMIT slots and the oldest entry in the probe window is
+// recycled when all of them are taken, so the cost per packet is constant and
+// nothing is allocated.
+//
+// Each client owns a token bucket. The burst covers an `iburst` start (eight
+// requests two seconds apart); afterwards one request per refill interval is
+// sustained, which is still eight times faster than the shortest standard
+// poll interval of 64 s. A client that runs dry receives a RATE Kiss-o'-Death
+// (RFC 5905 section 7.4) at most once per refill interval and is otherwise
+// ignored.
+#define NTP_CLIENT_TABLE_BITS 5
+#define NTP_CLIENT_TABLE_SIZE (1 << NTP_CLIENT_TABLE_BITS)
+#define NTP_CLIENT_PROBE_LIMIT 4
+#define NTP_RATE_BURST 8
+#define NTP_RATE_REFILL_MS 8000
+
+typedef struct
+{
+    uint32_t addr;         // IPv4 source address, network order; 0 = free slot
+    uint32_t last_seen_ms;
+    uint32_t refill_ms;    // time the bucket was last topped up
+    uint32_t last_kod_ms;
+    uint32_t requests;     // every request seen from this client
+    uint32_t limited;      // requests refused by the token bucket
+    uint8_t tokens;
+    bool kod_sent;
+} ntp_client_entry_t;
+
+typedef enum
+{
+    NTP_ADMIT_SERVE = 0,
+    NTP_ADMIT_KOD,
+    NTP_ADMIT_DROP,
+} ntp_admit_t;
+
+// Handed by value through the handler queue, so the receive callback does not
+// need a heap allocation per request.
+typedef struct
+{
+    pbuf *pb;
+    ip4_addr_t addr;
+    uint16_t port;
+    bool kod;
+} ntp_request_t;
+
 class NtpServer {
   private:
     SystemClock* _clk;
@@ -53,7 +107,11 @@ class NtpServer {
     QueueHandle_t _udp_queue;
     TaskHandle_t _tHandle = NULL;
 
-    void handlePacket(pbuf *pb, ip4_addr_t addr, uint16_t port);
+    ntp_client_entry_t _clients[NTP_CLIENT_TABLE_SIZE] = {};
+    portMUX_TYPE _clientMux = portMUX_INITIALIZER_UNLOCKED;
+
+    void handlePacket(pbuf *pb, ip4_addr_t addr, uint16_t port, bool kod);
+    ntp_admit_t admitClient(uint32_t addr);
 
   public: 
     NtpServer(SystemClock* clk); 
@@ -61,6 +119,15 @@ class NtpServer {
     void start();
     void stop();
 
+    // Copy the client table into `out` (NTP_CLIENT_TABLE_SIZE entries) and
+    // return the number of occupied slots copied.
+    size_t getClients(ntp_client_entry_t *out);
+
     void _udpQueueHandler();
     bool _udpReceivePacket(pbuf *pb, const ip_addr_t *addr, uint16_t port);
 };
+
+// Append the per-client request counters of the running NTP server in
+// Prometheus text format, same contract as metrics_render_prometheus_part().
+// Cardinality is bounded by NTP_CLIENT_TABLE_SIZE.
+size_t ntp_server_render_prometheus(char *out, size_t cap, size_t offset, size_t *resume);
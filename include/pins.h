@@ -42,6 +42,10 @@
 #define LED_PWR_PIN GPIO_NUM_16
 
 #define DCF_PIN GPIO_NUM_39
+// GPS PPS input. Shares GPIO0 with the unused GPS UART TX (the firmware never
+// transmits to the receiver). GPIO0 is a boot strapping pin with an external
+// pull-up, so the PPS source must not hold it low during reset.
+#define GPS_PPS_PIN GPIO_NUM_0
 
 #define BOARD_REV_SENSE_CHANNEL ((adc_channel_t)ADC1_GPIO36_CHANNEL)
 #define BOARD_REV_SENSE_UNIT ADC_UNIT_1
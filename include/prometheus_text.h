@@ -0,0 +1,64 @@
+/*
+ *  prometheus_text.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+// Prometheus text appended to a bounded buffer in parts, so the exporter
+// can send a scrape in pieces of its buffer's size instead of rendering
+// all of it into one allocation.
+//
+// A part is a run of lines that belong together, usually one metric
+// family, closed by endPart(). With resume set, a part that does not fit
+// completely is taken back and the render stops; *resume then names that
+// part, and calling the same renderer with an emptied buffer and the same
+// *resume continues there. *resume is 0 on the first call and 0 again once
+// everything is rendered. A part larger than the whole buffer is cut short
+// rather than retried. Without resume the text is simply cut at cap.
+//
+// Parts are counted, so a renderer must close the same parts on every
+// call: endPart() belongs outside any condition on the data.
+class PrometheusText {
+public:
+    // Appends to out at offset, like the *_render_prometheus() functions.
+    PrometheusText(char *out, size_t cap, size_t offset, size_t *resume);
+
+    void emit(const char *format, ...) __attribute__((format(printf, 2, 3)));
+    void endPart();
+
+    // Closes the last part, NUL-terminates and returns the new length.
+    size_t finish();
+
+private:
+    bool active() const { return !_stopped && _part >= _first; }
+
+    char *_out;
+    size_t _cap;
+    size_t _offset;
+    size_t *_resume;
+    size_t _first;          // parts before it went out with an earlier call
+    size_t _part = 0;
+    size_t _partStart;
+    bool _stopped = false;
+};
@@ -70,3 +70,16 @@ public:
 
     void _serialQueueHandler();
 };
+
+// Transmit duty cycle over the sliding hour, from the frames sent to the
+// module; see DutyCycleBudget.
+typedef struct {
+    uint32_t airtime_ms;     // estimated transmit airtime in the last hour
+    uint32_t used_percent;   // share of the 1 % budget, above 100 once spent
+    uint8_t level;           // DutyCycleBudget::Level
+} radio_module_duty_cycle_t;
+
+void radio_module_get_duty_cycle(radio_module_duty_cycle_t *out);
+
+// Thresholds in percent of the budget (notify_config_t); 0 turns one off.
+void radio_module_set_duty_cycle_thresholds(uint8_t warn_percent, uint8_t alarm_percent);
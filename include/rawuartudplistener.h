@@ -32,6 +32,7 @@
 #include <atomic>
 #define _Atomic(X) std::atomic<X>
 #include "radiomoduleconnector.h"
+#include "rf_devices.h"
 
 class RawUartUdpListener : FrameHandler
 {
@@ -90,3 +91,28 @@ void raw_uart_get_latency(raw_uart_latency_t *out);
 // changing something, instead of reading a mark set days earlier. The
 // bucket counters are monotonic and deliberately not reset.
 void raw_uart_reset_latency_high_water(void);
+
+// Radio traffic relayed to the CCU over the sliding minute and hour; see
+// RfTrafficStats. Airtime is an estimate from the telegram lengths.
+typedef struct {
+    uint32_t frames_1m;
+    uint32_t bytes_1m;
+    uint32_t airtime_1m_ms;
+    uint32_t frames_1h;
+    uint32_t bytes_1h;
+    uint32_t airtime_1h_ms;
+} raw_uart_rf_rates_t;
+
+void raw_uart_get_rf_rates(raw_uart_rf_rates_t *out);
+
+// Copy the radio devices heard so far, most recently heard first, with the
+// uptime in seconds their last_seen_s is measured against and the number of
+// devices evicted from the full table. Either pointer may be NULL.
+size_t raw_uart_get_rf_devices(RfDeviceTable::Device *out, size_t cap, uint32_t *now_s,
+                               uint32_t *evictions);
+
+// Append the radio traffic rates, the per destination/command counters and
+// the busiest devices in Prometheus text format, same contract as
+// metrics_render_prometheus_part(). Cardinality is bounded by
+// RfTrafficStats::MAX_KINDS and RF_DEVICE_METRICS (8) devices.
+size_t raw_uart_render_rf_prometheus(char *out, size_t cap, size_t offset, size_t *resume);
@@ -0,0 +1,90 @@
+/*
+ *  rf_devices.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "hmframe.h"
+
+// Radio devices heard in the frames the module relays to the CCU, keyed by
+// the 24-bit sender address: frames seen, when last seen and the last RSSI
+// the module reported.
+//
+// A fixed table of CAPACITY entries, chained from BUCKETS hash heads and
+// kept on a recency list. record() is O(1) and never allocates; when the
+// table is full the device heard least recently is evicted. Not
+// thread-safe.
+class RfDeviceTable {
+public:
+    static constexpr size_t CAPACITY = 128;
+    static constexpr size_t BUCKETS = 256;   // power of two
+
+    struct Device {
+        uint32_t address;     // 24-bit radio address
+        uint32_t frames;
+        uint32_t last_seen_s;
+        int8_t rssi;          // dBm, valid if has_rssi
+        bool has_rssi;
+    };
+
+    RfDeviceTable() { clear(); }
+
+    void clear();
+    void record(uint32_t address, uint32_t now_s, bool has_rssi, int8_t rssi);
+
+    size_t size() const { return _count; }
+    uint32_t evictions() const { return _evictions; }
+    // Copies up to cap devices, most recently heard first.
+    size_t snapshot(Device *out, size_t cap) const;
+
+    // The sender of a received telegram and the RSSI the module measured,
+    // for the receive events whose layout is known (see SENDER_LAYOUTS in
+    // rf_devices.cpp). False for every other frame.
+    static bool sender(const HMFrame &frame, uint32_t *address, bool *has_rssi, int8_t *rssi);
+
+private:
+    static constexpr uint8_t NONE = 0xff;
+    static_assert(CAPACITY < NONE, "indices are uint8_t");
+    static_assert((BUCKETS & (BUCKETS - 1)) == 0, "BUCKETS must be a power of two");
+
+    struct Node {
+        Device device;
+        uint8_t chain;   // next node in the same bucket
+        uint8_t newer;   // recency list neighbours
+        uint8_t older;
+    };
+
+    static size_t bucket(uint32_t address);
+    void unlinkRecency(uint8_t index);
+    void pushNewest(uint8_t index);
+    void unlinkChain(uint8_t index);
+
+    Node _nodes[CAPACITY];
+    uint8_t _heads[BUCKETS];
+    uint8_t _newest;
+    uint8_t _oldest;
+    size_t _count;
+    uint32_t _evictions;
+};
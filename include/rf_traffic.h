@@ -0,0 +1,111 @@
+/*
+ *  rf_traffic.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "hmframe.h"
+
+// Sums over a sliding minute (60 one-second buckets) and a sliding hour (60
+// one-minute buckets, the current one partial). add() is O(1); the totals
+// walk the buckets. Each bucket is tagged with the second or minute it
+// holds, so idle periods need no clean-up pass. Not thread-safe.
+class RfRateWindow {
+public:
+    struct Totals {
+        uint32_t frames;
+        uint32_t bytes;
+        uint32_t airtime_us;
+    };
+
+    void add(uint32_t now_s, uint32_t frames, uint32_t bytes, uint32_t airtime_us);
+    Totals lastMinute(uint32_t now_s) const;
+    Totals lastHour(uint32_t now_s) const;
+
+private:
+    struct Bucket {
+        uint32_t tag;   // now_s (seconds) or now_s / 60 (minutes), plus one
+        Totals totals;
+    };
+
+    static void addTo(Bucket *bucket, uint32_t tag, uint32_t frames, uint32_t bytes,
+                      uint32_t airtime_us);
+    static Totals sum(const Bucket *buckets, uint32_t tag);
+
+    Bucket _seconds[60] = {};
+    Bucket _minutes[60] = {};
+};
+
+// Radio traffic the module hands to the CCU, decoded with HMFrame::TryParse:
+// frames and bytes per (destination, command) since boot, and sliding
+// 1 min / 1 h rates with an airtime estimate.
+//
+// Airtime is only estimated for frames that stand for a received radio
+// telegram (HmIP, LLMAC and TRX frames other than the module's command
+// acknowledgements), from the payload length plus preamble, sync word,
+// length byte and CRC at AIR_BITRATE.
+//
+// The first MAX_KINDS (destination, command) pairs get their own counters,
+// later ones share an overflow entry. Not thread-safe.
+class RfTrafficStats {
+public:
+    static constexpr size_t MAX_KINDS = 16;
+    static constexpr uint32_t AIR_BITRATE = 10000;    // BidCos and HmIP, bit/s
+    static constexpr uint32_t AIR_OVERHEAD_BYTES = 11;
+
+    struct Kind {
+        uint8_t destination;
+        uint8_t command;
+        bool overflow;        // destination/command are meaningless
+        uint32_t frames;
+        uint32_t bytes;
+    };
+
+    // One frame from the module. wire_len is its length on the UART,
+    // escapes included, which is what the relay forwards.
+    void record(const HMFrame &frame, uint16_t wire_len, uint32_t now_s);
+    // A frame TryParse rejected (or too large to decode); counted in the
+    // rates, without airtime.
+    void recordUnparsed(uint16_t wire_len, uint32_t now_s);
+
+    RfRateWindow::Totals lastMinute(uint32_t now_s) const { return _window.lastMinute(now_s); }
+    RfRateWindow::Totals lastHour(uint32_t now_s) const { return _window.lastHour(now_s); }
+
+    // Kinds in order of first appearance; index runs to kindCount(), the
+    // overflow entry last once used.
+    size_t kindCount() const { return _kind_count + (_overflow.frames ? 1 : 0); }
+    Kind kind(size_t index) const;
+    uint32_t unparsed() const { return _unparsed; }
+
+    static bool isAirFrame(const HMFrame &frame);
+    static uint32_t airtimeUs(uint16_t payload_len);
+
+private:
+    Kind _kinds[MAX_KINDS] = {};
+    size_t _kind_count = 0;
+    Kind _overflow = {0, 0, true, 0, 0};
+    uint32_t _unparsed = 0;
+    RfRateWindow _window;
+};
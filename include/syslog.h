@@ -44,9 +44,14 @@ esp_err_t syslog_stop(void);
 bool syslog_is_running(void);
 
 // Subscriber hook compatible with log_line_subscriber_t. Called by
-// LogManager::write() for every captured line. It only applies the severity
-// filter and non-blockingly queues one bounded raw line. Parsing, timestamp /
-// hostname lookup and RFC 5424 formatting are performed by the worker.
-void syslog_subscriber(const char *line, size_t len, uint64_t end_offset);
+// LogManager::write() for every captured entry, on the logging task. It only
+// applies the severity filter and copies the entry into a preallocated
+// lock-free queue, without allocating; a full queue drops the line. For GELF
+// and JSON lines it also records the core and the task name, which only the
+// logging task knows. Rendering the message, timestamp / hostname lookup and
+// formatting are performed by the worker, which takes severity and tag from
+// the entry instead of parsing the rendered line, and writes TCP/TLS in
+// batches of frames.
+void syslog_subscriber(const uint8_t *entry, size_t len, uint64_t end_offset);
 
 #endif // SYSLOG_H
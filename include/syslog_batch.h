@@ -0,0 +1,136 @@
+/*
+ *  syslog_batch.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+
+// Building blocks of the syslog forwarder that do not touch the network:
+// the queue between the logging tasks and the worker, RFC 5424 / RFC 6587
+// framing and the structured GELF / JSON-lines formats. Kept free of ESP-IDF
+// dependencies so the host benchmark can drive them against a local sink.
+
+// Bounded multi-producer, single-consumer queue of variable-length records
+// in caller-provided storage.
+//
+// A producer reserves its words with one compare-exchange on the head, copies
+// the record and publishes it by storing the header word (length plus a
+// ready bit) last, with release order. The consumer takes records strictly in
+// reservation order; one whose header is not published yet ends the current
+// drain and is picked up on the next one. Consumed words are zeroed before
+// the tail moves past them, so an unpublished header always reads as zero.
+//
+// Unlike LogRing this never overwrites: a record that does not fit is
+// dropped and counted, so the worker never has to resynchronise and the
+// drop count is exact.
+class SyslogQueue {
+public:
+    static constexpr size_t MAX_RECORD = 0xFFFF;
+
+    // Bytes of storage must be a power of two and at least 64.
+    static bool validCapacity(size_t bytes) {
+        return bytes >= 64 && bytes <= 0x10000000u && (bytes & (bytes - 1)) == 0;
+    }
+
+    // Use storage (4-byte aligned, validCapacity) for the queue. Call
+    // before any producer can see the queue; the storage must outlive it.
+    void attach(void *storage, size_t bytes);
+    bool attached() const { return _words.load(std::memory_order_acquire) != nullptr; }
+
+    // Any task. Returns false (and counts a drop) if the record does not
+    // fit. *wake is set when the consumer should be woken: the queue was
+    // empty or has just become half full.
+    bool push(const uint8_t *data, size_t len, bool *wake = nullptr);
+    // The same for a record made of two parts, stored back to back, so the
+    // producer needs no staging buffer.
+    bool push(const uint8_t *prefix, size_t prefix_len, const uint8_t *data, size_t len,
+              bool *wake = nullptr);
+
+    // Consumer only. Copies the next record into dst and returns its length;
+    // 0 if the queue is empty or the next record is still being written.
+    // A record longer than max is skipped and counted as dropped.
+    size_t pop(uint8_t *dst, size_t max);
+    // Consumer only: drop everything already published.
+    void discard();
+
+    size_t usedBytes() const;
+    size_t capacityBytes() const { return ((size_t)_mask + 1) * sizeof(uint32_t); }
+    uint32_t dropped() const { return _dropped.load(std::memory_order_relaxed); }
+
+private:
+    size_t consume(uint8_t *dst, size_t max);
+
+    std::atomic<std::atomic<uint32_t> *> _words{nullptr};
+    uint32_t _mask = 0;
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _dropped{0};
+};
+
+// Severity of an ESP-IDF level letter.
+int syslog_severity_from_level(char level);
+
+// Longest message body copied into a frame; longer ones are cut.
+static constexpr size_t SYSLOG_MSG_MAX = 384;
+// Upper bound of one frame as written by syslog_format_frame() and
+// syslog_format_structured().
+static constexpr size_t SYSLOG_FRAME_MAX = 512;
+
+// Write one RFC 5424 message (facility user) into out. timestamp is the
+// RFC 3339 time of the batch or "-". With octet_counted the message is
+// prefixed with its length as RFC 6587 section 3.4.1 requires for TCP and
+// TLS; otherwise it ends in a newline, as the UDP transport always sent it.
+// Returns the frame length, 0 if it does not fit.
+size_t syslog_format_frame(char *out, size_t cap, int severity, const char *tag,
+                           const char *msg, size_t msg_len, const char *hostname,
+                           const char *timestamp, bool octet_counted);
+
+// Wire format of the forwarder (syslog_config_t::format).
+enum syslog_format_t : uint8_t {
+    SYSLOG_FORMAT_RFC5424 = 0,
+    SYSLOG_FORMAT_GELF = 1,   // GELF 1.1
+    SYSLOG_FORMAT_JSON = 2,   // one JSON object per line
+};
+
+// One log line as captured on the logging task: nothing here is parsed back
+// out of the rendered text.
+struct SyslogFields {
+    int severity;           // RFC 5424 severity
+    char level;             // ESP-IDF level letter, 0 if the line has none
+    const char *tag;        // "" if the line has none
+    const char *task;       // "" if unknown
+    int core;               // -1 if unknown
+    uint32_t uptime_ms;     // capture time, milliseconds since boot
+    uint64_t epoch_ms;      // capture time, Unix milliseconds; 0 if the clock is not set
+};
+
+// Write one GELF or JSON-lines message into out. On a stream transport a
+// GELF message ends in a NUL byte, as Graylog's TCP input expects; a JSON
+// line always ends in a newline; a GELF datagram carries no terminator.
+// The message is cut at a character boundary so the frame stays within cap.
+// Returns the frame length, 0 if it does not fit.
+size_t syslog_format_structured(char *out, size_t cap, syslog_format_t format,
+                                const SyslogFields &fields, const char *msg,
+                                size_t msg_len, const char *hostname, bool stream);
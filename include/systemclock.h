@@ -23,10 +23,39 @@
 
 #pragma once
 
+#include <stdint.h>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "freertos/semphr.h"
 #include "rtcdriver.h"
 
+// Frequency discipline.
+//
+// Every correction handed to setTime()/adjustTime() doubles as a phase
+// sample: the offset left over since the previous sample, divided by the time
+// between them, measures the crystal's remaining frequency error. A scalar
+// Kalman filter folds these measurements into the drift estimate, weighting
+// each one by the caller's error bound and the length of the interval, so a
+// noisy NMEA sentence five minutes after the last one barely moves it while a
+// clean NTP sample after an hour dominates. The estimate is removed from the
+// clock by a small adjtime() slew every CLOCK_DISCIPLINE_TICK_MS, which keeps
+// the clock on time between syncs and through source outages (holdover).
+#define CLOCK_DISCIPLINE_TICK_MS 16000
+#define CLOCK_MAX_DRIFT_PPM 500.0
+// A-priori crystal tolerance (1 sigma) and random-walk wander of the drift.
+#define CLOCK_INITIAL_DRIFT_PPM 50.0
+#define CLOCK_DRIFT_WANDER_PPM2_PER_S 1e-4
+// Floor for the caller-supplied sample error; also used when none is given.
+#define CLOCK_MIN_SAMPLE_ERROR_US 500
+
+typedef struct
+{
+    double drift_ppm;  // estimated frequency error, positive = running fast
+    int64_t offset_us; // last measured offset (reference minus local clock)
+    int64_t error_us;  // estimated current error, -1 = never synced
+    bool locked;       // drift estimate is being applied
+} clock_discipline_t;
+
 class SystemClock
 {
 private:
@@ -34,6 +63,25 @@ private:
     struct timeval _lastSyncTime = { .tv_sec = 0, .tv_usec = 0 };
     portMUX_TYPE _syncTimeMux = portMUX_INITIALIZER_UNLOCKED;
     TaskHandle_t _tHandle = NULL;
+    volatile bool _running = false;
+    // Serializes read-modify-write sequences on the pending adjtime() delta
+    // and on the discipline state below.
+    SemaphoreHandle_t _adjustMutex = NULL;
+
+    // Discipline state. Written under _adjustMutex; _syncTimeMux guards the
+    // copies in and out, never the math on them.
+    double _drift_ppm = 0;
+    double _driftVar = CLOCK_INITIAL_DRIFT_PPM * CLOCK_INITIAL_DRIFT_PPM;
+    bool _locked = false;
+    int64_t _lastSample_us = 0; // esp_timer time of the last sample, 0 = none
+    int64_t _lastOffset_us = 0;
+    uint32_t _lastError_us = 0;
+    int64_t _lastTick_us = 0;
+    double _tickResidual_us = 0;
+
+    void discipline(int64_t offset_us, uint32_t error_us);
+    void disciplineTick();
+    void markSynced(const struct timeval *tv);
 
 public:
     SystemClock(Rtc *rtc);
@@ -41,8 +89,17 @@ public:
     void start();
     void stop();
 
-    void setTime(struct timeval *tv);
+    // Step the clock to an absolute time. `error_us` is the source's error
+    // bound for this sample and weights it in the drift estimate.
+    void setTime(struct timeval *tv, uint32_t error_us = 0);
+    // Slew the clock by `offset_us` with adjtime() instead of stepping it, so
+    // timestamps handed out in the meantime stay monotonic. Falls back to a
+    // step if the kernel refuses the adjustment.
+    void adjustTime(int64_t offset_us, uint32_t error_us = 0);
     struct timeval getTime();
     struct timeval getLastSyncTime();
     struct tm getLocalTime();
+    clock_discipline_t getDiscipline();
+
+    void _run();
 };
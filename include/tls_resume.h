@@ -0,0 +1,43 @@
+/*
+ *  tls_resume.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include "mbedtls/ssl.h"
+
+// TLS session resumption for the firmware's own mbedTLS clients (syslog TLS,
+// SMTP). Wrap every client handshake:
+//
+//   const int64_t start = tls_resume_begin(&ssl, host, port);
+//   ... mbedtls_ssl_handshake() loop ...
+//   tls_resume_end(&ssl, host, port, start, handshake_succeeded);
+//
+// begin() offers the session cached for host:port, if any. end() stores the
+// session of a successful handshake for the next connection, drops the
+// cached one after a failure and records the handshake duration and whether
+// it was resumed in the hbrfeth_tls_* metrics. Any task; calls are
+// serialised internally.
+int64_t tls_resume_begin(mbedtls_ssl_context *ssl, const char *host, uint16_t port);
+void tls_resume_end(mbedtls_ssl_context *ssl, const char *host, uint16_t port,
+                    int64_t start_us, bool ok);
@@ -0,0 +1,83 @@
+/*
+ *  tls_session_cache.h is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Serialized TLS client sessions, keyed by server name and port, so the next
+// connection to the same server can offer the session ID / ticket and get an
+// abbreviated handshake instead of a full one.
+//
+// A session is only ever offered to the host:port it was negotiated with:
+// resumption skips certificate verification, which is sound only because the
+// original handshake verified this very name. The table is small and fixed;
+// each entry owns one malloc'd blob of exactly the serialized size, freed
+// when it is replaced, evicted (least recently stored), expired or
+// forgotten.
+//
+// Not thread-safe: the mbedTLS glue (tls_resume.h) serialises callers.
+class TlsSessionCache {
+public:
+    static constexpr size_t SLOTS = 4;
+    static constexpr size_t HOST_MAX = 64;
+    // Serialized sessions carry the peer certificate
+    // (CONFIG_MBEDTLS_SSL_KEEP_PEER_CERTIFICATE); larger ones are not kept.
+    static constexpr size_t SESSION_MAX = 2560;
+    // Servers typically honour tickets for hours; a session older than this
+    // is dropped rather than kept in RAM on the chance.
+    static constexpr int64_t MAX_AGE_US = 60LL * 60 * 1000 * 1000;
+
+    ~TlsSessionCache() { clear(); }
+
+    // The blob stored for host:port, or nullptr if there is none or it has
+    // expired. Valid until the next call that modifies the cache.
+    const uint8_t *find(const char *host, uint16_t port, int64_t now_us, size_t *len);
+
+    // Take ownership of blob (from malloc) as the session for host:port.
+    // Returns false, and frees blob, if it cannot be kept.
+    bool adopt(const char *host, uint16_t port, int64_t now_us, uint8_t *blob, size_t len);
+
+    // Drop the session for host:port, e.g. after a handshake that offered
+    // it failed.
+    void forget(const char *host, uint16_t port);
+    void clear();
+
+    size_t entries() const;
+    size_t bytes() const;
+
+private:
+    struct Slot {
+        char host[HOST_MAX] = {};
+        uint16_t port = 0;
+        int64_t stored_us = 0;
+        uint8_t *blob = nullptr;
+        size_t len = 0;
+    };
+
+    Slot *slotFor(const char *host, uint16_t port);
+    static void release(Slot &slot);
+
+    Slot _slots[SLOTS];
+};
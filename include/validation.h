@@ -34,6 +34,7 @@
 #define MIN_DCF_OFFSET -60000
 #define MAX_DCF_OFFSET 60000
 #define MAX_NTP_SERVER_LENGTH 64
+#define MAX_NTP_SERVERS 4
 #define MAX_SERVER_ADDRESS_LENGTH 128
 #define MIN_ADMIN_PASSWORD_LENGTH 8
 #define MAX_ADMIN_PASSWORD_LENGTH 32
@@ -46,7 +47,8 @@ bool validateLEDBrightness(int brightness);
 bool validateGpsBaudrate(int baudrate);
 bool validateDcfOffset(int offset);
 bool validateAdminPassword(const char *password);
-// NTP server validation (hostname, IPv4, IPv6, with optional port)
+// NTP server validation: comma-separated list of up to MAX_NTP_SERVERS
+// entries (hostname, IPv4, IPv6, each with optional port)
 bool validateNtpServer(const char *ntpServer);
 
 // Port validation
@@ -69,3 +69,15 @@ esp_err_t webui_storage_update_finish();
 
 /** Abort an active update and invalidate the partial filesystem image. */
 void webui_storage_update_abort();
+
+/**
+ * Run fn while the partition is mounted and no image update is in progress,
+ * so a subsystem can keep its own files beside the WebUI (the log journal).
+ * fn gets the mount point and the free filesystem bytes. The storage lock is
+ * held while it runs, which holds off an image update; keep it short.
+ * Returns false without calling fn otherwise. An image update erases such
+ * files along with the partition.
+ */
+bool webui_storage_with_files(void (*fn)(const char *basePath, size_t freeBytes,
+                                         void *context),
+                              void *context);
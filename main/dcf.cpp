@@ -22,7 +22,9 @@
  */
 
 #include "dcf.h"
+#include "dcf_decoder.h"
 #include <sys/time.h>
+#include <time.h>
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
@@ -34,11 +36,7 @@
 static SystemClock *_clk;
 static Settings *_settings;
 
-static uint64_t _buffer = 0;
-static uint8_t _bufferPos = 0;
-
-static int64_t _previousSecondMark = 0;
-static int64_t _secondMark = 0;
+static DcfDecoder _decoder;
 
 static QueueHandle_t _flank_queue;
 static TaskHandle_t _queueHandlerTask;
@@ -51,76 +49,21 @@ typedef struct
     int state;
 } flank_event_t;
 
-inline uint8_t bcd2bin(uint8_t val)
-{
-    return val - 6 * (val >> 4);
-}
-
 DCF::DCF(Settings *settings, SystemClock *clk)
 {
     _settings = settings;
     _clk = clk;
 }
 
-bool checkParity(uint8_t start, uint8_t end)
-{
-    int parity = 0;
-
-    for (int pos = start; pos <= end; pos++)
-    {
-        parity ^= (int)((_buffer >> pos) & 1);
-    }
-
-    return parity == 0;
-}
-
-int is_leap(unsigned int y)
-{
-    return (y % 4) == 0 && ((y % 100) != 0 || ((y + 1900) % 400) == 0);
-}
-
-time_t dcf2epoch(struct tm *dcf_tm, uint8_t tz)
-{
-    static const unsigned ndays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
-
-    time_t res = 0;
-    int i;
-
-    for (i = 70; i < dcf_tm->tm_year; ++i)
-    {
-        res += is_leap(i) ? 366 : 365;
-    }
-
-    for (i = 0; i < dcf_tm->tm_mon; ++i)
-    {
-        res += ndays[i];
-        if (i == 1 && is_leap(dcf_tm->tm_year))
-        {
-            res++;
-        }
-    }
-
-    res += dcf_tm->tm_mday - 1;
-    res *= 24;
-    res += dcf_tm->tm_hour;
-    res -= tz ^ 3;
-    res *= 60;
-    res += dcf_tm->tm_min;
-    res *= 60;
-
-    return res;
-}
-
 // GPIO 34-39 (including DCF_PIN) are input-only on the ESP32 and have no
 // internal pull-up/pull-down; gpio_config() cannot compensate. Without a
 // receiver physically attached (or on a wiring fault), ANYEDGE on a floating
 // input can free-run at a rate bound only by pin capacitance/noise, far above
 // any real DCF77 signal. A genuine DCF77 edge never repeats faster than the
-// shortest pulse validated in handlePinChange() (80 ms); gate the ISR to a
-// fraction of that so a floating/storming pin cannot monopolize interrupt
-// time on this core, while every legitimate edge still passes through
-// untouched.
-static constexpr int64_t DCF_MIN_ISR_INTERVAL_US = 5000; // 5 ms, well under the 80 ms floor
+// shortest carrier reduction (100 ms); gate the ISR to a fraction of that so
+// a floating/storming pin cannot monopolize interrupt time on this core,
+// while every legitimate edge still passes through untouched.
+static constexpr int64_t DCF_MIN_ISR_INTERVAL_US = 5000; // 5 ms, well under the 100 ms floor
 static volatile int64_t _last_isr_time = 0;
 
 static void IRAM_ATTR onPinChange(void *arg)
@@ -150,105 +93,30 @@ static void IRAM_ATTR onPinChange(void *arg)
 
 static void handlePinChange(int64_t flankTime, int state)
 {
-    if (state)
-    {
-        // end of pulse
-        int64_t secondLength = _secondMark - _previousSecondMark;
-        int64_t pulseLength = flankTime - _secondMark;
-
-        uint64_t pulseValue;
-        if (pulseLength > 80000 && pulseLength < 135000)
-        {
-            pulseValue = 0;
-        }
-        else if (pulseLength > 180000 && pulseLength < 235000)
-        {
-            pulseValue = 1;
-        }
-        else
-        {
-            ESP_LOGE(TAG, "Invalid pulse: %llu %llu", secondLength / 1000ULL, pulseLength / 1000ULL);
-            return; // invalid pulse length
-        }
-
-        if (secondLength > 970000 && secondLength < 1035000)
-        {
-            if (_bufferPos < 59)
-            {
-                _bufferPos++;
-                _buffer |= (pulseValue << _bufferPos);
-            }
-        }
-        else if (secondLength > 1970000 && secondLength < 2035000)
-        {
-            uint8_t timezone = (uint8_t)((_buffer >> 17) & 3);
-
-            if (_bufferPos < 58 || _bufferPos > 59 || (int)(_buffer & 1) != 0 || (int)((_buffer >> 20) & 1) != 1 || timezone == 0 || timezone == 3 || !checkParity(21, 28) || !checkParity(29, 35) || !checkParity(36, 58))
-            {
-                ESP_LOGE(TAG, "Received invalid frame");
-            }
-            else
-            {
-                struct tm dcf_tm;
-                dcf_tm.tm_year = 100 + bcd2bin((int)((_buffer >> 50) & 0xff));
-                dcf_tm.tm_mon = bcd2bin((int)((_buffer >> 45) & 0x1f)) - 1;
-                dcf_tm.tm_mday = bcd2bin((int)((_buffer >> 36) & 0x3f));
-                dcf_tm.tm_hour = bcd2bin((int)((_buffer >> 29) & 0x3f));
-                dcf_tm.tm_min = bcd2bin((int)((_buffer >> 21) & 0x7f));
-                dcf_tm.tm_sec = 0;
-
-                // bcd2bin() is a pseudo-BCD decode with no defined behavior for
-                // non-BCD nibbles (e.g. bcd2bin(0x1f)=25), and the parity checks
-                // above only cover even-parity over bit ranges, not the decoded
-                // field's plausible value range. Without this, a noisy/malformed
-                // signal that happens to pass parity can produce tm_mon up to 24,
-                // and dcf2epoch()'s "for (i=0; i<tm_mon; ++i) res += ndays[i];"
-                // would then read past the 12-element ndays[] array.
-                if (dcf_tm.tm_mon < 0 || dcf_tm.tm_mon > 11 ||
-                    dcf_tm.tm_mday < 1 || dcf_tm.tm_mday > 31 ||
-                    dcf_tm.tm_hour < 0 || dcf_tm.tm_hour > 23 ||
-                    dcf_tm.tm_min < 0 || dcf_tm.tm_min > 59)
-                {
-                    ESP_LOGE(TAG, "Received frame with out-of-range field(s): mon=%d mday=%d hour=%d min=%d",
-                             dcf_tm.tm_mon, dcf_tm.tm_mday, dcf_tm.tm_hour, dcf_tm.tm_min);
-                }
-                else
-                {
-                    struct timeval tv;
-                    tv.tv_sec = dcf2epoch(&dcf_tm, timezone);
-                    int64_t usec = esp_timer_get_time() - _secondMark + _settings->getDcfOffset();
-                    while (usec >= 1000000)
-                    {
-                        tv.tv_sec++;
-                        usec -= 1000000;
-                    }
-                    while (usec < 0)
-                    {
-                        tv.tv_sec--;
-                        usec += 1000000;
-                    }
-                    tv.tv_usec = (suseconds_t)usec;
-
-                    ESP_LOGI(TAG, "Updated time to %02d-%02d-%02d %02d:%02d:%02d.%06ld %s", dcf_tm.tm_year + 1900, dcf_tm.tm_mon + 1, dcf_tm.tm_mday, dcf_tm.tm_hour, dcf_tm.tm_min, dcf_tm.tm_sec, (long)tv.tv_usec, timezone == 2 ? "CET" : "CEST");
-                    _clk->setTime(&tv);
-                }
-            }
+    dcf_time_t decoded;
+    if (!_decoder.edge(flankTime, state, &decoded))
+        return;
 
-            _buffer = pulseValue;
-            _bufferPos = 0;
-        }
-        else
-        {
-            ESP_LOGE(TAG, "Invalid second: %llu %llu", secondLength / 1000ULL, pulseLength / 1000ULL);
-            return; // invalid second length
-        }
+    struct timeval tv;
+    tv.tv_sec = decoded.epoch;
+    int64_t usec = esp_timer_get_time() - decoded.mark_us + _settings->getDcfOffset();
+    while (usec >= 1000000)
+    {
+        tv.tv_sec++;
+        usec -= 1000000;
     }
-    else
+    while (usec < 0)
     {
-        // start of pulse
-        _previousSecondMark = _secondMark;
-        _secondMark = flankTime;
+        tv.tv_sec--;
+        usec += 1000000;
     }
+    tv.tv_usec = (suseconds_t)usec;
+
+    struct tm dcf_tm;
+    time_t local = decoded.epoch + (decoded.cest ? 7200 : 3600);
+    gmtime_r(&local, &dcf_tm);
+    ESP_LOGI(TAG, "Updated time to %02d-%02d-%02d %02d:%02d:%02d.%06ld %s", dcf_tm.tm_year + 1900, dcf_tm.tm_mon + 1, dcf_tm.tm_mday, dcf_tm.tm_hour, dcf_tm.tm_min, dcf_tm.tm_sec, (long)tv.tv_usec, decoded.cest ? "CEST" : "CET");
+    _clk->setTime(&tv, DCF_EDGE_ERROR_US);
 }
 
 static void flankEventQueueHandler(void *arg)
@@ -269,6 +137,7 @@ static void flankEventQueueHandler(void *arg)
 void DCF::start()
 {
     if (_queueHandlerTask || _flank_queue) return;
+    _decoder.reset();
     _flank_queue = xQueueCreate(8, sizeof(flank_event_t));
     if (!_flank_queue) {
         ESP_LOGE(TAG, "Failed to create DCF event queue");
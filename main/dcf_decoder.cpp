@@ -0,0 +1,374 @@
+/*
+ *  dcf_decoder.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "dcf_decoder.h"
+#include <string.h>
+
+#define DCF_BITS 59
+
+// Signed carrier-reduction likelihood: -100 for a clean 100 ms "0", +100 for
+// a clean 200 ms "1", 0 (erasure) for anything a receiver cannot produce.
+static int8_t pulseLikelihood(int64_t lowTime_us)
+{
+    int64_t ms = lowTime_us / 1000;
+    if (ms < 40 || ms > 280)
+        return 0;
+    int64_t llr = (ms - 150) * 2;
+    if (llr > 100) llr = 100;
+    if (llr < -100) llr = -100;
+    return (int8_t)llr;
+}
+
+// Proleptic Gregorian calendar conversions (days relative to 1970-01-01).
+static int64_t daysFromCivil(int y, int m, int d)
+{
+    y -= m <= 2;
+    int64_t era = (y >= 0 ? y : y - 399) / 400;
+    int64_t yoe = y - era * 400;
+    int64_t doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    int64_t doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays(int64_t z, int *y, int *m, int *d)
+{
+    z += 719468;
+    int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+    int64_t doe = z - era * 146097;
+    int64_t yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    int64_t doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    int64_t mp = (5 * doy + 2) / 153;
+    *d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    *m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    *y = (int)(yoe + era * 400 + (*m <= 2));
+}
+
+static void putBcd(uint8_t *bits, int first, int count, int value)
+{
+    int bcd = (value / 10) << 4 | (value % 10);
+    for (int i = 0; i < count; i++)
+        bits[first + i] = (bcd >> i) & 1;
+}
+
+static int getBcd(const int8_t *llr, int first, int count)
+{
+    int bcd = 0;
+    for (int i = 0; i < count; i++)
+        if (llr[first + i] > 0)
+            bcd |= 1 << i;
+    if ((bcd & 0xf) > 9)
+        return -1;
+    return (bcd >> 4) * 10 + (bcd & 0xf);
+}
+
+static uint8_t parity(const uint8_t *bits, int first, int last)
+{
+    uint8_t p = 0;
+    for (int i = first; i <= last; i++)
+        p ^= bits[i];
+    return p;
+}
+
+// The frame transmitted during the minute before `epoch` (UTC).
+static void encodeFrame(time_t epoch, bool cest, uint8_t *bits)
+{
+    int64_t local = (int64_t)epoch + (cest ? 7200 : 3600);
+    int64_t days = local >= 0 ? local / 86400 : (local - 86399) / 86400;
+    int64_t secs = local - days * 86400;
+    int y, m, d;
+    civilFromDays(days, &y, &m, &d);
+
+    memset(bits, 0, DCF_BITS);
+    bits[17] = cest ? 1 : 0;
+    bits[18] = cest ? 0 : 1;
+    bits[20] = 1;
+    putBcd(bits, 21, 7, (int)(secs / 60 % 60));
+    bits[28] = parity(bits, 21, 27);
+    putBcd(bits, 29, 6, (int)(secs / 3600));
+    bits[35] = parity(bits, 29, 34);
+    putBcd(bits, 36, 6, d);
+    putBcd(bits, 42, 3, (int)((days % 7 + 10) % 7) + 1); // 1970-01-01 was a Thursday
+    putBcd(bits, 45, 5, m);
+    putBcd(bits, 50, 8, y % 100);
+    bits[58] = parity(bits, 36, 57);
+}
+
+// Hard-decision decode of the time fields. Minute and the hour/date fields may
+// come from different (time-aligned) likelihood frames.
+static bool decodeFrame(const int8_t *minuteLlr, const int8_t *dateLlr, time_t *epoch, bool *cest)
+{
+    int tz = dateLlr[17] - dateLlr[18];
+    if (tz == 0)
+        return false;
+    *cest = tz > 0;
+
+    int minute = getBcd(minuteLlr, 21, 7);
+    int hour = getBcd(dateLlr, 29, 6);
+    int day = getBcd(dateLlr, 36, 6);
+    int month = getBcd(dateLlr, 45, 5);
+    int year = getBcd(dateLlr, 50, 8);
+    if (minute < 0 || minute > 59 || hour < 0 || hour > 23 || day < 1 || day > 31 ||
+        month < 1 || month > 12 || year < 0)
+        return false;
+
+    int64_t days = daysFromCivil(2000 + year, month, day);
+    int cy, cm, cd;
+    civilFromDays(days, &cy, &cm, &cd);
+    if (cm != month || cd != day)
+        return false; // 31 April and friends
+
+    *epoch = (time_t)(days * 86400 + hour * 3600 + minute * 60 - (*cest ? 7200 : 3600));
+    return true;
+}
+
+void DcfDecoder::reset()
+{
+    *this = DcfDecoder();
+}
+
+void DcfDecoder::anchor(int64_t t_us)
+{
+    memset(_llr, 0, sizeof(_llr));
+    memset(_markerVotes, 0, sizeof(_markerVotes));
+    // Keep slot numbers monotonic but far enough ahead that nothing from
+    // before the new grid can be mistaken for a slot on it.
+    _second += DCF_RING_SECONDS;
+    _anchorSlot = _second;
+    _anchored = true;
+    _synced = false;
+    openSlot(_second, t_us);
+}
+
+void DcfDecoder::integrateLow(int64_t until_us)
+{
+    if (!_slotOpen || _level != 0)
+        return;
+    int64_t windowEnd = _slotStart_us + DCF_PULSE_WINDOW_US;
+    int64_t from = _levelSince_us > _slotStart_us ? _levelSince_us : _slotStart_us;
+    int64_t to = until_us < windowEnd ? until_us : windowEnd;
+    if (to > from)
+        _lowTime_us += to - from;
+}
+
+void DcfDecoder::finishSlot()
+{
+    if (!_slotOpen)
+        return;
+    integrateLow(_slotStart_us + DCF_PULSE_WINDOW_US);
+    _llr[_second % DCF_RING_SECONDS] = pulseLikelihood(_lowTime_us);
+    _slotOpen = false;
+}
+
+void DcfDecoder::openSlot(uint32_t slot, int64_t t_us)
+{
+    // Seconds skipped on the way carry no pulse: erasures, and minute marker
+    // candidates.
+    for (uint32_t s = _second + 1; s < slot; s++) {
+        _llr[s % DCF_RING_SECONDS] = 0;
+        uint8_t &votes = _markerVotes[s % 60];
+        if (votes < 8) votes += 2;
+    }
+    uint8_t &votes = _markerVotes[slot % 60];
+    if (votes > 0) votes--;
+
+    _second = slot;
+    _lastMark_us = t_us;
+    _llr[slot % DCF_RING_SECONDS] = 0;
+    _slotOpen = true;
+    _slotStart_us = t_us;
+    _lowTime_us = 0;
+}
+
+// Slot phase (mod 60) of the missing 59th second, or -1 while undecided.
+int DcfDecoder::minutePhase()
+{
+    int best = -1;
+    bool unique = false;
+    for (int p = 0; p < 60; p++) {
+        if (_markerVotes[p] == 0)
+            continue;
+        if (best < 0 || _markerVotes[p] > _markerVotes[best]) {
+            best = p;
+            unique = true;
+        } else if (_markerVotes[p] == _markerVotes[best]) {
+            unique = false;
+        }
+    }
+    return unique ? best : -1;
+}
+
+bool DcfDecoder::edge(int64_t t_us, int state, dcf_time_t *out)
+{
+    if (_slotOpen && t_us > _slotStart_us + DCF_PULSE_WINDOW_US)
+        finishSlot();
+
+    if (state) {
+        integrateLow(t_us);
+        _level = 1;
+        _levelSince_us = t_us;
+        return false;
+    }
+
+    integrateLow(t_us);
+    _level = 0;
+    _levelSince_us = t_us;
+
+    if (!_anchored) {
+        anchor(t_us);
+        return false;
+    }
+
+    int64_t d = t_us - _lastMark_us;
+    int64_t k = (d + 500000) / 1000000;
+    int64_t err = d - k * 1000000;
+    if (k < 1 || err < -DCF_SLOT_TOLERANCE_US || err > DCF_SLOT_TOLERANCE_US) {
+        // Off the grid: a glitch, or the grid itself is wrong.
+        if (d > DCF_REANCHOR_US) {
+            finishSlot();
+            anchor(t_us);
+        }
+        return false;
+    }
+    if (k > DCF_MAX_GAP_SECONDS) {
+        finishSlot();
+        anchor(t_us);
+        return false;
+    }
+
+    finishSlot();
+    uint32_t previous = _second;
+    uint32_t slot = _second + (uint32_t)k;
+    openSlot(slot, t_us);
+
+    int phase = minutePhase();
+    if (phase < 0)
+        return false;
+    // Second 0 of a minute crossed by this mark?
+    for (uint32_t s = previous + 1; s <= slot; s++) {
+        if ((int)(s % 60) == (phase + 1) % 60)
+            return evaluate(s, t_us - (int64_t)(slot - s) * 1000000, out);
+    }
+    return false;
+}
+
+bool DcfDecoder::evaluate(uint32_t slot0, int64_t mark_us, dcf_time_t *out)
+{
+    static const uint8_t required[] = {17, 18, 20};
+    int8_t frames[DCF_VOTE_MINUTES][DCF_BITS];
+    int8_t summed[DCF_BITS];
+    bool present[DCF_VOTE_MINUTES];
+
+    memset(summed, 0, sizeof(summed));
+    for (int m = 0; m < DCF_VOTE_MINUTES; m++) {
+        present[m] = false;
+        for (int b = 0; b < DCF_BITS; b++) {
+            int64_t slot = (int64_t)slot0 - 60 * (m + 1) + b;
+            int8_t v = slot >= (int64_t)_anchorSlot ? _llr[slot % DCF_RING_SECONDS] : 0;
+            frames[m][b] = v;
+            if (v != 0) present[m] = true;
+            int s = summed[b] + v;
+            summed[b] = (int8_t)(s > 127 ? 127 : s < -127 ? -127 : s);
+        }
+    }
+    if (!present[0])
+        return false;
+
+    // Candidates: each frame on its own, each frame's minute with the summed
+    // hour/date fields, and the free-running continuation of the last sync.
+    time_t candidates[2 * DCF_VOTE_MINUTES + 1];
+    bool candidateCest[2 * DCF_VOTE_MINUTES + 1];
+    int count = 0;
+    for (int m = 0; m < DCF_VOTE_MINUTES; m++) {
+        if (!present[m])
+            continue;
+        time_t epoch;
+        bool cest;
+        if (decodeFrame(frames[m], frames[m], &epoch, &cest)) {
+            candidates[count] = epoch + 60 * m;
+            candidateCest[count++] = cest;
+        }
+        if (decodeFrame(frames[m], summed, &epoch, &cest)) {
+            candidates[count] = epoch + 60 * m;
+            candidateCest[count++] = cest;
+        }
+    }
+    if (_synced && (slot0 - _lastSyncSlot) % 60 == 0) {
+        candidates[count] = _lastEpoch + (time_t)(slot0 - _lastSyncSlot);
+        candidateCest[count++] = frames[0][17] - frames[0][18] > 0;
+    }
+
+    int best = -1;
+    int64_t bestScore = 0;
+    bool ambiguous = false;
+    for (int c = 0; c < count; c++) {
+        bool duplicate = false;
+        for (int o = 0; o < c; o++)
+            if (candidates[o] == candidates[c]) duplicate = true;
+        if (duplicate)
+            continue;
+
+        int support[DCF_BITS] = {};
+        int64_t score = 0;
+        for (int m = 0; m < DCF_VOTE_MINUTES; m++) {
+            if (!present[m])
+                continue;
+            // Each frame is judged in the zone it announces itself, so votes
+            // stay consistent across a daylight saving switch.
+            int tz = frames[m][17] - frames[m][18];
+            bool cest = tz != 0 ? tz > 0 : candidateCest[c];
+            uint8_t expected[DCF_BITS];
+            encodeFrame(candidates[c] - 60 * m, cest, expected);
+            for (int b = 0; b < DCF_BITS; b++) {
+                int a = expected[b] ? frames[m][b] : -frames[m][b];
+                support[b] += a;
+                score += a;
+            }
+        }
+
+        bool accepted = true;
+        for (uint8_t b : required)
+            if (support[b] < DCF_MIN_BIT_SUPPORT) accepted = false;
+        for (int b = 21; b < DCF_BITS; b++)
+            if (support[b] < DCF_MIN_BIT_SUPPORT) accepted = false;
+        if (!accepted)
+            continue;
+
+        if (best >= 0)
+            ambiguous = true;
+        if (best < 0 || score > bestScore) {
+            best = c;
+            bestScore = score;
+        }
+    }
+    if (best < 0 || ambiguous)
+        return false;
+
+    _synced = true;
+    _lastEpoch = candidates[best];
+    _lastSyncSlot = slot0;
+
+    out->epoch = candidates[best];
+    out->mark_us = mark_us;
+    out->cest = candidateCest[best];
+    return true;
+}
@@ -0,0 +1,86 @@
+/*
+ *  duty_cycle.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "duty_cycle.h"
+
+void DutyCycleBudget::configure(uint8_t warn_percent, uint8_t alarm_percent) {
+    _warn = warn_percent;
+    _alarm = alarm_percent;
+    _level = LEVEL_OK;   // re-evaluated against the new thresholds
+}
+
+void DutyCycleBudget::advance(uint32_t now_s) {
+    const uint32_t tag = now_s / BUCKET_S + 1;
+    if (_tag == 0) {
+        _tag = tag;
+        return;
+    }
+    if (tag <= _tag) return;
+    const uint32_t steps = tag - _tag < BUCKETS ? tag - _tag : BUCKETS;
+    for (uint32_t i = 1; i <= steps; i++) {
+        uint32_t &bucket = _buckets[(_tag + i) % BUCKETS];
+        _total_us -= bucket;
+        bucket = 0;
+    }
+    _tag = tag;
+}
+
+DutyCycleBudget::Level DutyCycleBudget::levelFor(uint32_t percent) const {
+    if (_alarm && percent >= _alarm) return LEVEL_ALARM;
+    if (_warn && percent >= _warn) return LEVEL_WARN;
+    return LEVEL_OK;
+}
+
+DutyCycleBudget::Level DutyCycleBudget::add(uint32_t now_s, uint32_t airtime_us) {
+    advance(now_s);
+    _buckets[_tag % BUCKETS] += airtime_us;
+    _total_us += airtime_us;
+    const Level level = levelFor(usedPercent(now_s));
+    if (level <= _level) return LEVEL_OK;
+    _level = level;
+    return level;
+}
+
+uint32_t DutyCycleBudget::usedUs(uint32_t now_s) {
+    advance(now_s);
+    return _total_us;
+}
+
+uint32_t DutyCycleBudget::usedPercent(uint32_t now_s) {
+    const uint32_t percent = (uint32_t)((uint64_t)usedUs(now_s) * 100 / BUDGET_US);
+    const Level relaxed = levelFor(percent + REARM_MARGIN);
+    if (relaxed < _level) _level = relaxed;
+    return percent;
+}
+
+bool DutyCycleBudget::isTransmission(const HMFrame &frame) {
+    switch (frame.destination) {
+        case HM_DST_TRX:
+        case HM_DST_HMIP:
+        case HM_DST_LLMAC:
+            return frame.data_len >= MIN_TELEGRAM_BYTES;
+        default:
+            return false;
+    }
+}
@@ -26,6 +26,9 @@
 #include "crash_blackbox.h"
 #include "settings.h"
 #include "metrics.h"
+#include "tls_resume.h"
+#include "notify_digest.h"
+#include "json_writer.h"
 #include "esp_log.h"
 #include "esp_timer.h"
 #include "esp_http_client.h"
@@ -91,10 +94,21 @@ static MetricsCounter g_failed_total("hbrfeth_notify_failed_total",
                                      "Notification delivery attempts that failed");
 static MetricsCounter g_suppressed_total("hbrfeth_notify_suppressed_total",
                                          "Events suppressed by cooldown window");
+// Handshakes per delivered event is handshakes / events_delivered: digests
+// and kept-alive connections both bring it down.
+static MetricsCounter g_handshakes_total("hbrfeth_notify_handshakes_total",
+                                         "Connections opened to deliver notifications");
+static MetricsCounter g_reused_total("hbrfeth_notify_connection_reuses_total",
+                                     "Notification requests sent on a kept-alive connection");
+static MetricsCounter g_events_delivered_total("hbrfeth_notify_events_delivered_total",
+                                               "Events carried by delivered notifications");
 
 static constexpr int EVENT_HTTP_TOTAL_TIMEOUT_MS = 12000;
 static constexpr int SMTP_TOTAL_TIMEOUT_MS = 12000;
 static constexpr int EVENT_HTTP_ASYNC_RETRY_MS = 10;
+static constexpr int EVENT_HTTP_KEEPALIVE_MS = 10000;
+static constexpr int EVENT_HTTP_DRAIN_MAX = 4096;
+static constexpr size_t DIGEST_BODY_MAX = 2048;
 
 static int remaining_deadline_ms(int64_t deadline_us)
 {
@@ -132,9 +146,10 @@ static void event_http_retry_delay(int64_t deadline_us)
 // read an arbitrarily large/slow response body and could keep the worker alive
 // beyond events_stop()'s lifecycle bound. HTTPS uses IDF's asynchronous
 // transport; every retry is checked against one absolute request deadline.
+// *sent is set once the whole request has been written.
 static esp_err_t post_event_http(esp_http_client_handle_t client,
                                  const char *body, size_t body_len,
-                                 int64_t deadline_us)
+                                 int64_t deadline_us, bool *sent)
 {
     if (!client || !body || body_len > static_cast<size_t>(INT32_MAX)) {
         return ESP_ERR_INVALID_ARG;
@@ -177,6 +192,7 @@ static esp_err_t post_event_http(esp_http_client_handle_t client,
         }
         return ESP_FAIL;
     }
+    *sent = true;
 
     for (;;) {
         if (!prepare_event_http_step(client, deadline_us)) {
@@ -278,6 +294,8 @@ static const EventMeta &meta_for(Event e)
     static const EventMeta m_ccu_disc = {"ccu_disconnected",
                                          "CCU disconnected from the radio interface"};
     static const EventMeta m_low_heap = {"low_heap", "Free heap dropped below the safe threshold"};
+    static const EventMeta m_duty_cycle = {"duty_cycle",
+                                           "Radio transmit duty cycle budget running low"};
     static const EventMeta m_test         = { "test",               "Test notification from HB-RF-ETH-ng" };
     static const EventMeta m_unknown      = { "unknown",            "Unknown event" };
 
@@ -296,6 +314,8 @@ static const EventMeta &meta_for(Event e)
             return m_ccu_disc;
         case EVENT_LOW_HEAP:
             return m_low_heap;
+        case EVENT_DUTY_CYCLE:
+            return m_duty_cycle;
         case EVENT_TEST:               return m_test;
         default:                       return m_unknown;
     }
@@ -326,6 +346,8 @@ uint16_t events_mask_bit(Event e)
             return NOTIFY_EVENT_CCU_DISCONNECTED;
         case EVENT_LOW_HEAP:
             return NOTIFY_EVENT_LOW_HEAP;
+        case EVENT_DUTY_CYCLE:
+            return NOTIFY_EVENT_DUTY_CYCLE;
         // EVENT_TEST and anything unknown are not filterable. Returning 0
         // makes the worker deliver them unconditionally, which is what the
         // diagnostic button depends on.
@@ -338,37 +360,109 @@ uint16_t events_mask_bit(Event e)
 // Channel senders.
 // ---------------------------------------------------------------------------
 
-// --- Webhook ---
-static bool send_webhook(const EventEntry &e, const EventMeta &m,
-                         const notify_config_t &config)
+// A notification as the channel senders deliver it: one event, or the
+// digest of several.
+struct NotifyMessage {
+    const char *key;              // stable wire key; "digest" for a digest
+    const char *title;            // event message, or the digest headline
+    const char *detail;
+    int64_t timestamp;
+    const NotifyDigest *digest;   // its entries, NULL for a single event
+};
+
+static const char *device_name()
 {
-    if (config.webhook_url[0] == '\0') {
-        return false;
-    }
-    if (!is_https_url(config.webhook_url)) {
-        ESP_LOGE(TAG, "Rejected non-HTTPS webhook URL");
-        return false;
+    Settings *s = monitoring_get_settings();
+    if (s && s->getHostname() && s->getHostname()[0]) return s->getHostname();
+    return "hb-rf-eth-ng";
+}
+
+// "Ethernet link went down (3x): eth0" — one line per digest entry.
+static void format_digest_line(char *out, size_t cap, const NotifyDigest::Entry &entry)
+{
+    const EventMeta &m = meta_for(static_cast<Event>(entry.id));
+    char count[16] = "";
+    if (entry.count > 1) snprintf(count, sizeof(count), " (%ux)", (unsigned)entry.count);
+    snprintf(out, cap, "%s%s%s%s", m.default_msg, count,
+             entry.detail[0] ? ": " : "", entry.detail);
+}
+
+// --- Kept-alive HTTPS connections ---
+// The webhook and Telegram senders each keep their client open after a
+// delivery and reuse it if the next one comes within the idle window: a
+// burst of notifications then costs one TLS handshake per channel instead
+// of one per notification. With the dynamic mbedTLS buffers an idle
+// connection holds only the session state, a few KiB.
+//
+// Sessions are only touched under g_net_fetch_mutex, so the gate still
+// admits one TLS context at a time: every other holder closes them with
+// events_close_idle_connections() before its own handshake. The worker
+// expires idle ones only if the gate is free; a busy gate means its holder
+// has closed them already.
+struct EventHttpSession {
+    esp_http_client_handle_t client;
+    NotifyKeepAlive keep_alive;
+};
+static EventHttpSession s_webhook_session = {NULL, NotifyKeepAlive(EVENT_HTTP_KEEPALIVE_MS * 1000LL)};
+static EventHttpSession s_telegram_session = {NULL, NotifyKeepAlive(EVENT_HTTP_KEEPALIVE_MS * 1000LL)};
+
+static void close_http_session(EventHttpSession *session)
+{
+    if (session->client) {
+        esp_http_client_close(session->client);
+        esp_http_client_cleanup(session->client);
+        session->client = NULL;
     }
+    session->keep_alive.reset();
+}
 
-    // Heap-allocate body so we can host it through the http client lifecycle.
-    char *body = (char *)malloc(512);
-    if (!body) return false;
+static void expire_http_sessions(int64_t now_us, bool force)
+{
+    if (!g_net_fetch_mutex || xSemaphoreTake(g_net_fetch_mutex, 0) != pdTRUE) return;
+    for (EventHttpSession *session : {&s_webhook_session, &s_telegram_session}) {
+        if (session->client && (force || session->keep_alive.expired(now_us))) {
+            close_http_session(session);
+        }
+    }
+    xSemaphoreGive(g_net_fetch_mutex);
+}
 
-    const char *host = "hb-rf-eth-ng";
-    Settings *s = monitoring_get_settings();
-    if (s && s->getHostname() && s->getHostname()[0]) host = s->getHostname();
+void events_close_idle_connections(void)
+{
+    close_http_session(&s_webhook_session);
+    close_http_session(&s_telegram_session);
+}
 
-    int n = snprintf(body, 512,
-        "{\"event\":\"%s\",\"device\":\"%s\",\"detail\":\"%s\",\"ts\":%lld}",
-        m.key, host,
-        e.detail[0] ? e.detail : "",
-        (long long)(e.timestamp / 1000000LL));
-    if (n <= 0 || n >= 512) { free(body); return false; }
+// Read the rest of the response so the connection can carry the next
+// request. A body longer than EVENT_HTTP_DRAIN_MAX is not worth it; the
+// caller closes the connection instead.
+static bool drain_event_http_response(esp_http_client_handle_t client,
+                                      int64_t deadline_us)
+{
+    char buf[64];
+    int drained = 0;
+    while (!esp_http_client_is_complete_data_received(client)) {
+        if (drained > EVENT_HTTP_DRAIN_MAX ||
+            !prepare_event_http_step(client, deadline_us)) return false;
+        const int n = esp_http_client_read(client, buf, sizeof(buf));
+        if (n > 0) {
+            drained += n;
+            continue;
+        }
+        if (n == -ESP_ERR_HTTP_EAGAIN) {
+            event_http_retry_delay(deadline_us);
+            continue;
+        }
+        return n == 0 && esp_http_client_is_complete_data_received(client);
+    }
+    return true;
+}
 
-    const int64_t deadline_us = esp_timer_get_time() +
-        static_cast<int64_t>(EVENT_HTTP_TOTAL_TIMEOUT_MS) * 1000;
+static esp_http_client_handle_t open_http_client(const char *url, const char *secret,
+                                                 int64_t deadline_us)
+{
     esp_http_client_config_t cfg = {};
-    cfg.url = config.webhook_url;
+    cfg.url = url;
     cfg.method = HTTP_METHOD_POST;
     cfg.timeout_ms = remaining_deadline_ms(deadline_us);
     cfg.crt_bundle_attach = esp_crt_bundle_attach;
@@ -376,107 +470,168 @@ static bool send_webhook(const EventEntry &e, const EventMeta &m,
     // keeps credentials and the absolute deadline scoped to one endpoint.
     cfg.disable_auto_redirect = true;
     // ESP-IDF supports non-blocking esp_http_client only over HTTPS. Requiring
-    // HTTPS above keeps every operation under the absolute deadline.
+    // HTTPS keeps every operation under the absolute deadline.
     cfg.is_async = true;
 
+    esp_http_client_handle_t client = esp_http_client_init(&cfg);
+    if (client) {
+        esp_http_client_set_header(client, "Content-Type", "application/json");
+        if (secret && secret[0]) {
+            esp_http_client_set_header(client, "X-HB-RF-ETH-Secret", secret);
+        }
+    }
+    return client;
+}
+
+// POST body on the session's connection, opening one if there is none to
+// reuse. A kept-alive connection the server has closed in the meantime
+// fails on the first write; the request is then repeated once on a fresh
+// connection. A failure after the whole body went out is not repeated: the
+// server may have acted on it, and a retry would deliver the event twice.
+static bool post_event_session(EventHttpSession *session, const char *op,
+                               const char *url, const char *secret,
+                               const char *body, size_t body_len)
+{
+    const int64_t deadline_us = esp_timer_get_time() +
+        static_cast<int64_t>(EVENT_HTTP_TOTAL_TIMEOUT_MS) * 1000;
+    const uint32_t key = NotifyKeepAlive::key(url, secret);
+
     bool ok = false;
     // Outbound HTTPS must serialise on g_net_fetch_mutex.
     const int mutex_wait_ms = remaining_deadline_ms(deadline_us);
-    if (g_net_fetch_mutex && mutex_wait_ms > 0 &&
-        xSemaphoreTake(g_net_fetch_mutex,
-                       pdMS_TO_TICKS(mutex_wait_ms)) == pdTRUE) {
-        crash_blackbox_net_op_begin("events_webhook");
-        if (!s_running.load(std::memory_order_acquire)) {
-            crash_blackbox_net_op_end();
-            xSemaphoreGive(g_net_fetch_mutex);
-            free(body);
-            return false;
-        }
-        esp_http_client_handle_t client = esp_http_client_init(&cfg);
-        if (client) {
-            esp_http_client_set_header(client, "Content-Type", "application/json");
-            if (config.webhook_secret[0]) {
-                esp_http_client_set_header(client, "X-HB-RF-ETH-Secret", config.webhook_secret);
-            }
-            esp_err_t err = post_event_http(
-                client, body, static_cast<size_t>(n), deadline_us);
-            if (err == ESP_OK) {
-                int code = esp_http_client_get_status_code(client);
-                ok = (code >= 200 && code < 300);
-            }
-            esp_http_client_close(client);
-            esp_http_client_cleanup(client);
-        }
+    if (!g_net_fetch_mutex || mutex_wait_ms <= 0 ||
+        xSemaphoreTake(g_net_fetch_mutex, pdMS_TO_TICKS(mutex_wait_ms)) != pdTRUE) {
+        return false;
+    }
+    crash_blackbox_net_op_begin(op);
+    if (!s_running.load(std::memory_order_acquire)) {
         crash_blackbox_net_op_end();
         xSemaphoreGive(g_net_fetch_mutex);
+        return false;
     }
+
+    bool reused = session->client &&
+                  session->keep_alive.reusable(esp_timer_get_time(), key);
+    esp_err_t err = ESP_FAIL;
+    for (int attempt = 0; attempt < 2; attempt++) {
+        if (!reused) {
+            close_http_session(session);
+            session->client = open_http_client(url, secret, deadline_us);
+            if (!session->client) break;
+            g_handshakes_total.inc();
+        } else {
+            g_reused_total.inc();
+        }
+        bool sent = false;
+        err = post_event_http(session->client, body, body_len, deadline_us, &sent);
+        if (err == ESP_OK || sent || !reused || !s_running.load(std::memory_order_acquire)) break;
+        reused = false;
+    }
+
+    if (err == ESP_OK) {
+        const int code = esp_http_client_get_status_code(session->client);
+        ok = (code >= 200 && code < 300);
+        if (drain_event_http_response(session->client, deadline_us)) {
+            session->keep_alive.used(esp_timer_get_time(), key);
+        } else {
+            close_http_session(session);
+        }
+    } else {
+        close_http_session(session);
+    }
+    crash_blackbox_net_op_end();
+    xSemaphoreGive(g_net_fetch_mutex);
+    return ok;
+}
+
+// --- Webhook ---
+static bool send_webhook(const NotifyMessage &msg, const notify_config_t &config)
+{
+    if (config.webhook_url[0] == '\0') {
+        return false;
+    }
+    if (!is_https_url(config.webhook_url)) {
+        ESP_LOGE(TAG, "Rejected non-HTTPS webhook URL");
+        return false;
+    }
+
+    // Heap-allocate body so we can host it through the http client lifecycle.
+    const size_t cap = msg.digest ? DIGEST_BODY_MAX : 512;
+    char *body = (char *)malloc(cap);
+    if (!body) return false;
+
+    JsonWriter json(body, cap);
+    json.beginObject();
+    json.string("event", msg.key);
+    json.string("device", device_name());
+    json.string("detail", msg.detail);
+    json.number("ts", (int64_t)(msg.timestamp / 1000000LL));
+    if (msg.digest) {
+        json.beginArray("events");
+        for (size_t i = 0; i < msg.digest->size(); i++) {
+            const NotifyDigest::Entry &entry = msg.digest->entry(i);
+            json.beginObject();
+            json.string("event", meta_for(static_cast<Event>(entry.id)).key);
+            json.number("count", (uint64_t)entry.count);
+            json.string("detail", entry.detail);
+            json.number("ts", (int64_t)(entry.first_us / 1000000LL));
+            json.number("lastTs", (int64_t)(entry.last_us / 1000000LL));
+            json.endObject();
+        }
+        json.endArray();
+        json.number("unlisted", (uint64_t)msg.digest->unlisted());
+    }
+    json.endObject();
+
+    bool ok = json.ok() &&
+              post_event_session(&s_webhook_session, "events_webhook", config.webhook_url,
+                                 config.webhook_secret, body, json.length());
     free(body);
     return ok;
 }
 
 // --- Telegram ---
-static bool send_telegram(const EventEntry &e, const EventMeta &m,
-                          const notify_config_t &config)
+static bool send_telegram(const NotifyMessage &msg, const notify_config_t &config)
 {
     if (config.telegram_token[0] == '\0' || config.telegram_chatid[0] == '\0') {
         return false;
     }
 
-    const char *host = "hb-rf-eth-ng";
-    Settings *s = monitoring_get_settings();
-    if (s && s->getHostname() && s->getHostname()[0]) host = s->getHostname();
-
     char url[256];
     int url_len = snprintf(url, sizeof(url),
                            "https://api.telegram.org/bot%s/sendMessage",
                            config.telegram_token);
     if (url_len <= 0 || url_len >= static_cast<int>(sizeof(url))) return false;
 
-    char *body = (char *)malloc(640);
-    if (!body) return false;
-    int n = snprintf(body, 640,
-        "{\"chat_id\":\"%s\",\"text\":\"[%s] %s: %s\",\"disable_web_page_preview\":true}",
-        config.telegram_chatid, host, m.default_msg,
-        e.detail[0] ? e.detail : "");
-    if (n <= 0 || n >= 640) { free(body); return false; }
-
-    const int64_t deadline_us = esp_timer_get_time() +
-        static_cast<int64_t>(EVENT_HTTP_TOTAL_TIMEOUT_MS) * 1000;
-    esp_http_client_config_t cfg = {};
-    cfg.url = url;
-    cfg.method = HTTP_METHOD_POST;
-    cfg.timeout_ms = remaining_deadline_ms(deadline_us);
-    cfg.crt_bundle_attach = esp_crt_bundle_attach;
-    cfg.disable_auto_redirect = true;
-    cfg.is_async = true;
-
-    bool ok = false;
-    const int mutex_wait_ms = remaining_deadline_ms(deadline_us);
-    if (g_net_fetch_mutex && mutex_wait_ms > 0 &&
-        xSemaphoreTake(g_net_fetch_mutex,
-                       pdMS_TO_TICKS(mutex_wait_ms)) == pdTRUE) {
-        crash_blackbox_net_op_begin("events_telegram");
-        if (!s_running.load(std::memory_order_acquire)) {
-            crash_blackbox_net_op_end();
-            xSemaphoreGive(g_net_fetch_mutex);
-            free(body);
-            return false;
-        }
-        esp_http_client_handle_t client = esp_http_client_init(&cfg);
-        if (client) {
-            esp_http_client_set_header(client, "Content-Type", "application/json");
-            esp_err_t err = post_event_http(
-                client, body, static_cast<size_t>(n), deadline_us);
-            if (err == ESP_OK) {
-                int code = esp_http_client_get_status_code(client);
-                ok = (code >= 200 && code < 300);
-            }
-            esp_http_client_close(client);
-            esp_http_client_cleanup(client);
-        }
-        crash_blackbox_net_op_end();
-        xSemaphoreGive(g_net_fetch_mutex);
+    // The message text first, then the JSON request around it; a digest
+    // lists one line per event type.
+    const size_t text_cap = msg.digest ? DIGEST_BODY_MAX : 512;
+    char *text = (char *)malloc(text_cap);
+    char *body = (char *)malloc(text_cap + 128);
+    if (!text || !body) {
+        free(text);
+        free(body);
+        return false;
+    }
+    int len = snprintf(text, text_cap, "[%s] %s: %s", device_name(), msg.title, msg.detail);
+    for (size_t i = 0; msg.digest && i < msg.digest->size() && len > 0 &&
+                       (size_t)len < text_cap; i++) {
+        char line[200];
+        format_digest_line(line, sizeof(line), msg.digest->entry(i));
+        len += snprintf(text + len, text_cap - len, "\n- %s", line);
     }
+
+    JsonWriter json(body, text_cap + 128);
+    json.beginObject();
+    json.string("chat_id", config.telegram_chatid);
+    json.string("text", text);
+    json.boolean("disable_web_page_preview", true);
+    json.endObject();
+
+    bool ok = len > 0 && (size_t)len < text_cap && json.ok() &&
+              post_event_session(&s_telegram_session, "events_telegram", url, NULL,
+                                 body, json.length());
+    free(text);
     free(body);
     return ok;
 }
@@ -571,7 +726,7 @@ static bool smtp_send_line(int sock, mbedtls_ssl_context *ssl,
 static bool smtp_setup_tls(mbedtls_ssl_context *ssl,
                            mbedtls_ssl_config *conf,
                            SmtpTlsIoContext *io,
-                           int sock, const char *host,
+                           int sock, const char *host, uint16_t port,
                            int64_t deadline_us, bool *setup_complete)
 {
     io->net.fd = sock;
@@ -599,19 +754,25 @@ static bool smtp_setup_tls(mbedtls_ssl_context *ssl,
                         smtp_tls_recv_timeout);
     if (mbedtls_ssl_set_hostname(ssl, host) != 0) return false;
 
+    // Notifications to the same mail server resume the last session.
+    const int64_t resume_start = tls_resume_begin(ssl, host, port);
+    bool ok = false;
     while (remaining_deadline_ms(deadline_us) > 0 &&
            s_running.load(std::memory_order_acquire)) {
-        if (!apply_socket_deadline(sock, deadline_us)) return false;
+        if (!apply_socket_deadline(sock, deadline_us)) break;
         int r = mbedtls_ssl_handshake(ssl);
-        if (r == 0) return true;
+        if (r == 0) {
+            ok = true;
+            break;
+        }
         if (r != MBEDTLS_ERR_SSL_WANT_READ &&
-            r != MBEDTLS_ERR_SSL_WANT_WRITE) return false;
+            r != MBEDTLS_ERR_SSL_WANT_WRITE) break;
     }
-    return false;
+    tls_resume_end(ssl, host, port, resume_start, ok);
+    return ok;
 }
 
-static bool send_email(const EventEntry &e, const EventMeta &m,
-                       const notify_config_t &config)
+static bool send_email(const NotifyMessage &msg, const notify_config_t &config)
 {
     if (config.smtp_server[0] == '\0' || config.smtp_from[0] == '\0' ||
         config.smtp_to[0] == '\0' || !g_net_fetch_mutex) return false;
@@ -623,10 +784,12 @@ static bool send_email(const EventEntry &e, const EventMeta &m,
         xSemaphoreTake(g_net_fetch_mutex,
                        pdMS_TO_TICKS(mutex_wait_ms)) != pdTRUE) return false;
     crash_blackbox_net_op_begin("events_smtp");
+    events_close_idle_connections();
 
     // Implicit TLS: full TLS from the start. STARTTLS: plaintext then upgrade.
     const bool use_tls = config.smtp_tls == 2;
     const bool use_starttls = config.smtp_tls == 1;
+    const uint16_t smtp_port = config.smtp_port ? config.smtp_port : 587;
 
     bool ok = false;
     struct addrinfo hints = {};
@@ -651,8 +814,7 @@ static bool send_email(const EventEntry &e, const EventMeta &m,
     tls_io.deadline_us = deadline_us;
 
     do {
-        snprintf(port_str, sizeof(port_str), "%u",
-                 config.smtp_port ? config.smtp_port : 587);
+        snprintf(port_str, sizeof(port_str), "%u", smtp_port);
         if (getaddrinfo(config.smtp_server, port_str, &hints, &res) != ESP_OK ||
             !res || remaining_deadline_ms(deadline_us) <= 0 ||
             !s_running.load(std::memory_order_acquire)) break;
@@ -660,6 +822,8 @@ static bool send_email(const EventEntry &e, const EventMeta &m,
         sock = socket(res->ai_family, res->ai_socktype, res->ai_protocol);
         if (sock < 0) break;
         if (!publish_active_socket(sock)) break;
+        // SMTP has no connection reuse: every email is a new session.
+        g_handshakes_total.inc();
 
         flags = fcntl(sock, F_GETFL, 0);
         if (flags >= 0) fcntl(sock, F_SETFL, flags | O_NONBLOCK);
@@ -689,8 +853,8 @@ static bool send_email(const EventEntry &e, const EventMeta &m,
 
         if (use_tls) {
             if (!smtp_setup_tls(&ssl, &conf, &tls_io, sock,
-                                config.smtp_server, deadline_us,
-                                &tls_setup)) break;
+                                config.smtp_server, smtp_port,
+                                deadline_us, &tls_setup)) break;
             tls_active = true;
         }
         mbedtls_ssl_context *active_ssl = tls_active ? &ssl : NULL;
@@ -703,8 +867,8 @@ static bool send_email(const EventEntry &e, const EventMeta &m,
             if (!smtp_send_line(sock, NULL, "STARTTLS", deadline_us) ||
                 smtp_read_reply(sock, NULL, line, sizeof(line), deadline_us) / 100 != 2 ||
                 !smtp_setup_tls(&ssl, &conf, &tls_io, sock,
-                                config.smtp_server, deadline_us,
-                                &tls_setup)) break;
+                                config.smtp_server, smtp_port,
+                                deadline_us, &tls_setup)) break;
             tls_active = true;
             active_ssl = &ssl;
             if (!smtp_send_line(sock, active_ssl, "EHLO hb-rf-eth-ng", deadline_us) ||
@@ -744,14 +908,21 @@ static bool send_email(const EventEntry &e, const EventMeta &m,
         snprintf(line, sizeof(line), "To: %s", config.smtp_to);
         if (!smtp_send_line(sock, active_ssl, line, deadline_us)) break;
         snprintf(line, sizeof(line), "Subject: [%s] %s",
-                 config.smtp_from, m.default_msg);
+                 config.smtp_from, msg.title);
         if (!smtp_send_line(sock, active_ssl, line, deadline_us) ||
             !smtp_send_line(sock, active_ssl,
                             "Content-Type: text/plain; charset=utf-8", deadline_us) ||
             !smtp_send_line(sock, active_ssl, "", deadline_us)) break;
-        snprintf(line, sizeof(line), "%s: %s", m.default_msg,
-                 e.detail[0] ? e.detail : "");
-        if (!smtp_send_line(sock, active_ssl, line, deadline_us) ||
+        snprintf(line, sizeof(line), "%s: %s", msg.title, msg.detail);
+        if (!smtp_send_line(sock, active_ssl, line, deadline_us)) break;
+        bool body_sent = true;
+        for (size_t i = 0; msg.digest && i < msg.digest->size() && body_sent; i++) {
+            // Entries start with an event message, never with the "." that
+            // would need dot-stuffing.
+            format_digest_line(line, sizeof(line), msg.digest->entry(i));
+            body_sent = smtp_send_line(sock, active_ssl, line, deadline_us);
+        }
+        if (!body_sent ||
             !smtp_send_line(sock, active_ssl, ".", deadline_us) ||
             smtp_read_reply(sock, active_ssl, line, sizeof(line), deadline_us) / 100 != 2) break;
 
@@ -785,15 +956,96 @@ static bool send_email(const EventEntry &e, const EventMeta &m,
 // ---------------------------------------------------------------------------
 // Worker task.
 // ---------------------------------------------------------------------------
+
+// Events waiting for the digest window to close; worker-owned.
+static NotifyDigest s_digest;
+
+static void snapshot_config(notify_config_t *config)
+{
+    SemaphoreHandle_t lifecycle = events_lifecycle_mutex();
+    xSemaphoreTake(lifecycle, portMAX_DELAY);
+    memcpy(config, &s_cfg, sizeof(*config));
+    xSemaphoreGive(lifecycle);
+}
+
+static void deliver(const NotifyMessage &msg, uint32_t events, const notify_config_t &config)
+{
+    const uint8_t channels = config.channels;
+    bool any_ok = false;
+
+    if (channels & NOTIFY_CHANNEL_WEBHOOK) {
+        if (send_webhook(msg, config)) any_ok = true;
+    }
+    if (s_running.load(std::memory_order_acquire) &&
+        (channels & NOTIFY_CHANNEL_TELEGRAM)) {
+        if (send_telegram(msg, config)) any_ok = true;
+    }
+    if (s_running.load(std::memory_order_acquire) &&
+        (channels & NOTIFY_CHANNEL_EMAIL)) {
+        if (send_email(msg, config)) any_ok = true;
+    }
+
+    if (any_ok) {
+        g_sent_total.inc();
+        g_events_delivered_total.inc(events);
+    } else {
+        g_failed_total.inc();
+    }
+}
+
+static void deliver_digest(const notify_config_t &config)
+{
+    // A window that caught a single event sends it as if there were no
+    // digest, so quiet periods look the same in either mode.
+    if (s_digest.events() == 1) {
+        const NotifyDigest::Entry &entry = s_digest.entry(0);
+        const EventMeta &m = meta_for(static_cast<Event>(entry.id));
+        deliver({m.key, m.default_msg, entry.detail, entry.first_us, NULL}, 1, config);
+    } else {
+        char detail[64];
+        if (s_digest.unlisted() > 0) {
+            snprintf(detail, sizeof(detail), "%u events in %u s, %u not listed",
+                     (unsigned)s_digest.events(), (unsigned)config.digest_seconds,
+                     (unsigned)s_digest.unlisted());
+        } else {
+            snprintf(detail, sizeof(detail), "%u events in %u s",
+                     (unsigned)s_digest.events(), (unsigned)config.digest_seconds);
+        }
+        deliver({"digest", "Notification digest", detail, esp_timer_get_time(), &s_digest},
+                s_digest.events(), config);
+    }
+    s_digest.clear();
+}
+
 static void events_task(void *)
 {
     for (;;) {
         ESP_LOGI(TAG, "event worker started");
         while (s_running.load(std::memory_order_acquire)) {
+            // Wake in time for a pending digest, and at least every 500 ms
+            // to close idle connections.
+            int wait_ms = 500;
+            if (!s_digest.empty()) {
+                const int64_t left_ms = (s_digest.deadline() - esp_timer_get_time() + 999) / 1000;
+                if (left_ms < wait_ms) wait_ms = left_ms > 0 ? static_cast<int>(left_ms) : 0;
+            }
             EventEntry e;
-            if (xQueueReceive(s_queue, &e, pdMS_TO_TICKS(500)) != pdTRUE) continue;
+            const bool received =
+                xQueueReceive(s_queue, &e, pdMS_TO_TICKS(wait_ms)) == pdTRUE;
             if (!s_running.load(std::memory_order_acquire)) break;
 
+            // A digest waits out a firmware upload like single events do;
+            // idle connections are closed to give the upload their heap.
+            const bool ota_active = net_fetch_ota_active();
+            const int64_t now = esp_timer_get_time();
+            if (s_digest.due(now) && !ota_active) {
+                notify_config_t config;
+                snapshot_config(&config);
+                deliver_digest(config);
+            }
+            expire_http_sessions(esp_timer_get_time(), ota_active);
+            if (!received) continue;
+
             // Defer notification delivery while a manual firmware upload is in
             // progress. The upload reserves heap and flash bandwidth; starting
             // webhook/Telegram/email TLS work at the same time could starve it.
@@ -816,10 +1068,7 @@ static void events_task(void *)
             }
 
             notify_config_t config;
-            SemaphoreHandle_t lifecycle = events_lifecycle_mutex();
-            xSemaphoreTake(lifecycle, portMAX_DELAY);
-            memcpy(&config, &s_cfg, sizeof(config));
-            xSemaphoreGive(lifecycle);
+            snapshot_config(&config);
 
             // Honour the user's event selection before the cooldown check, so
             // a deselected event never consumes the debounce slot of an event
@@ -830,6 +1079,17 @@ static void events_task(void *)
                 continue;
             }
 
+            // In digest mode a repeat of an event already waiting in the
+            // digest is folded into it instead of being suppressed: the
+            // digest reports how often it happened. The test notification
+            // is never held back.
+            const bool digest = config.digest_seconds > 0 && e.id != EVENT_TEST;
+            const int64_t window_us = (int64_t)config.digest_seconds * 1000000LL;
+            if (digest && s_digest.contains(e.id)) {
+                s_digest.add(e.id, e.timestamp, e.detail, esp_timer_get_time(), window_us);
+                continue;
+            }
+
             if ((int)e.id < MAX_EVENT_ID) {
                 int64_t now = esp_timer_get_time();
                 int64_t cooldown_us = (int64_t)config.cooldown_seconds * 1000000LL;
@@ -840,27 +1100,20 @@ static void events_task(void *)
                 s_last_sent[e.id] = now;
             }
 
-            const EventMeta &m = meta_for(e.id);
-
-            // Snapshot the channels bitmask
-            uint8_t channels = config.channels;
-            bool any_ok = false;
-
-            if (channels & NOTIFY_CHANNEL_WEBHOOK) {
-                if (send_webhook(e, m, config)) any_ok = true;
-            }
-            if (s_running.load(std::memory_order_acquire) &&
-                (channels & NOTIFY_CHANNEL_TELEGRAM)) {
-                if (send_telegram(e, m, config)) any_ok = true;
-            }
-            if (s_running.load(std::memory_order_acquire) &&
-                (channels & NOTIFY_CHANNEL_EMAIL)) {
-                if (send_email(e, m, config)) any_ok = true;
+            if (digest) {
+                s_digest.add(e.id, e.timestamp, e.detail, esp_timer_get_time(), window_us);
+                continue;
             }
 
-            if (any_ok) g_sent_total.inc();
-            else        g_failed_total.inc();
+            const EventMeta &m = meta_for(e.id);
+            deliver({m.key, m.default_msg, e.detail, e.timestamp, NULL}, 1, config);
+        }
+        if (!s_digest.empty()) {
+            ESP_LOGW(TAG, "dropping digest of %u events: worker stopping",
+                     (unsigned)s_digest.events());
+            s_digest.clear();
         }
+        expire_http_sessions(0, true);
         ESP_LOGI(TAG, "event worker stopped");
         SemaphoreHandle_t lifecycle = events_lifecycle_mutex();
         xSemaphoreTake(lifecycle, portMAX_DELAY);
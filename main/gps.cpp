@@ -25,7 +25,10 @@
 #include "pins.h"
 #include "esp_log.h"
 #include "esp_timer.h"
+#include "driver/gpio.h"
 #include "string.h"
+#include <stdlib.h>
+#include <time.h>
 #include <new>
 
 void gpsSerialQueueHandlerTask(void *parameter)
@@ -33,6 +36,11 @@ void gpsSerialQueueHandlerTask(void *parameter)
     ((GPS *)parameter)->_gpsSerialQueueHandler();
 }
 
+static void IRAM_ATTR onPpsEdge(void *arg)
+{
+    ((GPS *)arg)->_ppsInterrupt();
+}
+
 GPS::~GPS()
 {
     delete _lineReader;
@@ -55,7 +63,9 @@ GPS::GPS(Settings *settings, SystemClock *clk) : _settings(settings), _clk(clk)
         },
     };
     uart_param_config(UART_NUM_2, &uart_config);
-    uart_set_pin(UART_NUM_2, GPIO_NUM_0, DCF_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
+    // TX stays unassigned: the firmware never talks to the receiver, and its
+    // former pin is the PPS input now.
+    uart_set_pin(UART_NUM_2, UART_PIN_NO_CHANGE, DCF_PIN, UART_PIN_NO_CHANGE, UART_PIN_NO_CHANGE);
 
     using namespace std::placeholders;
     _lineReader = new (std::nothrow) LineReader(std::bind(&GPS::_handleLine, this, _1, _2));
@@ -84,11 +94,36 @@ void GPS::start()
         ESP_LOGE("GPS", "Failed to create UART handler task");
         uart_driver_delete(UART_NUM_2);
         _uart_queue = NULL;
+        return;
+    }
+
+    // PPS is optional: without a pulse on the pin the ISR never fires and the
+    // clock is set from NMEA alone.
+    gpio_config_t io_conf = {};
+    io_conf.intr_type = GPIO_INTR_POSEDGE;
+    io_conf.mode = GPIO_MODE_INPUT;
+    io_conf.pin_bit_mask = 1ULL << GPS_PPS_PIN;
+    io_conf.pull_down_en = GPIO_PULLDOWN_DISABLE;
+    io_conf.pull_up_en = GPIO_PULLUP_DISABLE;
+    err = gpio_config(&io_conf);
+    if (err == ESP_OK) {
+        err = gpio_install_isr_service(0);
+        if (err == ESP_ERR_INVALID_STATE) err = ESP_OK;
+    }
+    if (err == ESP_OK) err = gpio_isr_handler_add(GPS_PPS_PIN, onPpsEdge, this);
+    if (err == ESP_OK) {
+        _ppsIsr = true;
+    } else {
+        ESP_LOGW("GPS", "PPS input unavailable: %s", esp_err_to_name(err));
     }
 }
 
 void GPS::stop()
 {
+    if (_ppsIsr) {
+        gpio_isr_handler_remove(GPS_PPS_PIN);
+        _ppsIsr = false;
+    }
     if (_tHandle) {
         vTaskDelete(_tHandle);
         _tHandle = NULL;
@@ -143,106 +178,275 @@ void GPS::_gpsSerialQueueHandler()
     }
 }
 
-bool parseRMCTime(unsigned char *buffer, uint16_t len, timeval *tv)
+typedef struct
 {
-    int fieldIndex = 0;
-    int fieldStart = 0;
+    const unsigned char *data;
+    int len;
+} nmea_field_t;
 
-    int fieldLength;
+#define NMEA_MAX_FIELDS 20
 
-    struct tm time = {};
-    time.tm_isdst = 0;
-    bool statusValid = false;
+static int hexValue(unsigned char c)
+{
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    return -1;
+}
+
+// Split a sentence into its comma separated fields (field 0 is the address,
+// e.g. "$GPRMC"). The XOR checksum over everything between '$' and '*' is
+// verified when present; sentences without one are accepted as NMEA 0183
+// allows for older receivers. Returns the field count, or -1 if the sentence
+// is malformed or corrupted.
+static int splitSentence(const unsigned char *buffer, uint16_t len, nmea_field_t *fields)
+{
+    if (len < 7 || buffer[0] != '$')
+        return -1;
 
-    for (int i = 0; i < len; i++)
+    uint8_t checksum = 0;
+    int end = 1;
+    while (end < len && buffer[end] != '*' && buffer[end] != 0)
     {
-        if (buffer[i] == ',')
+        checksum ^= buffer[end];
+        end++;
+    }
+
+    if (end < len && buffer[end] == '*')
+    {
+        if (end + 2 >= len)
+            return -1;
+        int hi = hexValue(buffer[end + 1]);
+        int lo = hexValue(buffer[end + 2]);
+        if (hi < 0 || lo < 0 || ((hi << 4) | lo) != checksum)
+            return -1;
+    }
+
+    int count = 0;
+    int fieldStart = 0;
+    for (int i = 0; i <= end && count < NMEA_MAX_FIELDS; i++)
+    {
+        if (i == end || buffer[i] == ',')
         {
-            fieldLength = i - fieldStart;
+            fields[count].data = buffer + fieldStart;
+            fields[count].len = i - fieldStart;
+            count++;
+            fieldStart = i + 1;
+        }
+    }
+    return count;
+}
 
-            if (fieldIndex == 1)
-            {
-                if (fieldLength < 6)
-                    return false;
+static bool parseDigits(const unsigned char *data, int count, int *value)
+{
+    *value = 0;
+    for (int d = 0; d < count; d++)
+    {
+        if (data[d] < '0' || data[d] > '9') return false;
+        *value = *value * 10 + (data[d] - '0');
+    }
+    return true;
+}
 
-                for (int d = 0; d < 6; d++) {
-                    if (buffer[fieldStart + d] < '0' || buffer[fieldStart + d] > '9') return false;
-                }
+// hhmmss[.ss] as used by RMC, ZDA and GGA.
+static bool parseTimeOfDay(const nmea_field_t *field, struct tm *time, suseconds_t *usec)
+{
+    if (field->len < 6)
+        return false;
 
-                time.tm_hour = ((buffer[fieldStart + 0] - '0') * 10) + (buffer[fieldStart + 1] - '0');
-                time.tm_min = ((buffer[fieldStart + 2] - '0') * 10) + (buffer[fieldStart + 3] - '0');
-                time.tm_sec = ((buffer[fieldStart + 4] - '0') * 10) + (buffer[fieldStart + 5] - '0');
+    if (!parseDigits(field->data, 2, &time->tm_hour) ||
+        !parseDigits(field->data + 2, 2, &time->tm_min) ||
+        !parseDigits(field->data + 4, 2, &time->tm_sec))
+        return false;
 
-                if (time.tm_hour > 23 || time.tm_min > 59 || time.tm_sec > 60) return false;
+    if (time->tm_hour > 23 || time->tm_min > 59 || time->tm_sec > 60) return false;
 
-                tv->tv_usec = 0;
-                if (fieldLength >= 9 && buffer[fieldStart + 6] == '.') {
-                    if (buffer[fieldStart + 7] >= '0' && buffer[fieldStart + 7] <= '9')
-                        tv->tv_usec += (buffer[fieldStart + 7] - '0') * 100000;
-                    if (buffer[fieldStart + 8] >= '0' && buffer[fieldStart + 8] <= '9')
-                        tv->tv_usec += (buffer[fieldStart + 8] - '0') * 10000;
-                }
-            }
-            else if (fieldIndex == 2)
-            {
-                // Field 2: Status 'A' = valid fix, 'V' = warning / invalid fix
-                if (fieldLength == 1 && buffer[fieldStart] == 'A') {
-                    statusValid = true;
-                } else {
-                    return false;
-                }
-            }
-            else if (fieldIndex == 9)
-            {
-                if (fieldLength != 6)
-                    return false;
+    *usec = 0;
+    if (field->len >= 9 && field->data[6] == '.') {
+        if (field->data[7] >= '0' && field->data[7] <= '9')
+            *usec += (field->data[7] - '0') * 100000;
+        if (field->data[8] >= '0' && field->data[8] <= '9')
+            *usec += (field->data[8] - '0') * 10000;
+    }
+    return true;
+}
 
-                for (int d = 0; d < 6; d++) {
-                    if (buffer[fieldStart + d] < '0' || buffer[fieldStart + d] > '9') return false;
-                }
+static bool toTimeval(struct tm *time, suseconds_t usec, timeval *tv)
+{
+    if (time->tm_mon < 0 || time->tm_mon > 11 || time->tm_mday < 1 || time->tm_mday > 31) return false;
 
-                time.tm_mday = ((buffer[fieldStart + 0] - '0') * 10) + (buffer[fieldStart + 1] - '0');
-                time.tm_mon = ((buffer[fieldStart + 2] - '0') * 10) + (buffer[fieldStart + 3] - '0') - 1;
-                time.tm_year = ((buffer[fieldStart + 4] - '0') * 10) + (buffer[fieldStart + 5] - '0') + 100;
+    time->tm_isdst = 0;
+    tv->tv_sec = mktime(time);
+    if (tv->tv_sec == (time_t)-1)
+        return false;
+    tv->tv_usec = usec;
+    return true;
+}
 
-                if (time.tm_mon < 0 || time.tm_mon > 11 || time.tm_mday < 1 || time.tm_mday > 31) return false;
-            }
+// $--RMC,hhmmss.ss,A,llll.ll,a,yyyyy.yy,a,x.x,x.x,ddmmyy,...
+static bool parseRMCTime(const nmea_field_t *fields, int count, timeval *tv)
+{
+    struct tm time = {};
+    suseconds_t usec;
 
-            fieldIndex++;
-            fieldStart = i + 1;
-        }
-    }
+    if (count < 10 || !parseTimeOfDay(&fields[1], &time, &usec))
+        return false;
 
-    if (fieldIndex < 10 || !statusValid)
+    // Field 2: Status 'A' = valid fix, 'V' = warning / invalid fix
+    if (fields[2].len != 1 || fields[2].data[0] != 'A')
         return false;
 
-    tv->tv_sec = mktime(&time);
-    if (tv->tv_sec == (time_t)-1)
+    if (fields[9].len != 6 ||
+        !parseDigits(fields[9].data, 2, &time.tm_mday) ||
+        !parseDigits(fields[9].data + 2, 2, &time.tm_mon) ||
+        !parseDigits(fields[9].data + 4, 2, &time.tm_year))
+        return false;
+    time.tm_mon -= 1;
+    time.tm_year += 100;
+
+    return toTimeval(&time, usec, tv);
+}
+
+// $--ZDA,hhmmss.ss,dd,mm,yyyy,zh,zm
+static bool parseZDATime(const nmea_field_t *fields, int count, timeval *tv)
+{
+    struct tm time = {};
+    suseconds_t usec;
+
+    if (count < 5 || !parseTimeOfDay(&fields[1], &time, &usec))
+        return false;
+
+    if (fields[2].len != 2 || fields[3].len != 2 || fields[4].len != 4 ||
+        !parseDigits(fields[2].data, 2, &time.tm_mday) ||
+        !parseDigits(fields[3].data, 2, &time.tm_mon) ||
+        !parseDigits(fields[4].data, 4, &time.tm_year))
+        return false;
+    // Receivers without a fix report their battery-backed RTC, starting at
+    // some firmware epoch. Anything before 2020 cannot be a real fix.
+    if (time.tm_year < 2020)
+        return false;
+    time.tm_mon -= 1;
+    time.tm_year -= 1900;
+
+    return toTimeval(&time, usec, tv);
+}
+
+// $--GGA,hhmmss.ss,llll.ll,a,yyyyy.yy,a,q,... carries no date. The date is
+// taken from the system clock, choosing the day that puts the result within
+// twelve hours of it, so GGA can only refine a clock that is already set.
+static bool parseGGATime(const nmea_field_t *fields, int count, const timeval *now, timeval *tv)
+{
+    struct tm time = {};
+    suseconds_t usec;
+
+    if (count < 7 || !parseTimeOfDay(&fields[1], &time, &usec))
+        return false;
+
+    // Field 6: fix quality, 0 = invalid
+    if (fields[6].len != 1 || fields[6].data[0] < '1' || fields[6].data[0] > '9')
+        return false;
+
+    if (now->tv_sec < 1577836800l) // 2020-01-01 00:00:00 GMT
         return false;
 
+    time_t midnight = now->tv_sec - now->tv_sec % 86400;
+    time_t sec = midnight + time.tm_hour * 3600 + time.tm_min * 60 + time.tm_sec;
+    if (sec - now->tv_sec > 43200)
+        sec -= 86400;
+    else if (now->tv_sec - sec > 43200)
+        sec += 86400;
+
+    tv->tv_sec = sec;
+    tv->tv_usec = usec;
     return true;
 }
 
-void GPS::_handleLine(unsigned char *buffer, uint16_t len)
+void IRAM_ATTR GPS::_ppsInterrupt()
 {
-    uint64_t startTime = esp_timer_get_time();
-    if (len > 6 && buffer[0] == '$' && memcmp(buffer + 3, "RMC", 3) == 0)
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL_ISR(&_ppsMux);
+    int64_t interval = now - _ppsEdge_us;
+    if (interval >= 1000000 - GPS_PPS_TOLERANCE_US && interval <= 1000000 + GPS_PPS_TOLERANCE_US)
     {
-        timeval tv;
-        if (parseRMCTime(buffer, len, &tv))
-        {
-            if (_nextSync < startTime)
-            {
-                _nextSync = startTime + 300 * 1000 * 1000; // every 5 minutes
+        if (_ppsPulses < GPS_PPS_LOCK_PULSES)
+            _ppsPulses++;
+    }
+    else
+    {
+        // First edge, a missed pulse or a glitch: start counting again.
+        _ppsPulses = 1;
+    }
+    _ppsEdge_us = now;
+    portEXIT_CRITICAL_ISR(&_ppsMux);
+}
 
-                int64_t elapsed_us = esp_timer_get_time() - startTime;
-                tv.tv_usec += elapsed_us;
-                while (tv.tv_usec >= 1000000) {
-                    tv.tv_sec++;
-                    tv.tv_usec -= 1000000;
-                }
-                _clk->setTime(&tv);
-            }
-        }
+// True if PPS is locked and its most recent edge is the one a sentence
+// processed at `now_us` describes.
+bool GPS::ppsEdge(int64_t now_us, int64_t *edge_us)
+{
+    portENTER_CRITICAL(&_ppsMux);
+    bool locked = _ppsPulses >= GPS_PPS_LOCK_PULSES;
+    *edge_us = _ppsEdge_us;
+    portEXIT_CRITICAL(&_ppsMux);
+
+    return locked && now_us - *edge_us <= GPS_PPS_MAX_SENTENCE_DELAY_US;
+}
+
+void GPS::syncClock(struct timeval *tv, uint32_t error_us)
+{
+    struct timeval now = _clk->getTime();
+    int64_t offset = ((int64_t)tv->tv_sec - now.tv_sec) * 1000000 + (tv->tv_usec - now.tv_usec);
+
+    if (_synced && llabs(offset) < GPS_STEP_THRESHOLD_US)
+        _clk->adjustTime(offset, error_us);
+    else
+        _clk->setTime(tv, error_us);
+    _synced = true;
+}
+
+void GPS::_handleLine(unsigned char *buffer, uint16_t len)
+{
+    int64_t startTime = esp_timer_get_time();
+
+    nmea_field_t fields[NMEA_MAX_FIELDS];
+    int count = splitSentence(buffer, len, fields);
+    if (count < 1 || fields[0].len != 6)
+        return;
+
+    const unsigned char *type = fields[0].data + 3;
+    timeval tv;
+    bool valid;
+    if (memcmp(type, "RMC", 3) == 0) {
+        valid = parseRMCTime(fields, count, &tv);
+    } else if (memcmp(type, "ZDA", 3) == 0) {
+        valid = parseZDATime(fields, count, &tv);
+    } else if (memcmp(type, "GGA", 3) == 0) {
+        timeval now = _clk->getTime();
+        valid = parseGGATime(fields, count, &now, &tv);
+    } else {
+        return;
+    }
+    if (!valid)
+        return;
+
+    int64_t edge;
+    bool pps = tv.tv_usec == 0 && ppsEdge(startTime, &edge);
+    // The first PPS-labelled sentence syncs right away rather than waiting out
+    // the longer interval of a preceding NMEA-only sync.
+    if (_synced && _nextSync > startTime && (_ppsSynced || !pps))
+        return;
+    _ppsSynced = pps;
+    _nextSync = startTime + (pps ? GPS_PPS_SYNC_INTERVAL_US : GPS_SYNC_INTERVAL_US);
+
+    // With PPS the sentence only labels the edge; the time elapsed since the
+    // edge comes from its interrupt timestamp. Without it, the best estimate
+    // is the moment the sentence was processed.
+    int64_t elapsed_us = esp_timer_get_time() - (pps ? edge : startTime);
+    tv.tv_usec += elapsed_us;
+    while (tv.tv_usec >= 1000000) {
+        tv.tv_sec++;
+        tv.tv_usec -= 1000000;
     }
+    syncClock(&tv, pps ? GPS_PPS_ERROR_US : GPS_NMEA_ERROR_US);
 }
@@ -75,6 +75,34 @@ bool HMFrame::TryParse(unsigned char *buffer, uint16_t len, HMFrame *frame)
     return true;
 }
 
+uint16_t HMFrame::unescape(const unsigned char *buffer, uint16_t len, unsigned char *out, uint16_t cap)
+{
+    uint16_t res = 0;
+    bool escaped = false;
+
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (buffer[i] == 0xfc)
+        {
+            escaped = true;
+            continue;
+        }
+        if (res >= cap)
+            return 0;
+        out[res++] = escaped ? (buffer[i] | 0x80) : buffer[i];
+        escaped = false;
+    }
+
+    return res;
+}
+
+bool HMFrame::TryDecode(const unsigned char *buffer, uint16_t len, unsigned char *scratch,
+                        uint16_t cap, HMFrame *frame)
+{
+    const uint16_t decoded_len = unescape(buffer, len, scratch, cap);
+    return decoded_len > 0 && TryParse(scratch, decoded_len, frame);
+}
+
 HMFrame::HMFrame() : counter(0), destination(0), command(0), data(nullptr), data_len(0)
 {
 }
@@ -0,0 +1,161 @@
+/*
+ *  json_writer.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "json_writer.h"
+
+#include <stdio.h>
+#include <string.h>
+
+JsonWriter::JsonWriter(char *buffer, size_t capacity) : _buf(buffer), _cap(capacity) {
+    if (!_buf || _cap == 0) {
+        _full = true;
+        return;
+    }
+    _buf[0] = '\0';
+}
+
+// Keeps one byte for the terminating NUL.
+void JsonWriter::put(const char *text, size_t len) {
+    if (_full) return;
+    if (len >= _cap - _len) {
+        _full = true;
+        return;
+    }
+    memcpy(_buf + _len, text, len);
+    _len += len;
+    _buf[_len] = '\0';
+}
+
+void JsonWriter::escaped(const char *text, size_t len) {
+    put("\"", 1);
+    size_t run = 0;   // bytes copied unchanged, written in one go
+    for (size_t i = 0; i < len && !_full; i++) {
+        const unsigned char c = (unsigned char)text[i];
+        if (c >= 0x20 && c != '"' && c != '\\' && c != 0x7F) {
+            run++;
+            continue;
+        }
+        put(text + i - run, run);
+        run = 0;
+        char esc[8];
+        size_t esc_len = 2;
+        esc[0] = '\\';
+        if (c == '"' || c == '\\') esc[1] = (char)c;
+        else if (c == '\n') esc[1] = 'n';
+        else if (c == '\r') esc[1] = 'r';
+        else if (c == '\t') esc[1] = 't';
+        else esc_len = (size_t)snprintf(esc, sizeof(esc), "\\u%04x", c);
+        put(esc, esc_len);
+    }
+    put(text + len - run, run);
+    put("\"", 1);
+}
+
+void JsonWriter::member(const char *key) {
+    if (_depth == 0) {
+        // Only one top-level value.
+        if (_len > 0) _misused = true;
+        return;
+    }
+    const uint8_t bit = (uint8_t)(1u << (_depth - 1));
+    if (_has_value & bit) put(",", 1);
+    _has_value |= bit;
+    const bool in_array = (_is_array & bit) != 0;
+    if (in_array != (key == nullptr)) _misused = true;
+    if (!in_array && key) {
+        escaped(key, strlen(key));
+        put(":", 1);
+    }
+}
+
+void JsonWriter::open(const char *key, char bracket) {
+    member(key);
+    if (_depth == MAX_DEPTH) {
+        _misused = true;
+        return;
+    }
+    const uint8_t bit = (uint8_t)(1u << _depth);
+    _has_value &= (uint8_t)~bit;
+    if (bracket == '[') _is_array |= bit;
+    else _is_array &= (uint8_t)~bit;
+    _depth++;
+    put(&bracket, 1);
+}
+
+void JsonWriter::close(char bracket) {
+    const bool array = _depth > 0 && (_is_array & (1u << (_depth - 1)));
+    if (_depth == 0 || array != (bracket == ']')) {
+        _misused = true;
+        return;
+    }
+    _depth--;
+    put(&bracket, 1);
+}
+
+void JsonWriter::beginObject(const char *key) { open(key, '{'); }
+void JsonWriter::endObject() { close('}'); }
+void JsonWriter::beginArray(const char *key) { open(key, '['); }
+void JsonWriter::endArray() { close(']'); }
+
+void JsonWriter::string(const char *key, const char *value) {
+    string(key, value, value ? strlen(value) : 0);
+}
+
+void JsonWriter::string(const char *key, const char *value, size_t len) {
+    member(key);
+    escaped(value ? value : "", value ? len : 0);
+}
+
+void JsonWriter::number(const char *key, const char *value) {
+    member(key);
+    if (!value || !value[0]) put("null", 4);
+    else put(value, strlen(value));
+}
+
+void JsonWriter::number(const char *key, uint64_t value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%llu", (unsigned long long)value);
+    number(key, text);
+}
+
+void JsonWriter::number(const char *key, int64_t value) {
+    char text[24];
+    snprintf(text, sizeof(text), "%lld", (long long)value);
+    number(key, text);
+}
+
+void JsonWriter::boolean(const char *key, bool value) {
+    member(key);
+    if (value) put("true", 4);
+    else put("false", 5);
+}
+
+void JsonWriter::null(const char *key) {
+    member(key);
+    put("null", 4);
+}
+
+void JsonWriter::raw(const char *key, const char *json, size_t len) {
+    member(key);
+    put(json, len);
+}
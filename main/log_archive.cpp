@@ -0,0 +1,409 @@
+/*
+ *  log_archive.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "log_archive.h"
+#include "log_entry.h"
+
+#include <string.h>
+
+// Primes the match window of every segment. Text entries and inline %s
+// copies carry ESP-IDF line prefixes and colour escapes; deferred entries
+// are mostly headers and small argument words full of zero bytes. Later
+// bytes are the most common ones, nothing else depends on the order.
+static const uint8_t DICTIONARY[] =
+    "connected disconnected failed error timeout free heap bytes "
+    "settings mqtt syslog ntp dcf gps ethernet webui ota radio "
+    "HmIP-RFUSB raw-uart packet address\n"
+    "\xff\xff\xff\xff\x00\x00\x00\x00\x01\x00\x00\x00"
+    "\033[0;31mE (\033[0;33mW (\033[0;32mI (\033[0m\n"
+    ") LogManager: \033[0m\n\033[0;32mI (";
+static constexpr size_t DICT_SIZE = sizeof(DICTIONARY) - 1;
+
+static constexpr size_t MIN_MATCH = 4;
+static constexpr size_t MIN_REPEAT = 3;
+static constexpr size_t MAX_DISTANCE = 0xFFFF;
+static constexpr unsigned HASH_BITS = 9;
+static constexpr size_t HASH_ENTRIES = 1u << HASH_BITS;
+
+static_assert(DICT_SIZE + LogArchive::SEGMENT_SIZE <= MAX_DISTANCE,
+              "segment offsets must fit the 16-bit match distance");
+
+static inline uint32_t hash4(const uint8_t *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return (v * 2654435761u) >> (32 - HASH_BITS);
+}
+
+static uint8_t *put_length(uint8_t *out, size_t len) {
+    while (len >= 255) {
+        *out++ = 255;
+        len -= 255;
+    }
+    *out++ = static_cast<uint8_t>(len);
+    return out;
+}
+
+static uint32_t load32(const uint8_t *p) {
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+static void store32(uint8_t *p, uint32_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+    p[2] = static_cast<uint8_t>(v >> 16);
+    p[3] = static_cast<uint8_t>(v >> 24);
+}
+
+// Timestamps are the least compressible part of an entry: the header one
+// changes with every line, and ESP_LOG passes the same value again as the
+// first argument of a deferred entry. Before compression each header
+// timestamp is replaced by its distance to the previous entry's, and the
+// word after the format pointer by its distance to the header timestamp;
+// both are small and repeat. The transform is a bijection whatever the
+// entries contain, so restore() always recovers the original bytes.
+static void fold_timestamps(uint8_t *entries, size_t len, bool restore) {
+    static constexpr size_t TS = LOG_ENTRY_HEADER_SIZE - 4;
+    static constexpr size_t FIRST_ARG = LOG_ENTRY_HEADER_SIZE + sizeof(uintptr_t);
+    uint32_t previous = 0;
+    size_t at = 0;
+    while (len - at >= LOG_ENTRY_HEADER_SIZE) {
+        const size_t entry_len = log_entry_length(entries + at, len - at);
+        if (entry_len == 0 || entry_len > len - at) break;
+        uint8_t *entry = entries + at;
+        const uint32_t stored = load32(entry + TS);
+        const uint32_t ts = restore ? stored + previous : stored;
+        store32(entry + TS, restore ? ts : ts - previous);
+        if (entry[1] == LOG_ENTRY_DEFERRED && entry_len >= FIRST_ARG + 4) {
+            const uint32_t arg = load32(entry + FIRST_ARG);
+            store32(entry + FIRST_ARG, restore ? arg + ts : arg - ts);
+        }
+        previous = ts;
+        at += entry_len;
+    }
+}
+
+size_t LogArchive::storageSize(size_t pool_size) {
+    return HASH_ENTRIES * sizeof(uint16_t) +
+           2 * (DICT_SIZE + SEGMENT_SIZE) + pool_size;
+}
+
+size_t LogArchive::compressBound(size_t len) {
+    return len + len / 255 + 16;
+}
+
+void LogArchive::attach(uint8_t *storage, size_t pool_size) {
+    _storage = storage;
+    _hash = reinterpret_cast<uint16_t *>(storage);
+    _window = storage + HASH_ENTRIES * sizeof(uint16_t);
+    _cache = _window + DICT_SIZE + SEGMENT_SIZE;
+    _pool = _cache + DICT_SIZE + SEGMENT_SIZE;
+    _pool_size = pool_size;
+    memcpy(_window, DICTIONARY, DICT_SIZE);
+    memcpy(_cache, DICTIONARY, DICT_SIZE);
+    reset();
+}
+
+uint8_t *LogArchive::detach() {
+    uint8_t *storage = _storage;
+    _storage = nullptr;
+    _pool = nullptr;
+    _window = nullptr;
+    _cache = nullptr;
+    _hash = nullptr;
+    _pool_size = 0;
+    reset();
+    return storage;
+}
+
+void LogArchive::reset() {
+    _first = 0;
+    _count = 0;
+    _raw_bytes = 0;
+    _compressed_bytes = 0;
+    _staging_start = 0;
+    _staging_len = 0;
+    _cached_start = UINT64_MAX;
+    _cached_len = 0;
+}
+
+uint64_t LogArchive::end() const {
+    return _staging_start + _staging_len;
+}
+
+uint64_t LogArchive::oldest() const {
+    return _count > 0 ? segmentAt(0).start : _staging_start;
+}
+
+const LogArchive::Segment &LogArchive::segmentAt(size_t index) const {
+    return _segments[(_first + index) % MAX_SEGMENTS];
+}
+
+void LogArchive::append(uint64_t position, const uint8_t *entry, size_t len) {
+    if (!_pool || len == 0 || len > SEGMENT_SIZE) return;
+    if (_count > 0 || _staging_len > 0) {
+        if (position < end()) return;   // already held
+        if (position != end() || _staging_len + len > SEGMENT_SIZE) seal();
+    }
+    if (_staging_len == 0) _staging_start = position;
+    memcpy(_window + DICT_SIZE + _staging_len, entry, len);
+    _staging_len += len;
+}
+
+void LogArchive::dropOldest() {
+    const Segment &segment = segmentAt(0);
+    _raw_bytes -= segment.raw_len;
+    _compressed_bytes -= segment.compressed_len;
+    if (segment.start == _cached_start) _cached_start = UINT64_MAX;
+    _first = (_first + 1) % MAX_SEGMENTS;
+    _count--;
+}
+
+// Find room for len contiguous pool bytes after the newest segment, wrapping
+// to the start of the pool if needed, and evict the oldest segments until
+// nothing overlaps it.
+bool LogArchive::reservePool(size_t len, uint32_t *offset) {
+    if (len > _pool_size) return false;
+    if (_count == MAX_SEGMENTS) dropOldest();
+
+    size_t at = 0;
+    if (_count > 0) {
+        const Segment &newest = segmentAt(_count - 1);
+        at = newest.pool_offset + newest.compressed_len;
+        if (at + len > _pool_size) at = 0;
+    }
+    for (;;) {
+        bool overlap = false;
+        for (size_t i = 0; i < _count && !overlap; i++) {
+            const Segment &segment = segmentAt(i);
+            overlap = segment.pool_offset < at + len &&
+                      at < static_cast<size_t>(segment.pool_offset) + segment.compressed_len;
+        }
+        if (!overlap) break;
+        dropOldest();
+    }
+    *offset = static_cast<uint32_t>(at);
+    return true;
+}
+
+void LogArchive::seal() {
+    if (_staging_len == 0) return;
+    uint32_t offset = 0;
+    if (reservePool(compressBound(_staging_len), &offset)) {
+        fold_timestamps(_window + DICT_SIZE, _staging_len, false);
+        const size_t compressed =
+            compress(_window + DICT_SIZE, _staging_len, _pool + offset);
+        Segment &segment = _segments[(_first + _count) % MAX_SEGMENTS];
+        segment.start = _staging_start;
+        segment.pool_offset = offset;
+        segment.raw_len = static_cast<uint16_t>(_staging_len);
+        segment.compressed_len = static_cast<uint16_t>(compressed);
+        _count++;
+        _raw_bytes += _staging_len;
+        _compressed_bytes += compressed;
+    }
+    _staging_start += _staging_len;
+    _staging_len = 0;
+}
+
+// Sequence format: a token, extra literal length bytes, the literals, then
+// for every sequence but the last a match. Token bits 7..5 hold the literal
+// count (7: more follows), bit 4 says the match reuses the previous distance
+// (otherwise two distance bytes follow), bits 3..0 hold the match length
+// minus MIN_REPEAT (15: more follows). Consecutive entries of the same line
+// differ in a few argument bytes at identical distances, which is exactly
+// what the repeat flag makes cheap.
+static inline size_t match_length(const uint8_t *window, size_t from, size_t at, size_t end) {
+    size_t len = 0;
+    while (at + len < end && window[from + len] == window[at + len]) len++;
+    return len;
+}
+
+size_t LogArchive::compress(const uint8_t *src, size_t len, uint8_t *out) {
+    if (!_window || len > SEGMENT_SIZE) return 0;
+    uint8_t *window = _window;
+    if (src != window + DICT_SIZE) memcpy(window + DICT_SIZE, src, len);
+
+    // Positions are stored + 1 so that 0 means empty.
+    memset(_hash, 0, HASH_ENTRIES * sizeof(uint16_t));
+    for (size_t i = 0; i + MIN_MATCH <= DICT_SIZE; i++) {
+        _hash[hash4(window + i)] = static_cast<uint16_t>(i + 1);
+    }
+
+    const size_t end = DICT_SIZE + len;
+    uint8_t *op = out;
+    size_t anchor = DICT_SIZE;
+    size_t last_distance = 0;
+    size_t i = DICT_SIZE;
+    while (i + MIN_REPEAT <= end) {
+        size_t repeat_len = 0;
+        if (last_distance != 0 && last_distance <= i) {
+            repeat_len = match_length(window, i - last_distance, i, end);
+        }
+        size_t found_len = 0;
+        size_t found = 0;
+        if (i + MIN_MATCH <= end) {
+            const uint32_t h = hash4(window + i);
+            const size_t candidate = _hash[h];
+            _hash[h] = static_cast<uint16_t>(i + 1);
+            if (candidate != 0 && i - (candidate - 1) <= MAX_DISTANCE) {
+                found = candidate - 1;
+                found_len = match_length(window, found, i, end);
+                if (found_len < MIN_MATCH) found_len = 0;
+            }
+        }
+
+        // A new distance costs two bytes more than a repeat.
+        const bool repeat = repeat_len >= MIN_REPEAT && repeat_len + 2 >= found_len;
+        if (!repeat && found_len == 0) {
+            i++;
+            continue;
+        }
+        const size_t match_len = repeat ? repeat_len : found_len;
+        const size_t distance = repeat ? last_distance : i - found;
+
+        const size_t literals = i - anchor;
+        const size_t extra = match_len - MIN_REPEAT;
+        *op++ = static_cast<uint8_t>(((literals < 7 ? literals : 7) << 5) |
+                                     (repeat ? 0x10 : 0) |
+                                     (extra < 15 ? extra : 15));
+        if (literals >= 7) op = put_length(op, literals - 7);
+        memcpy(op, window + anchor, literals);
+        op += literals;
+        if (!repeat) {
+            *op++ = static_cast<uint8_t>(distance);
+            *op++ = static_cast<uint8_t>(distance >> 8);
+        }
+        if (extra >= 15) op = put_length(op, extra - 15);
+        last_distance = distance;
+
+        // Index the matched bytes too; repeated lines chain matches that way.
+        for (size_t j = i + 1; j < i + match_len && j + MIN_MATCH <= end; j++) {
+            _hash[hash4(window + j)] = static_cast<uint16_t>(j + 1);
+        }
+        i += match_len;
+        anchor = i;
+    }
+
+    // Trailing literals form a last sequence without a match.
+    const size_t literals = end - anchor;
+    *op++ = static_cast<uint8_t>((literals < 7 ? literals : 7) << 5);
+    if (literals >= 7) op = put_length(op, literals - 7);
+    memcpy(op, window + anchor, literals);
+    op += literals;
+    return static_cast<size_t>(op - out);
+}
+
+size_t LogArchive::decompress(const uint8_t *src, size_t len, uint8_t *out, size_t cap) {
+    if (!_cache) return 0;
+    uint8_t *const base = _cache + DICT_SIZE;
+    if (cap > SEGMENT_SIZE) cap = SEGMENT_SIZE;
+    _cached_start = UINT64_MAX;   // about to be overwritten
+
+    const uint8_t *ip = src;
+    const uint8_t *const ip_end = src + len;
+    size_t produced = 0;
+    size_t distance = 0;
+    while (ip < ip_end) {
+        const uint8_t token = *ip++;
+        size_t literals = token >> 5;
+        if (literals == 7) {
+            uint8_t b;
+            do {
+                if (ip >= ip_end) return 0;
+                b = *ip++;
+                literals += b;
+            } while (b == 255);
+        }
+        if (literals > static_cast<size_t>(ip_end - ip) || literals > cap - produced) return 0;
+        memcpy(base + produced, ip, literals);
+        ip += literals;
+        produced += literals;
+        if (ip == ip_end) break;   // last sequence
+
+        if (!(token & 0x10)) {
+            if (ip_end - ip < 2) return 0;
+            distance = ip[0] | (static_cast<size_t>(ip[1]) << 8);
+            ip += 2;
+        }
+        size_t match_len = (token & 0x0F) + MIN_REPEAT;
+        if ((token & 0x0F) == 15) {
+            uint8_t b;
+            do {
+                if (ip >= ip_end) return 0;
+                b = *ip++;
+                match_len += b;
+            } while (b == 255);
+        }
+        if (distance == 0 || distance > produced + DICT_SIZE ||
+            match_len > cap - produced) {
+            return 0;
+        }
+        // Overlapping copies repeat the pattern, byte by byte on purpose.
+        const uint8_t *from = base + produced - distance;
+        for (size_t k = 0; k < match_len; k++) base[produced + k] = from[k];
+        produced += match_len;
+    }
+    if (out != base) memcpy(out, base, produced);
+    return produced;
+}
+
+size_t LogArchive::read(uint64_t *offset, uint8_t *dst, size_t max) {
+    if (!_pool || max == 0) return 0;
+    if (*offset < oldest()) *offset = oldest();
+
+    for (size_t i = 0; i < _count; i++) {
+        const Segment &segment = segmentAt(i);
+        const uint64_t segment_end = segment.start + segment.raw_len;
+        if (*offset >= segment_end) continue;
+        if (*offset < segment.start) *offset = segment.start;
+
+        if (_cached_start != segment.start) {
+            const size_t n = decompress(_pool + segment.pool_offset,
+                                        segment.compressed_len,
+                                        _cache + DICT_SIZE, SEGMENT_SIZE);
+            if (n != segment.raw_len) {
+                // Never expected; skip what cannot be trusted.
+                *offset = segment_end;
+                continue;
+            }
+            fold_timestamps(_cache + DICT_SIZE, n, true);
+            _cached_start = segment.start;
+            _cached_len = n;
+        }
+        const size_t from = static_cast<size_t>(*offset - segment.start);
+        size_t count = _cached_len - from;
+        if (count > max) count = max;
+        memcpy(dst, _cache + DICT_SIZE + from, count);
+        *offset += count;
+        return count;
+    }
+
+    if (_staging_len == 0 || *offset >= end()) return 0;
+    if (*offset < _staging_start) *offset = _staging_start;
+    const size_t from = static_cast<size_t>(*offset - _staging_start);
+    size_t count = _staging_len - from;
+    if (count > max) count = max;
+    memcpy(dst, _window + DICT_SIZE + from, count);
+    *offset += count;
+    return count;
+}
@@ -0,0 +1,679 @@
+/*
+ *  log_entry.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "log_entry.h"
+
+#include <stdio.h>
+#include <string.h>
+
+// Longest single conversion specification ("%-+#0123.456lld" and the like)
+// that is deferred. Anything longer is formatted at capture time.
+static const size_t SPEC_MAX = 24;
+
+// Tags in front of a %s argument.
+static const uint8_t STR_STATIC = 0;
+static const uint8_t STR_INLINE = 1;
+static const uint8_t STR_NULL = 2;
+
+// The capture predicate, applied again to every pointer read back out of an
+// entry: a reader resynchronising after a ring overwrite can take an inline
+// %s copy for a header, and its bytes for a format pointer. Unset, no
+// deferred entry is trusted.
+static log_entry_static_fn s_read_is_static = nullptr;
+
+enum arg_class_t {
+    ARG_NONE,     // "%%"
+    ARG_INT,
+    ARG_LONG,
+    ARG_LLONG,
+    ARG_INTMAX,
+    ARG_SIZE,
+    ARG_PTRDIFF,
+    ARG_DOUBLE,
+    ARG_PTR,
+    ARG_STR,
+};
+
+struct spec_t {
+    size_t len;           // '%' through the conversion character
+    int stars;            // '*' width and/or precision arguments
+    bool star_precision;  // the last star is the precision
+    int precision;        // literal precision, -1 if none
+    bool is_unsigned;
+    arg_class_t cls;
+};
+
+// Parse the conversion starting at p ('%'). False for anything the deferred
+// path cannot reproduce exactly.
+static bool parse_spec(const char *p, spec_t *s)
+{
+    const char *q = p + 1;
+    s->stars = 0;
+    s->star_precision = false;
+    s->precision = -1;
+    s->is_unsigned = false;
+
+    if (*q == '%') {
+        s->len = 2;
+        s->cls = ARG_NONE;
+        return true;
+    }
+
+    while (*q && strchr("-+ #0", *q)) q++;
+    if (*q == '*') {
+        s->stars++;
+        q++;
+    } else {
+        while (*q >= '0' && *q <= '9') q++;
+    }
+    if (*q == '.') {
+        q++;
+        if (*q == '*') {
+            s->stars++;
+            s->star_precision = true;
+            q++;
+        } else {
+            s->precision = 0;
+            while (*q >= '0' && *q <= '9') s->precision = s->precision * 10 + (*q++ - '0');
+        }
+    }
+
+    enum { LEN_NONE, LEN_L, LEN_LL, LEN_J, LEN_Z, LEN_T } length = LEN_NONE;
+    if (q[0] == 'h') {
+        q += (q[1] == 'h') ? 2 : 1;   // promoted to int
+    } else if (q[0] == 'l') {
+        if (q[1] == 'l') {
+            length = LEN_LL;
+            q += 2;
+        } else {
+            length = LEN_L;
+            q++;
+        }
+    } else if (*q == 'j') {
+        length = LEN_J;
+        q++;
+    } else if (*q == 'z') {
+        length = LEN_Z;
+        q++;
+    } else if (*q == 't') {
+        length = LEN_T;
+        q++;
+    }
+
+    switch (*q) {
+        case 'u': case 'o': case 'x': case 'X':
+            s->is_unsigned = true;
+            // fall through
+        case 'd': case 'i':
+            switch (length) {
+                case LEN_NONE: s->cls = ARG_INT; break;
+                case LEN_L:    s->cls = ARG_LONG; break;
+                case LEN_LL:   s->cls = ARG_LLONG; break;
+                case LEN_J:    s->cls = ARG_INTMAX; break;
+                case LEN_Z:    s->cls = ARG_SIZE; break;
+                case LEN_T:    s->cls = ARG_PTRDIFF; break;
+            }
+            break;
+        case 'c':
+            if (length != LEN_NONE) return false;
+            s->cls = ARG_INT;
+            break;
+        case 'f': case 'F': case 'e': case 'E':
+        case 'g': case 'G': case 'a': case 'A':
+            if (length != LEN_NONE && length != LEN_L) return false;
+            s->cls = ARG_DOUBLE;
+            break;
+        case 'p':
+            if (length != LEN_NONE) return false;
+            s->cls = ARG_PTR;
+            break;
+        case 's':
+            if (length != LEN_NONE) return false;
+            s->cls = ARG_STR;
+            break;
+        default:
+            // %n, long double, wide characters, glibc extensions, or a
+            // truncated specification at the end of the string.
+            return false;
+    }
+
+    s->len = (size_t)(q + 1 - p);
+    return s->len < SPEC_MAX;
+}
+
+template <typename T>
+static bool put(uint8_t *out, size_t cap, size_t *pos, T value)
+{
+    if (cap - *pos < sizeof(T)) return false;
+    memcpy(out + *pos, &value, sizeof(T));
+    *pos += sizeof(T);
+    return true;
+}
+
+template <typename T>
+static bool get(const uint8_t *entry, size_t len, size_t *pos, T *value)
+{
+    if (len - *pos < sizeof(T)) return false;
+    memcpy(value, entry + *pos, sizeof(T));
+    *pos += sizeof(T);
+    return true;
+}
+
+static void write_header(uint8_t *out, uint8_t kind, size_t len, uint32_t timestamp_ms)
+{
+    out[0] = LOG_ENTRY_MAGIC;
+    out[1] = kind;
+    out[2] = (uint8_t)(len & 0xFF);
+    out[3] = (uint8_t)(len >> 8);
+    out[4] = (uint8_t)~(out[0] ^ out[1] ^ out[2] ^ out[3]);
+    out[5] = (uint8_t)(timestamp_ms & 0xFF);
+    out[6] = (uint8_t)(timestamp_ms >> 8);
+    out[7] = (uint8_t)(timestamp_ms >> 16);
+    out[8] = (uint8_t)(timestamp_ms >> 24);
+}
+
+size_t log_entry_encode_deferred(uint8_t *out, size_t cap, uint32_t timestamp_ms,
+                                 const char *fmt, va_list args,
+                                 log_entry_static_fn is_static)
+{
+    if (!out || !fmt || !is_static || !is_static(fmt)) return 0;
+    if (cap > 0xFFFF) cap = 0xFFFF;
+    if (cap < LOG_ENTRY_HEADER_SIZE) return 0;
+
+    size_t pos = LOG_ENTRY_HEADER_SIZE;
+    if (!put(out, cap, &pos, (uintptr_t)fmt)) return 0;
+
+    for (const char *p = fmt; *p;) {
+        if (*p != '%') {
+            p++;
+            continue;
+        }
+        spec_t spec;
+        if (!parse_spec(p, &spec)) return 0;
+        p += spec.len;
+
+        int star_value = -1;
+        for (int i = 0; i < spec.stars; i++) {
+            star_value = va_arg(args, int);
+            if (!put(out, cap, &pos, star_value)) return 0;
+        }
+
+        bool ok = true;
+        switch (spec.cls) {
+            case ARG_NONE:
+                break;
+            case ARG_INT:
+                ok = put(out, cap, &pos, va_arg(args, int));
+                break;
+            case ARG_LONG:
+                ok = put(out, cap, &pos, va_arg(args, long));
+                break;
+            case ARG_LLONG:
+                ok = put(out, cap, &pos, va_arg(args, long long));
+                break;
+            case ARG_INTMAX:
+                ok = put(out, cap, &pos, va_arg(args, intmax_t));
+                break;
+            case ARG_SIZE:
+                ok = put(out, cap, &pos, va_arg(args, size_t));
+                break;
+            case ARG_PTRDIFF:
+                ok = put(out, cap, &pos, va_arg(args, ptrdiff_t));
+                break;
+            case ARG_DOUBLE:
+                ok = put(out, cap, &pos, va_arg(args, double));
+                break;
+            case ARG_PTR:
+                ok = put(out, cap, &pos, va_arg(args, void *));
+                break;
+            case ARG_STR: {
+                const char *str = va_arg(args, const char *);
+                if (!str) {
+                    ok = put(out, cap, &pos, STR_NULL);
+                } else if (is_static(str)) {
+                    ok = put(out, cap, &pos, STR_STATIC) &&
+                         put(out, cap, &pos, str);
+                } else {
+                    // Copy what the conversion will print; a precision bounds
+                    // the read just like printf itself.
+                    int limit = spec.precision;
+                    if (spec.star_precision) limit = star_value;
+                    const size_t n = limit >= 0 ? strnlen(str, (size_t)limit) : strlen(str);
+                    if (cap - pos < n + 2) return 0;
+                    out[pos++] = STR_INLINE;
+                    memcpy(out + pos, str, n);
+                    pos += n;
+                    out[pos++] = '\0';
+                }
+                break;
+            }
+        }
+        if (!ok) return 0;
+    }
+
+    write_header(out, LOG_ENTRY_DEFERRED, pos, timestamp_ms);
+    return pos;
+}
+
+size_t log_entry_encode_text(uint8_t *out, size_t cap, uint32_t timestamp_ms,
+                             const char *text, size_t len)
+{
+    if (!out || !text) return 0;
+    if (cap > 0xFFFF) cap = 0xFFFF;
+    if (cap <= LOG_ENTRY_HEADER_SIZE) return 0;
+    if (len > cap - LOG_ENTRY_HEADER_SIZE) len = cap - LOG_ENTRY_HEADER_SIZE;
+    memmove(out + LOG_ENTRY_HEADER_SIZE, text, len);
+    const size_t total = LOG_ENTRY_HEADER_SIZE + len;
+    write_header(out, LOG_ENTRY_TEXT, total, timestamp_ms);
+    return total;
+}
+
+size_t log_entry_length(const uint8_t *p, size_t avail)
+{
+    if (!p || avail < LOG_ENTRY_HEADER_SIZE) return 0;
+    if (p[0] != LOG_ENTRY_MAGIC) return 0;
+    if (p[1] != LOG_ENTRY_TEXT && p[1] != LOG_ENTRY_DEFERRED) return 0;
+    if (p[4] != (uint8_t)~(p[0] ^ p[1] ^ p[2] ^ p[3])) return 0;
+    const size_t len = (size_t)p[2] | ((size_t)p[3] << 8);
+    if (len < LOG_ENTRY_HEADER_SIZE) return 0;
+    if (p[1] == LOG_ENTRY_DEFERRED && len < LOG_ENTRY_HEADER_SIZE + sizeof(uintptr_t)) return 0;
+    return len;
+}
+
+void log_entry_set_static_fn(log_entry_static_fn is_static)
+{
+    s_read_is_static = is_static;
+}
+
+static bool pointer_ok(const char *p)
+{
+    return p && s_read_is_static && s_read_is_static(p);
+}
+
+uint32_t log_entry_timestamp(const uint8_t *entry)
+{
+    return (uint32_t)entry[5] | ((uint32_t)entry[6] << 8) |
+           ((uint32_t)entry[7] << 16) | ((uint32_t)entry[8] << 24);
+}
+
+// Where the arguments of a deferred entry start.
+static const size_t ARGS_POS = LOG_ENTRY_HEADER_SIZE + sizeof(uintptr_t);
+
+// Format of a deferred entry; NULL if the entry is corrupt.
+static const char *entry_format(const uint8_t *entry, size_t len)
+{
+    size_t pos = LOG_ENTRY_HEADER_SIZE;
+    uintptr_t fmt = 0;
+    if (!get(entry, len, &pos, &fmt)) return NULL;
+    const char *p = reinterpret_cast<const char *>(fmt);
+    return pointer_ok(p) ? p : NULL;
+}
+
+char log_entry_first_char(const uint8_t *entry, size_t len)
+{
+    if (log_entry_length(entry, len) != len) return 0;
+    if (entry[1] == LOG_ENTRY_TEXT) {
+        return len > LOG_ENTRY_HEADER_SIZE ? (char)entry[LOG_ENTRY_HEADER_SIZE] : 0;
+    }
+    const char *fmt = entry_format(entry, len);
+    return (fmt && fmt[0] != '%') ? fmt[0] : 0;
+}
+
+char log_entry_level(const uint8_t *entry, size_t len)
+{
+    if (log_entry_length(entry, len) != len) return 0;
+    const char *line;
+    size_t avail;
+    if (entry[1] == LOG_ENTRY_TEXT) {
+        line = reinterpret_cast<const char *>(entry + LOG_ENTRY_HEADER_SIZE);
+        avail = len - LOG_ENTRY_HEADER_SIZE;
+    } else {
+        line = entry_format(entry, len);
+        if (!line) return 0;
+        avail = strnlen(line, 16);
+    }
+    size_t i = 0;
+    if (avail > 0 && line[0] == '\033') {
+        while (i < avail && line[i] != 'm') i++;
+        i++;
+    }
+    if (i + 1 >= avail || line[i + 1] != ' ') return 0;
+    return (line[i] != '\0' && strchr("EWIDV", line[i])) ? line[i] : 0;
+}
+
+// Bytes the encoder stored for the value of one conversion; strings are
+// variable and read with get_str().
+static size_t value_size(arg_class_t cls)
+{
+    switch (cls) {
+        case ARG_NONE:    return 0;
+        case ARG_INT:     return sizeof(int);
+        case ARG_LONG:    return sizeof(long);
+        case ARG_LLONG:   return sizeof(long long);
+        case ARG_INTMAX:  return sizeof(intmax_t);
+        case ARG_SIZE:    return sizeof(size_t);
+        case ARG_PTRDIFF: return sizeof(ptrdiff_t);
+        case ARG_DOUBLE:  return sizeof(double);
+        case ARG_PTR:     return sizeof(void *);
+        case ARG_STR:     return 0;
+    }
+    return 0;
+}
+
+static bool get_str(const uint8_t *entry, size_t len, size_t *pos, const char **value)
+{
+    uint8_t tag = STR_NULL;
+    if (!get(entry, len, pos, &tag)) return false;
+    if (tag == STR_STATIC) return get(entry, len, pos, value) && pointer_ok(*value);
+    if (tag == STR_INLINE) {
+        const char *v = reinterpret_cast<const char *>(entry + *pos);
+        const size_t n = strnlen(v, len - *pos);
+        if (n >= len - *pos) return false;
+        *pos += n + 1;
+        *value = v;
+        return true;
+    }
+    *value = "(null)";
+    return true;
+}
+
+static void put_tag(char *out, size_t cap, size_t *n, const char *text, size_t len)
+{
+    if (len > cap - 1 - *n) len = cap - 1 - *n;
+    memcpy(out + *n, text, len);
+    *n += len;
+}
+
+// Tag of a text line and where its message starts; 0 if it has no tag.
+static size_t text_tag(const uint8_t *entry, size_t len, char *out, size_t cap,
+                       const char **message)
+{
+    size_t n = 0;
+    const char *line = reinterpret_cast<const char *>(entry + LOG_ENTRY_HEADER_SIZE);
+    const char *end = line + (len - LOG_ENTRY_HEADER_SIZE);
+    const char *p = static_cast<const char *>(memchr(line, ')', (size_t)(end - line)));
+    if (!p || end - p < 2 || p[1] != ' ') return 0;
+    const char *tag = p + 2;
+    for (p = tag; p + 1 < end && !(p[0] == ':' && p[1] == ' '); p++) {
+    }
+    if (p + 1 >= end) return 0;
+    put_tag(out, cap, &n, tag, (size_t)(p - tag));
+    out[n] = '\0';
+    if (message) *message = p + 2;
+    return n;
+}
+
+// Deferred: walk the format the way rendering would, but only through the
+// tag. The timestamp conversion is skipped, never formatted. *rest and
+// *rest_pos receive the format and argument position of the message.
+static size_t deferred_tag(const uint8_t *entry, size_t len, char *out, size_t cap,
+                           const char **rest, size_t *rest_pos)
+{
+    size_t n = 0;
+    size_t pos = ARGS_POS;
+    const char *p = entry_format(entry, len);
+    if (!p) return 0;
+    bool in_tag = false;
+    while (*p) {
+        if (*p != '%') {
+            if (!in_tag && p[0] == ')' && p[1] == ' ') {
+                in_tag = true;
+                p += 2;
+            } else if (in_tag && p[0] == ':' && p[1] == ' ') {
+                out[n] = '\0';
+                if (rest) *rest = p + 2;
+                if (rest_pos) *rest_pos = pos;
+                return n;
+            } else {
+                if (in_tag) put_tag(out, cap, &n, p, 1);
+                p++;
+            }
+            continue;
+        }
+        spec_t spec;
+        if (!parse_spec(p, &spec)) return 0;
+        p += spec.len;
+        pos += (size_t)spec.stars * sizeof(int);
+        if (pos > len) return 0;
+        if (spec.cls == ARG_STR) {
+            const char *v = nullptr;
+            if (!get_str(entry, len, &pos, &v)) return 0;
+            if (in_tag) put_tag(out, cap, &n, v, strlen(v));
+        } else if (in_tag && spec.cls == ARG_NONE) {
+            put_tag(out, cap, &n, "%", 1);
+        } else if (in_tag || len - pos < value_size(spec.cls)) {
+            return 0;
+        } else {
+            pos += value_size(spec.cls);
+        }
+    }
+    out[0] = '\0';
+    return 0;
+}
+
+size_t log_entry_tag(const uint8_t *entry, size_t len, char *out, size_t cap)
+{
+    if (!out || cap == 0) return 0;
+    out[0] = '\0';
+    // Also validates the entry: only "L (time) TAG: " lines have a tag.
+    if (log_entry_level(entry, len) == 0) return 0;
+    if (entry[1] == LOG_ENTRY_TEXT) return text_tag(entry, len, out, cap, nullptr);
+    return deferred_tag(entry, len, out, cap, nullptr, nullptr);
+}
+
+// snprintf one conversion with its star arguments in front of the value.
+template <typename T>
+static int emit(char *out, size_t room, const char *spec, const int *stars,
+                int star_count, T value)
+{
+    switch (star_count) {
+        case 0: return snprintf(out, room, spec, value);
+        case 1: return snprintf(out, room, spec, stars[0], value);
+        default: return snprintf(out, room, spec, stars[0], stars[1], value);
+    }
+}
+
+// Render the format from p on, with its arguments from entry offset pos.
+// Returns the characters written; *cut is set if the output was cut. A
+// string that fails get_str() makes the entry corrupt: nothing is rendered.
+static size_t render_format(const uint8_t *entry, size_t len, const char *p, size_t pos,
+                            char *out, size_t cap, bool *cut)
+{
+    size_t n = 0;
+    *cut = false;
+    while (*p && !*cut) {
+        if (*p != '%') {
+            if (n + 1 >= cap) {
+                *cut = true;
+                break;
+            }
+            out[n++] = *p++;
+            continue;
+        }
+
+        spec_t spec;
+        if (!parse_spec(p, &spec)) break;   // cannot happen: encoded with it
+        char fmt_spec[SPEC_MAX];
+        memcpy(fmt_spec, p, spec.len);
+        fmt_spec[spec.len] = '\0';
+        p += spec.len;
+
+        int stars[2] = {0, 0};
+        bool ok = true;
+        for (int i = 0; i < spec.stars; i++) ok = ok && get(entry, len, &pos, &stars[i]);
+
+        char *dst = out + n;
+        const size_t room = cap - n;
+        int written = 0;
+        switch (spec.cls) {
+            case ARG_NONE:
+                written = snprintf(dst, room, "%%");
+                break;
+            case ARG_INT: {
+                int v = 0;
+                ok = ok && get(entry, len, &pos, &v);
+                written = spec.is_unsigned
+                    ? emit(dst, room, fmt_spec, stars, spec.stars, (unsigned)v)
+                    : emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+            case ARG_LONG: {
+                long v = 0;
+                ok = ok && get(entry, len, &pos, &v);
+                written = spec.is_unsigned
+                    ? emit(dst, room, fmt_spec, stars, spec.stars, (unsigned long)v)
+                    : emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+            case ARG_LLONG: {
+                long long v = 0;
+                ok = ok && get(entry, len, &pos, &v);
+                written = spec.is_unsigned
+                    ? emit(dst, room, fmt_spec, stars, spec.stars, (unsigned long long)v)
+                    : emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+            case ARG_INTMAX: {
+                intmax_t v = 0;
+                ok = ok && get(entry, len, &pos, &v);
+                written = spec.is_unsigned
+                    ? emit(dst, room, fmt_spec, stars, spec.stars, (uintmax_t)v)
+                    : emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+            case ARG_SIZE: {
+                size_t v = 0;
+                ok = ok && get(entry, len, &pos, &v);
+                written = emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+            case ARG_PTRDIFF: {
+                ptrdiff_t v = 0;
+                ok = ok && get(entry, len, &pos, &v);
+                written = emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+            case ARG_DOUBLE: {
+                double v = 0;
+                ok = ok && get(entry, len, &pos, &v);
+                written = emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+            case ARG_PTR: {
+                void *v = NULL;
+                ok = ok && get(entry, len, &pos, &v);
+                written = emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+            case ARG_STR: {
+                const char *v = "(null)";
+                if (!ok) break;
+                if (!get_str(entry, len, &pos, &v)) {
+                    *cut = false;
+                    return 0;
+                }
+                written = emit(dst, room, fmt_spec, stars, spec.stars, v);
+                break;
+            }
+        }
+        if (!ok) break;   // truncated entry; keep what was rendered
+        if (written < 0) continue;
+        if ((size_t)written >= room) {
+            n = cap - 1;
+            *cut = true;
+        } else {
+            n += (size_t)written;
+        }
+    }
+    return n;
+}
+
+size_t log_entry_render(const uint8_t *entry, size_t len, char *out, size_t cap)
+{
+    if (!out || cap == 0) return 0;
+    out[0] = '\0';
+    if (log_entry_length(entry, len) != len) return 0;
+    if (cap > LOG_LINE_MAX) cap = LOG_LINE_MAX;
+
+    size_t n = 0;
+    bool cut = false;
+
+    if (entry[1] == LOG_ENTRY_TEXT) {
+        n = len - LOG_ENTRY_HEADER_SIZE;
+        if (n > cap - 1) {
+            n = cap - 1;
+            cut = true;
+        }
+        memcpy(out, entry + LOG_ENTRY_HEADER_SIZE, n);
+    } else {
+        const char *fmt = entry_format(entry, len);
+        if (!fmt) return 0;
+        n = render_format(entry, len, fmt, ARGS_POS, out, cap, &cut);
+    }
+
+    // A cut line still ends like a line, so consumers keep their framing.
+    if (cut && n > 0) out[n - 1] = '\n';
+    out[n] = '\0';
+    return n;
+}
+
+size_t log_entry_message(const uint8_t *entry, size_t len, char *out, size_t cap)
+{
+    if (!out || cap == 0) return 0;
+    out[0] = '\0';
+    if (cap > LOG_LINE_MAX) cap = LOG_LINE_MAX;
+
+    size_t n = 0;
+    char tag[2];
+    if (log_entry_level(entry, len) == 0) {
+        n = log_entry_render(entry, len, out, cap);
+    } else if (entry[1] == LOG_ENTRY_TEXT) {
+        const char *message = nullptr;
+        if (text_tag(entry, len, tag, sizeof(tag), &message) == 0) {
+            n = log_entry_render(entry, len, out, cap);
+        } else {
+            n = (size_t)(reinterpret_cast<const char *>(entry) + len - message);
+            if (n > cap - 1) n = cap - 1;
+            memcpy(out, message, n);
+        }
+    } else {
+        const char *rest = nullptr;
+        size_t pos = 0;
+        bool cut = false;
+        if (deferred_tag(entry, len, tag, sizeof(tag), &rest, &pos) == 0) {
+            n = log_entry_render(entry, len, out, cap);
+        } else {
+            n = render_format(entry, len, rest, pos, out, cap, &cut);
+        }
+    }
+
+    // The newline and the colour reset belong to the line, not the message.
+    static const char RESET[] = "\033[0m";
+    if (n > 0 && out[n - 1] == '\n') n--;
+    if (n >= sizeof(RESET) - 1 &&
+        memcmp(out + n - (sizeof(RESET) - 1), RESET, sizeof(RESET) - 1) == 0) {
+        n -= sizeof(RESET) - 1;
+    }
+    out[n] = '\0';
+    return n;
+}
@@ -0,0 +1,136 @@
+/*
+ *  log_index.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "log_index.h"
+
+// meta: entry length (9 bits), level rank (3 bits), tag hash (20 bits).
+static constexpr uint32_t LEN_MASK = 0x1FF;
+static constexpr unsigned RANK_SHIFT = 9;
+static constexpr unsigned TAG_SHIFT = 12;
+static constexpr uint32_t TAG_MASK = (1u << LogIndex::TAG_BITS) - 1;
+
+static_assert((LogIndex::SLOTS & (LogIndex::SLOTS - 1)) == 0,
+              "slot numbers must stay aligned across the 2^32 wrap");
+static_assert(TAG_SHIFT + LogIndex::TAG_BITS == 32, "meta is one word");
+
+uint8_t log_level_rank(char level) {
+    switch (level) {
+        case 'E': return 1;
+        case 'W': return 2;
+        case 'I': return 3;
+        case 'D': return 4;
+        case 'V': return 5;
+        default:  return 0;
+    }
+}
+
+uint32_t log_tag_hash(const char *tag, size_t len) {
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)tag[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void LogIndex::record(uint64_t end, size_t len, uint8_t rank, uint32_t tag_hash) {
+    // Entries are at most LOG_ENTRY_MAX bytes; anything else is left out
+    // and shows up as a coverage gap.
+    if (len == 0 || len > LEN_MASK) return;
+    Slot &slot = _slots[_next.fetch_add(1, std::memory_order_relaxed) & (SLOTS - 1)];
+    // An end word of 0 marks the slot empty. The rare line that really ends
+    // at a multiple of 2^32 is simply not indexed.
+    slot.end.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.meta.store((uint32_t)len | ((uint32_t)(rank & 7) << RANK_SHIFT) |
+                        ((tag_hash & TAG_MASK) << TAG_SHIFT),
+                    std::memory_order_relaxed);
+    slot.end.store((uint32_t)end, std::memory_order_release);
+}
+
+void LogIndex::clear() {
+    for (Slot &slot : _slots) slot.end.store(0, std::memory_order_relaxed);
+}
+
+// Read one slot consistently and place it in the 64-bit stream relative to
+// end. False for empty and torn slots and for entries past end.
+bool LogIndex::load(size_t slot, uint64_t end, Record *record) const {
+    const Slot &s = _slots[slot];
+    const uint32_t end_lo = s.end.load(std::memory_order_acquire);
+    const uint32_t meta = s.meta.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (end_lo == 0 || s.end.load(std::memory_order_relaxed) != end_lo) return false;
+
+    const uint32_t behind = (uint32_t)end - end_lo;
+    if (behind >= 0x80000000u || behind > end) return false;
+    const uint32_t len = meta & LEN_MASK;
+    record->end = end - behind;
+    if (record->end < len) return false;
+    record->start = record->end - len;
+    record->meta = meta;
+    return true;
+}
+
+uint64_t LogIndex::coveredFrom(uint64_t from, uint64_t end) const {
+    // Entries never overlap, so the indexed lines from the oldest one (or
+    // from the query start) on account for every byte up to end exactly
+    // when nothing in between is missing.
+    uint64_t floor = end;
+    Record r;
+    for (size_t i = 0; i < SLOTS; i++) {
+        if (load(i, end, &r) && r.start < floor) floor = r.start;
+    }
+    if (floor < from) floor = from;
+    uint64_t covered = 0;
+    for (size_t i = 0; i < SLOTS; i++) {
+        if (load(i, end, &r) && r.start >= floor) covered += r.end - r.start;
+    }
+    return covered == end - floor ? floor : end;
+}
+
+size_t LogIndex::find(uint64_t from, uint64_t end, uint8_t max_rank, uint32_t tag_hash,
+                      Hit *out, size_t max) const {
+    if (max == 0) return 0;
+    size_t count = 0;
+    Record r;
+    // Oldest slot first: slots are then nearly in stream order, so keeping
+    // the hits sorted rarely moves more than one of them.
+    const uint32_t oldest = _next.load(std::memory_order_relaxed);
+    for (size_t i = 0; i < SLOTS; i++) {
+        if (!load((oldest + i) & (SLOTS - 1), end, &r) || r.start < from) continue;
+        const uint8_t rank = (uint8_t)((r.meta >> RANK_SHIFT) & 7);
+        if (max_rank != 0 && (rank == 0 || rank > max_rank)) continue;
+        if (tag_hash != ANY_TAG && (r.meta >> TAG_SHIFT) != (tag_hash & TAG_MASK)) continue;
+
+        // Keep the max lowest offsets.
+        if (count == max && r.start >= out[count - 1].start) continue;
+        size_t at = count < max ? count++ : count - 1;
+        while (at > 0 && out[at - 1].start > r.start) {
+            out[at] = out[at - 1];
+            at--;
+        }
+        out[at] = {r.start, (uint16_t)(r.end - r.start)};
+    }
+    return count;
+}
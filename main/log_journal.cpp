@@ -0,0 +1,253 @@
+/*
+ *  log_journal.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "log_journal.h"
+#include "log_journal_store.h"
+#include "log_manager.h"
+#include "metrics.h"
+#include "reset_info.h"
+#include "webui_storage.h"
+#include "esp_app_desc.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "freertos/semphr.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *TAG = "LogJournal";
+
+// One SPIFFS block per write.
+static constexpr size_t JOURNAL_BATCH = 4096;
+// Two files of this size at most; less if the partition is short of room.
+static constexpr size_t JOURNAL_FILE_MAX = 16 * 1024;
+// Free space the journal always leaves to SPIFFS, for its garbage
+// collection and for the WebUI files.
+static constexpr size_t JOURNAL_FS_RESERVE = 16 * 1024;
+static constexpr int64_t JOURNAL_MAX_DELAY_US = 30LL * 1000 * 1000;
+static constexpr TickType_t JOURNAL_POLL = pdMS_TO_TICKS(5000);
+// About 0.8 MB a day. SPIFFS spreads it over the free blocks of the
+// partition, which keeps them well inside their erase cycles for the life
+// of the device.
+static constexpr uint32_t JOURNAL_BYTES_PER_HOUR = 32 * 1024;
+static constexpr uint32_t JOURNAL_BURST = 32 * 1024;
+
+static MetricsCounter g_journal_bytes("hbrfeth_log_journal_bytes_total",
+                                      "Log bytes written to the flash journal");
+static MetricsCounter g_journal_writes("hbrfeth_log_journal_writes_total",
+                                       "Batched flash writes of the log journal");
+static MetricsCounter g_journal_gaps("hbrfeth_log_journal_gaps_total",
+                                     "Places where captured lines are missing from the journal");
+
+static StaticSemaphore_t s_mutex_buffer;
+
+static SemaphoreHandle_t journal_mutex()
+{
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutexStatic(&s_mutex_buffer);
+    return mutex;
+}
+
+static TaskHandle_t s_task = NULL;
+// Everything below is guarded by journal_mutex().
+static LogJournalStore s_store;
+static LogWriteBudget s_budget;
+static char *s_batch = NULL;
+static size_t s_batch_len = 0;
+static int64_t s_pending_since = 0;
+static uint64_t s_cursor = 0;
+static bool s_gap = false;
+
+struct JournalWrite {
+    bool over_budget;
+    bool written;
+};
+
+struct JournalRead {
+    uint64_t *position;
+    char *dst;
+    size_t max;
+    uint64_t end;
+    size_t copied;
+};
+
+static void journal_note(const char *text)
+{
+    const size_t len = strlen(text);
+    if (JOURNAL_BATCH - s_batch_len < len) return;
+    if (s_batch_len == 0) s_pending_since = esp_timer_get_time();
+    memcpy(s_batch + s_batch_len, text, len);
+    s_batch_len += len;
+}
+
+// Move new lines from the log into the batch, never cutting one.
+static void journal_collect()
+{
+    LogManager &log = LogManager::instance();
+    const uint64_t total = log.getTotalWritten();
+    if (!log.isEnabled()) {
+        s_cursor = total;
+        return;
+    }
+    const size_t buffered = log.getBufferedBytes();
+    if (buffered > 0 && s_cursor < total - buffered) {
+        // The writer fell behind the log; lines were overwritten unread.
+        s_gap = true;
+        g_journal_gaps.inc();
+        s_cursor = total - buffered;
+    }
+    if (s_gap && JOURNAL_BATCH - s_batch_len >= LOG_LINE_MAX) {
+        journal_note("--- lines missing from the journal ---\n");
+        s_gap = false;
+    }
+
+    // Below half the budget only warnings and errors are kept, so a chatty
+    // hour does not crowd out the lines that explain a failure.
+    LogManager::LogFilter filter;
+    if (s_budget.available(esp_timer_get_time()) < JOURNAL_BURST / 2) {
+        filter.max_rank = log_level_rank('W');
+    }
+    while (JOURNAL_BATCH - s_batch_len >= LOG_LINE_MAX && s_cursor < total) {
+        const uint64_t before = s_cursor;
+        const size_t n = log.readFiltered(filter, &s_cursor, total, s_batch + s_batch_len,
+                                          JOURNAL_BATCH - s_batch_len);
+        if (n > 0 && s_batch_len == 0) s_pending_since = esp_timer_get_time();
+        s_batch_len += n;
+        if (n == 0 && s_cursor == before) break;
+    }
+}
+
+static void journal_write_files(const char *base_path, size_t free_bytes, void *context)
+{
+    JournalWrite *write = static_cast<JournalWrite *>(context);
+    s_store.configure(base_path, JOURNAL_FILE_MAX);
+    // What the journal may occupy: its own files plus the free space above
+    // the reserve, split over the two files.
+    const size_t room = free_bytes + s_store.size();
+    if (room < JOURNAL_FS_RESERVE + 2 * (JOURNAL_BATCH + LogJournalStore::HEADER_SIZE)) {
+        return;
+    }
+    size_t file_max = (room - JOURNAL_FS_RESERVE) / 2;
+    if (file_max > JOURNAL_FILE_MAX) file_max = JOURNAL_FILE_MAX;
+    s_store.configure(base_path, file_max);
+
+    if (!s_budget.take(s_batch_len, esp_timer_get_time())) {
+        write->over_budget = true;
+        return;
+    }
+    write->written = s_store.append(s_batch, s_batch_len);
+}
+
+static void journal_flush_locked()
+{
+    if (s_batch_len == 0) return;
+    JournalWrite write = {false, false};
+    if (!webui_storage_with_files(journal_write_files, &write)) {
+        // No WWW partition right now; keep the batch for the next attempt.
+        return;
+    }
+    if (write.written) {
+        g_journal_writes.inc();
+        g_journal_bytes.inc((uint32_t)s_batch_len);
+    } else {
+        if (!write.over_budget) ESP_LOGW(TAG, "Journal write failed, %u bytes lost",
+                                         (unsigned)s_batch_len);
+        s_gap = true;
+        g_journal_gaps.inc();
+    }
+    s_batch_len = 0;
+}
+
+static void journal_task(void *)
+{
+    for (;;) {
+        vTaskDelay(JOURNAL_POLL);
+        // Without the WWW partition there is nowhere to write; the log is
+        // not read, so no gaps are counted for it either.
+        const WebUIStorageStatus storage = webui_storage_get_status();
+        if (!storage.mounted || storage.updateActive) continue;
+        xSemaphoreTake(journal_mutex(), portMAX_DELAY);
+        journal_collect();
+        const bool full = JOURNAL_BATCH - s_batch_len < LOG_LINE_MAX;
+        const bool due = s_batch_len > 0 &&
+                         esp_timer_get_time() - s_pending_since >= JOURNAL_MAX_DELAY_US;
+        if (full || due) journal_flush_locked();
+        xSemaphoreGive(journal_mutex());
+    }
+}
+
+esp_err_t log_journal_start(void)
+{
+    if (s_task) return ESP_OK;
+    s_batch = static_cast<char *>(malloc(JOURNAL_BATCH));
+    if (!s_batch) return ESP_ERR_NO_MEM;
+
+    s_budget.configure(JOURNAL_BYTES_PER_HOUR, JOURNAL_BURST, esp_timer_get_time());
+    // The leading newline ends a line the previous boot may have left cut.
+    const esp_app_desc_t *app = esp_app_get_description();
+    const char *reason = ResetInfo::getEspResetReason();
+    s_batch_len = (size_t)snprintf(s_batch, JOURNAL_BATCH,
+                                   "\n=== boot: firmware %s, reset %s ===\n",
+                                   app ? app->version : "?", reason ? reason : "?");
+    s_pending_since = esp_timer_get_time();
+
+    if (xTaskCreate(journal_task, "log_journal", 3584, NULL, 1, &s_task) != pdPASS) {
+        free(s_batch);
+        s_batch = NULL;
+        s_batch_len = 0;
+        s_task = NULL;
+        return ESP_ERR_NO_MEM;
+    }
+    ESP_LOGI(TAG, "Log journal started");
+    return ESP_OK;
+}
+
+void log_journal_flush(void)
+{
+    if (!s_task || xSemaphoreTake(journal_mutex(), pdMS_TO_TICKS(1000)) != pdTRUE) return;
+    journal_collect();
+    journal_flush_locked();
+    xSemaphoreGive(journal_mutex());
+}
+
+static void journal_read_files(const char *base_path, size_t, void *context)
+{
+    JournalRead *read = static_cast<JournalRead *>(context);
+    s_store.configure(base_path, JOURNAL_FILE_MAX);
+    read->copied = s_store.read(read->position, read->dst, read->max);
+    read->end = s_store.end();
+}
+
+size_t log_journal_read(uint64_t *position, char *dst, size_t max, uint64_t *end)
+{
+    if (end) *end = 0;
+    if (!position || !dst || max == 0 || !s_task) return 0;
+    if (xSemaphoreTake(journal_mutex(), pdMS_TO_TICKS(1000)) != pdTRUE) return 0;
+    JournalRead read = {position, dst, max, 0, 0};
+    webui_storage_with_files(journal_read_files, &read);
+    xSemaphoreGive(journal_mutex());
+    if (end) *end = read.end;
+    return read.copied;
+}
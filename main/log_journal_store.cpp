@@ -0,0 +1,181 @@
+/*
+ *  log_journal_store.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "log_journal_store.h"
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+
+static const char MAGIC[4] = {'H', 'B', 'J', '1'};
+
+void LogJournalStore::configure(const char *dir, size_t file_max) {
+    snprintf(_current, sizeof(_current), "%s/journal.log", dir);
+    snprintf(_previous, sizeof(_previous), "%s/journal.old", dir);
+    _file_max = file_max > HEADER_SIZE ? file_max : HEADER_SIZE + 1;
+}
+
+// Header and size of one file; a file with a damaged header is removed and
+// reported absent.
+bool LogJournalStore::inspect(const char *path, FileInfo *info) {
+    *info = {false, 0, 0};
+    struct stat st = {};
+    if (stat(path, &st) != 0) return false;
+    FILE *file = fopen(path, "rb");
+    if (!file) return false;
+    uint8_t header[HEADER_SIZE];
+    const bool ok = fread(header, 1, sizeof(header), file) == sizeof(header) &&
+                    memcmp(header, MAGIC, sizeof(MAGIC)) == 0;
+    fclose(file);
+    if (!ok || (size_t)st.st_size < HEADER_SIZE) {
+        remove(path);
+        return false;
+    }
+    uint64_t base = 0;
+    for (int i = 7; i >= 0; i--) base = (base << 8) | header[8 + i];
+    *info = {true, base, (size_t)st.st_size - HEADER_SIZE};
+    return true;
+}
+
+bool LogJournalStore::create(const char *path, uint64_t base) {
+    uint8_t header[HEADER_SIZE] = {};
+    memcpy(header, MAGIC, sizeof(MAGIC));
+    for (int i = 0; i < 8; i++) header[8 + i] = (uint8_t)(base >> (8 * i));
+    FILE *file = fopen(path, "wb");
+    if (!file) return false;
+    const bool ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+    return fclose(file) == 0 && ok;
+}
+
+void LogJournalStore::files(FileInfo *previous, FileInfo *current) {
+    inspect(_previous, previous);
+    inspect(_current, current);
+    // A previous file that does not end where the current one starts is
+    // left over from an interrupted rotation.
+    if (previous->present && current->present &&
+        previous->base + previous->data != current->base) {
+        remove(_previous);
+        previous->present = false;
+    }
+}
+
+bool LogJournalStore::append(const char *data, size_t len) {
+    if (_file_max == 0 || !data || len == 0) return false;
+    const size_t capacity = _file_max - HEADER_SIZE;
+    if (len > capacity) len = capacity;
+
+    FileInfo previous, current;
+    files(&previous, &current);
+    if (!current.present) {
+        const uint64_t base = previous.present ? previous.base + previous.data : 0;
+        if (!create(_current, base)) return false;
+        current = {true, base, 0};
+    }
+    if (current.data + len > capacity) {
+        remove(_previous);
+        if (rename(_current, _previous) != 0) return false;
+        const uint64_t base = current.base + current.data;
+        if (!create(_current, base)) return false;
+        current = {true, base, 0};
+    }
+
+    FILE *file = fopen(_current, "ab");
+    if (!file) return false;
+    const bool ok = fwrite(data, 1, len, file) == len;
+    return fclose(file) == 0 && ok;
+}
+
+size_t LogJournalStore::read(uint64_t *position, char *dst, size_t max) {
+    FileInfo previous, current;
+    files(&previous, &current);
+    const FileInfo *held[2] = {&previous, &current};
+    for (const FileInfo *info : held) {
+        if (!info->present || *position >= info->base + info->data) continue;
+        if (*position < info->base) *position = info->base;
+        const size_t at = (size_t)(*position - info->base);
+        size_t count = info->data - at;
+        if (count > max) count = max;
+        FILE *file = fopen(info == &previous ? _previous : _current, "rb");
+        if (!file) return 0;
+        size_t got = 0;
+        if (fseek(file, (long)(HEADER_SIZE + at), SEEK_SET) == 0) {
+            got = fread(dst, 1, count, file);
+        }
+        fclose(file);
+        *position += got;
+        return got;
+    }
+    if (current.present && *position > current.base + current.data) {
+        *position = current.base + current.data;
+    }
+    return 0;
+}
+
+uint64_t LogJournalStore::oldest() {
+    FileInfo previous, current;
+    files(&previous, &current);
+    if (previous.present) return previous.base;
+    return current.present ? current.base : 0;
+}
+
+uint64_t LogJournalStore::end() {
+    FileInfo previous, current;
+    files(&previous, &current);
+    if (current.present) return current.base + current.data;
+    return previous.present ? previous.base + previous.data : 0;
+}
+
+size_t LogJournalStore::size() {
+    FileInfo previous, current;
+    files(&previous, &current);
+    return (previous.present ? previous.data : 0) + (current.present ? current.data : 0);
+}
+
+void LogWriteBudget::configure(uint32_t bytes_per_hour, uint32_t burst, int64_t now_us) {
+    _rate = bytes_per_hour;
+    _burst = burst;
+    _tokens = burst;
+    _last_us = now_us;
+}
+
+void LogWriteBudget::refill(int64_t now_us) {
+    if (now_us <= _last_us) return;
+    const uint64_t added = (uint64_t)(now_us - _last_us) * _rate / 3600000000ull;
+    if (added == 0) return;
+    // Whole bytes only; the clock advances by the time they took, so slow
+    // polling loses no budget.
+    _last_us += (int64_t)(added * 3600000000ull / _rate);
+    _tokens = added >= _burst - _tokens ? _burst : _tokens + (uint32_t)added;
+}
+
+bool LogWriteBudget::take(size_t len, int64_t now_us) {
+    refill(now_us);
+    if (len > _tokens) return false;
+    _tokens -= (uint32_t)len;
+    return true;
+}
+
+uint32_t LogWriteBudget::available(int64_t now_us) {
+    refill(now_us);
+    return _tokens;
+}
@@ -0,0 +1,120 @@
+/*
+ *  log_limiter.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "log_limiter.h"
+
+void LogLimiter::configure(uint16_t lines_per_second, uint16_t burst, uint32_t now_us) {
+    if (lines_per_second > MAX_RATE) lines_per_second = MAX_RATE;
+    if (burst < 1) burst = 1;
+    if (burst > MAX_BURST) burst = MAX_BURST;
+
+    const uint32_t interval = lines_per_second ? 1000000u / lines_per_second : 0;
+    // Disable first so admit() never pairs a new interval with an old
+    // tolerance; a line racing the switch is simply admitted.
+    _interval_us.store(0, std::memory_order_relaxed);
+    _tolerance_us.store(interval * (uint32_t)(burst - 1), std::memory_order_relaxed);
+    for (Bucket &bucket : _buckets) bucket.tat.store(now_us, std::memory_order_relaxed);
+    _overflow.tat.store(now_us, std::memory_order_relaxed);
+    _rate.store(lines_per_second, std::memory_order_relaxed);
+    _burst.store(lines_per_second ? burst : 0, std::memory_order_relaxed);
+    _interval_us.store(interval, std::memory_order_release);
+}
+
+LogLimiter::Bucket &LogLimiter::bucketFor(const char *tag, uint32_t now_us) {
+    for (Bucket &bucket : _buckets) {
+        const char *held = bucket.tag.load(std::memory_order_acquire);
+        if (held == tag) return bucket;
+        if (held == nullptr) {
+            // Claim the first free slot, full. Losing the race to another
+            // tag just moves on to the next slot.
+            bucket.tat.store(now_us, std::memory_order_relaxed);
+            if (bucket.tag.compare_exchange_strong(held, tag, std::memory_order_acq_rel) ||
+                held == tag) {
+                return bucket;
+            }
+        }
+    }
+    return _overflow;
+}
+
+bool LogLimiter::admit(const char *tag, uint32_t now_us) {
+    const uint32_t interval = _interval_us.load(std::memory_order_acquire);
+    if (interval == 0 || tag == nullptr) return true;
+    const uint32_t tolerance = _tolerance_us.load(std::memory_order_relaxed);
+
+    Bucket &bucket = bucketFor(tag, now_us);
+    uint32_t tat = bucket.tat.load(std::memory_order_relaxed);
+    for (;;) {
+        // The bucket is full when its arrival time lies in the past. A lead
+        // well beyond one burst cannot come from admit() and means the value
+        // is from before a wrap of the 32-bit clock. The slack covers tasks
+        // that read the clock and were preempted before getting here.
+        const int32_t lead = (int32_t)(tat - now_us);
+        const bool stale = lead < 0 || (uint32_t)lead > tolerance + interval + REORDER_SLACK_US;
+        const uint32_t base = stale ? now_us : tat;
+        if (base - now_us > tolerance) break;
+        if (bucket.tat.compare_exchange_weak(tat, base + interval, std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+
+    bucket.pending.fetch_add(1, std::memory_order_relaxed);
+    bucket.total.fetch_add(1, std::memory_order_relaxed);
+    _suppressed_total.fetch_add(1, std::memory_order_relaxed);
+    _summary_pending.store(true, std::memory_order_release);
+    return false;
+}
+
+bool LogLimiter::summaryDue(uint32_t now_us) {
+    if (!_summary_pending.load(std::memory_order_acquire)) return false;
+    uint32_t last = _last_summary_us.load(std::memory_order_relaxed);
+    if (now_us - last < SUMMARY_INTERVAL_US) return false;
+    // One caller wins the interval; the others keep logging normally.
+    if (!_last_summary_us.compare_exchange_strong(last, now_us, std::memory_order_relaxed)) {
+        return false;
+    }
+    _summary_pending.store(false, std::memory_order_release);
+    return true;
+}
+
+bool LogLimiter::takeSummary(size_t *cursor, const char **tag, uint32_t *count) {
+    while (*cursor <= TAG_SLOTS) {
+        Bucket &bucket = *cursor < TAG_SLOTS ? _buckets[*cursor] : _overflow;
+        (*cursor)++;
+        const uint32_t pending = bucket.pending.exchange(0, std::memory_order_relaxed);
+        if (pending == 0) continue;
+        *tag = &bucket == &_overflow ? nullptr : bucket.tag.load(std::memory_order_acquire);
+        *count = pending;
+        return true;
+    }
+    return false;
+}
+
+bool LogLimiter::slotTotal(size_t index, const char **tag, uint32_t *suppressed) const {
+    if (index > TAG_SLOTS) return false;
+    const Bucket &bucket = index < TAG_SLOTS ? _buckets[index] : _overflow;
+    *tag = index < TAG_SLOTS ? bucket.tag.load(std::memory_order_acquire) : nullptr;
+    if (index < TAG_SLOTS && *tag == nullptr) return false;
+    *suppressed = bucket.total.load(std::memory_order_relaxed);
+    return true;
+}
@@ -25,12 +25,15 @@
 #include <esp_log.h>
 #include <esp_timer.h>
 #include <esp_heap_caps.h>
+#include <esp_memory_utils.h>
+#include <freertos/task.h>
 #include <nvs.h>
 #include <nvs_flash.h>
 #include "nvs_storage_lock.h"
 #include <string.h>
 #include <stdio.h>
 #include <stdarg.h>
+#include <inttypes.h>
 #include <cstdlib>
 
 static const char *TAG = "LogManager";
@@ -45,54 +48,134 @@ LogManager& LogManager::instance() {
     return instance;
 }
 
+// Format strings and TAG literals live in the flash-mapped DROM segment for
+// the whole boot, so a deferred entry may keep pointers to them.
+static bool log_ptr_is_static(const void *ptr) {
+    return esp_ptr_in_drom(ptr);
+}
+
+// Tag of an ESP_LOGx line, or nullptr for anything else (raw printf-style
+// output, ESP_LOG_BUFFER dumps). The log macros expand to an optional colour
+// escape, the level letter and " (%" PRIu32 ") %s: ", so the timestamp and
+// the tag are always the first two arguments.
+static const char *log_line_tag(const char *fmt, va_list args) {
+    static const char LAYOUT[] = " (%" PRIu32 ") %s: ";
+    const char *p = fmt;
+    if (*p == '\033') {
+        p = strchr(p, 'm');
+        if (!p) return nullptr;
+        p++;
+    }
+    if (*p == '\0' || !strchr("EWIDV", *p)) return nullptr;
+    if (strncmp(p + 1, LAYOUT, sizeof(LAYOUT) - 1) != 0) return nullptr;
+    va_list copy;
+    va_copy(copy, args);
+    (void)va_arg(copy, uint32_t);
+    const char *tag = va_arg(copy, const char *);
+    va_end(copy);
+    return tag;
+}
+
 // Custom vprintf handler to capture logs
 // Note: This must NOT be static because it's a friend function declared in the header with extern linkage
 int log_vprintf(const char *fmt, va_list args) {
     LogManager &manager = LogManager::instance();
 
+    // Per-tag budget, checked before the line costs anything: a storm from
+    // one subsystem is dropped here instead of being formatted, captured,
+    // fanned out to syslog and the WebSocket and pushed through the UART
+    // while the relay tasks wait for CPU. Dropped lines are reported as
+    // "N lines suppressed" summaries, emitted from whichever line comes
+    // next once the summary interval has passed.
+    if (manager._limiter.enabled()) {
+        const char *tag = log_line_tag(fmt, args);
+        if (tag) {
+            const uint32_t now_us = (uint32_t)esp_timer_get_time();
+            if (manager._limiter.summaryDue(now_us)) manager._reportSuppressed();
+            if (!manager._limiter.admit(tag, now_us)) return 0;
+        }
+    }
+    return manager._forward(fmt, args);
+}
+
+int LogManager::_forward(const char *fmt, va_list args) {
     // Fast path: when the ring buffer is not active AND no subscribers are
-    // registered, skip all the va_copy / vsnprintf / malloc overhead and just
+    // registered, skip all the va_copy / encoding overhead and just
     // forward to the original UART sink. This is the common case at runtime
     // (logging is opt-in) and avoids the ~50 % CPU regression seen on devices
     // with chatty subsystems (raw-uart bridge, network events) where every
     // log line paid the full formatting cost for nothing.
-    if (!manager._capture_active.load(std::memory_order_acquire) &&
-        manager._subscriber_count_fast.load(std::memory_order_acquire) == 0) {
-        LogManager::vprintf_fn_t sink =
-            manager._orig_vprintf.load(std::memory_order_acquire);
+    if (!_capture_active.load(std::memory_order_acquire) &&
+        _subscriber_count_fast.load(std::memory_order_acquire) == 0) {
+        vprintf_fn_t sink = _orig_vprintf.load(std::memory_order_acquire);
         return sink ? sink(fmt, args) : vprintf(fmt, args);
     }
 
-    // Capture path. We must format once for the ring buffer / subscribers,
-    // and the UART sink needs the original (fmt, va_list). To avoid the
-    // expensive double-formatting of the previous implementation (a
-    // vsnprintf(NULL,0,...) length probe + a malloc fallback for oversized
-    // lines, both running on EVERY log line while capture was merely
-    // enabled), we format into a fixed stack buffer exactly once and feed
-    // that to write(). Truncation beyond 256 bytes is acceptable: the ring
-    // buffer and the WebSocket / syslog forwarders are diagnostic-only and
-    // already cap their payloads (log_stream: 256, syslog: 384). The UART
-    // copy below still receives the full, untruncated line.
+    // Capture path. Instead of running vsnprintf on the logging task, record
+    // the format pointer, a timestamp and the raw argument words; the ring,
+    // syslog and the WebSocket stream render the text when they read it.
+    // Lines that cannot be deferred exactly are formatted once, straight into
+    // the entry, and truncated to the entry size as before. The UART copy
+    // below still receives the full, untruncated line.
     va_list args_for_uart;
     va_copy(args_for_uart, args);
 
-    char buf[256];
-    int len = vsnprintf(buf, sizeof(buf), fmt, args);
-    if (len > 0) {
-        size_t capped = (size_t)len < sizeof(buf) ? (size_t)len : sizeof(buf) - 1;
-        manager.write(buf, capped);
+    const char *tag = log_line_tag(fmt, args);
+    uint8_t entry[LOG_ENTRY_MAX];
+    const uint32_t timestamp_ms = esp_log_timestamp();
+    va_list args_for_entry;
+    va_copy(args_for_entry, args);
+    size_t entry_len = log_entry_encode_deferred(entry, sizeof(entry), timestamp_ms,
+                                                 fmt, args_for_entry, log_ptr_is_static);
+    va_end(args_for_entry);
+    if (entry_len == 0) {
+        char *text = reinterpret_cast<char *>(entry + LOG_ENTRY_HEADER_SIZE);
+        const size_t text_cap = sizeof(entry) - LOG_ENTRY_HEADER_SIZE;
+        int len = vsnprintf(text, text_cap, fmt, args);
+        if (len > 0) {
+            size_t capped = (size_t)len < text_cap ? (size_t)len : text_cap - 1;
+            entry_len = log_entry_encode_text(entry, sizeof(entry), timestamp_ms,
+                                              text, capped);
+        }
     }
+    if (entry_len > 0) write(entry, entry_len, tag);
 
     // Forward to the previous ESP-IDF log sink using the copy.
-    LogManager::vprintf_fn_t sink =
-        manager._orig_vprintf.load(std::memory_order_acquire);
+    vprintf_fn_t sink = _orig_vprintf.load(std::memory_order_acquire);
     int ret = sink ? sink(fmt, args_for_uart) : vprintf(fmt, args_for_uart);
     va_end(args_for_uart);
     return ret;
 }
 
-void LogManager::begin(size_t size) {
-    instance()._begin(size);
+// Summaries go straight to _forward(): they are never limited themselves and
+// must not re-enter log_vprintf through ESP_LOGW.
+static const char SUPPRESSED_TAG[] = "LogLimiter";
+static const char SUPPRESSED_FORMAT[] =
+    LOG_COLOR_W "W (%" PRIu32 ") %s: %" PRIu32 " lines from %s suppressed" LOG_RESET_COLOR "\n";
+
+void LogManager::_forwardf(const char *fmt, ...) {
+    va_list args;
+    va_start(args, fmt);
+    _forward(fmt, args);
+    va_end(args);
+}
+
+void LogManager::_reportSuppressed() {
+    size_t cursor = 0;
+    const char *tag = nullptr;
+    uint32_t count = 0;
+    while (_limiter.takeSummary(&cursor, &tag, &count)) {
+        _forwardf(SUPPRESSED_FORMAT, esp_log_timestamp(), SUPPRESSED_TAG, count,
+                  tag ? tag : "other tags");
+    }
+}
+
+void LogManager::setRateLimit(uint16_t lines_per_second, uint16_t burst) {
+    instance()._limiter.configure(lines_per_second, burst, (uint32_t)esp_timer_get_time());
+}
+
+void LogManager::begin(size_t size, size_t history_size) {
+    instance()._begin(size, history_size);
 }
 
 void LogManager::stop() {
@@ -112,6 +195,7 @@ void LogManager::init() {
     if (m._hook_installed.load(std::memory_order_acquire)) return;
     xSemaphoreTake(m._mutex, portMAX_DELAY);
     if (!m._hook_installed.load(std::memory_order_relaxed)) {
+        log_entry_set_static_fn(log_ptr_is_static);
         vprintf_fn_t previous = esp_log_set_vprintf(log_vprintf);
         m._orig_vprintf.store(previous, std::memory_order_release);
         m._hook_installed.store(true, std::memory_order_release);
@@ -126,12 +210,17 @@ void LogManager::addSubscriber(log_line_subscriber_t sub) {
     init();
     if (!m._mutex) return;
     xSemaphoreTake(m._mutex, portMAX_DELAY);
+    int free_slot = -1;
     bool found = false;
-    for (int i = 0; i < m._subscriber_count; i++) {
-        if (m._subscribers[i] == sub) { found = true; break; }
+    for (int i = 0; i < LOG_MAX_SUBSCRIBERS; i++) {
+        log_line_subscriber_t current =
+            m._subscribers[i].load(std::memory_order_relaxed);
+        if (current == sub) { found = true; break; }
+        if (!current && free_slot < 0) free_slot = i;
     }
-    if (!found && m._subscriber_count < LOG_MAX_SUBSCRIBERS) {
-        m._subscribers[m._subscriber_count++] = sub;
+    if (!found && free_slot >= 0) {
+        m._subscribers[free_slot].store(sub, std::memory_order_release);
+        m._subscriber_count++;
         m._subscriber_count_fast.store(
             static_cast<uint32_t>(m._subscriber_count),
             std::memory_order_release);
@@ -144,14 +233,12 @@ void LogManager::removeSubscriber(log_line_subscriber_t sub) {
     LogManager &m = instance();
     if (!m._mutex) return;
     xSemaphoreTake(m._mutex, portMAX_DELAY);
-    for (int i = 0; i < m._subscriber_count; i++) {
-        if (m._subscribers[i] == sub) {
-            // Shift-down compact; order is not significant.
-            for (int j = i + 1; j < m._subscriber_count; j++) {
-                m._subscribers[j - 1] = m._subscribers[j];
-            }
+    for (int i = 0; i < LOG_MAX_SUBSCRIBERS; i++) {
+        if (m._subscribers[i].load(std::memory_order_relaxed) == sub) {
+            // Clear the slot in place: write() scans all slots without the
+            // mutex, so entries must not move underneath it.
+            m._subscribers[i].store(nullptr, std::memory_order_release);
             m._subscriber_count--;
-            m._subscribers[m._subscriber_count] = nullptr;
             m._subscriber_count_fast.store(
                 static_cast<uint32_t>(m._subscriber_count),
                 std::memory_order_release);
@@ -166,7 +253,150 @@ int LogManager::subscriberCount() const {
         _subscriber_count_fast.load(std::memory_order_acquire));
 }
 
-void LogManager::_begin(size_t size) {
+// Unpublish and free the ring storage. Caller holds _mutex. Producers never
+// take the mutex, so wait until every write() that may still have loaded the
+// old pointer has left the ring before handing the memory back.
+void LogManager::_releaseBuffer() {
+    _ring.detach();
+    while (_ring.busy()) vTaskDelay(1);
+    free(log_buffer);
+    log_buffer = nullptr;
+}
+
+// First index in buf at which a chain of valid entry headers runs to the end
+// of the buffer (the last entry may be cut off by it). A reader lands
+// mid-entry after the ring overwrote its position; one plausible-looking
+// header alone is not trusted, the entries after it have to line up too.
+static size_t find_entry_boundary(const uint8_t *buf, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (buf[i] != LOG_ENTRY_MAGIC) continue;
+        size_t j = i;
+        bool chained = true;
+        while (j < count && count - j >= LOG_ENTRY_HEADER_SIZE) {
+            const size_t len = log_entry_length(buf + j, count - j);
+            if (len == 0 || len > LOG_ENTRY_MAX) {
+                chained = false;
+                break;
+            }
+            j += len;
+        }
+        if (chained) return i;
+    }
+    return count;
+}
+
+// Keep this much contiguous heap free for TLS and HTTP before allocating the
+// optional compressed history; the live ring always takes precedence.
+static const size_t HISTORY_HEAP_RESERVE = 32 * 1024;
+// The history task drains the ring this often. A 4 KiB ring therefore keeps
+// up with roughly 16 KB/s of captured entries before lines skip the history.
+static const TickType_t HISTORY_DRAIN_PERIOD = pdMS_TO_TICKS(250);
+
+void LogManager::_historyTask(void *) {
+    for (;;) {
+        vTaskDelay(HISTORY_DRAIN_PERIOD);
+        instance()._drainHistory();
+    }
+}
+
+// Caller holds _mutex, with the ring attached.
+void LogManager::_beginHistory(size_t history_size) {
+    if (history_size == 0) return;
+    const size_t storage_size = LogArchive::storageSize(history_size);
+    if (heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT) <
+        storage_size + HISTORY_HEAP_RESERVE) {
+        ESP_LOGW(TAG, "Compressed log history skipped — free heap is low");
+        return;
+    }
+    uint8_t *storage = (uint8_t *)malloc(storage_size);
+    if (!storage) return;
+    _history.attach(storage, history_size);
+    _history_position = _ring.oldest();
+
+    // Created once and kept for the whole boot; it idles while no history
+    // is attached.
+    if (!_history_task &&
+        xTaskCreate(_historyTask, "log_history", 2560, NULL, 1,
+                    &_history_task) != pdPASS) {
+        _history_task = nullptr;
+        free(_history.detach());
+    }
+}
+
+// Caller holds _mutex. The history is only touched under the mutex, so it
+// can be freed right away.
+void LogManager::_releaseHistory() {
+    free(_history.detach());
+}
+
+// Move every committed entry that is not in the history yet out of the
+// ring. Compression happens here, on the history task, never on a logging
+// task.
+void LogManager::_drainHistory() {
+    if (!_mutex || xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) != pdTRUE) return;
+    if (!_history.active() || _ring.capacity() == 0) {
+        xSemaphoreGive(_mutex);
+        return;
+    }
+
+    const uint64_t end = _ring.committed();
+    uint64_t position = _history_position;
+    while (position < end) {
+        uint64_t cursor = position;
+        const uint64_t wanted = end - position;
+        const size_t count = _ring.read(
+            &cursor, reinterpret_cast<char *>(_raw),
+            wanted < sizeof(_raw) ? static_cast<size_t>(wanted) : sizeof(_raw));
+        if (count == 0) break;
+        const uint64_t base = cursor - count;
+
+        // Entries the ring overwrote before they were drained are gone; the
+        // history resumes at the next boundary and starts a new segment.
+        size_t at = 0;
+        if (base != position || log_entry_length(_raw, count) == 0) {
+            at = find_entry_boundary(_raw, count);
+        }
+        size_t taken = at;
+        while (count - taken >= LOG_ENTRY_HEADER_SIZE) {
+            const size_t len = log_entry_length(_raw + taken, count - taken);
+            if (len == 0 || len > count - taken) break;
+            _history.append(base + taken, _raw + taken, len);
+            taken += len;
+        }
+        if (taken == 0 || base + taken <= position) break;
+        position = base + taken;
+    }
+    _history_position = position;
+    xSemaphoreGive(_mutex);
+}
+
+// Oldest readable offset across history and ring. Caller holds _mutex.
+uint64_t LogManager::_oldest() const {
+    const uint64_t ring_oldest = _ring.oldest();
+    if (_history.active() && _history.oldest() < _history.end() &&
+        _history.oldest() < ring_oldest) {
+        return _history.oldest();
+    }
+    return ring_oldest;
+}
+
+// Raw entry bytes from wherever the offset is still held: the ring if it
+// still has it, the compressed history otherwise. Caller holds _mutex.
+size_t LogManager::_readRaw(uint64_t *offset, uint8_t *destination,
+                            size_t maximum_length) {
+    if (_history.active() && *offset < _ring.oldest()) {
+        uint64_t cursor = *offset;
+        const size_t count = _history.read(&cursor, destination, maximum_length);
+        if (count > 0) {
+            *offset = cursor;
+            return count;
+        }
+    }
+    return _ring.read(offset, reinterpret_cast<char *>(destination),
+                      maximum_length);
+}
+
+void LogManager::_begin(size_t size, size_t history_size) {
     init();
     if (!_mutex) {
         ESP_LOGE(TAG, "Failed to create log buffer mutex");
@@ -176,11 +406,8 @@ void LogManager::_begin(size_t size) {
     bool enabled = false;
     xSemaphoreTake(_mutex, portMAX_DELAY);
 
-    if (log_buffer) {
-        free(log_buffer);
-        log_buffer = nullptr;
-    }
-    ring_start_offset = total_written;
+    if (log_buffer) _releaseBuffer();
+    _releaseHistory();
 
     // Try the requested size first, then fall back to progressively smaller
     // buffers. The ESP32-WROOM-32 has no PSRAM and only ~250 KB internal
@@ -189,22 +416,30 @@ void LogManager::_begin(size_t size) {
     // even though a 4 KB or 2 KB one still fits. A smaller log is strictly
     // better than no log — and the user's "not enough memory" error goes
     // away because begin() now succeeds with whatever fits.
+    // The lock-free ring indexes with a mask, so the size is rounded down to
+    // a power of two first.
     static const size_t MIN_LOG_BUFFER = 2048;
-    size_t want = size;
-    if (want < MIN_LOG_BUFFER) want = MIN_LOG_BUFFER;
+    size_t want = MIN_LOG_BUFFER;
+    while (want <= size / 2 && LogRing::validCapacity(want * 2)) want <<= 1;
     while (want >= MIN_LOG_BUFFER) {
         log_buffer = (char *)malloc(want);
         if (log_buffer) break;
         want >>= 1;
     }
-    log_buffer_size = log_buffer ? want : 0;
 
     if (log_buffer) {
         // Zero out for cleanliness, though not strictly required for ring buffer
-        memset(log_buffer, 0, log_buffer_size);
+        memset(log_buffer, 0, want);
+        _ring.attach(log_buffer, want);
+        // Producers that loaded the old (null) storage reserve bytes they
+        // never copy. Start the readable window after the last of them.
+        while (_ring.busy()) vTaskDelay(1);
+        _ring.markStart();
+        _index.clear();
+        _beginHistory(history_size);
         enabled = true;
     }
-    const size_t enabled_size = log_buffer_size;
+    const size_t enabled_size = log_buffer ? want : 0;
     _capture_active.store(enabled, std::memory_order_release);
 
     xSemaphoreGive(_mutex);
@@ -226,12 +461,8 @@ void LogManager::_stop() {
 
     // Only free the ring buffer. The capture hook stays installed so any
     // registered subscribers (syslog, log_stream) keep receiving lines.
-    if (log_buffer) {
-        free(log_buffer);
-        log_buffer = nullptr;
-        log_buffer_size = 0;
-    }
-    ring_start_offset = total_written;
+    if (log_buffer) _releaseBuffer();
+    _releaseHistory();
     _capture_active.store(false, std::memory_order_release);
 
     xSemaphoreGive(_mutex);
@@ -246,139 +477,245 @@ bool LogManager::isEnabled() const {
 void LogManager::_clear() {
     if (!_mutex) return;
     xSemaphoreTake(_mutex, portMAX_DELAY);
-    ring_start_offset = total_written;
-    if (log_buffer) memset(log_buffer, 0, log_buffer_size);
+    _ring.clear();
+    _history.reset();
+    _index.clear();
+    _history_position = _ring.committed();
     xSemaphoreGive(_mutex);
 }
 
-void LogManager::write(const char* data, size_t len) {
-    if (len == 0 || !_mutex) return;
-
-    const char *subscriber_data = data;
-    const size_t subscriber_len = len;
-
-    // Update the ring and snapshot subscribers under one lock so every
-    // subscriber receives the exact absolute offset for this line. The
-    // callbacks themselves still run unlocked and must remain non-blocking.
-    log_line_subscriber_t snap[LOG_MAX_SUBSCRIBERS];
-    int snap_count = 0;
-    uint64_t end_offset = 0;
-
-    // Use timeout to avoid blocking logging if something is stuck
-    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        snap_count = _subscriber_count;
-        for (int i = 0; i < snap_count; i++) snap[i] = _subscribers[i];
-
-        // Advance the absolute stream even when the optional ring is disabled.
-        // Live subscribers need a monotonic checkpoint independent of ring
-        // allocation, clear and stop/start cycles.
-        total_written += len;
-        end_offset = total_written;
-
-        if (log_buffer && log_buffer_size > 0) {
-            // Only the tail of an oversized log entry can fit in the ring.
-            if (len > log_buffer_size) {
-                size_t skipped = len - log_buffer_size;
-                data += skipped;
-                len = log_buffer_size;
-            }
+void LogManager::write(const uint8_t *entry, size_t len, const char *tag) {
+    if (len == 0) return;
+
+    // Lock-free: a task logging from any priority never waits for a reader
+    // or another producer, and no line is dropped under contention. The
+    // absolute stream advances even when the optional ring is disabled, so
+    // live subscribers get a monotonic checkpoint independent of ring
+    // allocation, clear and stop/start cycles.
+    const uint64_t end_offset =
+        _ring.write(reinterpret_cast<const char *>(entry), len);
+
+    // Level and tag for filtered reads. The tag usually comes from the
+    // caller's arguments; only lines in an unusual layout are parsed here.
+    // Nothing is rendered either way.
+    if (_capture_active.load(std::memory_order_relaxed)) {
+        const uint8_t rank = log_level_rank(log_entry_level(entry, len));
+        char parsed[LOG_INDEX_TAG_MAX];
+        if (!tag && rank != 0) {
+            log_entry_tag(entry, len, parsed, sizeof(parsed));
+            tag = parsed;
+        }
+        const uint32_t tag_hash = tag ? log_tag_hash(tag, strnlen(tag, LOG_INDEX_TAG_MAX - 1)) : 0;
+        _index.record(end_offset, len, rank, tag_hash);
+    }
 
-            const uint64_t write_start = total_written - len;
-            size_t current_idx = write_start % log_buffer_size;
-            size_t space_at_end = log_buffer_size - current_idx;
+    // The callbacks run on the logging task and must remain non-blocking.
+    for (int i = 0; i < LOG_MAX_SUBSCRIBERS; i++) {
+        log_line_subscriber_t sub =
+            _subscribers[i].load(std::memory_order_acquire);
+        if (sub) sub(entry, len, end_offset);
+    }
+}
 
-            if (len <= space_at_end) {
-                memcpy(log_buffer + current_idx, data, len);
-            } else {
-                memcpy(log_buffer + current_idx, data, space_at_end);
-                memcpy(log_buffer, data + space_at_end, len - space_at_end);
+// Find the first complete entry in [from, end), leave it in _raw at *at and
+// report where the next one starts. Caller holds _mutex.
+bool LogManager::_nextEntry(uint64_t from, uint64_t end, uint64_t *next,
+                            size_t *at, size_t *len) {
+    uint64_t position = from;
+    for (int attempt = 0; attempt < 8 && position < end; attempt++) {
+        uint64_t cursor = position;
+        const uint64_t wanted = end - position;
+        const size_t count = _readRaw(
+            &cursor, _raw,
+            wanted < sizeof(_raw) ? static_cast<size_t>(wanted) : sizeof(_raw));
+        if (count == 0) return false;
+        const uint64_t base = cursor - count;
+
+        *at = find_entry_boundary(_raw, count);
+        *len = *at < count ? log_entry_length(_raw + *at, count - *at) : 0;
+        if (*len == 0 || *at + *len > count) {
+            // No boundary in this window, or the entry runs past it: read
+            // again from the boundary (or from what could still start one).
+            uint64_t resume = base + *at;
+            if (*at == count && count > LOG_ENTRY_HEADER_SIZE) {
+                resume = base + count - LOG_ENTRY_HEADER_SIZE;
             }
+            if (resume <= position) return false;
+            position = resume;
+            continue;
         }
-        xSemaphoreGive(_mutex);
+
+        *next = base + *at + *len;
+        return true;
     }
+    return false;
+}
 
-    for (int i = 0; i < snap_count; i++) {
-        snap[i](subscriber_data, subscriber_len, end_offset);
+// Render the first complete entry in [from, end) into _line and report where
+// the next one starts. Caller holds _mutex.
+bool LogManager::_renderNext(uint64_t from, uint64_t end, uint64_t *next,
+                             size_t *line_len) {
+    size_t at = 0;
+    size_t len = 0;
+    if (!_nextEntry(from, end, next, &at, &len)) return false;
+    *line_len = log_entry_render(_raw + at, len, _line, sizeof(_line));
+    return true;
+}
+
+// Whether a raw entry passes the filter, decided without rendering it.
+static bool filter_matches(const LogManager::LogFilter &filter, const uint8_t *entry,
+                           size_t len) {
+    if (filter.max_rank != 0) {
+        const uint8_t rank = log_level_rank(log_entry_level(entry, len));
+        if (rank == 0 || rank > filter.max_rank) return false;
+    }
+    if (filter.tag[0] != '\0') {
+        char tag[LOG_INDEX_TAG_MAX];
+        log_entry_tag(entry, len, tag, sizeof(tag));
+        if (strcmp(tag, filter.tag) != 0) return false;
     }
+    return true;
 }
 
 std::string LogManager::getLogContent(uint64_t offset) {
     return getLogSnapshot(offset, nullptr);
 }
 
+// Copy the complete entries of [*position, end) that fit into out, back to
+// back, and move *position past them. _mutex is held for the copy only, so
+// callers render with logging unblocked. Returns 0 at the end or when the
+// mutex stays busy.
+size_t LogManager::_copyEntries(uint64_t *position, uint64_t end, uint8_t *out,
+                                size_t cap) {
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) != pdTRUE) return 0;
+    size_t copied = 0;
+    uint64_t next = 0;
+    size_t at = 0;
+    size_t len = 0;
+    while (_nextEntry(*position, end, &next, &at, &len) && len <= cap - copied) {
+        memcpy(out + copied, _raw + at, len);
+        copied += len;
+        *position = next;
+    }
+    xSemaphoreGive(_mutex);
+    return copied;
+}
+
 std::string LogManager::getLogSnapshot(uint64_t offset, uint64_t *snapshot_total) {
     if (snapshot_total) *snapshot_total = 0;
     std::string result;
 
-    if (_mutex) {
-        if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) == pdTRUE) {
-            const uint64_t local_total = total_written;
-            if (snapshot_total) *snapshot_total = local_total;
-
-            // The atomic capture flag is only a lock-free hint. Recheck the
-            // actual ring state under the mutex before dereferencing it.
-            if (!log_buffer || log_buffer_size == 0) {
-                xSemaphoreGive(_mutex);
-                return "";
-            }
+    if (!_mutex || xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return result;
+    }
 
-            // If client asks for future data (shouldn't happen), return empty
-            if (offset >= local_total) {
-                xSemaphoreGive(_mutex);
-                return "";
-            }
+    const uint64_t local_total = _ring.committed();
+    if (snapshot_total) *snapshot_total = local_total;
 
-            uint64_t oldest = ring_start_offset;
-            if (local_total - ring_start_offset > log_buffer_size) {
-                oldest = local_total - log_buffer_size;
-            }
-            if (offset < oldest) offset = oldest;
-            if (offset >= local_total) {
-                xSemaphoreGive(_mutex);
-                return "";
+    // The atomic capture flag is only a lock-free hint. Recheck the actual
+    // ring state under the mutex before dereferencing it.
+    const bool empty = _ring.capacity() == 0 || offset >= local_total;
+    xSemaphoreGive(_mutex);
+    if (empty) return result;
+
+    // A snapshot renders far more than one call of readChunk(), so it does
+    // so after releasing the mutex: raw entries are copied out a chunk at a
+    // time into scratch of its own and rendered there.
+    const size_t chunk_size = 2 * LOG_ENTRY_MAX;
+    uint8_t *scratch = (uint8_t *)malloc(chunk_size + LOG_LINE_MAX);
+    if (!scratch) return result;
+    uint8_t *chunk = scratch;
+    char *line = reinterpret_cast<char *>(scratch + chunk_size);
+    auto for_each_line = [&](auto &&visit) {
+        uint64_t position = offset;
+        size_t count = 0;
+        while ((count = _copyEntries(&position, local_total, chunk, chunk_size)) > 0) {
+            for (size_t at = 0; at < count;) {
+                const size_t len = log_entry_length(chunk + at, count - at);
+                if (len == 0 || len > count - at) break;
+                const size_t line_len = log_entry_render(chunk + at, len, line, LOG_LINE_MAX);
+                at += len;
+                if (!visit(line_len)) return;
             }
-            uint64_t wanted_len = local_total - offset;
-
-            // FIX: Check heap before allocating to prevent OOM crash.
-            // std::string::resize may abort on ESP-IDF if allocation fails.
-            // Use the largest contiguous free block (not total free heap) and
-            // keep a safety margin for the HTTP server / TLS while streaming.
-            size_t largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
-            size_t max_alloc = (largest_block > 1536) ? (largest_block - 1536) : 0;
-            if (wanted_len > max_alloc) {
-                wanted_len = max_alloc;
-                if (wanted_len > log_buffer_size) wanted_len = log_buffer_size;
-                if (wanted_len == 0) {
-                    xSemaphoreGive(_mutex);
-                    return "";
-                }
-                offset = local_total - wanted_len;
+        }
+    };
+
+    // The rendered size is only known after rendering, so measure first.
+    size_t text_len = 0;
+    for_each_line([&](size_t line_len) {
+        text_len += line_len;
+        return true;
+    });
+
+    // FIX: Check heap before allocating to prevent OOM crash.
+    // std::string::resize may abort on ESP-IDF if allocation fails.
+    // Use the largest contiguous free block (not total free heap) and
+    // keep a safety margin for the HTTP server / TLS while streaming.
+    size_t largest_block = heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT);
+    size_t max_alloc = (largest_block > 1536) ? (largest_block - 1536) : 0;
+    const size_t budget = text_len < max_alloc ? text_len : max_alloc;
+
+    if (budget > 0) {
+        // Pre-allocate to avoid reallocations. When the heap is short, the
+        // oldest lines are skipped so the newest ones survive. Lines the
+        // ring overwrote since the measuring pass only shorten the result.
+        result.reserve(budget);
+        size_t skip = text_len - budget;
+        for_each_line([&](size_t line_len) {
+            if (skip > 0) {
+                skip = skip > line_len ? skip - line_len : 0;
+                return true;
             }
+            if (result.size() + line_len > budget) return false;
+            result.append(line, line_len);
+            return true;
+        });
+    }
 
-            size_t data_len = static_cast<size_t>(wanted_len);
-
-            // Pre-allocate to avoid reallocations
-            result.resize(data_len);
+    free(scratch);
+    return result;
+}
 
-            size_t start_idx = offset % log_buffer_size;
-            size_t space_at_end = log_buffer_size - start_idx;
+size_t LogManager::readChunk(uint64_t *absolute_offset, char *destination,
+                             size_t maximum_length) {
+    if (!absolute_offset || !destination || maximum_length == 0 ||
+        !_mutex) {
+        return 0;
+    }
 
-            if (data_len <= space_at_end) {
-                memcpy(&result[0], log_buffer + start_idx, data_len);
-            } else {
-                memcpy(&result[0], log_buffer + start_idx, space_at_end);
-                memcpy(&result[space_at_end], log_buffer, data_len - space_at_end);
-            }
+    if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
+        return 0;
+    }
 
-            xSemaphoreGive(_mutex);
+    const uint64_t end = _ring.committed();
+    uint64_t position = *absolute_offset;
+    if (position > end) position = end;
+    size_t copied = 0;
+    uint64_t next = 0;
+    size_t line_len = 0;
+    while (copied < maximum_length &&
+           _renderNext(position, end, &next, &line_len)) {
+        if (line_len > maximum_length - copied) {
+            if (copied > 0) break;
+            line_len = maximum_length;
         }
+        memcpy(destination + copied, _line, line_len);
+        copied += line_len;
+        position = next;
+    }
+    if (copied == 0 && _ring.capacity() > 0) {
+        const uint64_t oldest = _oldest();
+        if (position < oldest) position = oldest;
     }
 
-    return result;
+    *absolute_offset = position;
+    xSemaphoreGive(_mutex);
+    return copied;
 }
 
-size_t LogManager::readChunk(uint64_t *absolute_offset, char *destination,
-                             size_t maximum_length) {
+size_t LogManager::readFiltered(const LogFilter &filter, uint64_t *absolute_offset,
+                                uint64_t end, char *destination,
+                                size_t maximum_length) {
     if (!absolute_offset || !destination || maximum_length == 0 ||
         !_mutex) {
         return 0;
@@ -387,58 +724,87 @@ size_t LogManager::readChunk(uint64_t *absolute_offset, char *destination,
     if (xSemaphoreTake(_mutex, pdMS_TO_TICKS(100)) != pdTRUE) {
         return 0;
     }
-    if (!log_buffer || log_buffer_size == 0) {
+
+    const uint64_t committed = _ring.committed();
+    if (end > committed) end = committed;
+    uint64_t position = *absolute_offset;
+    if (_ring.capacity() == 0 || position >= end) {
+        if (position > end) position = end;
+        *absolute_offset = position;
         xSemaphoreGive(_mutex);
         return 0;
     }
+    const uint64_t oldest = _oldest();
+    if (position < oldest) position = oldest;
+
+    size_t copied = 0;
+    // Only a single line longer than the whole buffer is cut, as in
+    // readChunk(); otherwise a line that does not fit waits for the next call.
+    auto take = [&](const uint8_t *entry, size_t len) {
+        const size_t line_len = log_entry_render(entry, len, _line, sizeof(_line));
+        if (line_len > maximum_length - copied) {
+            if (copied > 0) return false;
+            memcpy(destination, _line, maximum_length);
+            copied = maximum_length;
+            return true;
+        }
+        memcpy(destination + copied, _line, line_len);
+        copied += line_len;
+        return true;
+    };
+
+    // Lines older than what the index vouches for are walked one by one,
+    // still without rendering the ones that do not match.
+    const uint64_t indexed = _index.coveredFrom(position, end);
+    uint64_t next = 0;
+    size_t at = 0;
+    size_t len = 0;
+    while (position < indexed && copied < maximum_length) {
+        if (!_nextEntry(position, indexed, &next, &at, &len)) {
+            position = indexed;
+            break;
+        }
+        if (filter_matches(filter, _raw + at, len) && !take(_raw + at, len)) break;
+        position = next;
+    }
 
-    const uint64_t local_total = total_written;
-    uint64_t requested = *absolute_offset;
-    if (requested > local_total) requested = local_total;
-
-    uint64_t oldest = ring_start_offset;
-    if (local_total - ring_start_offset > log_buffer_size) {
-        oldest = local_total - log_buffer_size;
-    }
-    if (requested < oldest) requested = oldest;
-
-    const uint64_t available64 = local_total - requested;
-    const size_t available = available64 > SIZE_MAX
-        ? SIZE_MAX
-        : static_cast<size_t>(available64);
-    const size_t count = available < maximum_length
-        ? available
-        : maximum_length;
-
-    if (count > 0) {
-        const size_t start = static_cast<size_t>(requested % log_buffer_size);
-        const size_t first = (count < log_buffer_size - start)
-            ? count
-            : log_buffer_size - start;
-        memcpy(destination, log_buffer + start, first);
-        if (count > first) {
-            memcpy(destination + first, log_buffer, count - first);
+    // From there on, seek straight to the candidates. Each one is checked
+    // against the entry itself: the index is only a hint.
+    const uint32_t tag_hash = filter.tag[0] != '\0'
+        ? log_tag_hash(filter.tag, strlen(filter.tag))
+        : LogIndex::ANY_TAG;
+    while (position >= indexed && position < end && copied < maximum_length) {
+        LogIndex::Hit hits[8];
+        const size_t found = _index.find(position, end, filter.max_rank, tag_hash,
+                                         hits, sizeof(hits) / sizeof(hits[0]));
+        size_t used = 0;
+        for (; used < found; used++) {
+            uint64_t cursor = hits[used].start;
+            const size_t count = _readRaw(&cursor, _raw, hits[used].len);
+            if (count == hits[used].len && cursor == hits[used].start + count &&
+                log_entry_length(_raw, count) == count &&
+                filter_matches(filter, _raw, count) && !take(_raw, count)) {
+                break;
+            }
+            position = hits[used].start + hits[used].len;
         }
+        if (used < found) break;
+        if (found < sizeof(hits) / sizeof(hits[0])) position = end;
     }
 
-    *absolute_offset = requested + count;
+    *absolute_offset = position;
     xSemaphoreGive(_mutex);
-    return count;
+    return copied;
 }
 
 uint64_t LogManager::getTotalWritten() const {
-    uint64_t result = 0;
-    if (_mutex && xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        result = total_written;
-        xSemaphoreGive(_mutex);
-    }
-    return result;
+    return _ring.committed();
 }
 
 size_t LogManager::getBufferSize() const {
     size_t result = 0;
     if (_mutex && xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        result = log_buffer_size;
+        result = _ring.capacity() + _history.poolSize();
         xSemaphoreGive(_mutex);
     }
     return result;
@@ -447,11 +813,8 @@ size_t LogManager::getBufferSize() const {
 size_t LogManager::getBufferedBytes() const {
     size_t result = 0;
     if (_mutex && xSemaphoreTake(_mutex, pdMS_TO_TICKS(10)) == pdTRUE) {
-        if (log_buffer && log_buffer_size > 0) {
-            const uint64_t available = total_written - ring_start_offset;
-            result = available < log_buffer_size
-                ? static_cast<size_t>(available)
-                : log_buffer_size;
+        if (_ring.capacity() > 0) {
+            result = static_cast<size_t>(_ring.committed() - _oldest());
         }
         xSemaphoreGive(_mutex);
     }
@@ -464,10 +827,16 @@ static const char *CRASH_TAIL_NVS_NS  = "reset_info";
 static const char *CRASH_TAIL_NVS_KEY = "clog";   // 4 chars, within NVS limit
 
 bool LogManager::saveCrashTailNvs(const char *tag) {
-    // Pull a tail of the ring buffer. getLogContent() already caps the
-    // returned size by the largest free block, so this is safe to call from
-    // the low-heap path that triggered the watchdog.
-    std::string tail = instance().getLogContent(0);
+    // Pull a tail of the live ring only; the compressed history behind it is
+    // far more than CRASH_TAIL_MAX and would only cost heap here.
+    // getLogContent() caps the returned size by the largest free block, so
+    // this is safe to call from the low-heap path that triggered the watchdog.
+    uint64_t from = 0;
+    if (_mutex && xSemaphoreTake(_mutex, pdMS_TO_TICKS(20)) == pdTRUE) {
+        from = _ring.oldest();
+        xSemaphoreGive(_mutex);
+    }
+    std::string tail = getLogContent(from);
     if (tail.empty()) {
         // No ring buffer active — nothing to persist, but not an error.
         return false;
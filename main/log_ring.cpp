@@ -0,0 +1,244 @@
+/*
+ *  log_ring.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "log_ring.h"
+
+#include <string.h>
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free,
+              "the log ring requires lock-free native 32-bit atomics");
+static_assert(std::atomic<char *>::is_always_lock_free,
+              "the log ring requires a lock-free storage pointer");
+
+// A reader whose whole copy was overwritten retries from the new oldest byte
+// a few times before giving up; a producer lapping the reader repeatedly
+// means the ring is far too small for the log rate anyway.
+static const int READ_ATTEMPTS = 4;
+
+// How far the lapping floor may trail the commit point before publish()
+// drags it along. Larger than any ring, so a trailing floor never matters.
+static const uint32_t FLOOR_REACH = 1u << 29;
+
+#ifdef LOG_RING_TEST_HOOKS
+extern "C" void log_ring_test_after_reserve(void);
+#endif
+
+void LogRing::attach(char *storage, size_t size) {
+    _mask.store(static_cast<uint32_t>(size - 1), std::memory_order_seq_cst);
+    _storage.store(storage, std::memory_order_seq_cst);
+}
+
+void LogRing::markStart() {
+    _start = extend(_reserve.load(std::memory_order_seq_cst));
+}
+
+char *LogRing::detach() {
+    return _storage.exchange(nullptr, std::memory_order_seq_cst);
+}
+
+bool LogRing::busy() const {
+    return _writers.load(std::memory_order_seq_cst) != 0;
+}
+
+void LogRing::clear() {
+    _start = committed();
+}
+
+size_t LogRing::capacity() const {
+    if (!_storage.load(std::memory_order_seq_cst)) return 0;
+    return static_cast<size_t>(_mask.load(std::memory_order_seq_cst)) + 1;
+}
+
+uint64_t LogRing::committed() const {
+    // Read the half-wrap counter first. It is only incremented after the
+    // commit word crossed a 2^31 boundary, so it can lag the commit word by
+    // one step but never lead it; a parity mismatch means exactly that lag.
+    uint32_t half_wraps = _half_wraps.load(std::memory_order_seq_cst);
+    const uint32_t commit = _commit.load(std::memory_order_seq_cst);
+    if ((half_wraps & 1u) != (commit >> 31)) half_wraps++;
+    return (static_cast<uint64_t>(half_wraps) << 31) | (commit & 0x7FFFFFFFu);
+}
+
+uint64_t LogRing::extend(uint32_t position) const {
+    // Every live position lies within 2^31 of the commit point.
+    const uint64_t commit = committed();
+    const int32_t delta = static_cast<int32_t>(position - static_cast<uint32_t>(commit));
+    return commit + static_cast<uint64_t>(static_cast<int64_t>(delta));
+}
+
+uint64_t LogRing::validFrom(uint64_t commit, uint32_t reserve) const {
+    const uint32_t size = _mask.load(std::memory_order_seq_cst) + 1;
+    const uint32_t commit32 = static_cast<uint32_t>(commit);
+    const uint32_t ahead = reserve - commit32;
+    uint64_t from = _start;
+
+    // Bytes reserved past the commit point may already sit in the oldest
+    // slots, whether or not their producer has finished copying them.
+    const uint64_t reserve64 = commit + ahead;
+    if (reserve64 > size && reserve64 - size > from) from = reserve64 - size;
+
+    // A floor matters only while it lies inside the ring behind the commit
+    // point or ahead of it by what is in flight plus one ring; anything else
+    // is a stale value from an earlier wrap.
+    const uint32_t floor = _floor.load(std::memory_order_seq_cst);
+    const int32_t rel = static_cast<int32_t>(floor - commit32);
+    if (rel > -static_cast<int32_t>(size) &&
+        (rel <= 0 || static_cast<uint32_t>(rel) <= ahead + size)) {
+        const uint64_t floor64 = commit + static_cast<uint64_t>(static_cast<int64_t>(rel));
+        if (floor64 > from) from = floor64;
+    }
+    return from;
+}
+
+void LogRing::publish() {
+    for (;;) {
+        // done is read before reserve and both only grow, so equality means
+        // every byte reserved at the moment done was read had been copied.
+        const uint32_t done = _done.load(std::memory_order_seq_cst);
+        const uint32_t reserve = _reserve.load(std::memory_order_seq_cst);
+        if (done != reserve) return;   // the last producer in flight publishes
+
+        uint32_t commit = _commit.load(std::memory_order_seq_cst);
+        if (static_cast<int32_t>(done - commit) <= 0) return;
+        if (_commit.compare_exchange_weak(commit, done, std::memory_order_seq_cst)) {
+            if ((commit ^ done) & 0x80000000u) {
+                _half_wraps.fetch_add(1, std::memory_order_seq_cst);
+            }
+            // Keep the floor within reach so a value left by a lapped
+            // producer long ago cannot look current again after a 2^32 wrap.
+            uint32_t floor = _floor.load(std::memory_order_seq_cst);
+            if (static_cast<int32_t>(floor - done) < -static_cast<int32_t>(FLOOR_REACH)) {
+                _floor.compare_exchange_strong(floor, done - FLOOR_REACH,
+                                               std::memory_order_seq_cst);
+            }
+            return;
+        }
+    }
+}
+
+uint64_t LogRing::write(const char *data, size_t len) {
+    const uint32_t length = static_cast<uint32_t>(len);
+
+    _writers.fetch_add(1, std::memory_order_seq_cst);
+    char *storage = _storage.load(std::memory_order_seq_cst);
+    const uint32_t start = _reserve.fetch_add(length, std::memory_order_seq_cst);
+#ifdef LOG_RING_TEST_HOOKS
+    log_ring_test_after_reserve();
+#endif
+
+    if (storage && length > 0) {
+        // Readers validate a copy by re-reading the reserve word afterwards;
+        // the reservation must be visible before any of these bytes are.
+        std::atomic_thread_fence(std::memory_order_release);
+
+        const uint32_t mask = _mask.load(std::memory_order_seq_cst);
+        const uint32_t size = mask + 1;
+        uint32_t from = start;
+        uint32_t count = length;
+        if (count > size) {
+            // Only the tail of an oversized entry can fit in the ring.
+            data += count - size;
+            from += count - size;
+            count = size;
+        }
+
+        const uint32_t index = from & mask;
+        const uint32_t first = count < size - index ? count : size - index;
+        memcpy(storage + index, data, first);
+        if (count > first) memcpy(storage, data + first, count - first);
+
+        // A producer preempted for a whole ring's worth of other lines has
+        // just written into slots that newer lines already own. Fence off
+        // everything up to the end of the newest line it may have hit. Until
+        // this producer is done the commit point stays behind it, so no
+        // reader can see those slots in the meantime.
+        const uint32_t reserve = _reserve.load(std::memory_order_seq_cst);
+        if (reserve - from > size) {
+            const uint32_t phase = (reserve - from) & mask;
+            const uint32_t target = phase >= count ? reserve - phase + count : reserve;
+            const uint32_t commit = _commit.load(std::memory_order_seq_cst);
+            uint32_t floor = _floor.load(std::memory_order_seq_cst);
+            while ((static_cast<int32_t>(target - floor) > 0 ||
+                    static_cast<int32_t>(floor - commit) <= 0) &&
+                   !_floor.compare_exchange_weak(floor, target,
+                                                 std::memory_order_seq_cst)) {
+            }
+        }
+    }
+
+    _done.fetch_add(length, std::memory_order_seq_cst);
+    publish();
+    const uint64_t end = extend(start + length);
+    _writers.fetch_sub(1, std::memory_order_seq_cst);
+    return end;
+}
+
+uint64_t LogRing::oldest() const {
+    const uint64_t commit = committed();
+    if (!_storage.load(std::memory_order_seq_cst)) return commit;
+    const uint64_t from = validFrom(commit, _reserve.load(std::memory_order_seq_cst));
+    return from < commit ? from : commit;
+}
+
+size_t LogRing::read(uint64_t *offset, char *dst, size_t max) const {
+    const char *storage = _storage.load(std::memory_order_seq_cst);
+    if (!offset || !dst || max == 0 || !storage) return 0;
+
+    const uint32_t mask = _mask.load(std::memory_order_seq_cst);
+    const uint32_t size = mask + 1;
+
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        const uint64_t commit = committed();
+        const uint64_t from = validFrom(commit, _reserve.load(std::memory_order_seq_cst));
+        uint64_t position = *offset;
+        if (position < from) position = from;
+        if (position > commit) position = commit;
+        if (position >= commit) {
+            *offset = position;
+            return 0;
+        }
+
+        const uint64_t available = commit - position;
+        const size_t count = available < max ? static_cast<size_t>(available) : max;
+        const uint32_t index = static_cast<uint32_t>(position) & mask;
+        const size_t first = count < size - index ? count : size - index;
+        memcpy(dst, storage + index, first);
+        if (count > first) memcpy(dst + first, storage, count - first);
+
+        // Sequence check: any byte whose slot was reserved by a newer line
+        // while we copied is older than the new valid window start.
+        std::atomic_thread_fence(std::memory_order_acquire);
+        const uint64_t valid = validFrom(commit, _reserve.load(std::memory_order_seq_cst));
+        if (valid <= position) {
+            *offset = position + count;
+            return count;
+        }
+        if (valid < position + count) {
+            const size_t skipped = static_cast<size_t>(valid - position);
+            memmove(dst, dst + skipped, count - skipped);
+            *offset = position + count;
+            return count - skipped;
+        }
+    }
+    return 0;
+}
@@ -23,6 +23,8 @@
 
 #include "log_stream.h"
 #include "log_manager.h"
+#include "log_stream_batch.h"
+#include "metrics.h"
 #include "esp_log.h"
 #include "esp_heap_caps.h"
 #include "freertos/FreeRTOS.h"
@@ -84,7 +86,7 @@ static uint32_t s_next_generation = 1;       // guarded by stream_mutex()
 static bool register_subscriber(int fd, uint64_t requested_offset,
                                 std::string *snapshot,
                                 uint64_t *checkpoint);
-static void log_stream_subscriber(const char *line, size_t len,
+static void log_stream_subscriber(const uint8_t *entry, size_t len,
                                   uint64_t end_offset);
 static void acknowledge_subscriber(int fd);
 static bool unregister_subscriber(int fd, uint32_t generation = 0);
@@ -94,7 +96,7 @@ static esp_err_t queue_close_all_subscribers(httpd_handle_t server);
 // send, which is queued onto the HTTP server task using fixed storage. The
 // worker drains this queue and broadcasts.
 struct StreamItem {
-    char  payload[256];   // single log line (truncated if longer)
+    uint8_t entry[LOG_ENTRY_MAX];   // single log entry, rendered by the worker
     size_t len;
     uint64_t end_offset;
 };
@@ -102,7 +104,21 @@ static QueueHandle_t s_publish_q = NULL;
 static TaskHandle_t   s_worker   = NULL;
 static std::atomic<bool> s_publish_overflow{false};
 
-static constexpr size_t STREAM_WIRE_SIZE = 320;
+// The worker gathers lines for this long after the first one and then sends
+// them as one frame per subscriber (see LogStreamBatch), instead of one frame
+// and one HTTP task hand-off per line per subscriber.
+static constexpr TickType_t STREAM_FLUSH_INTERVAL = pdMS_TO_TICKS(50);
+
+// Worker-only, kept off its 3 KB stack.
+static LogStreamBatch s_batch;
+static char s_line[LOG_LINE_MAX];
+
+static MetricsCounter g_stream_lines("hbrfeth_log_stream_lines_total",
+                                     "Log lines delivered to live log WebSocket subscribers");
+static MetricsCounter g_stream_frames("hbrfeth_log_stream_frames_total",
+                                      "Live log WebSocket frames handed to the HTTP server");
+static MetricsCounter g_stream_resyncs("hbrfeth_log_stream_resyncs_total",
+                                       "Live log streams reconnected after a lost range");
 
 // Ownership transfers to the HTTP server task after httpd_queue_work()
 // succeeds. Keeping the frame payload in the work item avoids passing the
@@ -113,15 +129,19 @@ struct StreamSendWork {
     int fd;
     uint32_t generation;
     size_t len;
-    uint8_t payload[STREAM_WIRE_SIZE];
+    uint8_t payload[LogStreamBatch::FRAME_MAX];
 };
 
-// Two complete four-client fan-outs can be pending at once without touching
-// the heap. If the HTTP server falls further behind, the existing overflow
-// path reconnects clients and repairs the gap from the LogManager snapshot.
-// A fixed pool is deliberately preferable to malloc/free per log line: the
-// latter fragments the small WROOM-32 heap during long live-log sessions.
-static constexpr int STREAM_SEND_WORK_SLOTS = MAX_SUBSCRIBERS * 2;
+// One complete four-client fan-out of a full batch can be pending without
+// touching the heap. A flush normally sends one frame per client every
+// 50 ms, and a slot now carries up to LogStreamBatch::LINES_MAX lines where
+// it used to carry one, so one fan-out holds more backlog than the former
+// eight single-line slots did. If the HTTP server falls further behind, the
+// existing overflow path reconnects clients and repairs the gap from the
+// LogManager snapshot. A fixed pool is deliberately preferable to
+// malloc/free per frame: the latter fragments the small WROOM-32 heap
+// during long live-log sessions.
+static constexpr int STREAM_SEND_WORK_SLOTS = MAX_SUBSCRIBERS;
 static StreamSendWork s_send_work_pool[STREAM_SEND_WORK_SLOTS];
 
 struct CloseTarget {
@@ -244,26 +264,81 @@ static void send_in_httpd_context(void *arg)
     release_send_work(work);
 }
 
-static esp_err_t queue_stream_send(httpd_handle_t server, int fd,
-                                   uint32_t generation,
-                                   const char *payload, size_t len)
+// Hand the subscriber's next frame of s_batch to the HTTP server task.
+static esp_err_t queue_stream_frame(httpd_handle_t server, int fd,
+                                    uint32_t generation, uint64_t *position)
 {
-    if (!server || !payload || len == 0 || len > STREAM_WIRE_SIZE) {
-        return ESP_ERR_INVALID_ARG;
-    }
+    if (!server) return ESP_ERR_INVALID_ARG;
 
     StreamSendWork *work = acquire_send_work();
     if (!work) return ESP_ERR_NO_MEM;
 
+    uint32_t lines = 0;
+    work->len = s_batch.nextFrame(position, reinterpret_cast<char *>(work->payload),
+                                  sizeof(work->payload), &lines);
+    if (work->len == 0) {
+        release_send_work(work);
+        return ESP_ERR_INVALID_ARG;
+    }
     work->server = server;
     work->fd = fd;
     work->generation = generation;
-    work->len = len;
-    memcpy(work->payload, payload, len);
 
     esp_err_t result = httpd_queue_work(server, send_in_httpd_context, work);
-    if (result != ESP_OK) release_send_work(work);
-    return result;
+    if (result != ESP_OK) {
+        release_send_work(work);
+        return result;
+    }
+    g_stream_frames.inc();
+    g_stream_lines.inc(lines);
+    return ESP_OK;
+}
+
+// Send everything in s_batch to the subscribers that have not seen it yet.
+static void flush_batch(httpd_handle_t srv)
+{
+    if (s_batch.empty()) return;
+
+    // Snapshot the ready subscribers under the lock, send unlocked.
+    struct Target {
+        int fd;
+        uint32_t generation;
+        uint64_t checkpoint;
+    } targets[MAX_SUBSCRIBERS];
+    int n = 0;
+    // A handshake briefly holds this lock while taking its ring snapshot.
+    // Wait for that atomic checkpoint instead of dropping the batch in the
+    // tiny snapshot/activation window.
+    SemaphoreHandle_t mutex = stream_mutex();
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
+        if (s_subs[i].fd >= 0 && s_subs[i].delivery_enabled) {
+            targets[n++] = {s_subs[i].fd, s_subs[i].generation,
+                            s_subs[i].checkpoint};
+        }
+    }
+    xSemaphoreGive(mutex);
+
+    if (srv) {
+        for (int i = 0; i < n; i++) {
+            // Lines the subscriber's snapshot already contained are skipped;
+            // a gap in the batch ends a frame and the next one follows.
+            uint64_t position = targets[i].checkpoint;
+            bool failed = false;
+            while (!failed && s_batch.hasFrameAfter(position)) {
+                failed = queue_stream_frame(srv, targets[i].fd,
+                                            targets[i].generation,
+                                            &position) != ESP_OK;
+            }
+            if (failed) {
+                // A failed hand-off loses an absolute byte range. Reconnect on
+                // the worker's next pass so the ring snapshot repairs it.
+                s_publish_overflow.store(true, std::memory_order_release);
+                break;
+            }
+        }
+    }
+    s_batch.clear();
 }
 
 static void publish_worker(void *)
@@ -288,7 +363,9 @@ static void publish_worker(void *)
         if (s_publish_overflow.exchange(false, std::memory_order_acq_rel)) {
             // At least one absolute byte range was lost. Reconnect the clients
             // which observed it so their next snapshots fill the gap.
-            if (queue_close_all_subscribers(srv) != ESP_OK) {
+            if (queue_close_all_subscribers(srv) == ESP_OK) {
+                g_stream_resyncs.inc();
+            } else {
                 // A previously queued recovery owns the single close slot, or
                 // the HTTP control queue is temporarily unavailable. Retry
                 // from the worker; never close a numeric fd from this task.
@@ -305,52 +382,39 @@ static void publish_worker(void *)
         // gets retried even when no producer ever submits another line.
         StreamItem it;
         if (!queue || xQueueReceive(queue, &it, pdMS_TO_TICKS(250)) != pdTRUE) continue;
-        if (it.len == 0) continue;
-
-        // Snapshot the ready subscriber fd list under the lock, send unlocked.
-        struct Target {
-            int fd;
-            uint32_t generation;
-        } targets[MAX_SUBSCRIBERS];
-        int n = 0;
-        // A handshake briefly holds this lock while taking its ring snapshot.
-        // Wait for that atomic checkpoint instead of dropping the item in the
-        // tiny snapshot/activation window.
-        xSemaphoreTake(mutex, portMAX_DELAY);
-        for (int i = 0; i < MAX_SUBSCRIBERS; i++) {
-            if (s_subs[i].fd >= 0 && s_subs[i].delivery_enabled &&
-                it.end_offset > s_subs[i].checkpoint) {
-                targets[n++] = {s_subs[i].fd, s_subs[i].generation};
-            }
-        }
-        xSemaphoreGive(mutex);
-
-        if (!srv || n == 0) continue;
-
-        char wire[STREAM_WIRE_SIZE];
-        int header_len = snprintf(wire, sizeof(wire), "stream data %" PRIu64 "\n", it.end_offset);
-        if (header_len <= 0 || (size_t)header_len + it.len > sizeof(wire)) continue;
-        memcpy(wire + header_len, it.payload, it.len);
 
-        for (int i = 0; i < n; i++) {
-            esp_err_t r = queue_stream_send(
-                srv, targets[i].fd, targets[i].generation, wire,
-                (size_t)header_len + it.len);
-            if (r != ESP_OK) {
-                // A failed hand-off loses an absolute byte range. Reconnect on
-                // the worker's next pass so the ring snapshot repairs it.
-                s_publish_overflow.store(true, std::memory_order_release);
+        // Gather what arrives within the flush interval. The receive loop
+        // keeps the 8-item publish queue drained during a burst; a full batch
+        // is sent early.
+        const TickType_t window_start = xTaskGetTickCount();
+        for (;;) {
+            if (it.len > 0) {
+                // Rendering caps the line and keeps its trailing newline. An
+                // entry that renders to nothing still covers its range.
+                const size_t text_len = log_entry_render(it.entry, it.len,
+                                                         s_line, sizeof(s_line));
+                if (!s_batch.append(s_line, text_len, it.end_offset, (uint32_t)it.len)) {
+                    flush_batch(srv);
+                    s_batch.append(s_line, text_len, it.end_offset, (uint32_t)it.len);
+                }
+            }
+            const TickType_t waited = xTaskGetTickCount() - window_start;
+            if (waited >= STREAM_FLUSH_INTERVAL ||
+                s_publish_overflow.load(std::memory_order_acquire) ||
+                xQueueReceive(queue, &it, STREAM_FLUSH_INTERVAL - waited) != pdTRUE) {
                 break;
             }
         }
+        flush_batch(srv);
     }
-    ESP_LOGI(TAG, "publish worker stopped");
+    ESP_LOGI(TAG, "publish worker stopped (stack high water mark %u bytes free)",
+             (unsigned)uxTaskGetStackHighWaterMark(NULL));
     vTaskDelete(NULL);
 }
 
-void log_stream_publish(const char *message, size_t len, uint64_t end_offset)
+void log_stream_publish(const uint8_t *entry, size_t len, uint64_t end_offset)
 {
-    if (!message || len == 0 || end_offset == 0 ||
+    if (!entry || len == 0 || len > LOG_ENTRY_MAX || end_offset == 0 ||
         !s_pipeline_active.load(std::memory_order_acquire)) return;
 
     // Published by the release-store to s_pipeline_active and never deleted
@@ -360,10 +424,8 @@ void log_stream_publish(const char *message, size_t len, uint64_t end_offset)
     if (!queue) return;
 
     StreamItem it;
-    size_t n = len;
-    if (n > sizeof(it.payload)) n = sizeof(it.payload);
-    memcpy(it.payload, message, n);
-    it.len = n;
+    memcpy(it.entry, entry, len);
+    it.len = len;
     it.end_offset = end_offset;
 
     // Non-blocking logging path. A full queue is recovered by forcing a
@@ -373,11 +435,11 @@ void log_stream_publish(const char *message, size_t len, uint64_t end_offset)
     }
 }
 
-// Subscriber hook for LogManager: forward the raw formatted line.
-static void log_stream_subscriber(const char *line, size_t len, uint64_t end_offset)
+// Subscriber hook for LogManager: forward the captured entry unformatted.
+static void log_stream_subscriber(const uint8_t *entry, size_t len, uint64_t end_offset)
 {
-    if (!line || len == 0) return;
-    log_stream_publish(line, len, end_offset);
+    if (!entry || len == 0) return;
+    log_stream_publish(entry, len, end_offset);
 }
 
 int log_stream_subscriber_count(void)
@@ -438,7 +500,9 @@ static bool register_subscriber(int fd, uint64_t requested_offset,
         if (!s_worker) {
             xQueueReset(s_publish_q);
             s_publish_overflow.store(false, std::memory_order_release);
-            // 3 KB stack: fixed wire buffer plus queue and subscriber state.
+            // 3 KB stack: one queued entry, the subscriber snapshot and
+            // vsnprintf of one line; the rendered line and the batch are
+            // static. The stop message reports the high-water mark.
             if (xTaskCreate(publish_worker, "log_stream", 3072, NULL, 4,
                             &s_worker) != pdPASS) {
                 s_worker = NULL;
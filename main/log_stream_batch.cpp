@@ -0,0 +1,83 @@
+/*
+ *  log_stream_batch.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "log_stream_batch.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+bool LogStreamBatch::append(const char *text, size_t len, uint64_t end_offset,
+                            uint32_t span) {
+    if (_count == LINES_MAX || len > TEXT_MAX - _text_len || span == 0 || end_offset < span) {
+        return false;
+    }
+    // Insertion from the back: out-of-order lines are rare and near the end.
+    size_t at = _count;
+    while (at > 0 && _pieces[at - 1].end > end_offset) {
+        _pieces[at] = _pieces[at - 1];
+        at--;
+    }
+    _pieces[at] = {end_offset, span, (uint16_t)_text_len, (uint16_t)len};
+    _count++;
+    if (len > 0) memcpy(_text + _text_len, text, len);
+    _text_len += len;
+    return true;
+}
+
+size_t LogStreamBatch::firstAfter(uint64_t position) const {
+    size_t i = 0;
+    while (i < _count && _pieces[i].end <= position) i++;
+    return i;
+}
+
+bool LogStreamBatch::hasFrameAfter(uint64_t position) const {
+    return firstAfter(position) < _count;
+}
+
+size_t LogStreamBatch::nextFrame(uint64_t *position, char *out, size_t cap,
+                                 uint32_t *lines) const {
+    // All text of a batch fits one frame, so a frame is never cut.
+    const size_t first = firstAfter(*position);
+    if (first == _count || cap < FRAME_MAX) return 0;
+
+    // The run of entries that follow each other without a gap.
+    size_t last = first;
+    while (last + 1 < _count &&
+           _pieces[last + 1].end - _pieces[last + 1].span == _pieces[last].end) {
+        last++;
+    }
+    const uint64_t start = _pieces[first].end - _pieces[first].span;
+    const uint64_t end = _pieces[last].end;
+
+    const int n = snprintf(out, HEADER_MAX, "stream data %" PRIu64 " %" PRIu64 "\n",
+                           end, end - start);
+    if (n <= 0 || (size_t)n >= HEADER_MAX) return 0;
+    size_t len = (size_t)n;
+    for (size_t i = first; i <= last; i++) {
+        memcpy(out + len, _text + _pieces[i].text_at, _pieces[i].text_len);
+        len += _pieces[i].text_len;
+    }
+    *position = end;
+    if (lines) *lines = (uint32_t)(last - first + 1);
+    return len;
+}
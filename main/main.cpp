@@ -50,6 +50,7 @@
 #include "esp_ota_ops.h"
 #include "monitoring.h"
 #include "log_manager.h"
+#include "log_journal.h"
 #include "metrics.h"
 #include "events.h"
 #include "reset_info.h"
@@ -339,6 +340,13 @@ void app_main()
     static WebUI webUI(&settings, &statusLED, &sysInfo, &ethernet, &rawUartUdpLister, &radioModuleConnector, &radioModuleDetector);
     webUI.start();
 
+    // Keep captured log lines across reboots in the WWW partition. Started
+    // after the WebUI storage is mounted; idle while system logging is off.
+    if (log_journal_start() != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Log journal could not be started");
+    }
+
     // If system logging was enabled in settings but the ring buffer could not
     // be allocated during early boot (heap was too tight — typically because
     // of TLS-heavy startup work), retry once
@@ -22,6 +22,7 @@
  */
 
 #include "metrics.h"
+#include "prometheus_text.h"
 #include <atomic>
 #include <cstring>
 #include <stdio.h>
@@ -35,7 +36,7 @@ static const char *TAG = "metrics";
 // Bounded registry — counters are registered once at boot, so a small
 // fixed table avoids dynamic allocation and is safe under the boot-time
 // registration lock.
-static constexpr int MAX_COUNTERS = 32;
+static constexpr int MAX_COUNTERS = 48;
 
 static_assert(std::atomic<uint32_t>::is_always_lock_free,
               "ESP32 metrics require lock-free native 32-bit atomics");
@@ -226,44 +227,38 @@ extern "C" void metrics_gauge_reset(metrics_gauge_t gauge)
     gauge->high_water.store(0, std::memory_order_release);
 }
 
-extern "C" size_t metrics_render_prometheus(char *out, size_t cap, size_t offset)
+extern "C" size_t metrics_render_prometheus_part(char *out, size_t cap, size_t offset,
+                                                size_t *resume)
 {
-    if (!out || cap == 0) return offset;
-    if (offset >= cap) offset = cap - 1;
-    out[offset] = '\0';
+    PrometheusText text(out, cap, offset, resume);
 
     // Take the mutex to get a consistent snapshot of the table layout; the
     // counter values themselves are atomic and may drift between reads.
-    if (s_registry_mutex == NULL) return offset;
+    // One part per counter or gauge.
+    if (s_registry_mutex == NULL) return text.finish();
     xSemaphoreTake(s_registry_mutex, portMAX_DELAY);
     int n = s_counter_count;
     for (int i = 0; i < n; i++) {
-        if (offset + 1 >= cap) break;
         const metrics_counter &c = s_counters[i];
-        uint64_t v = metrics_snapshot(&c);
-        int written = snprintf(out + offset, cap - offset,
-                               "# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
-                               c.name, c.help[0] ? c.help : "counter",
-                               c.name, c.name, (unsigned long long)v);
-        if (written < 0) break;
-        size_t adv = (size_t)written;
-        if (adv >= cap - offset) adv = cap - offset - 1;
-        offset += adv;
+        text.emit("# HELP %s %s\n# TYPE %s counter\n%s %llu\n",
+                  c.name, c.help[0] ? c.help : "counter",
+                  c.name, c.name, (unsigned long long)metrics_snapshot(&c));
+        text.endPart();
     }
     int gauges = s_gauge_count;
     for (int i = 0; i < gauges; i++) {
-        if (offset + 1 >= cap) break;
         const metrics_gauge &g = s_gauges[i];
-        int written = snprintf(out + offset, cap - offset, "# HELP %s %s\n# TYPE %s gauge\n%s %u\n",
-                               g.name, g.help[0] ? g.help : "gauge", g.name, g.name,
-                               (unsigned)g.high_water.load(std::memory_order_acquire));
-        if (written < 0) break;
-        size_t adv = (size_t)written;
-        if (adv >= cap - offset) adv = cap - offset - 1;
-        offset += adv;
+        text.emit("# HELP %s %s\n# TYPE %s gauge\n%s %u\n",
+                  g.name, g.help[0] ? g.help : "gauge", g.name, g.name,
+                  (unsigned)g.high_water.load(std::memory_order_acquire));
+        text.endPart();
     }
     xSemaphoreGive(s_registry_mutex);
 
-    out[offset] = '\0';
-    return offset;
+    return text.finish();
+}
+
+extern "C" size_t metrics_render_prometheus(char *out, size_t cap, size_t offset)
+{
+    return metrics_render_prometheus_part(out, cap, offset, NULL);
 }
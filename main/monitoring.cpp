@@ -28,6 +28,7 @@
 #include "events.h"
 #include "settings.h"
 #include "log_manager.h"
+#include "log_journal.h"
 #include "esp_log.h"
 #include "nvs_flash.h"
 #include "nvs.h"
@@ -48,6 +49,7 @@
 #include <errno.h>
 #include <atomic>
 #include "ethernet.h"
+#include "radiomoduleconnector.h"
 #include "radiomoduledetector.h"
 #include "systemclock.h"
 #include "reset_info.h"
@@ -155,6 +157,9 @@ enum OtaPausedService : uint32_t {
 #define NVS_MQTT_TLS_KEY    "mqtt_tls_key"
 #define NVS_MQTT_CMD_EN     "mqtt_cmd_en"   // command topic enabled
 #define NVS_MQTT_CMD_TOK    "mqtt_cmd_tok"  // optional shared-secret
+#define NVS_MQTT_REFRESH    "mqtt_refresh"  // status refresh interval, minutes
+#define NVS_MQTT_STATE_DOC  "mqtt_state_doc" // status as one JSON document
+#define NVS_MQTT_V5         "mqtt_v5"       // connect with MQTT 5
 
 // Prometheus (Phase A)
 #define NVS_PROM_ENABLED    "prom_en"
@@ -168,6 +173,9 @@ enum OtaPausedService : uint32_t {
 #define NVS_SYSLOG_XPORT    "syslog_xp"
 #define NVS_SYSLOG_SEV      "syslog_sev"
 #define NVS_SYSLOG_HOST     "syslog_host"
+#define NVS_SYSLOG_RATE     "syslog_rate"
+#define NVS_SYSLOG_BURST    "syslog_burst"
+#define NVS_SYSLOG_FMT      "syslog_fmt"
 
 // Notifications (Phase C/D)
 #define NVS_NOTIFY_ENABLED  "notify_en"
@@ -185,6 +193,9 @@ enum OtaPausedService : uint32_t {
 #define NVS_NOTIFY_SMTPTO   "notify_smtp_to"
 #define NVS_NOTIFY_COOLDOWN "notify_cd"
 #define NVS_NOTIFY_EVENTS   "notify_ev"
+#define NVS_NOTIFY_DC_WARN  "notify_dcw"
+#define NVS_NOTIFY_DC_ALARM "notify_dca"
+#define NVS_NOTIFY_DIGEST   "notify_dg"
 
 // Global pointers
 static SysInfo* g_sysInfo = NULL;
@@ -648,6 +659,9 @@ static const ConfigFieldDesc CONFIG_FIELDS[] = {
     CFG_BLOB(mqtt.tls_keyfile, NVS_MQTT_TLS_KEY),
     CFG_U8(mqtt.command_enabled, NVS_MQTT_CMD_EN),
     CFG_STR(mqtt.command_token, NVS_MQTT_CMD_TOK),
+    CFG_U16(mqtt.status_refresh_minutes, NVS_MQTT_REFRESH),
+    CFG_U8(mqtt.state_document, NVS_MQTT_STATE_DOC),
+    CFG_U8(mqtt.protocol_v5, NVS_MQTT_V5),
     CFG_U8(prometheus.enabled, NVS_PROM_ENABLED),
     CFG_U16(prometheus.port, NVS_PROM_PORT),
     CFG_STR(prometheus.allowed_hosts, NVS_PROM_HOSTS),
@@ -657,6 +671,9 @@ static const ConfigFieldDesc CONFIG_FIELDS[] = {
     CFG_U8(syslog.transport, NVS_SYSLOG_XPORT),
     CFG_U8(syslog.min_severity, NVS_SYSLOG_SEV),
     CFG_STR(syslog.hostname, NVS_SYSLOG_HOST),
+    CFG_U16(syslog.rate_limit, NVS_SYSLOG_RATE),
+    CFG_U16(syslog.rate_burst, NVS_SYSLOG_BURST),
+    CFG_U8(syslog.format, NVS_SYSLOG_FMT),
     CFG_U8(notify.enabled, NVS_NOTIFY_ENABLED),
     CFG_U8(notify.channels, NVS_NOTIFY_CHANS),
     CFG_STR(notify.webhook_url, NVS_NOTIFY_WHOOK),
@@ -672,6 +689,9 @@ static const ConfigFieldDesc CONFIG_FIELDS[] = {
     CFG_STR(notify.smtp_to, NVS_NOTIFY_SMTPTO),
     CFG_U16(notify.cooldown_seconds, NVS_NOTIFY_COOLDOWN),
     CFG_U16(notify.event_mask, NVS_NOTIFY_EVENTS),
+    CFG_U8(notify.duty_cycle_warn, NVS_NOTIFY_DC_WARN),
+    CFG_U8(notify.duty_cycle_alarm, NVS_NOTIFY_DC_ALARM),
+    CFG_U16(notify.digest_seconds, NVS_NOTIFY_DIGEST),
 };
 
 #undef CFG_OFF
@@ -1116,6 +1136,19 @@ static esp_err_t load_integrity_sensitive_config(
                    load_optional_integrity_text(
                        handle, NVS_MQTT_CMD_TOK, config->mqtt.command_token,
                        sizeof(config->mqtt.command_token)));
+    // zero_allowed: 0 publishes every status topic on every cycle.
+    LOAD_INTEGRITY(NVS_MQTT_REFRESH,
+                   load_optional_integrity_u16(
+                       handle, NVS_MQTT_REFRESH,
+                       &config->mqtt.status_refresh_minutes, true));
+    LOAD_INTEGRITY(NVS_MQTT_STATE_DOC,
+                   load_optional_integrity_bool(
+                       handle, NVS_MQTT_STATE_DOC,
+                       &config->mqtt.state_document));
+    LOAD_INTEGRITY(NVS_MQTT_V5,
+                   load_optional_integrity_bool(
+                       handle, NVS_MQTT_V5,
+                       &config->mqtt.protocol_v5));
 
     // A corrupt transport must never normalize TLS back to UDP/plain TCP.
     LOAD_INTEGRITY(NVS_SYSLOG_ENABLED,
@@ -1141,6 +1174,17 @@ static esp_err_t load_integrity_sensitive_config(
                    load_optional_integrity_text(
                        handle, NVS_SYSLOG_HOST, config->syslog.hostname,
                        sizeof(config->syslog.hostname)));
+    // zero_allowed: a rate of 0 switches the log limiter off.
+    LOAD_INTEGRITY(NVS_SYSLOG_RATE,
+                   load_optional_integrity_u16(
+                       handle, NVS_SYSLOG_RATE, &config->syslog.rate_limit, true));
+    LOAD_INTEGRITY(NVS_SYSLOG_BURST,
+                   load_optional_integrity_u16(
+                       handle, NVS_SYSLOG_BURST, &config->syslog.rate_burst));
+    LOAD_INTEGRITY(NVS_SYSLOG_FMT,
+                   load_optional_integrity_u8(
+                       handle, NVS_SYSLOG_FMT,
+                       &config->syslog.format, 2));
 
     // Notification routing, TLS mode, endpoints and all channel secrets are a
     // single integrity domain: a partial fallback could leak or misroute data.
@@ -1213,6 +1257,19 @@ static esp_err_t load_integrity_sensitive_config(
     LOAD_INTEGRITY(
         NVS_NOTIFY_EVENTS,
         load_optional_integrity_u16(handle, NVS_NOTIFY_EVENTS, &config->notify.event_mask, true));
+    LOAD_INTEGRITY(NVS_NOTIFY_DC_WARN,
+                   load_optional_integrity_u8(
+                       handle, NVS_NOTIFY_DC_WARN,
+                       &config->notify.duty_cycle_warn, 100));
+    LOAD_INTEGRITY(NVS_NOTIFY_DC_ALARM,
+                   load_optional_integrity_u8(
+                       handle, NVS_NOTIFY_DC_ALARM,
+                       &config->notify.duty_cycle_alarm, 100));
+    // 0 (digest off) is the default and a valid stored value.
+    LOAD_INTEGRITY(NVS_NOTIFY_DIGEST,
+                   load_optional_integrity_u16(
+                       handle, NVS_NOTIFY_DIGEST,
+                       &config->notify.digest_seconds, true));
 
 #undef LOAD_INTEGRITY
     return ESP_OK;
@@ -1349,6 +1406,7 @@ static void heap_watchdog_task(void *pvParameters)
                 // too tight to format, the diag string above still carries
                 // the headline numbers.
                 LogManager::instance().saveCrashTailNvs("heap_watchdog");
+                log_journal_flush();
                 ResetInfo::storeResetReason(RESET_REASON_WATCHDOG, diag);
                 vTaskDelay(pdMS_TO_TICKS(200));
                 esp_restart();
@@ -1583,6 +1641,12 @@ esp_err_t monitoring_init(const monitoring_config_t *config, SysInfo* sysInfo)
         prometheus_start(&current_config.prometheus);
     }
 
+    // The log rate limit covers the whole capture path, not just syslog.
+    LogManager::setRateLimit(current_config.syslog.rate_limit,
+                             current_config.syslog.rate_burst);
+    radio_module_set_duty_cycle_thresholds(current_config.notify.duty_cycle_warn,
+                                           current_config.notify.duty_cycle_alarm);
+
     // Start syslog forwarder if enabled
     if (current_config.syslog.enabled) {
         syslog_start(&current_config.syslog);
@@ -1699,6 +1763,32 @@ static void rollback_bounded_config_transitions(
 }
 
 // Update configuration
+// The log rate limit lives in syslog_config_t but is applied to LogManager
+// directly; changing it alone must not restart the forwarder.
+static bool syslog_forwarding_changed(const syslog_config_t *current,
+                                      const syslog_config_t *candidate)
+{
+    syslog_config_t a, b;
+    memcpy(&a, current, sizeof(a));
+    memcpy(&b, candidate, sizeof(b));
+    a.rate_limit = b.rate_limit = 0;
+    a.rate_burst = b.rate_burst = 0;
+    return memcmp(&a, &b, sizeof(a)) != 0;
+}
+
+// Likewise the duty-cycle thresholds are read by the radio module connector,
+// not the notification worker.
+static bool notify_delivery_changed(const notify_config_t *current,
+                                    const notify_config_t *candidate)
+{
+    notify_config_t a, b;
+    memcpy(&a, current, sizeof(a));
+    memcpy(&b, candidate, sizeof(b));
+    a.duty_cycle_warn = b.duty_cycle_warn = 0;
+    a.duty_cycle_alarm = b.duty_cycle_alarm = 0;
+    return memcmp(&a, &b, sizeof(a)) != 0;
+}
+
 esp_err_t monitoring_update_config(const monitoring_config_t *config)
 {
     if (config == NULL) return ESP_ERR_INVALID_ARG;
@@ -1726,8 +1816,8 @@ esp_err_t monitoring_update_config(const monitoring_config_t *config)
     bool checkmk_changed    = (memcmp(&current_config.checkmk,    &config->checkmk,    sizeof(checkmk_config_t))    != 0);
     bool mqtt_changed       = (memcmp(&current_config.mqtt,       &config->mqtt,       sizeof(mqtt_config_t))       != 0);
     bool prometheus_changed = (memcmp(&current_config.prometheus, &config->prometheus, sizeof(prometheus_config_t)) != 0);
-    bool syslog_changed     = (memcmp(&current_config.syslog,     &config->syslog,     sizeof(syslog_config_t))     != 0);
-    bool notify_changed     = (memcmp(&current_config.notify,     &config->notify,     sizeof(notify_config_t))     != 0);
+    bool syslog_changed     = syslog_forwarding_changed(&current_config.syslog, &config->syslog);
+    bool notify_changed     = notify_delivery_changed(&current_config.notify, &config->notify);
     bool checkmk_was_enabled    = current_config.checkmk.enabled;
     bool mqtt_was_enabled       = current_config.mqtt.enabled;
     bool prometheus_was_enabled = current_config.prometheus.enabled;
@@ -1907,6 +1997,9 @@ esp_err_t monitoring_update_config(const monitoring_config_t *config)
     xSemaphoreTake(config_mutex, portMAX_DELAY);
     memcpy(&current_config, config, sizeof(monitoring_config_t));
     xSemaphoreGive(config_mutex);
+    LogManager::setRateLimit(config->syslog.rate_limit, config->syslog.rate_burst);
+    radio_module_set_duty_cycle_thresholds(config->notify.duty_cycle_warn,
+                                           config->notify.duty_cycle_alarm);
 
     return ESP_OK;
 }
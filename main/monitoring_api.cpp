@@ -24,6 +24,7 @@
 #include "monitoring_api.h"
 #include "monitoring.h"
 #include "validation.h"
+#include "log_limiter.h"
 #include "security_headers.h"
 #include "esp_err.h"
 #include "esp_log.h"
@@ -168,6 +169,9 @@ esp_err_t get_monitoring_handler_func(httpd_req_t *req)
     // sends "commandTokenClear=true" to remove it, or a new value to replace.
     cJSON_AddBoolToObject(mqtt, "commandEnabled", config.mqtt.command_enabled);
     cJSON_AddBoolToObject(mqtt, "commandTokenSet", strlen(config.mqtt.command_token) > 0);
+    cJSON_AddNumberToObject(mqtt, "statusRefreshMinutes", config.mqtt.status_refresh_minutes);
+    cJSON_AddBoolToObject(mqtt, "stateDocument", config.mqtt.state_document);
+    cJSON_AddBoolToObject(mqtt, "protocolV5", config.mqtt.protocol_v5);
     cJSON_AddItemToObject(root, "mqtt", mqtt);
 
     // CheckMK config
@@ -208,6 +212,9 @@ esp_err_t get_monitoring_handler_func(httpd_req_t *req)
     cJSON_AddNumberToObject(syslog, "transport", config.syslog.transport);
     cJSON_AddNumberToObject(syslog, "minSeverity", config.syslog.min_severity);
     cJSON_AddStringToObject(syslog, "hostname", config.syslog.hostname);
+    cJSON_AddNumberToObject(syslog, "rateLimit", config.syslog.rate_limit);
+    cJSON_AddNumberToObject(syslog, "rateBurst", config.syslog.rate_burst);
+    cJSON_AddNumberToObject(syslog, "format", config.syslog.format);
     cJSON_AddItemToObject(root, "syslog", syslog);
 
     // Notify config (Phase C/D) — secrets are echoed back only as "is set"
@@ -237,6 +244,9 @@ esp_err_t get_monitoring_handler_func(httpd_req_t *req)
     // renders exactly the supported checkboxes instead of hardcoding a list
     // that drifts out of sync with the firmware it is talking to.
     cJSON_AddNumberToObject(notify, "eventMaskSupported", NOTIFY_EVENT_ALL);
+    cJSON_AddNumberToObject(notify, "dutyCycleWarn", config.notify.duty_cycle_warn);
+    cJSON_AddNumberToObject(notify, "dutyCycleAlarm", config.notify.duty_cycle_alarm);
+    cJSON_AddNumberToObject(notify, "digestSeconds", config.notify.digest_seconds);
     cJSON_AddItemToObject(root, "notify", notify);
 
     char *json_string = cJSON_Print(root);
@@ -547,6 +557,29 @@ esp_err_t post_monitoring_handler_func(httpd_req_t *req)
                               sizeof(config.mqtt.command_token),
                               commandToken->valuestring);
         }
+
+        cJSON *statusRefresh = cJSON_GetObjectItem(mqtt, "statusRefreshMinutes");
+        if (statusRefresh != NULL && cJSON_IsNumber(statusRefresh))
+        {
+            if (statusRefresh->valuedouble < 0 || statusRefresh->valuedouble > 1440)
+            {
+                cJSON_Delete(root);
+                return send_json_error(req, "Invalid MQTT status refresh interval");
+            }
+            config.mqtt.status_refresh_minutes = (uint16_t)statusRefresh->valueint;
+        }
+
+        cJSON *stateDocument = cJSON_GetObjectItem(mqtt, "stateDocument");
+        if (stateDocument != NULL && cJSON_IsBool(stateDocument))
+        {
+            config.mqtt.state_document = cJSON_IsTrue(stateDocument);
+        }
+
+        cJSON *protocolV5 = cJSON_GetObjectItem(mqtt, "protocolV5");
+        if (protocolV5 != NULL && cJSON_IsBool(protocolV5))
+        {
+            config.mqtt.protocol_v5 = cJSON_IsTrue(protocolV5);
+        }
     }
 
     // Parse Prometheus config (Phase A)
@@ -613,6 +646,30 @@ esp_err_t post_monitoring_handler_func(httpd_req_t *req)
             }
             copy_string_field(config.syslog.hostname, sizeof(config.syslog.hostname), shost->valuestring);
         }
+        cJSON *srate = cJSON_GetObjectItem(syslog, "rateLimit");
+        if (srate && cJSON_IsNumber(srate)) {
+            if (srate->valuedouble < 0 || srate->valuedouble > LogLimiter::MAX_RATE) {
+                cJSON_Delete(root);
+                return send_json_error(req, "Invalid log rate limit");
+            }
+            config.syslog.rate_limit = (uint16_t)srate->valueint;
+        }
+        cJSON *sburst = cJSON_GetObjectItem(syslog, "rateBurst");
+        if (sburst && cJSON_IsNumber(sburst)) {
+            if (sburst->valuedouble < 1 || sburst->valuedouble > LogLimiter::MAX_BURST) {
+                cJSON_Delete(root);
+                return send_json_error(req, "Invalid log rate burst");
+            }
+            config.syslog.rate_burst = (uint16_t)sburst->valueint;
+        }
+        cJSON *sfmt = cJSON_GetObjectItem(syslog, "format");
+        if (sfmt && cJSON_IsNumber(sfmt)) {
+            if (sfmt->valuedouble < 0 || sfmt->valuedouble > 2) {
+                cJSON_Delete(root);
+                return send_json_error(req, "Invalid syslog format");
+            }
+            config.syslog.format = (uint8_t)sfmt->valueint;
+        }
     }
 
     // Parse Notify config (Phase C/D)
@@ -752,6 +809,30 @@ esp_err_t post_monitoring_handler_func(httpd_req_t *req)
             }
             config.notify.event_mask = (uint16_t)nev->valueint;
         }
+        cJSON *ndw = cJSON_GetObjectItem(notify, "dutyCycleWarn");
+        if (ndw && cJSON_IsNumber(ndw)) {
+            if (ndw->valuedouble < 0 || ndw->valuedouble > 100) {
+                cJSON_Delete(root);
+                return send_json_error(req, "Invalid duty cycle warning threshold");
+            }
+            config.notify.duty_cycle_warn = (uint8_t)ndw->valueint;
+        }
+        cJSON *nda = cJSON_GetObjectItem(notify, "dutyCycleAlarm");
+        if (nda && cJSON_IsNumber(nda)) {
+            if (nda->valuedouble < 0 || nda->valuedouble > 100) {
+                cJSON_Delete(root);
+                return send_json_error(req, "Invalid duty cycle alarm threshold");
+            }
+            config.notify.duty_cycle_alarm = (uint8_t)nda->valueint;
+        }
+        cJSON *ndg = cJSON_GetObjectItem(notify, "digestSeconds");
+        if (ndg && cJSON_IsNumber(ndg)) {
+            if (ndg->valuedouble < 0 || ndg->valuedouble > 3600) {
+                cJSON_Delete(root);
+                return send_json_error(req, "Invalid notification digest window");
+            }
+            config.notify.digest_seconds = (uint16_t)ndg->valueint;
+        }
     }
 
     cJSON_Delete(root);
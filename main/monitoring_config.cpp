@@ -33,6 +33,7 @@ void monitoring_config_set_defaults(monitoring_config_t *config)
     strncpy(config->mqtt.ha_discovery_prefix, "homeassistant",
             sizeof(config->mqtt.ha_discovery_prefix) - 1);
     config->mqtt.command_enabled = true;
+    config->mqtt.status_refresh_minutes = 15;
 
     config->prometheus.port = 9100;
     strncpy(config->prometheus.allowed_hosts, "*",
@@ -41,6 +42,9 @@ void monitoring_config_set_defaults(monitoring_config_t *config)
     config->syslog.port = 514;
     config->syslog.transport = 0;
     config->syslog.min_severity = 6;
+    config->syslog.rate_limit = 20;
+    config->syslog.rate_burst = 50;
+    config->syslog.format = 0;
 
     config->notify.smtp_port = 587;
     config->notify.smtp_tls = 1;
@@ -50,6 +54,8 @@ void monitoring_config_set_defaults(monitoring_config_t *config)
     // when its key is missing, so an existing installation keeps receiving
     // exactly what it received before.
     config->notify.event_mask = NOTIFY_EVENT_ALL;
+    config->notify.duty_cycle_warn = 50;
+    config->notify.duty_cycle_alarm = 80;
 }
 
 void monitoring_config_normalize(monitoring_config_t *config)
@@ -76,15 +82,36 @@ void monitoring_config_normalize(monitoring_config_t *config)
         config->notify.smtp_port = 587;
     }
 
+    if (config->mqtt.status_refresh_minutes > 1440) {
+        config->mqtt.status_refresh_minutes = 1440;
+    }
     if (config->syslog.transport > 2) {
         config->syslog.transport = 0;
     }
     if (config->syslog.min_severity > 7) {
         config->syslog.min_severity = 6;
     }
+    if (config->syslog.format > 2) {
+        config->syslog.format = 0;
+    }
+    if (config->syslog.rate_limit > 1000) {
+        config->syslog.rate_limit = 1000;
+    }
+    if (config->syslog.rate_burst == 0 || config->syslog.rate_burst > 1000) {
+        config->syslog.rate_burst = 50;
+    }
     if (config->notify.smtp_tls > 2) {
         config->notify.smtp_tls = 1;
     }
+    if (config->notify.duty_cycle_warn > 100) {
+        config->notify.duty_cycle_warn = 50;
+    }
+    if (config->notify.duty_cycle_alarm > 100) {
+        config->notify.duty_cycle_alarm = 80;
+    }
+    if (config->notify.digest_seconds > 3600) {
+        config->notify.digest_seconds = 3600;
+    }
 
     // Bits above the defined events cannot come from this firmware's WebUI,
     // but a hand-crafted API call or a restored backup from a newer build
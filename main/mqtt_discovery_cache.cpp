@@ -0,0 +1,123 @@
+/*
+ *  mqtt_discovery_cache.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "mqtt_discovery_cache.h"
+
+#include <string.h>
+
+// Serialized form: a version byte, then key/content pairs, little-endian.
+static constexpr uint8_t FORMAT_VERSION = 1;
+
+static void put_u32(uint8_t *out, uint32_t value) {
+    for (int i = 0; i < 4; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static uint32_t get_u32(const uint8_t *in) {
+    return (uint32_t)in[0] | (uint32_t)in[1] << 8 | (uint32_t)in[2] << 16 |
+           (uint32_t)in[3] << 24;
+}
+
+void MqttDiscoveryCache::clear() {
+    _dirty = _dirty || _count > 0;
+    _count = 0;
+    memset(_seen, 0, sizeof(_seen));
+}
+
+int MqttDiscoveryCache::find(uint32_t key) const {
+    for (size_t i = 0; i < _count; i++) {
+        if (_entries[i].key == key) return (int)i;
+    }
+    return -1;
+}
+
+void MqttDiscoveryCache::beginPass() {
+    memset(_seen, 0, sizeof(_seen));
+}
+
+bool MqttDiscoveryCache::changed(uint32_t key, uint32_t content) {
+    const int i = find(key);
+    if (i < 0) return true;
+    _seen[i] = true;
+    return _entries[i].content != content;
+}
+
+bool MqttDiscoveryCache::record(uint32_t key, uint32_t content) {
+    int i = find(key);
+    if (i < 0) {
+        if (_count == MAX_ENTITIES) return false;
+        i = (int)_count++;
+        _entries[i].key = key;
+    } else if (_entries[i].content == content) {
+        _seen[i] = true;
+        return true;
+    }
+    _entries[i].content = content;
+    _seen[i] = true;
+    _dirty = true;
+    return true;
+}
+
+void MqttDiscoveryCache::endPass() {
+    size_t kept = 0;
+    for (size_t i = 0; i < _count; i++) {
+        if (!_seen[i]) {
+            _dirty = true;
+            continue;
+        }
+        _entries[kept] = _entries[i];
+        _seen[kept] = true;
+        kept++;
+    }
+    _count = kept;
+}
+
+size_t MqttDiscoveryCache::serializedSize() const {
+    return 1 + _count * 8;
+}
+
+size_t MqttDiscoveryCache::serialize(uint8_t *out, size_t capacity) const {
+    if (!out || capacity < serializedSize()) return 0;
+    out[0] = FORMAT_VERSION;
+    for (size_t i = 0; i < _count; i++) {
+        put_u32(out + 1 + i * 8, _entries[i].key);
+        put_u32(out + 5 + i * 8, _entries[i].content);
+    }
+    return serializedSize();
+}
+
+bool MqttDiscoveryCache::deserialize(const uint8_t *data, size_t len) {
+    _count = 0;
+    _dirty = false;
+    memset(_seen, 0, sizeof(_seen));
+    if (!data || len < 1 || data[0] != FORMAT_VERSION || (len - 1) % 8 != 0 ||
+        (len - 1) / 8 > MAX_ENTITIES) {
+        return false;
+    }
+    _count = (len - 1) / 8;
+    for (size_t i = 0; i < _count; i++) {
+        _entries[i].key = get_u32(data + 1 + i * 8);
+        _entries[i].content = get_u32(data + 5 + i * 8);
+    }
+    return true;
+}
@@ -31,7 +31,15 @@
 #include "nvs_storage_lock.h"
 #include "events.h"
 #include "rawuartudplistener.h"
+#include "metrics.h"
+#include "mqtt_value_cache.h"
+#include "json_writer.h"
+#include "mqtt_topic_table.h"
+#include "mqtt_discovery_cache.h"
+#include "mqtt_pacer.h"
+#include "mqtt_topic_aliases.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "mqtt_client.h"
 #include "esp_crt_bundle.h"
 #include "nvs_flash.h"
@@ -39,8 +47,8 @@
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "freertos/semphr.h"
+#include "freertos/queue.h"
 #include "freertos/timers.h"
-#include "cJSON.h"
 #include "lwip/ip4_addr.h"
 #include "ethernet.h"
 #include "radiomoduledetector.h"
@@ -69,9 +77,223 @@ static TimerHandle_t mqtt_stop_watchdog_timer = NULL;
 static StaticTimer_t mqtt_stop_watchdog_timer_buffer;
 static mqtt_config_t current_mqtt_config;
 static mqtt_config_t *mqtt_pending_restart_config = NULL;
-static char mqtt_lwt_topic[160];
 static std::atomic<bool> mqtt_restart_command_pending{false};
 
+// Retained status values last published, see mqtt_handler_publish_status().
+// The periodic task and MQTT_EVENT_CONNECTED both publish status, so the
+// cache and the cycle using it are serialised by status_cache_mutex.
+static MqttValueCache status_cache;
+static SemaphoreHandle_t status_cache_mutex = NULL;
+static StaticSemaphore_t status_cache_mutex_buffer;
+static std::atomic<bool> status_cache_stale{true};
+// Set by MQTT_EVENT_CONNECTED; the publish task runs the cleanup before its
+// next status cycle.
+static std::atomic<bool> legacy_cleanup_pending{false};
+// In state-document mode (mqtt_config_t::state_document) a status cycle
+// collects its values here instead of publishing one topic each; set only
+// while status_cache_mutex is held. Static so the ~1.2 KiB document does
+// not live on the publisher stack.
+static JsonWriter *status_document = NULL;
+static char status_document_buffer[1536];
+
+// Home Assistant discovery, see mqtt_handler_publish_ha_discovery(). Runs in
+// the publish task, which owns the cache; the MQTT event task only raises
+// the flags. discovery_reset asks for a full republish (HA birth message),
+// discovery_restart for a new pass over every entity (new session).
+static MqttDiscoveryCache discovery_cache;
+static bool discovery_cache_loaded = false;
+static std::atomic<bool> discovery_pending{false};
+static std::atomic<bool> discovery_reset{false};
+static std::atomic<bool> discovery_restart{false};
+// Entity a paced pass resumes at; 0 starts a new pass. Publish task only,
+// like the scratch below, which stays off its 5 KB stack.
+static uint32_t discovery_cursor = 0;
+static char discovery_payload[768];
+static char discovery_topic[256];
+static char discovery_unique_id[128];
+static char discovery_template[96];
+
+static MetricsCounter g_discovery_publishes("hbrfeth_mqtt_discovery_publishes_total",
+                                            "Home Assistant discovery configs published");
+static MetricsCounter g_discovery_unchanged(
+    "hbrfeth_mqtt_discovery_unchanged_total",
+    "Home Assistant discovery configs not republished because the broker holds them");
+
+// Publish admission, see mqtt_publish_paced(). mqtt_in_flight counts QoS 1
+// messages handed to ESP-MQTT and not yet acknowledged.
+static MqttPacer publish_pacer;
+static portMUX_TYPE publish_pacer_mux = portMUX_INITIALIZER_UNLOCKED;
+static std::atomic<uint32_t> mqtt_in_flight{0};
+
+static MetricsHighWater g_outbox_bytes_max("hbrfeth_mqtt_outbox_bytes_max",
+                                           "Largest ESP-MQTT outbox seen before a publish, bytes");
+static MetricsCounter g_publishes_deferred("hbrfeth_mqtt_publishes_deferred_total",
+                                           "MQTT publishes postponed by the pacer");
+
+static MetricsCounter g_status_publishes("hbrfeth_mqtt_status_publishes_total",
+                                         "Retained MQTT status values published");
+static MetricsCounter g_status_publishes_avoided(
+    "hbrfeth_mqtt_status_publishes_avoided_total",
+    "MQTT status publishes skipped because the broker already holds the value");
+
+// Retained status topics under <prefix>/status/. The enum value is the
+// topic's id in status_cache.
+enum StatusTopic : uint8_t {
+    STATUS_ONLINE,
+    STATUS_SERIAL,
+    STATUS_FIRMWARE_VERSION,
+    STATUS_WEBUI_VERSION,
+    STATUS_BOARD_REVISION,
+    STATUS_CPU_USAGE,
+    STATUS_MEMORY_USAGE,
+    STATUS_UPTIME,
+    STATUS_UPTIME_TEXT,
+    STATUS_FREE_HEAP,
+    STATUS_MIN_FREE_HEAP,
+    STATUS_CCU_QUEUE_WAIT_MAX_MS,
+    STATUS_CCU_QUEUE_DEPTH_MAX,
+    STATUS_CCU_DELAYED_FRAMES,
+    STATUS_CCU_DROPPED_FRAMES,
+    STATUS_RF_FRAMES_PER_MIN,
+    STATUS_RF_FRAMES_PER_HOUR,
+    STATUS_RF_AIRTIME_PERCENT,
+    STATUS_RF_DUTY_CYCLE,
+    STATUS_NVS_USED_ENTRIES,
+    STATUS_NVS_FREE_ENTRIES,
+    STATUS_NVS_USAGE,
+    STATUS_LAST_RESET_REASON,
+    STATUS_ETH_CONNECTED,
+    STATUS_ETH_LINK_SPEED,
+    STATUS_ETH_DUPLEX,
+    STATUS_IP_ADDRESS,
+    STATUS_NETMASK,
+    STATUS_GATEWAY,
+    STATUS_DNS1,
+    STATUS_DNS2,
+    STATUS_IPV6_ADDRESSES,
+    STATUS_RADIO_MODULE_TYPE,
+    STATUS_RADIO_MODULE_SERIAL,
+    STATUS_RADIO_MODULE_FIRMWARE,
+    STATUS_NTP_SYNCED,
+    STATUS_LAST_NTP_SYNC,
+    STATUS_TASK_STACKS,
+    STATUS_TOPIC_COUNT
+};
+
+// The other topics below <prefix>/. Their ids continue after the status
+// topics: both index MQTT_SUBTOPICS and mqtt_topics.
+enum OtherTopic : uint8_t {
+    TOPIC_STATE = STATUS_TOPIC_COUNT,
+    TOPIC_EVENT_RESTART,
+    TOPIC_EVENT_COMMAND_REJECTED,
+    TOPIC_COMMAND_FILTER,
+    TOPIC_COMMAND_PREFIX,
+    TOPIC_COMMAND_RESTART,
+    TOPIC_COUNT
+};
+
+static const char *const MQTT_SUBTOPICS[] = {
+    "status/online",
+    "status/serial",
+    "status/firmware_version",
+    "status/webui_version",
+    "status/board_revision",
+    "status/cpu_usage",
+    "status/memory_usage",
+    "status/uptime",
+    "status/uptime_text",
+    "status/free_heap",
+    "status/min_free_heap",
+    "status/ccu_queue_wait_max_ms",
+    "status/ccu_queue_depth_max",
+    "status/ccu_delayed_frames",
+    "status/ccu_dropped_frames",
+    "status/rf_frames_per_min",
+    "status/rf_frames_per_hour",
+    "status/rf_airtime_percent",
+    "status/rf_duty_cycle",
+    "status/nvs_used_entries",
+    "status/nvs_free_entries",
+    "status/nvs_usage",
+    "status/last_reset_reason",
+    "status/eth_connected",
+    "status/eth_link_speed",
+    "status/eth_duplex",
+    "status/ip_address",
+    "status/netmask",
+    "status/gateway",
+    "status/dns1",
+    "status/dns2",
+    "status/ipv6_addresses",
+    "status/radio_module_type",
+    "status/radio_module_serial",
+    "status/radio_module_firmware",
+    "status/ntp_synced",
+    "status/last_ntp_sync",
+    "status/task_stacks",
+    "state",
+    "event/restart",
+    "event/command_rejected",
+    "command/#",
+    "command/",
+    "command/restart",
+};
+static_assert(sizeof(MQTT_SUBTOPICS) / sizeof(MQTT_SUBTOPICS[0]) == TOPIC_COUNT,
+              "every topic needs a subtopic");
+static_assert(TOPIC_COUNT <= MqttTopicTable::MAX_TOPICS, "topic table too small");
+static_assert(STATUS_TOPIC_COUNT <= MqttValueCache::SLOTS, "status cache too small");
+static_assert(TOPIC_COUNT <= MqttTopicAliases::MAX_TOPICS, "topic ids exceed the alias table");
+
+// MQTT 5 sessions (mqtt_config_t::protocol_v5). ESP-MQTT keeps the publish
+// properties as client state until the next publish, so setting them and
+// publishing is one step under mqtt5_publish_mutex, which also guards the
+// alias table. The holder waits for ESP-MQTT's API lock, which the MQTT task
+// holds while it runs mqtt_event_handler(): that task never waits for the
+// mutex, and a session change only ends the alias table's session.
+static MqttTopicAliases mqtt5_aliases;
+static SemaphoreHandle_t mqtt5_publish_mutex = NULL;
+static StaticSemaphore_t mqtt5_publish_mutex_buffer;
+// The task running mqtt_event_handler(), recorded on every event.
+static std::atomic<TaskHandle_t> mqtt_event_task_handle{NULL};
+// Events are news for a few minutes, not for whoever connects next morning.
+static constexpr uint32_t MQTT5_EVENT_EXPIRY_S = 300;
+
+// "unit" user property of a status value. One property list per unit, built
+// on the first MQTT 5 start and kept: ESP-MQTT only references it.
+enum StatusUnit : uint8_t {
+    UNIT_NONE,
+    UNIT_PERCENT,
+    UNIT_SECONDS,
+    UNIT_BYTES,
+    UNIT_MILLISECONDS,
+    UNIT_MBITS,
+    UNIT_COUNT
+};
+static const char *const STATUS_UNITS[UNIT_COUNT] = {NULL, "%", "s", "B", "ms", "Mbit/s"};
+static mqtt5_user_property_handle_t mqtt5_unit_properties[UNIT_COUNT];
+
+// MQTT 5 extras of one publish; 3.1.1 sessions ignore them.
+struct MqttPublishOptions {
+    int topic_id;         // mqtt_topics id, for a topic alias; -1 for none
+    uint32_t expiry_s;    // message expiry interval; 0 for none
+    StatusUnit unit;
+};
+
+// Every topic above as "<prefix>/<subtopic>", built by mqtt_handler_start()
+// before the client exists, so lookups never race a rebuild. The online
+// topic doubles as the LWT topic for the client's lifetime.
+static MqttTopicTable mqtt_topics;
+
+// Topics below the Home Assistant discovery prefix.
+enum HaTopic : uint8_t {
+    HA_TOPIC_STATUS,    // HA's birth/LWT topic: "online" after every HA start
+    HA_TOPIC_COUNT
+};
+static const char *const HA_SUBTOPICS[] = {"status"};
+static_assert(sizeof(HA_SUBTOPICS) / sizeof(HA_SUBTOPICS[0]) == HA_TOPIC_COUNT,
+              "every topic needs a subtopic");
+static MqttTopicTable ha_topics;
+
 // ESP-MQTT waits for half the configured reconnect interval while it is in
 // MQTT_STATE_WAIT_RECONNECT. esp_mqtt_client_stop() does not wake that wait, so
 // the public cleanup deadline must include those 15 seconds plus transport,
@@ -85,6 +307,25 @@ static constexpr int MQTT_RESTART_RETRY_DELAY_MS = 10000;
 static constexpr int MQTT_PUBLISH_DRAIN_TIMEOUT_MS = 5000;
 static constexpr int MQTT_TLS_GATE_WAIT_SLICE_MS = 1000;
 static constexpr int MQTT_TLS_GATE_MAX_WAIT_MS = 10 * 60 * 1000;
+// Discovery configs are QoS 1 and stay in the ESP-MQTT outbox until the
+// broker acknowledges them; a few per step keep that to a few KiB on a
+// fresh (TLS) connection instead of ~40 configs at once.
+static constexpr uint32_t DISCOVERY_BURST = 4;
+static constexpr int DISCOVERY_STEP_MS = 500;
+
+// Publish pacing: ~20 messages/s with bursts of 16 keep a full status
+// cycle under two seconds. The outbox limits are a few discovery configs
+// (soft) and what the WROOM-32 can hold without starving TLS (hard).
+static constexpr MqttPacer::Limits PUBLISH_PACER_LIMITS = {
+    20,             // rate_per_s
+    16,             // burst
+    4 * 1024,       // soft_bytes
+    16 * 1024,      // hard_bytes
+    8,              // soft_in_flight
+    32,             // hard_in_flight
+};
+// Longest single sleep for a token; the bucket refills one per 50 ms.
+static constexpr uint32_t PUBLISH_PACER_MAX_WAIT_MS = 100;
 
 static_assert(std::atomic<uint32_t>::is_always_lock_free,
               "MQTT publisher lifetime guard must be native 32-bit");
@@ -129,8 +370,89 @@ static bool mqtt_can_publish()
            mqtt_connected.load(std::memory_order_acquire);
 }
 
+static bool mqtt_event_task_is_current()
+{
+    return xTaskGetCurrentTaskHandle() ==
+           mqtt_event_task_handle.load(std::memory_order_relaxed);
+}
+
+// Applies the MQTT 5 properties of one publish and picks the topic to send:
+// the full topic, or "" once the broker knows the topic's alias. Does
+// nothing on 3.1.1 sessions. False when the publish must not go out now:
+// the MQTT event task found another task's properties pending.
+class Mqtt5Publish {
+public:
+    Mqtt5Publish(esp_mqtt_client_handle_t publish_client, const char *topic,
+                 const MqttPublishOptions *options)
+        : topic_(topic), full_topic_(topic)
+    {
+        if (!current_mqtt_config.protocol_v5 || mqtt5_publish_mutex == NULL) return;
+        // Any other holder waits for the API lock the event task holds, so
+        // the event task only takes a free mutex. Publishing without it
+        // would send the holder's properties with this topic.
+        const TickType_t wait = mqtt_event_task_is_current() ? 0 : portMAX_DELAY;
+        locked_ = xSemaphoreTake(mqtt5_publish_mutex, wait) == pdTRUE;
+        ready_ = locked_;
+        if (!locked_) return;
+        if (options != NULL) {
+            property_.message_expiry_interval = options->expiry_s;
+            property_.user_property = mqtt5_unit_properties[options->unit];
+            if (options->topic_id >= 0) {
+                bool bind = false;
+                property_.topic_alias = mqtt5_aliases.assign((uint16_t)options->topic_id, &bind);
+                if (property_.topic_alias != 0 && !bind) topic_ = "";
+            }
+        }
+        // Set for every publish, even an empty one: ESP-MQTT would otherwise
+        // send the previous publish's properties again.
+        if (esp_mqtt5_client_set_publish_property(publish_client, &property_) != ESP_OK &&
+            property_.topic_alias != 0) {
+            // Above the broker's Topic Alias Maximum. Aliases are handed out
+            // from 1 upwards, so every lower one is fine.
+            ESP_LOGI(TAG, "Broker refused topic alias %u; using fewer",
+                     (unsigned)property_.topic_alias);
+            mqtt5_aliases.limit(property_.topic_alias - 1);
+            property_.topic_alias = 0;
+            topic_ = topic;
+            (void)esp_mqtt5_client_set_publish_property(publish_client, &property_);
+        }
+    }
+
+    ~Mqtt5Publish()
+    {
+        if (locked_) xSemaphoreGive(mqtt5_publish_mutex);
+    }
+
+    Mqtt5Publish(const Mqtt5Publish &) = delete;
+    Mqtt5Publish &operator=(const Mqtt5Publish &) = delete;
+
+    explicit operator bool() const { return ready_; }
+
+    // Read right before esp_mqtt_client_publish: the waits for the API lock
+    // since assign() may span a reconnect, and the new session does not
+    // know an alias picked in the old one. The full topic binds it again.
+    const char *topic() const
+    {
+        return *topic_ == '\0' && !mqtt5_aliases.sameSession() ? full_topic_ : topic_;
+    }
+
+    // A binding the broker never saw must be sent again.
+    void published(int result)
+    {
+        if (result < 0 && property_.topic_alias != 0) mqtt5_aliases.drop(property_.topic_alias);
+    }
+
+private:
+    const char *topic_;
+    const char *full_topic_;
+    esp_mqtt5_publish_property_config_t property_ = {};
+    bool locked_ = false;
+    bool ready_ = true;
+};
+
 static int mqtt_publish_connected(const char *topic, const char *data,
-                                  int len, int qos, int retain)
+                                  int len, int qos, int retain,
+                                  const MqttPublishOptions *options = NULL)
 {
     if (topic == NULL || data == NULL) {
         return -1;
@@ -146,19 +468,130 @@ static int mqtt_publish_connected(const char *topic, const char *data,
         mqtt_connected.load(std::memory_order_acquire)) {
         esp_mqtt_client_handle_t publish_client = client;
         if (publish_client != NULL) {
-            result = esp_mqtt_client_publish(
-                publish_client, topic, data, len, qos, retain);
+            Mqtt5Publish v5(publish_client, topic, options);
+            if (v5) {
+                result = esp_mqtt_client_publish(
+                    publish_client, v5.topic(), data, len, qos, retain);
+                v5.published(result);
+            }
         }
     }
     mqtt_active_publishers.fetch_sub(1, std::memory_order_seq_cst);
+    if (result > 0 && qos > 0) {
+        mqtt_in_flight.fetch_add(1, std::memory_order_relaxed);
+    }
     return result;
 }
 
+// Bytes ESP-MQTT holds for retransmission, under the same lease as
+// mqtt_publish_connected().
+static size_t mqtt_outbox_bytes()
+{
+    mqtt_active_publishers.fetch_add(1, std::memory_order_seq_cst);
+    int bytes = 0;
+    if (mqtt_running.load(std::memory_order_seq_cst)) {
+        esp_mqtt_client_handle_t publish_client = client;
+        if (publish_client != NULL) {
+            bytes = esp_mqtt_client_get_outbox_size(publish_client);
+        }
+    }
+    mqtt_active_publishers.fetch_sub(1, std::memory_order_seq_cst);
+    return bytes > 0 ? (size_t)bytes : 0;
+}
+
+static void mqtt_publish_acknowledged()
+{
+    uint32_t in_flight = mqtt_in_flight.load(std::memory_order_relaxed);
+    while (in_flight > 0 &&
+           !mqtt_in_flight.compare_exchange_weak(in_flight, in_flight - 1,
+                                                 std::memory_order_relaxed)) {
+    }
+}
+
+static bool mqtt_publish_task_is_current()
+{
+    return xTaskGetCurrentTaskHandle() ==
+           mqtt_publish_task_handle.load(std::memory_order_acquire);
+}
+
+// mqtt_publish_connected() behind the pacer. Only the publish task sleeps
+// for a token; any other caller (the MQTT event task) must not stall the
+// client, so there a missing token defers like outbox pressure does.
+// Returns -1 for a deferred publish: callers keep it for their next cycle.
+static int mqtt_publish_paced(MqttPacer::Priority priority, const char *topic,
+                              const char *data, int len, int qos, int retain,
+                              const MqttPublishOptions *options = NULL)
+{
+    const bool may_wait = mqtt_publish_task_is_current();
+    for (;;) {
+        const size_t outbox = mqtt_outbox_bytes();
+        g_outbox_bytes_max.record((uint32_t)outbox);
+        // An empty outbox holds nothing unacknowledged, whatever the count
+        // says after a reconnect dropped the session.
+        if (outbox == 0) mqtt_in_flight.store(0, std::memory_order_relaxed);
+
+        uint32_t wait_ms = 0;
+        portENTER_CRITICAL(&publish_pacer_mux);
+        const MqttPacer::Decision decision = publish_pacer.decide(
+            priority, (uint32_t)(esp_timer_get_time() / 1000), outbox,
+            mqtt_in_flight.load(std::memory_order_relaxed), &wait_ms);
+        portEXIT_CRITICAL(&publish_pacer_mux);
+
+        if (decision == MqttPacer::ADMIT) {
+            return mqtt_publish_connected(topic, data, len, qos, retain, options);
+        }
+        if (decision == MqttPacer::DEFER || !may_wait || !mqtt_can_publish()) {
+            g_publishes_deferred.inc();
+            return -1;
+        }
+        if (wait_ms > PUBLISH_PACER_MAX_WAIT_MS) wait_ms = PUBLISH_PACER_MAX_WAIT_MS;
+        vTaskDelay(pdMS_TO_TICKS(wait_ms) > 0 ? pdMS_TO_TICKS(wait_ms) : 1);
+    }
+}
+
 // Serializes mqtt_handler_start / mqtt_handler_stop so configuration updates
 // cannot race with the publish task or a concurrent (re)start.
 static SemaphoreHandle_t mqtt_lifecycle_mutex = NULL;
 static StaticSemaphore_t mqtt_lifecycle_mutex_buffer;
 
+// Events the MQTT event task could not publish without waiting (Mqtt5Publish,
+// mqtt_publish_paced). The publish task sends them.
+struct MqttDeferredEvent {
+    char subtopic[32];
+    char payload[96];
+};
+static constexpr UBaseType_t MQTT_DEFERRED_EVENTS = 4;
+static QueueHandle_t mqtt_deferred_events = NULL;
+static StaticQueue_t mqtt_deferred_events_buffer;
+static uint8_t mqtt_deferred_events_storage[MQTT_DEFERRED_EVENTS * sizeof(MqttDeferredEvent)];
+
+// Wakes the publish task from the MQTT event task, which must not wait for
+// mqtt_lifecycle_mutex: a stop holds it while it waits for that task. The
+// publish task still picks the work up within one 5 s wait slice.
+static void mqtt_wake_publish_task_nowait()
+{
+    if (mqtt_lifecycle_mutex == NULL ||
+        xSemaphoreTake(mqtt_lifecycle_mutex, 0) != pdTRUE) {
+        return;
+    }
+    TaskHandle_t task = mqtt_publish_task_handle.load(std::memory_order_acquire);
+    if (task) xTaskNotifyGive(task);
+    xSemaphoreGive(mqtt_lifecycle_mutex);
+}
+
+static void mqtt_defer_event(const char *subtopic, const char *payload)
+{
+    MqttDeferredEvent deferred;
+    snprintf(deferred.subtopic, sizeof(deferred.subtopic), "%s", subtopic);
+    snprintf(deferred.payload, sizeof(deferred.payload), "%s", payload);
+    if (mqtt_deferred_events == NULL ||
+        xQueueSend(mqtt_deferred_events, &deferred, 0) != pdTRUE) {
+        ESP_LOGW(TAG, "Dropping MQTT event %s: deferred queue full", subtopic);
+        return;
+    }
+    mqtt_wake_publish_task_nowait();
+}
+
 // Latch set by mqtt_handler_trigger_status_publish() so the periodic task
 // emits an immediate cycle out-of-band after an explicit status change.
 
@@ -170,6 +603,7 @@ extern SystemClock* monitoring_get_systemclock(void);
 
 void mqtt_handler_publish_ha_discovery(void);
 static void publish_legacy_topic_cleanup(void);
+static void mqtt_publish_deferred_events(void);
 
 static void log_error_if_nonzero(const char *message, int error_code)
 {
@@ -303,6 +737,7 @@ static void mqtt_take_tls_gate_if_needed()
     }
     mqtt_tls_gate_held.store(true, std::memory_order_release);
     crash_blackbox_net_op_begin("mqtt_tls");
+    events_close_idle_connections();
 }
 
 static void mqtt_release_tls_gate_if_held()
@@ -342,13 +777,33 @@ static void mqtt_stop_watchdog_callback(TimerHandle_t)
     esp_restart();
 }
 
+// Topic aliases live for one network connection (MQTT 5, 3.2.2.3.8). Runs
+// in the event task on every session change, so the next Mqtt5Publish
+// resets the table under the mutex and one already picked sends its topic.
+static void mqtt5_session_end()
+{
+    mqtt5_aliases.endSession();
+}
+
+static void mqtt5_build_unit_properties()
+{
+    for (size_t unit = UNIT_NONE + 1; unit < UNIT_COUNT; unit++) {
+        if (mqtt5_unit_properties[unit] != NULL) continue;
+        esp_mqtt5_user_property_item_t item = {"unit", STATUS_UNITS[unit]};
+        // Without the list the unit is just not sent.
+        (void)esp_mqtt5_client_set_user_property(&mqtt5_unit_properties[unit], &item, 1);
+    }
+}
+
 static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_t event_id, void *event_data)
 {
     ESP_LOGD(TAG, "Event dispatched from event loop base=%s, event_id=%" PRIi32, base, event_id);
     esp_mqtt_event_handle_t event = (esp_mqtt_event_handle_t)event_data;
+    mqtt_event_task_handle.store(xTaskGetCurrentTaskHandle(), std::memory_order_relaxed);
 
     switch ((esp_mqtt_event_id_t)event_id) {
     case MQTT_EVENT_BEFORE_CONNECT:
+        mqtt5_session_end();
         mqtt_take_tls_gate_if_needed();
         break;
     case MQTT_EVENT_CONNECTED:
@@ -359,6 +814,10 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             break;
         }
         ESP_LOGI(TAG, "MQTT_EVENT_CONNECTED");
+        // A new session may be a different broker, or one that lost its
+        // retained store: publish every status value once.
+        status_cache_stale.store(true, std::memory_order_release);
+        mqtt5_session_end();
         mqtt_connected.store(true, std::memory_order_release);
         // Close the event-vs-stop interleaving where cleanup clears the flag
         // between the running check above and this store.
@@ -377,36 +836,63 @@ static void mqtt_event_handler(void *handler_args, esp_event_base_t base, int32_
             // Subscribe to command topic whenever commands OR HA discovery
             // are enabled. Previously this was gated on ha_discovery only,
             // which blocked plain-MQTT users from triggering restart.
-            char command_topic[128];
-            snprintf(command_topic, sizeof(command_topic), "%s/command/#", current_mqtt_config.topic_prefix);
+            const char *command_topic = mqtt_topics.topic(TOPIC_COMMAND_FILTER);
             esp_mqtt_client_subscribe(event->client, command_topic, 1);
             ESP_LOGI(TAG, "Subscribed to command topic: %s", command_topic);
         }
-        // Clear legacy retained status/* topics the firmware no longer
-        // publishes to. Must happen BEFORE the first publish_status so
-        // subscribers don't briefly see a stale -127 temperature again
-        // after we've just announced we're online.
-        publish_legacy_topic_cleanup();
-        // Publish initial status (includes online marker)
-        mqtt_handler_publish_status();
-        // Publish HA discovery config if enabled
         if (current_mqtt_config.ha_discovery_enabled) {
-            mqtt_handler_publish_ha_discovery();
+            esp_mqtt_client_subscribe(event->client, ha_topics.topic(HA_TOPIC_STATUS), 1);
+        }
+        // Only the online marker goes out from here. The status cycle
+        // waits for status_cache_mutex and the pacer, which must not stall
+        // the client, so the publish task runs it next, after clearing the
+        // legacy retained status/* topics the firmware no longer publishes.
+        {
+            const MqttPublishOptions options = {STATUS_ONLINE, 0, UNIT_NONE};
+            (void)mqtt_publish_connected(mqtt_topics.topic(STATUS_ONLINE), "online", 0, 0, 1,
+                                         &options);
+        }
+        legacy_cleanup_pending.store(true, std::memory_order_release);
+        mqtt_publish_request.store(true, std::memory_order_release);
+        mqtt_wake_publish_task_nowait();
+        // HA discovery runs paced in the publish task, not in this event
+        // handler: only the configs the broker does not hold are sent. The
+        // task picks the flag up within one 5 s wait slice.
+        if (current_mqtt_config.ha_discovery_enabled) {
+            discovery_restart.store(true, std::memory_order_release);
+            discovery_pending.store(true, std::memory_order_release);
         }
         break;
     case MQTT_EVENT_DISCONNECTED:
         mqtt_release_tls_gate_if_held();
         ESP_LOGI(TAG, "MQTT_EVENT_DISCONNECTED");
+        mqtt5_session_end();
         mqtt_connected.store(false);
         events_emit(EVENT_MQTT_DISCONNECTED, nullptr);
         break;
+    case MQTT_EVENT_PUBLISHED:
+    case MQTT_EVENT_DELETED:
+        // Acknowledged, or expired from the outbox unacknowledged.
+        mqtt_publish_acknowledged();
+        break;
     case MQTT_EVENT_DATA:
         ESP_LOGI(TAG, "MQTT_EVENT_DATA");
+        // Home Assistant (re)started and forgot its entities: republish all
+        // discovery configs. A retained birth message is an old one, not a
+        // fresh start.
+        if (current_mqtt_config.ha_discovery_enabled && !event->retain &&
+            (size_t)event->topic_len == ha_topics.length(HA_TOPIC_STATUS) &&
+            strncmp(event->topic, ha_topics.topic(HA_TOPIC_STATUS), event->topic_len) == 0) {
+            if (event->data_len == 6 && strncmp(event->data, "online", 6) == 0) {
+                discovery_reset.store(true, std::memory_order_release);
+                discovery_pending.store(true, std::memory_order_release);
+            }
+            break;
+        }
         if (current_mqtt_config.command_enabled) {
             // Note: event->topic is NOT null-terminated per ESP-IDF MQTT API.
-            char command_topic_prefix[128];
-            snprintf(command_topic_prefix, sizeof(command_topic_prefix), "%s/command/", current_mqtt_config.topic_prefix);
-            size_t prefix_len = strlen(command_topic_prefix);
+            const char *command_topic_prefix = mqtt_topics.topic(TOPIC_COMMAND_PREFIX);
+            size_t prefix_len = mqtt_topics.length(TOPIC_COMMAND_PREFIX);
 
             if ((size_t)event->topic_len > prefix_len &&
                 strncmp(event->topic, command_topic_prefix, prefix_len) == 0) {
@@ -442,7 +928,7 @@ void mqtt_publish_task(void *pvParameters)
         // esp_mqtt_client_start() returns before the asynchronous broker login
         // completes. During startup or reconnect, wait without formatting or
         // submitting a complete status batch. MQTT_EVENT_CONNECTED publishes
-        // the initial retained status and HA discovery immediately.
+        // the online marker and wakes this task for the full status.
         if (!mqtt_can_publish()) {
             (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(250));
             continue;
@@ -453,6 +939,14 @@ void mqtt_publish_task(void *pvParameters)
                      (unsigned)uxTaskGetStackHighWaterMark(NULL));
         }
         publish_cycle++;
+        // Clear legacy retained topics BEFORE the first status cycle of a
+        // session so subscribers don't briefly see a stale -127 temperature
+        // next to fresh values.
+        if (legacy_cleanup_pending.exchange(false, std::memory_order_acq_rel)) {
+            publish_legacy_topic_cleanup();
+        }
+        // This cycle answers any request made before it.
+        mqtt_publish_request.store(false, std::memory_order_release);
         mqtt_handler_publish_status();
 
         // Task-stack diagnostics move slowly; publishing every cycle
@@ -463,21 +957,35 @@ void mqtt_publish_task(void *pvParameters)
             mqtt_handler_publish_task_stacks();
         }
 
-        // 60 s base cadence (was 10 s): each cycle publishes ~30 retained
-        // status topics, so at 10 s that was ~11 000 esp_mqtt_client_publish
-        // calls per hour — each doing small internal mallocs that slowly
-        // fragment the WROOM-32 heap over hours/days, the prime suspect for
-        // the long-uptime Interrupt-Watchdog crashes (issue #362). Raising the
-        // cadence to 60 s cuts that churn to ~1 800/h (−84 %) without losing
-        // useful monitoring resolution — the values barely change within a
-        // minute. The 12-step subdivision keeps trigger_publish response at
-        // ~5 s so explicitly requested status changes still publish promptly.
-        for (int i = 0; i < 12 && mqtt_running.load(); i++) {
+        // 60 s base cadence (was 10 s): each cycle used to publish ~30
+        // retained status topics, so at 10 s that was ~11 000
+        // esp_mqtt_client_publish calls per hour — each doing small internal
+        // mallocs that slowly fragment the WROOM-32 heap over hours/days, the
+        // prime suspect for the long-uptime Interrupt-Watchdog crashes (issue
+        // #362). Raising the cadence to 60 s cut that churn to ~1 800/h; the
+        // last-value cache now also skips every topic that did not change,
+        // leaving a handful of publishes per cycle. The 12-step subdivision
+        // keeps trigger_publish response at ~5 s so explicitly requested
+        // status changes still publish promptly.
+        //
+        // Pending HA discovery is sent between the slices, DISCOVERY_BURST
+        // configs per DISCOVERY_STEP_MS, without counting against them;
+        // deferred command events go out on every wakeup.
+        for (int i = 0; i < 12 && mqtt_running.load();) {
+            if (mqtt_can_publish()) {
+                mqtt_publish_deferred_events();
+            }
             if (mqtt_publish_request.exchange(false)) {
                 break;  // run a fresh publish cycle immediately
             }
+            if (mqtt_can_publish() && discovery_pending.exchange(false)) {
+                mqtt_handler_publish_ha_discovery();
+                (void)ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(DISCOVERY_STEP_MS));
+                continue;
+            }
             (void)ulTaskNotifyTake(pdTRUE,
                                    pdMS_TO_TICKS(60000 / 12));
+            i++;
         }
     }
     // Coordinate handle retirement with every notifier. Without the mutex a
@@ -519,12 +1027,195 @@ void mqtt_handler_publish_event(const char *subtopic, const char *payload)
     if (!operation) {
         return;
     }
-    char topic[160];
-    snprintf(topic, sizeof(topic), "%s/%s", current_mqtt_config.topic_prefix, subtopic);
     // Non-retained, QoS 0: events are transient by definition.
-    mqtt_publish_connected(topic, payload, 0, 0, 0);
+    MqttPublishOptions options = {-1, MQTT5_EVENT_EXPIRY_S, UNIT_NONE};
+    const char *topic = NULL;
+    for (size_t id = TOPIC_EVENT_RESTART; id <= TOPIC_EVENT_COMMAND_REJECTED; id++) {
+        if (strcmp(subtopic, MQTT_SUBTOPICS[id]) == 0) {
+            options.topic_id = (int)id;
+            topic = mqtt_topics.topic(id);
+            break;
+        }
+    }
+    char custom_topic[160];
+    if (topic == NULL) {
+        snprintf(custom_topic, sizeof(custom_topic), "%s/%s",
+                 current_mqtt_config.topic_prefix, subtopic);
+        topic = custom_topic;
+    }
+    // Command replies come from the event task, which neither waits for a
+    // pacer token nor for mqtt5_publish_mutex.
+    if (mqtt_publish_paced(MqttPacer::HIGH, topic, payload, 0, 0, 0, &options) < 0 &&
+        mqtt_event_task_is_current()) {
+        mqtt_defer_event(subtopic, payload);
+    }
+}
+
+static void mqtt_publish_deferred_events(void)
+{
+    MqttDeferredEvent deferred;
+    while (mqtt_deferred_events != NULL &&
+           xQueueReceive(mqtt_deferred_events, &deferred, 0) == pdTRUE) {
+        mqtt_handler_publish_event(deferred.subtopic, deferred.payload);
+    }
+}
+
+// Changes smaller than this are noise, not news: a sensor graph in Home
+// Assistant does not get more useful from a publish per 0.3 % CPU or per
+// few hundred bytes of heap. The refresh interval still republishes them.
+static double status_deadband(StatusTopic id)
+{
+    switch (id) {
+        case STATUS_CPU_USAGE:    return 2.0;     // percent
+        case STATUS_MEMORY_USAGE: return 0.5;     // percent
+        case STATUS_FREE_HEAP:    return 4096;    // bytes
+        default:                  return 0;
+    }
+}
+
+// Diagnostics nobody watches live wait for a later cycle when the broker
+// link is congested; the online marker never waits.
+static MqttPacer::Priority status_priority(StatusTopic id)
+{
+    switch (id) {
+        case STATUS_ONLINE:           return MqttPacer::HIGH;
+        case STATUS_TASK_STACKS:
+        case STATUS_NVS_USED_ENTRIES:
+        case STATUS_NVS_FREE_ENTRIES:
+        case STATUS_NVS_USAGE:        return MqttPacer::LOW;
+        default:                      return MqttPacer::NORMAL;
+    }
+}
+
+static StatusUnit status_unit(StatusTopic id)
+{
+    switch (id) {
+        case STATUS_CPU_USAGE:
+        case STATUS_MEMORY_USAGE:
+        case STATUS_NVS_USAGE:
+        case STATUS_RF_AIRTIME_PERCENT:
+        case STATUS_RF_DUTY_CYCLE:         return UNIT_PERCENT;
+        case STATUS_UPTIME:                return UNIT_SECONDS;
+        case STATUS_FREE_HEAP:
+        case STATUS_MIN_FREE_HEAP:         return UNIT_BYTES;
+        case STATUS_CCU_QUEUE_WAIT_MAX_MS: return UNIT_MILLISECONDS;
+        case STATUS_ETH_LINK_SPEED:        return UNIT_MBITS;
+        default:                           return UNIT_NONE;
+    }
+}
+
+static uint32_t status_now_s()
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// The document key of a status topic: its name below status/.
+static const char *status_key(StatusTopic id)
+{
+    return MQTT_SUBTOPICS[id] + sizeof("status/") - 1;
+}
+
+// The status topic whose document key is key, or -1.
+static int status_topic_id(const char *key)
+{
+    for (size_t id = 0; id < STATUS_TOPIC_COUNT; id++) {
+        if (strcmp(status_key((StatusTopic)id), key) == 0) return (int)id;
+    }
+    return -1;
+}
+
+// Publish one retained status value unless the broker already holds it.
+// numeric: value is the number payload was rendered from, compared against
+// the topic's deadband.
+//
+// In state-document mode the value goes into the document instead. The
+// online marker keeps its own topic in both modes: it is the LWT topic, and
+// the broker can only replace a whole payload.
+static void publish_status_value(StatusTopic id, const char *payload, bool numeric = false,
+                                 double value = 0)
+{
+    if (status_document != NULL && id != STATUS_ONLINE && id != STATUS_TASK_STACKS) {
+        if (numeric) status_document->number(status_key(id), payload);
+        else status_document->string(status_key(id), payload);
+        return;
+    }
+    const size_t len = strlen(payload);
+    const uint32_t now_s = status_now_s();
+    const bool wanted =
+        numeric ? status_cache.wantsNumber(id, value, status_deadband(id), payload, len, now_s)
+                : status_cache.wants(id, payload, len, now_s);
+    if (!wanted) {
+        g_status_publishes_avoided.inc();
+        return;
+    }
+    // A deferred value is not recorded, so the next cycle offers it again.
+    const MqttPublishOptions options = {(int)id, 0, status_unit(id)};
+    if (mqtt_publish_paced(status_priority(id), mqtt_topics.topic(id), payload, 0, 0, 1,
+                           &options) >= 0) {
+        status_cache.published(id, payload, len, now_s, value);
+        g_status_publishes.inc();
+    } else if (!mqtt_publish_task_is_current()) {
+        mqtt_publish_request.store(true, std::memory_order_release);
+    }
 }
 
+static void publish_status_flag(StatusTopic id, bool value)
+{
+    if (status_document != NULL) {
+        status_document->boolean(status_key(id), value);
+        return;
+    }
+    publish_status_value(id, value ? "true" : "false");
+}
+
+// One retained <prefix>/state publish per cycle: every value of the cycle
+// in one payload, and one outbox allocation instead of ~30.
+static void publish_state_document(const JsonWriter &document)
+{
+    if (!document.ok()) {
+        ESP_LOGW(TAG, "Status document exceeds %u bytes; not published",
+                 (unsigned)sizeof(status_document_buffer));
+        return;
+    }
+    const MqttPublishOptions options = {TOPIC_STATE, 0, UNIT_NONE};
+    if (mqtt_publish_paced(MqttPacer::NORMAL, mqtt_topics.topic(TOPIC_STATE), document.c_str(),
+                           (int)document.length(), 0, 1, &options) >= 0) {
+        g_status_publishes.inc();
+    } else if (!mqtt_publish_task_is_current()) {
+        mqtt_publish_request.store(true, std::memory_order_release);
+    }
+}
+
+// Holds status_cache_mutex for one status publish; applies a pending
+// invalidation and the configured refresh interval on entry.
+class StatusCacheLock {
+public:
+    StatusCacheLock()
+    {
+        locked_ = status_cache_mutex != NULL &&
+                  xSemaphoreTake(status_cache_mutex, pdMS_TO_TICKS(5000)) == pdTRUE;
+        if (!locked_) return;
+        status_cache.setRefreshInterval(
+            (uint32_t)current_mqtt_config.status_refresh_minutes * 60);
+        if (status_cache_stale.exchange(false, std::memory_order_acq_rel)) {
+            status_cache.invalidate();
+        }
+    }
+
+    ~StatusCacheLock()
+    {
+        if (locked_) xSemaphoreGive(status_cache_mutex);
+    }
+
+    StatusCacheLock(const StatusCacheLock &) = delete;
+    StatusCacheLock &operator=(const StatusCacheLock &) = delete;
+
+    explicit operator bool() const { return locked_; }
+
+private:
+    bool locked_ = false;
+};
+
 // Publish the FreeRTOS task stack high-water marks as a single retained string.
 // Called infrequently (every 60 s) because the values move slowly and the
 // payload can be several hundred bytes — publishing it on the 5 s status cycle
@@ -541,36 +1232,36 @@ void mqtt_handler_publish_task_stacks(void)
     std::string stacks = sysInfo->getTaskStackInfo();
     if (stacks.empty()) return;
 
-    char topic[160];
-    snprintf(topic, sizeof(topic), "%s/status/task_stacks",
-             current_mqtt_config.topic_prefix);
-    mqtt_publish_connected(topic, stacks.c_str(), 0, 0, 1);
+    StatusCacheLock cache_lock;
+    if (!cache_lock) return;
+    publish_status_value(STATUS_TASK_STACKS, stacks.c_str());
 }
 
-// Publish one value under <prefix>/<subtopic> with retain=1, QoS=0.
-// Defined as a macro so the compiler can inline the snprintf chains.
-#define PUBLISH_STR(subtopic, value) \
-    do { \
-        snprintf(topic, sizeof(topic), "%s/%s", current_mqtt_config.topic_prefix, subtopic); \
-        mqtt_publish_connected(topic, value, 0, 0, 1); \
-    } while (0)
+// Publish one value under <prefix>/status/<topic> with retain=1, QoS=0, if
+// it changed since the last cycle (publish_status_value). The numeric forms
+// format into the caller's payload buffer and hand the number on for the
+// cache's deadband; the macros only keep the call sites below short.
+#define PUBLISH_STR(id, value) publish_status_value(id, value)
 
-#define PUBLISH_INT(subtopic, value) \
+#define PUBLISH_BOOL(id, value) publish_status_flag(id, value)
+
+#define PUBLISH_INT(id, value) \
     do { \
         snprintf(payload, sizeof(payload), "%d", (int)(value)); \
-        PUBLISH_STR(subtopic, payload); \
+        publish_status_value(id, payload, true, (double)(value)); \
     } while (0)
 
-#define PUBLISH_UINT64(subtopic, value) \
+#define PUBLISH_UINT64(id, value) \
     do { \
         snprintf(payload, sizeof(payload), "%llu", (unsigned long long)(value)); \
-        PUBLISH_STR(subtopic, payload); \
+        publish_status_value(id, payload, true, (double)(value)); \
     } while (0)
 
-#define PUBLISH_DOUBLE(subtopic, value, prec) \
+#define PUBLISH_DOUBLE(id, value, prec) \
     do { \
-        snprintf(payload, sizeof(payload), "%.*f", prec, value); \
-        PUBLISH_STR(subtopic, payload); \
+        const double number_ = (value); \
+        snprintf(payload, sizeof(payload), "%.*f", prec, number_); \
+        publish_status_value(id, payload, true, number_); \
     } while (0)
 
 void mqtt_handler_publish_status(void)
@@ -590,25 +1281,36 @@ void mqtt_handler_publish_status(void)
         return;
     }
 
-    char topic[160];
+    StatusCacheLock cache_lock;
+    if (!cache_lock) {
+        ESP_LOGW(TAG, "Status publish already in progress; skipping cycle");
+        return;
+    }
+
+    JsonWriter document(status_document_buffer, sizeof(status_document_buffer));
+    if (current_mqtt_config.state_document) {
+        document.beginObject();
+        status_document = &document;
+    }
+
     char payload[96];
 
     // Birth/online marker. The matching LWT (set in mqtt_handler_start)
     // overwrites this with "offline" if the connection drops uncleanly.
-    PUBLISH_STR("status/online", "online");
+    PUBLISH_STR(STATUS_ONLINE, "online");
 
     // ---- Identity ---------------------------------------------------------
-    PUBLISH_STR("status/serial", sysInfo->getSerialNumber());
-    PUBLISH_STR("status/firmware_version", sysInfo->getCurrentVersion());
+    PUBLISH_STR(STATUS_SERIAL, sysInfo->getSerialNumber());
+    PUBLISH_STR(STATUS_FIRMWARE_VERSION, sysInfo->getCurrentVersion());
     char webuiVersion[32] = {};
     webui_storage_get_effective_version(webuiVersion, sizeof(webuiVersion));
-    PUBLISH_STR("status/webui_version", webuiVersion);
-    PUBLISH_STR("status/board_revision", sysInfo->getBoardRevisionString().c_str());
+    PUBLISH_STR(STATUS_WEBUI_VERSION, webuiVersion);
+    PUBLISH_STR(STATUS_BOARD_REVISION, sysInfo->getBoardRevisionString().c_str());
 
     // ---- System metrics ---------------------------------------------------
-    PUBLISH_DOUBLE("status/cpu_usage", sysInfo->getCpuUsage(), 1);
-    PUBLISH_DOUBLE("status/memory_usage", sysInfo->getMemoryUsage(), 1);
-    PUBLISH_UINT64("status/uptime", sysInfo->getUptimeSeconds());
+    PUBLISH_DOUBLE(STATUS_CPU_USAGE, sysInfo->getCpuUsage(), 1);
+    PUBLISH_DOUBLE(STATUS_MEMORY_USAGE, sysInfo->getMemoryUsage(), 1);
+    PUBLISH_UINT64(STATUS_UPTIME, sysInfo->getUptimeSeconds());
 
     // Uptime formatted
     {
@@ -618,15 +1320,15 @@ void mqtt_handler_publish_status(void)
         uint32_t mins  = (uint32_t)(uptime_s / 60);
         snprintf(payload, sizeof(payload), "%lu d, %lu h, %lu m",
                  (unsigned long)days, (unsigned long)hours, (unsigned long)mins);
-        PUBLISH_STR("status/uptime_text", payload);
+        PUBLISH_STR(STATUS_UPTIME_TEXT, payload);
     }
 
     // Heap details - useful for memory leak monitoring in HA graphs.
     {
         multi_heap_info_t info;
         heap_caps_get_info(&info, MALLOC_CAP_INTERNAL);
-        PUBLISH_UINT64("status/free_heap", info.total_free_bytes);
-        PUBLISH_UINT64("status/min_free_heap", esp_get_minimum_free_heap_size());
+        PUBLISH_UINT64(STATUS_FREE_HEAP, info.total_free_bytes);
+        PUBLISH_UINT64(STATUS_MIN_FREE_HEAP, esp_get_minimum_free_heap_size());
     }
 
     // ---- CCU relay latency -------------------------------------------------
@@ -638,11 +1340,28 @@ void mqtt_handler_publish_status(void)
     {
         raw_uart_latency_t latency = {};
         raw_uart_get_latency(&latency);
-        PUBLISH_UINT64("status/ccu_queue_wait_max_ms", latency.queue_wait_max_us / 1000);
-        PUBLISH_UINT64("status/ccu_queue_depth_max", latency.queue_depth_max);
-        PUBLISH_UINT64("status/ccu_delayed_frames",
+        PUBLISH_UINT64(STATUS_CCU_QUEUE_WAIT_MAX_MS, latency.queue_wait_max_us / 1000);
+        PUBLISH_UINT64(STATUS_CCU_QUEUE_DEPTH_MAX, latency.queue_depth_max);
+        PUBLISH_UINT64(STATUS_CCU_DELAYED_FRAMES,
                        latency.wait_over_10ms + latency.wait_over_100ms + latency.wait_over_1s);
-        PUBLISH_UINT64("status/ccu_dropped_frames", latency.drops);
+        PUBLISH_UINT64(STATUS_CCU_DROPPED_FRAMES, latency.drops);
+    }
+
+    // ---- Radio traffic ------------------------------------------------------
+    // Sliding-window rates of what the module relays to the CCU. The airtime
+    // share is the estimated on-air time of the last hour's received
+    // telegrams: a chatty device or a busy neighbourhood shows up here
+    // before it shows up as lost commands.
+    {
+        raw_uart_rf_rates_t rf = {};
+        raw_uart_get_rf_rates(&rf);
+        PUBLISH_UINT64(STATUS_RF_FRAMES_PER_MIN, rf.frames_1m);
+        PUBLISH_UINT64(STATUS_RF_FRAMES_PER_HOUR, rf.frames_1h);
+        PUBLISH_DOUBLE(STATUS_RF_AIRTIME_PERCENT, rf.airtime_1h_ms / 36000.0, 2);
+        // Transmit side: share of the 1 % hourly budget already spent.
+        radio_module_duty_cycle_t duty = {};
+        radio_module_get_duty_cycle(&duty);
+        PUBLISH_UINT64(STATUS_RF_DUTY_CYCLE, duty.used_percent);
     }
 
     // NVS fill level. 16 KiB shared by settings, MQTT credentials, TLS key
@@ -651,37 +1370,37 @@ void mqtt_handler_publish_status(void)
     {
         nvs_stats_t nvs = {};
         if (nvs_get_stats(NULL, &nvs) == ESP_OK && nvs.total_entries > 0) {
-            PUBLISH_UINT64("status/nvs_used_entries", nvs.used_entries);
-            PUBLISH_UINT64("status/nvs_free_entries", nvs.available_entries);
-            PUBLISH_DOUBLE("status/nvs_usage",
+            PUBLISH_UINT64(STATUS_NVS_USED_ENTRIES, nvs.used_entries);
+            PUBLISH_UINT64(STATUS_NVS_FREE_ENTRIES, nvs.available_entries);
+            PUBLISH_DOUBLE(STATUS_NVS_USAGE,
                            (100.0 * (double)nvs.used_entries) / (double)nvs.total_entries, 1);
         }
     }
 
     // Reset reason (combines app-level stored reason + ESP hardware reason).
     if (sysInfo->getResetReason()) {
-        PUBLISH_STR("status/last_reset_reason", sysInfo->getResetReason());
+        PUBLISH_STR(STATUS_LAST_RESET_REASON, sysInfo->getResetReason());
     }
 
     // ---- Ethernet ---------------------------------------------------------
     if (eth) {
-        PUBLISH_STR("status/eth_connected", eth->isConnected() ? "true" : "false");
-        PUBLISH_INT("status/eth_link_speed", eth->getLinkSpeedMbps());
+        PUBLISH_BOOL(STATUS_ETH_CONNECTED, eth->isConnected());
+        PUBLISH_INT(STATUS_ETH_LINK_SPEED, eth->getLinkSpeedMbps());
         if (eth->getDuplexMode()) {
-            PUBLISH_STR("status/eth_duplex", eth->getDuplexMode());
+            PUBLISH_STR(STATUS_ETH_DUPLEX, eth->getDuplexMode());
         }
         ip4_addr_t ip, nm, gw, dns1, dns2;
         eth->getNetworkSettings(&ip, &nm, &gw, &dns1, &dns2);
         snprintf(payload, sizeof(payload), IPSTR, IP2STR(&ip));
-        PUBLISH_STR("status/ip_address", payload);
+        PUBLISH_STR(STATUS_IP_ADDRESS, payload);
         snprintf(payload, sizeof(payload), IPSTR, IP2STR(&nm));
-        PUBLISH_STR("status/netmask", payload);
+        PUBLISH_STR(STATUS_NETMASK, payload);
         snprintf(payload, sizeof(payload), IPSTR, IP2STR(&gw));
-        PUBLISH_STR("status/gateway", payload);
+        PUBLISH_STR(STATUS_GATEWAY, payload);
         snprintf(payload, sizeof(payload), IPSTR, IP2STR(&dns1));
-        PUBLISH_STR("status/dns1", payload);
+        PUBLISH_STR(STATUS_DNS1, payload);
         snprintf(payload, sizeof(payload), IPSTR, IP2STR(&dns2));
-        PUBLISH_STR("status/dns2", payload);
+        PUBLISH_STR(STATUS_DNS2, payload);
 
         // IPv6 addresses (comma-separated; empty string when none assigned)
         char ipv6_addrs[4][48];
@@ -696,9 +1415,9 @@ void mqtt_handler_publish_status(void)
                 off += snprintf(ipv6_buf + off, sizeof(ipv6_buf) - off,
                                 "%s", ipv6_addrs[i]);
             }
-            PUBLISH_STR("status/ipv6_addresses", ipv6_buf);
+            PUBLISH_STR(STATUS_IPV6_ADDRESSES, ipv6_buf);
         } else {
-            PUBLISH_STR("status/ipv6_addresses", "");
+            PUBLISH_STR(STATUS_IPV6_ADDRESSES, "");
         }
     }
 
@@ -712,14 +1431,14 @@ void mqtt_handler_publish_status(void)
             case RADIO_MODULE_NONE:           type = "none";           break;
             default:                          type = "unknown";        break;
         }
-        PUBLISH_STR("status/radio_module_type", type);
+        PUBLISH_STR(STATUS_RADIO_MODULE_TYPE, type);
         if (radio->getSerial()) {
-            PUBLISH_STR("status/radio_module_serial", radio->getSerial());
+            PUBLISH_STR(STATUS_RADIO_MODULE_SERIAL, radio->getSerial());
         }
         const uint8_t* fw = radio->getFirmwareVersion();
         if (fw && (fw[0] || fw[1] || fw[2])) {
             snprintf(payload, sizeof(payload), "%d.%d.%d", fw[0], fw[1], fw[2]);
-            PUBLISH_STR("status/radio_module_firmware", payload);
+            PUBLISH_STR(STATUS_RADIO_MODULE_FIRMWARE, payload);
         }
     }
 
@@ -727,16 +1446,23 @@ void mqtt_handler_publish_status(void)
     if (clk) {
         struct timeval sync = clk->getLastSyncTime();
         bool synced = (sync.tv_sec > 0);
-        PUBLISH_STR("status/ntp_synced", synced ? "true" : "false");
+        PUBLISH_BOOL(STATUS_NTP_SYNCED, synced);
         if (synced) {
-            PUBLISH_UINT64("status/last_ntp_sync", (unsigned long long)sync.tv_sec);
+            PUBLISH_UINT64(STATUS_LAST_NTP_SYNC, (unsigned long long)sync.tv_sec);
         } else {
-            PUBLISH_STR("status/last_ntp_sync", "0");
+            PUBLISH_STR(STATUS_LAST_NTP_SYNC, "0");
         }
     }
+
+    if (status_document != NULL) {
+        status_document = NULL;
+        document.endObject();
+        publish_state_document(document);
+    }
 }
 
 #undef PUBLISH_STR
+#undef PUBLISH_BOOL
 #undef PUBLISH_INT
 #undef PUBLISH_UINT64
 #undef PUBLISH_DOUBLE
@@ -757,7 +1483,7 @@ void mqtt_handler_publish_status(void)
 // latest_firmware_version. Each is an empty retained publish that the
 // broker treats as "delete this retained value", mirroring the existing
 // remove_config() pattern for HA discovery topics. Idempotent and cheap,
-// so running it on every MQTT_EVENT_CONNECTED is safer than tracking
+// so running it after every MQTT_EVENT_CONNECTED is safer than tracking
 // per-boot state across reconnects.
 static void publish_legacy_topic_cleanup(void)
 {
@@ -869,6 +1595,53 @@ static void publish_legacy_topic_cleanup(void)
     }
 }
 
+// The discovery cache survives reboots in its own namespace, like the
+// legacy-cleanup marker, so a settings rewrite cannot drop it. Losing it
+// only costs one full republish.
+static const char *const DISCOVERY_NS = "mqtt_disc";
+static const char *const DISCOVERY_KEY = "cfgHashes";
+
+static void discovery_cache_load(void)
+{
+    static uint8_t blob[1 + MqttDiscoveryCache::MAX_ENTITIES * 8];
+    size_t len = sizeof(blob);
+    esp_err_t err;
+    {
+        NvsStorageLock storage_lock(portMAX_DELAY, "mqtt.discovery_read");
+        if (!storage_lock) return;
+        nvs_handle_t h;
+        err = nvs_open(DISCOVERY_NS, NVS_READONLY, &h);
+        if (err == ESP_OK) {
+            err = nvs_get_blob(h, DISCOVERY_KEY, blob, &len);
+            nvs_close(h);
+        }
+    }
+    if (err == ESP_ERR_NVS_NOT_FOUND) return;
+    if (err != ESP_OK || !discovery_cache.deserialize(blob, len)) {
+        ESP_LOGW(TAG, "Discarding stored discovery hashes: %s", esp_err_to_name(err));
+    }
+}
+
+static void discovery_cache_save(void)
+{
+    static uint8_t blob[1 + MqttDiscoveryCache::MAX_ENTITIES * 8];
+    const size_t len = discovery_cache.serialize(blob, sizeof(blob));
+    NvsStorageLock storage_lock(portMAX_DELAY, "mqtt.discovery_write");
+    if (!storage_lock) return;
+    nvs_handle_t h;
+    esp_err_t err = nvs_open(DISCOVERY_NS, NVS_READWRITE, &h);
+    if (err == ESP_OK) {
+        err = nvs_set_blob(h, DISCOVERY_KEY, blob, len);
+        if (err == ESP_OK) err = nvs_commit(h);
+        nvs_close(h);
+    }
+    if (err == ESP_OK) {
+        discovery_cache.markClean();
+    } else {
+        ESP_LOGW(TAG, "Could not persist discovery hashes: %s", esp_err_to_name(err));
+    }
+}
+
 void mqtt_handler_publish_ha_discovery(void)
 {
     MqttPublishOperation operation;
@@ -881,7 +1654,18 @@ void mqtt_handler_publish_ha_discovery(void)
         return;
     }
 
-    ESP_LOGI(TAG, "Publishing Home Assistant discovery configs");
+    if (!discovery_cache_loaded) {
+        discovery_cache_load();
+        discovery_cache_loaded = true;
+    }
+    if (discovery_reset.exchange(false)) {
+        ESP_LOGI(TAG, "Home Assistant came online; republishing discovery configs");
+        discovery_cache.clear();
+        discovery_cursor = 0;
+    }
+    if (discovery_restart.exchange(false)) {
+        discovery_cursor = 0;
+    }
 
     // The token callers must send as payload_press so the HA restart button
     // works even when a command_token is configured. Empty token -> plain
@@ -895,63 +1679,137 @@ void mqtt_handler_publish_ha_discovery(void)
     if (!hostname || !hostname[0]) {
         hostname = "HB-RF-ETH";
     }
-
-    cJSON *device = cJSON_CreateObject();
     char identifiers[64];
     snprintf(identifiers, sizeof(identifiers), "hb-rf-eth-%s", sysInfo->getSerialNumber());
-    cJSON_AddStringToObject(device, "identifiers", identifiers);
-    cJSON_AddStringToObject(device, "name", hostname);
-    cJSON_AddStringToObject(device, "model", "HB-RF-ETH-ng");
-    cJSON_AddStringToObject(device, "manufacturer", "Xerolux");
-    cJSON_AddStringToObject(device, "sw_version", sysInfo->getCurrentVersion());
-    cJSON_AddStringToObject(device, "hw_version", sysInfo->getBoardRevisionString().c_str());
-
-    // Helper: publish a sensor / binary_sensor / button / update config.
+    const std::string board_revision = sysInfo->getBoardRevisionString();
+
+    // Every config is streamed into discovery_payload and hashed; only
+    // configs the broker does not hold yet are published, at most
+    // DISCOVERY_BURST per call. Entities are keyed by their discovery topic
+    // and the broker, so a new prefix or broker republishes everything.
+    //
+    // Entities are numbered in the order below. A call renders only from
+    // discovery_cursor on and stops at the first config it does not send,
+    // so a paced pass renders each entity once rather than all of them on
+    // every step.
+    const uint32_t broker =
+        MqttValueCache::hash(current_mqtt_config.server, strlen(current_mqtt_config.server)) ^
+        current_mqtt_config.port;
+    uint32_t published = 0;
+    uint32_t unchanged = 0;
+    bool more = false;
+    uint32_t entity = 0;
+    if (discovery_cursor == 0) discovery_cache.beginPass();
+
+    // Numbers the next entity; true if this call renders it.
+    auto visit = [&]() {
+        const uint32_t index = entity++;
+        return !more && index >= discovery_cursor;
+    };
+
+    // Publish one config (payload "" deletes the entity) unless the broker
+    // already holds exactly this payload.
+    auto submit = [&](const char* component, const char* object_id, const char* payload,
+                      size_t len) {
+        snprintf(discovery_topic, sizeof(discovery_topic), "%s/%s/hb-rf-eth-%s/%s/config",
+                 current_mqtt_config.ha_discovery_prefix, component,
+                 sysInfo->getSerialNumber(), object_id);
+        const uint32_t key = MqttValueCache::hash(discovery_topic, strlen(discovery_topic)) ^ broker;
+        const uint32_t content = MqttValueCache::hash(payload, len);
+        if (!discovery_cache.changed(key, content)) {
+            unchanged++;
+            return;
+        }
+        // A failed or deferred publish is not recorded; this entity and
+        // the rest wait for the next call.
+        if (published == DISCOVERY_BURST ||
+            mqtt_publish_paced(MqttPacer::LOW, discovery_topic, payload, (int)len, 1, 1) < 0) {
+            more = true;
+            discovery_cursor = entity - 1;
+            return;
+        }
+        discovery_cache.record(key, content);
+        published++;
+        g_discovery_publishes.inc();
+    };
+
+    auto begin_config = [&](JsonWriter &json, const char* object_id, const char* name) {
+        json.beginObject();
+        json.string("name", name);
+        snprintf(discovery_unique_id, sizeof(discovery_unique_id), "%s_%s", identifiers, object_id);
+        json.string("unique_id", discovery_unique_id);
+    };
+
+    auto end_config = [&](JsonWriter &json, const char* component, const char* object_id) {
+        json.beginObject("device");
+        json.string("identifiers", identifiers);
+        json.string("name", hostname);
+        json.string("model", "HB-RF-ETH-ng");
+        json.string("manufacturer", "Xerolux");
+        json.string("sw_version", sysInfo->getCurrentVersion());
+        json.string("hw_version", board_revision.c_str());
+        json.endObject();
+        json.endObject();
+        if (!json.ok()) {
+            ESP_LOGW(TAG, "Discovery config for %s exceeds %u bytes; not published",
+                     object_id, (unsigned)sizeof(discovery_payload));
+            return;
+        }
+        submit(component, object_id, json.c_str(), json.length());
+    };
+
+    // Helper: publish a sensor / binary_sensor config.
     auto publish_config = [&](const char* component, const char* object_id, const char* name,
                               const char* device_class, const char* state_class,
                               const char* unit_of_measurement, const char* value_template,
                               const char* entity_category = NULL, const char* icon = NULL,
                               const char* payload_on = NULL, const char* payload_off = NULL) {
+        if (!visit()) return;
+        const int status_id = status_topic_id(object_id);
+        if (status_id < 0) {
+            ESP_LOGW(TAG, "No status topic for discovery entity %s", object_id);
+            return;
+        }
 
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "name", name);
-
-        char unique_id[128];
-        snprintf(unique_id, sizeof(unique_id), "%s_%s", identifiers, object_id);
-        cJSON_AddStringToObject(root, "unique_id", unique_id);
-
-        char state_topic[160];
-        snprintf(state_topic, sizeof(state_topic), "%s/status/%s", current_mqtt_config.topic_prefix, object_id);
-        cJSON_AddStringToObject(root, "state_topic", state_topic);
-
-        if (device_class) cJSON_AddStringToObject(root, "device_class", device_class);
-        if (state_class) cJSON_AddStringToObject(root, "state_class", state_class);
-        if (unit_of_measurement) cJSON_AddStringToObject(root, "unit_of_measurement", unit_of_measurement);
-        if (value_template) cJSON_AddStringToObject(root, "value_template", value_template);
-        if (payload_on) cJSON_AddStringToObject(root, "payload_on", payload_on);
-        if (payload_off) cJSON_AddStringToObject(root, "payload_off", payload_off);
-        if (entity_category) cJSON_AddStringToObject(root, "entity_category", entity_category);
-        if (icon) cJSON_AddStringToObject(root, "icon", icon);
-
-        cJSON_AddItemToObject(root, "device", cJSON_Duplicate(device, 1));
-
-        char *json_str = cJSON_PrintUnformatted(root);
-        char topic[256];
-        snprintf(topic, sizeof(topic), "%s/%s/hb-rf-eth-%s/%s/config",
-                 current_mqtt_config.ha_discovery_prefix, component, sysInfo->getSerialNumber(), object_id);
-        mqtt_publish_connected(topic, json_str, 0, 1, 1);
-        free(json_str);
-        cJSON_Delete(root);
+        JsonWriter json(discovery_payload, sizeof(discovery_payload));
+        begin_config(json, object_id, name);
+
+        // In state-document mode every value but the online marker is a
+        // key of <prefix>/state; the template picks it out. Booleans are
+        // mapped back onto payload_on/payload_off.
+        const char *state_topic = mqtt_topics.topic(status_id);
+        if (current_mqtt_config.state_document && status_id != STATUS_ONLINE) {
+            state_topic = mqtt_topics.topic(TOPIC_STATE);
+            if (!value_template && payload_on && payload_off) {
+                snprintf(discovery_template, sizeof(discovery_template),
+                         "{{ '%s' if value_json.%s else '%s' }}", payload_on, object_id, payload_off);
+                value_template = discovery_template;
+            } else if (!value_template) {
+                snprintf(discovery_template, sizeof(discovery_template),
+                         "{{ value_json.%s }}", object_id);
+                value_template = discovery_template;
+            }
+        }
+        json.string("state_topic", state_topic);
+
+        if (device_class) json.string("device_class", device_class);
+        if (state_class) json.string("state_class", state_class);
+        if (unit_of_measurement) json.string("unit_of_measurement", unit_of_measurement);
+        if (value_template) json.string("value_template", value_template);
+        if (payload_on) json.string("payload_on", payload_on);
+        if (payload_off) json.string("payload_off", payload_off);
+        if (entity_category) json.string("entity_category", entity_category);
+        if (icon) json.string("icon", icon);
+
+        end_config(json, component, object_id);
     };
 
     // Remove retained discovery entries created by older firmware versions.
     // These sensors were never backed by hardware on HB-RF-ETH boards.
+    // Recorded like any config, so each deletion is sent once, not on every
+    // connect.
     auto remove_config = [&](const char* component, const char* object_id) {
-        char topic[256];
-        snprintf(topic, sizeof(topic), "%s/%s/hb-rf-eth-%s/%s/config",
-                 current_mqtt_config.ha_discovery_prefix, component,
-                 sysInfo->getSerialNumber(), object_id);
-        mqtt_publish_connected(topic, "", 0, 1, 1);
+        if (visit()) submit(component, object_id, "", 0);
     };
 
     // ---- Sensors: system metrics ----------------------------------------
@@ -970,6 +1828,15 @@ void mqtt_handler_publish_ha_discovery(void)
                    NULL, NULL, "diagnostic", "mdi:timer-sand");
     publish_config("sensor", "ccu_dropped_frames", "CCU Dropped Frames", NULL, "total_increasing",
                    NULL, NULL, "diagnostic", "mdi:package-variant-remove");
+    // Radio traffic relayed to the CCU, sliding windows.
+    publish_config("sensor", "rf_frames_per_min", "Radio Frames (1 min)", NULL, "measurement",
+                   NULL, NULL, "diagnostic", "mdi:radio-tower");
+    publish_config("sensor", "rf_frames_per_hour", "Radio Frames (1 h)", NULL, "measurement",
+                   NULL, NULL, "diagnostic", "mdi:radio-tower");
+    publish_config("sensor", "rf_airtime_percent", "Radio Airtime (1 h)", NULL, "measurement",
+                   "%", NULL, "diagnostic", "mdi:sine-wave");
+    publish_config("sensor", "rf_duty_cycle", "Radio Duty Cycle (TX)", NULL, "measurement",
+                   "%", NULL, "diagnostic", "mdi:timer-sand-complete");
     // NVS fill level — a full partition presents as "settings will not save".
     publish_config("sensor", "nvs_usage", "NVS Usage", NULL, "measurement", "%", NULL, "diagnostic",
                    "mdi:database-settings");
@@ -1026,40 +1893,26 @@ void mqtt_handler_publish_ha_discovery(void)
 
     // ---- Buttons ---------------------------------------------------------
     auto publish_button = [&](const char* object_id, const char* name,
-                              const char* command, const char* payload_str,
+                              OtherTopic command, const char* payload_str,
                               const char* device_class = "restart",
                               const char* icon = nullptr) {
-        cJSON *root = cJSON_CreateObject();
-        cJSON_AddStringToObject(root, "name", name);
-        char unique_id[128];
-        snprintf(unique_id, sizeof(unique_id), "%s_%s", identifiers, object_id);
-        cJSON_AddStringToObject(root, "unique_id", unique_id);
-
-        char command_topic[160];
-        snprintf(command_topic, sizeof(command_topic), "%s/command/%s",
-                 current_mqtt_config.topic_prefix, command);
-        cJSON_AddStringToObject(root, "command_topic", command_topic);
-        cJSON_AddStringToObject(root, "payload_press", payload_str);
-
-        cJSON_AddStringToObject(root, "entity_category", "config");
-        if (device_class) cJSON_AddStringToObject(root, "device_class", device_class);
-        if (icon) cJSON_AddStringToObject(root, "icon", icon);
-
-        cJSON_AddItemToObject(root, "device", cJSON_Duplicate(device, 1));
-
-        char *json_str = cJSON_PrintUnformatted(root);
-        char topic[256];
-        snprintf(topic, sizeof(topic), "%s/button/hb-rf-eth-%s/%s/config",
-                 current_mqtt_config.ha_discovery_prefix, sysInfo->getSerialNumber(), object_id);
-        mqtt_publish_connected(topic, json_str, 0, 1, 1);
-        free(json_str);
-        cJSON_Delete(root);
+        if (!visit()) return;
+        JsonWriter json(discovery_payload, sizeof(discovery_payload));
+        begin_config(json, object_id, name);
+        json.string("command_topic", mqtt_topics.topic(command));
+        json.string("payload_press", payload_str);
+        json.string("entity_category", "config");
+        if (device_class) json.string("device_class", device_class);
+        if (icon) json.string("icon", icon);
+        end_config(json, "button", object_id);
     };
 
     // When commands are disabled, the device ignores every payload - so we
     // must NOT publish buttons that look clickable. Hide them by skipping.
     if (current_mqtt_config.command_enabled) {
-        publish_button("restart", "Restart", "restart", restart_payload, "restart", "mdi:restart");
+        publish_button("restart", "Restart", TOPIC_COMMAND_RESTART, restart_payload, "restart", "mdi:restart");
+    } else {
+        entity++;   // keeps the numbering of what follows
     }
 
     // Remove destructive/retired entities retained by older firmware.
@@ -1067,7 +1920,21 @@ void mqtt_handler_publish_ha_discovery(void)
     remove_config("button", "check_update");
     remove_config("update", "firmware_update");
 
-    cJSON_Delete(device);
+    g_discovery_unchanged.inc(unchanged);
+    if (more) {
+        // Paced by the publish task, DISCOVERY_STEP_MS per call.
+        discovery_pending.store(true, std::memory_order_release);
+        return;
+    }
+    discovery_cursor = 0;
+    discovery_cache.endPass();
+    ESP_LOGI(TAG, "mqtt_publish stack high water mark after discovery: %u bytes free",
+             (unsigned)uxTaskGetStackHighWaterMark(NULL));
+    if (discovery_cache.dirty()) {
+        ESP_LOGI(TAG, "Home Assistant discovery configs up to date (%u entities)",
+                 (unsigned)discovery_cache.size());
+        discovery_cache_save();
+    }
 }
 
 esp_err_t mqtt_handler_init(void)
@@ -1076,7 +1943,20 @@ esp_err_t mqtt_handler_init(void)
         mqtt_lifecycle_mutex =
             xSemaphoreCreateMutexStatic(&mqtt_lifecycle_mutex_buffer);
     }
-    if (mqtt_lifecycle_mutex == NULL) {
+    if (status_cache_mutex == NULL) {
+        status_cache_mutex = xSemaphoreCreateMutexStatic(&status_cache_mutex_buffer);
+    }
+    if (mqtt5_publish_mutex == NULL) {
+        mqtt5_publish_mutex = xSemaphoreCreateMutexStatic(&mqtt5_publish_mutex_buffer);
+        mqtt5_aliases.reset(MqttTopicAliases::MAX_ALIASES);
+    }
+    if (mqtt_deferred_events == NULL) {
+        mqtt_deferred_events = xQueueCreateStatic(
+            MQTT_DEFERRED_EVENTS, sizeof(MqttDeferredEvent),
+            mqtt_deferred_events_storage, &mqtt_deferred_events_buffer);
+    }
+    if (mqtt_lifecycle_mutex == NULL || status_cache_mutex == NULL ||
+        mqtt5_publish_mutex == NULL || mqtt_deferred_events == NULL) {
         ESP_LOGE(TAG, "MQTT static lifecycle primitives unavailable");
         return ESP_ERR_NO_MEM;
     }
@@ -1172,6 +2052,15 @@ static esp_err_t mqtt_start_locked(const mqtt_config_t *config)
     ESP_LOGI(TAG, "Starting MQTT client connecting to %s:%d", config->server, config->port);
 
     memcpy(&current_mqtt_config, config, sizeof(mqtt_config_t));
+    if (!mqtt_topics.build(current_mqtt_config.topic_prefix, MQTT_SUBTOPICS, TOPIC_COUNT) ||
+        !ha_topics.build(current_mqtt_config.ha_discovery_prefix, HA_SUBTOPICS, HA_TOPIC_COUNT)) {
+        ESP_LOGE(TAG, "Failed to build MQTT topic table");
+        return ESP_ERR_NO_MEM;
+    }
+    portENTER_CRITICAL(&publish_pacer_mux);
+    publish_pacer.configure(PUBLISH_PACER_LIMITS, (uint32_t)(esp_timer_get_time() / 1000));
+    portEXIT_CRITICAL(&publish_pacer_mux);
+    mqtt_in_flight.store(0, std::memory_order_relaxed);
 
     esp_mqtt_client_config_t mqtt_cfg = {};
     mqtt_cfg.broker.address.uri = NULL;
@@ -1209,15 +2098,19 @@ static esp_err_t mqtt_start_locked(const mqtt_config_t *config)
     }
 
     // Keep the LWT topic alive for the complete client lifetime. Pointing the
-    // config at a block-local array relied on undocumented eager copying.
-    snprintf(mqtt_lwt_topic, sizeof(mqtt_lwt_topic), "%s/status/online",
-             current_mqtt_config.topic_prefix);
-    mqtt_cfg.session.last_will.topic = mqtt_lwt_topic;
+    // config at a block-local array relied on undocumented eager copying;
+    // mqtt_topics is only rebuilt once this client is gone.
+    mqtt_cfg.session.last_will.topic = mqtt_topics.topic(STATUS_ONLINE);
     mqtt_cfg.session.last_will.msg = "offline";
     mqtt_cfg.session.last_will.msg_len = 7;
     mqtt_cfg.session.last_will.qos = 1;
     mqtt_cfg.session.last_will.retain = 1;
 
+    if (current_mqtt_config.protocol_v5) {
+        mqtt_cfg.session.protocol_ver = MQTT_PROTOCOL_V_5;
+        mqtt5_build_unit_properties();
+    }
+
     client = esp_mqtt_client_init(&mqtt_cfg);
     if (client == NULL) {
         ESP_LOGE(TAG, "Failed to initialize MQTT client");
@@ -1241,12 +2134,15 @@ static esp_err_t mqtt_start_locked(const mqtt_config_t *config)
         client = NULL;
         return err;
     }
-    // The publish task formats several status payloads via snprintf into a
-    // 96-byte stack buffer and calls esp_mqtt_client_publish — TLS handshakes
-    // run in the esp-mqtt client task, not here. The observed high-water mark
-    // (e.g. "mqtt_publish stack high water mark: 7536 bytes free") confirms
-    // only ~650 B of the previous 8 KB were ever used, so 5 KB leaves a
-    // >4 KB safety margin while returning ~3 KB to the WROOM-32 heap.
+    // The publish task formats status payloads via snprintf into a 96-byte
+    // stack buffer, runs the paced HA discovery passes and calls
+    // esp_mqtt_client_publish — TLS handshakes run in the esp-mqtt client
+    // task, not here. Discovery keeps its topic, unique_id, template and
+    // document buffers static, so its frames add only a JsonWriter and the
+    // snprintf calls; the status document buffer is static as well. The
+    // status-only task used ~650 B of the former 8 KB. The high-water mark
+    // is logged after the first status cycle and after each completed
+    // discovery pass, so the 5 KB can be checked with discovery enabled.
     TaskHandle_t pub_handle = NULL;
     if (xTaskCreate(mqtt_publish_task, "mqtt_publish", 5120,
                     NULL, 4, &pub_handle) != pdPASS) {
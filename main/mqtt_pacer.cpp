@@ -0,0 +1,59 @@
+/*
+ *  mqtt_pacer.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "mqtt_pacer.h"
+
+void MqttPacer::configure(const Limits &limits, uint32_t now_ms) {
+    _limits = limits;
+    if (_limits.burst == 0) _limits.burst = 1;
+    _tokens_milli = _limits.burst * 1000;
+    _refilled_ms = now_ms;
+}
+
+void MqttPacer::refill(uint32_t now_ms) {
+    const uint32_t elapsed_ms = now_ms - _refilled_ms;
+    _refilled_ms = now_ms;
+    const uint32_t capacity = _limits.burst * 1000;
+    // rate_per_s tokens per 1000 ms is rate_per_s milli-tokens per ms.
+    const uint64_t tokens = (uint64_t)_tokens_milli + (uint64_t)elapsed_ms * _limits.rate_per_s;
+    _tokens_milli = tokens > capacity ? capacity : (uint32_t)tokens;
+}
+
+MqttPacer::Decision MqttPacer::decide(Priority priority, uint32_t now_ms, size_t outbox_bytes,
+                                      uint32_t in_flight, uint32_t *wait_ms) {
+    if (priority == HIGH) return ADMIT;
+
+    const bool hard = outbox_bytes >= _limits.hard_bytes || in_flight >= _limits.hard_in_flight;
+    const bool soft = outbox_bytes >= _limits.soft_bytes || in_flight >= _limits.soft_in_flight;
+    if (hard || (soft && priority == LOW)) return DEFER;
+
+    if (_limits.rate_per_s == 0) return ADMIT;   // unpaced
+    refill(now_ms);
+    if (_tokens_milli >= 1000) {
+        _tokens_milli -= 1000;
+        return ADMIT;
+    }
+    if (wait_ms) *wait_ms = (1000 - _tokens_milli + _limits.rate_per_s - 1) / _limits.rate_per_s;
+    return WAIT;
+}
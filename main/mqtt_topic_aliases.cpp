@@ -0,0 +1,76 @@
+/*
+ *  mqtt_topic_aliases.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "mqtt_topic_aliases.h"
+
+void MqttTopicAliases::reset(uint16_t maximum) {
+    _maximum = maximum > MAX_ALIASES ? MAX_ALIASES : maximum;
+    _configured = _maximum;
+    for (uint16_t i = 0; i < MAX_ALIASES; i++) {
+        _topic[i] = UNBOUND;
+        _used[i] = 0;
+    }
+    for (uint16_t i = 0; i < MAX_TOPICS; i++) _seen[i] = 0;
+    _clock = 0;
+}
+
+void MqttTopicAliases::limit(uint16_t maximum) {
+    if (maximum >= _maximum) return;
+    for (uint16_t i = maximum; i < _maximum; i++) _topic[i] = UNBOUND;
+    _maximum = maximum;
+}
+
+uint16_t MqttTopicAliases::assign(uint16_t topic_id, bool *bind) {
+    *bind = false;
+    const uint32_t session = _session.load(std::memory_order_acquire);
+    if (session != _assigned) {
+        reset(_configured);
+        _assigned = session;
+    }
+    if (_maximum == 0 || topic_id >= MAX_TOPICS) return 0;
+
+    const uint32_t previous = _seen[topic_id];
+    _seen[topic_id] = ++_clock;
+    uint16_t slot = 0;
+    for (uint16_t i = 0; i < _maximum; i++) {
+        if (_topic[i] == topic_id) {
+            _used[i] = _clock;
+            return i + 1;
+        }
+        // Unbound slots sort first, then the least recently used.
+        if (_topic[slot] != UNBOUND && (_topic[i] == UNBOUND || _used[i] < _used[slot])) {
+            slot = i;
+        }
+    }
+    if (previous == 0 || _clock - previous > HOT_WINDOW) return 0;
+    _topic[slot] = topic_id;
+    _used[slot] = _clock;
+    *bind = true;
+    return slot + 1;
+}
+
+void MqttTopicAliases::drop(uint16_t alias) {
+    if (alias == 0 || alias > _maximum) return;
+    _topic[alias - 1] = UNBOUND;
+}
@@ -0,0 +1,77 @@
+/*
+ *  mqtt_topic_table.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "mqtt_topic_table.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+MqttTopicTable::~MqttTopicTable() {
+    clear();
+}
+
+void MqttTopicTable::clear() {
+    free(_arena);
+    _arena = nullptr;
+    _count = 0;
+}
+
+bool MqttTopicTable::build(const char *prefix, const char *const *subtopics, size_t count) {
+    clear();
+    if (!prefix || !subtopics || count > MAX_TOPICS) return false;
+
+    // Sized exactly in a first pass: with a short prefix the table is a
+    // fraction of what the longest configurable prefix would need.
+    const size_t prefix_len = strlen(prefix);
+    size_t total = 0;
+    for (size_t i = 0; i < count; i++) {
+        if (!subtopics[i]) return false;
+        total += prefix_len + 1 + strlen(subtopics[i]) + 1;
+    }
+    if (total > UINT16_MAX) return false;
+    _arena = (char *)malloc(total ? total : 1);
+    if (!_arena) return false;
+
+    size_t used = 0;
+    for (size_t i = 0; i < count; i++) {
+        _offsets[i] = (uint16_t)used;
+        memcpy(_arena + used, prefix, prefix_len);
+        used += prefix_len;
+        _arena[used++] = '/';
+        const size_t len = strlen(subtopics[i]);
+        memcpy(_arena + used, subtopics[i], len + 1);
+        used += len + 1;
+    }
+    _offsets[count] = (uint16_t)used;
+    _count = count;
+    return true;
+}
+
+const char *MqttTopicTable::topic(size_t id) const {
+    return id < _count ? _arena + _offsets[id] : "";
+}
+
+size_t MqttTopicTable::length(size_t id) const {
+    return id < _count ? (size_t)(_offsets[id + 1] - _offsets[id] - 1) : 0;
+}
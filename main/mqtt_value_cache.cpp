@@ -0,0 +1,69 @@
+/*
+ *  mqtt_value_cache.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "mqtt_value_cache.h"
+
+#include <math.h>
+
+// FNV-1a: a few cycles per byte and no table, on payloads of a few bytes.
+uint32_t MqttValueCache::hash(const char *data, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h ^= (uint8_t)data[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+void MqttValueCache::invalidate() {
+    for (Slot &slot : _slots) slot.valid = false;
+}
+
+bool MqttValueCache::due(const Slot &slot, uint32_t now_s) const {
+    return !slot.valid || _refresh_s == 0 || now_s - slot.published_s >= _refresh_s;
+}
+
+bool MqttValueCache::wants(uint8_t id, const char *payload, size_t len, uint32_t now_s) const {
+    if (id >= SLOTS) return true;
+    const Slot &slot = _slots[id];
+    return due(slot, now_s) || slot.hash != hash(payload, len);
+}
+
+bool MqttValueCache::wantsNumber(uint8_t id, double value, double deadband, const char *payload,
+                                 size_t len, uint32_t now_s) const {
+    if (id >= SLOTS) return true;
+    const Slot &slot = _slots[id];
+    if (due(slot, now_s)) return true;
+    if (slot.hash == hash(payload, len)) return false;
+    return fabs(value - (double)slot.value) >= deadband;
+}
+
+void MqttValueCache::published(uint8_t id, const char *payload, size_t len, uint32_t now_s,
+                               double value) {
+    if (id >= SLOTS) return;
+    Slot &slot = _slots[id];
+    slot.hash = hash(payload, len);
+    slot.published_s = now_s;
+    slot.value = (float)value;
+    slot.valid = true;
+}
@@ -0,0 +1,94 @@
+/*
+ *  notify_digest.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "notify_digest.h"
+#include <initializer_list>
+#include <string.h>
+
+void NotifyDigest::clear() {
+    _count = 0;
+    _events = 0;
+    _unlisted = 0;
+    _deadline_us = 0;
+}
+
+bool NotifyDigest::contains(uint8_t id) const {
+    for (size_t i = 0; i < _count; i++) {
+        if (_entries[i].id == id) return true;
+    }
+    return false;
+}
+
+void NotifyDigest::add(uint8_t id, int64_t timestamp_us, const char *detail,
+                       int64_t now_us, int64_t window_us) {
+    if (_events == 0) _deadline_us = now_us + window_us;
+    if (_events < UINT32_MAX) _events++;
+
+    Entry *entry = nullptr;
+    for (size_t i = 0; i < _count && !entry; i++) {
+        if (_entries[i].id == id) entry = &_entries[i];
+    }
+    if (!entry) {
+        if (_count == SLOTS) {
+            _unlisted++;
+            return;
+        }
+        entry = &_entries[_count++];
+        entry->id = id;
+        entry->count = 0;
+        entry->first_us = timestamp_us;
+    }
+    if (entry->count < UINT16_MAX) entry->count++;
+    entry->last_us = timestamp_us;
+    if (!detail) detail = "";
+    strncpy(entry->detail, detail, DETAIL_MAX - 1);
+    entry->detail[DETAIL_MAX - 1] = '\0';
+}
+
+uint32_t NotifyKeepAlive::key(const char *url, const char *secret) {
+    // FNV-1a. A collision after a settings change would send one more
+    // notification to the previous endpoint, with its own credentials.
+    uint32_t hash = 2166136261u;
+    for (const char *part : {url, "\n", secret}) {
+        for (const char *p = part ? part : ""; *p; p++) {
+            hash ^= (uint8_t)*p;
+            hash *= 16777619u;
+        }
+    }
+    return hash;
+}
+
+bool NotifyKeepAlive::reusable(int64_t now_us, uint32_t key) const {
+    return _open && key == _key && now_us - _last_us <= _idle_us;
+}
+
+bool NotifyKeepAlive::expired(int64_t now_us) const {
+    return _open && now_us - _last_us > _idle_us;
+}
+
+void NotifyKeepAlive::used(int64_t now_us, uint32_t key) {
+    _open = true;
+    _last_us = now_us;
+    _key = key;
+}
@@ -22,31 +22,668 @@
  */
 
 #include "ntpclient.h"
-#include "esp_sntp.h"
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "lwip/netdb.h"
+#include "metrics.h"
+#include "validation.h"
 
-static Settings *_settings;
-static SystemClock *_clk;
+static const char *TAG = "NtpClient";
 
-static void _time_sync_notification_cb(struct timeval *tv)
+static MetricsCounter g_requests("hbrfeth_ntp_upstream_requests_total",
+                                 "Requests sent to upstream NTP servers");
+static MetricsCounter g_responses("hbrfeth_ntp_upstream_responses_total",
+                                  "Valid responses received from upstream NTP servers");
+
+#define NTP_PACKET_SIZE 48
+#define NTP_UNIX_EPOCH_OFFSET 2208988800ULL
+#define NTP_BURST_INTERVAL_US 2000000LL
+// Samples, peers and combined results farther out than this are unusable.
+#define NTP_MAX_DISTANCE_US 1500000LL
+// Frequency tolerance of the local oscillator (RFC 5905 PHI), in ppm. Used to
+// age the dispersion of stored samples.
+#define NTP_PHI_PPM 15
+// Popcorn spike gate and poll-adjust gate, in multiples of the jitter.
+#define NTP_SGATE 3
+#define NTP_PGATE 4
+#define NTP_POLL_LIMIT 30
+// Floor for the jitter used by the poll-adjust gate: below a millisecond the
+// network and task scheduling noise dominates anyway.
+#define NTP_JITTER_FLOOR_US 1000
+#define NTP_RESOLVE_RETRY_US (60LL * 1000000)
+#define NTP_RESOLVE_UNREACHABLE_US (15LL * 60 * 1000000)
+#define NTP_RESOLVE_INTERVAL_US (24LL * 3600 * 1000000)
+
+static void ntpClientTask(void *parameter)
+{
+    ((NtpClient *)parameter)->_run();
+}
+
+static int64_t unix_now_us()
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static uint64_t read_timestamp(const uint8_t *p)
+{
+    uint64_t ts = 0;
+    for (int i = 0; i < 8; i++) ts = (ts << 8) | p[i];
+    return ts;
+}
+
+static void write_timestamp(uint8_t *p, uint64_t ts)
+{
+    for (int i = 7; i >= 0; i--) {
+        p[i] = (uint8_t)ts;
+        ts >>= 8;
+    }
+}
+
+static uint32_t read_u32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+}
+
+static uint64_t unix_us_to_ntp(int64_t unix_us)
+{
+    uint64_t sec = (uint64_t)(unix_us / 1000000) + NTP_UNIX_EPOCH_OFFSET;
+    uint64_t frac = ((uint64_t)(unix_us % 1000000) << 32) / 1000000;
+    return (sec << 32) | frac;
+}
+
+static int64_t ntp_to_unix_us(uint64_t ts)
+{
+    int64_t sec = (int64_t)(ts >> 32);
+    // Era 1 starts in February 2036; this firmware never runs before 2020.
+    if (sec < (int64_t)NTP_UNIX_EPOCH_OFFSET) sec += 1LL << 32;
+    int64_t usec = (int64_t)(((ts & 0xFFFFFFFFULL) * 1000000) >> 32);
+    return (sec - (int64_t)NTP_UNIX_EPOCH_OFFSET) * 1000000 + usec;
+}
+
+// NTP short format (16.16 seconds) to microseconds.
+static int64_t short_to_us(uint32_t value)
 {
-    _clk->setTime(tv);
+    return ((int64_t)value * 1000000) >> 16;
 }
 
-NtpClient::NtpClient(Settings *settings, SystemClock *clk)
+static bool same_address(const struct sockaddr_storage *a, const struct sockaddr_storage *b)
+{
+    if (a->ss_family != b->ss_family) return false;
+    if (a->ss_family == AF_INET) {
+        const struct sockaddr_in *x = (const struct sockaddr_in *)a;
+        const struct sockaddr_in *y = (const struct sockaddr_in *)b;
+        return x->sin_port == y->sin_port && x->sin_addr.s_addr == y->sin_addr.s_addr;
+    }
+    const struct sockaddr_in6 *x = (const struct sockaddr_in6 *)a;
+    const struct sockaddr_in6 *y = (const struct sockaddr_in6 *)b;
+    return x->sin6_port == y->sin6_port &&
+           memcmp(&x->sin6_addr, &y->sin6_addr, sizeof(x->sin6_addr)) == 0;
+}
+
+// Root distance of a peer (RFC 5905 A.5.5.2): everything that bounds how far
+// its offset can be from the truth.
+static int64_t root_distance(const ntp_peer_t *peer, int64_t now_us)
+{
+    int64_t age = now_us - peer->update_us;
+    return peer->root_distance_us + peer->delay_us / 2 + peer->dispersion_us +
+           age * NTP_PHI_PPM / 1000000 + peer->jitter_us;
+}
+
+NtpClient::NtpClient(Settings *settings, SystemClock *clk) : _settings(settings), _clk(clk)
 {
-    _settings = settings;
-    _clk = clk;
 }
 
 void NtpClient::start()
 {
-    esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    esp_sntp_setservername(0, _settings->getNtpServer());
-    esp_sntp_set_time_sync_notification_cb(_time_sync_notification_cb);
-    esp_sntp_init();
+    if (_tHandle) return;
+    _running = true;
+    if (xTaskCreate(ntpClientTask, "NtpClient", 4096, this, 5, &_tHandle) != pdPASS) {
+        ESP_LOGE(TAG, "Failed to create NTP client task");
+        _running = false;
+        _tHandle = NULL;
+    }
 }
 
 void NtpClient::stop()
 {
-    esp_sntp_stop();
-}
\ No newline at end of file
+    if (!_tHandle) return;
+    _running = false;
+    // The worker wakes at least once per second and owns its sockets.
+    for (int i = 0; i < 30 && _tHandle != NULL; i++) {
+        vTaskDelay(pdMS_TO_TICKS(100));
+    }
+    if (_tHandle != NULL) {
+        ESP_LOGW(TAG, "NTP client still stopping after timeout");
+    }
+}
+
+void NtpClient::resolvePeers()
+{
+    char list[MAX_NTP_SERVER_LENGTH + 1];
+    strncpy(list, _settings->getNtpServer(), sizeof(list) - 1);
+    list[sizeof(list) - 1] = '\0';
+
+    char names[NTP_MAX_PEERS][sizeof(list)];
+    int nameCount = 0;
+    char *saveptr = NULL;
+    for (char *token = strtok_r(list, ",", &saveptr); token && nameCount < NTP_MAX_PEERS;
+         token = strtok_r(NULL, ",", &saveptr)) {
+        while (*token == ' ') token++;
+        size_t l = strlen(token);
+        while (l > 0 && token[l - 1] == ' ') token[--l] = '\0';
+        if (l == 0) continue;
+        strncpy(names[nameCount], token, sizeof(names[0]) - 1);
+        names[nameCount][sizeof(names[0]) - 1] = '\0';
+        nameCount++;
+    }
+
+    // lwIP's resolver returns one address per name, so a lone pool name
+    // would give the selection algorithm a single peer to trust. Expand it
+    // the way ntp.org documents its zones: 0.pool..3.pool.
+    static const char POOL_SUFFIX[] = "pool.ntp.org";
+    if (nameCount == 1) {
+        size_t l = strlen(names[0]);
+        size_t s = sizeof(POOL_SUFFIX) - 1;
+        if (l >= s && strcmp(names[0] + l - s, POOL_SUFFIX) == 0 &&
+            !(names[0][0] >= '0' && names[0][0] <= '9' && names[0][1] == '.') &&
+            l + 2 < sizeof(names[0])) {
+            char base[sizeof(names[0])];
+            strcpy(base, names[0]);
+            for (nameCount = 0; nameCount < NTP_MAX_PEERS; nameCount++) {
+                snprintf(names[nameCount], sizeof(names[0]), "%d.%s", nameCount, base);
+            }
+        }
+    }
+
+    ntp_peer_t resolved[NTP_MAX_PEERS];
+    int count = 0;
+    for (int n = 0; n < nameCount && count < NTP_MAX_PEERS; n++) {
+        char host[sizeof(names[0])];
+        const char *port = "123";
+        strcpy(host, names[n]);
+        char *colon = strrchr(host, ':');
+        if (host[0] == '[') {
+            char *bracket = strchr(host, ']');
+            if (!bracket) continue;
+            *bracket = '\0';
+            if (bracket[1] == ':') port = bracket + 2;
+            memmove(host, host + 1, strlen(host + 1) + 1);
+        } else if (colon && strchr(host, ':') == colon) {
+            *colon = '\0';
+            port = colon + 1;
+        }
+
+        struct addrinfo hints = {};
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_DGRAM;
+        struct addrinfo *res = NULL;
+        if (getaddrinfo(host, port, &hints, &res) != 0 || res == NULL) {
+            ESP_LOGW(TAG, "Could not resolve NTP server %s", names[n]);
+            continue;
+        }
+        for (struct addrinfo *ai = res; ai && count < NTP_MAX_PEERS; ai = ai->ai_next) {
+            if ((ai->ai_family != AF_INET && ai->ai_family != AF_INET6) ||
+                ai->ai_addrlen > sizeof(struct sockaddr_storage)) {
+                continue;
+            }
+            struct sockaddr_storage addr = {};
+            memcpy(&addr, ai->ai_addr, ai->ai_addrlen);
+            bool duplicate = false;
+            for (int i = 0; i < count; i++) {
+                if (same_address(&resolved[i].addr, &addr)) duplicate = true;
+            }
+            if (duplicate) continue;
+
+            // Keep the filter history of a server that is still configured.
+            ntp_peer_t *peer = &resolved[count++];
+            memset(peer, 0, sizeof(*peer));
+            for (int i = 0; i < _peerCount; i++) {
+                if (same_address(&_peers[i].addr, &addr)) {
+                    *peer = _peers[i];
+                    break;
+                }
+            }
+            if (peer->addr_len == 0) {
+                // New server: poll it right away with a short burst.
+                peer->addr = addr;
+                peer->addr_len = ai->ai_addrlen;
+                peer->poll = NTP_MIN_POLL;
+                peer->burst = NTP_BURST_SAMPLES;
+            }
+            strncpy(peer->name, names[n], sizeof(peer->name) - 1);
+            peer->name[sizeof(peer->name) - 1] = '\0';
+        }
+        freeaddrinfo(res);
+    }
+
+    memcpy(_peers, resolved, sizeof(ntp_peer_t) * count);
+    _peerCount = count;
+
+    int64_t now = esp_timer_get_time();
+    _lastResolve_us = now;
+    _nextResolve_us = now + (count > 0 ? NTP_RESOLVE_INTERVAL_US : NTP_RESOLVE_RETRY_US);
+    if (count == 0) {
+        ESP_LOGE(TAG, "No NTP server could be resolved, retrying in %lld s",
+                 NTP_RESOLVE_RETRY_US / 1000000);
+    } else {
+        ESP_LOGI(TAG, "Polling %d NTP server address(es)", count);
+    }
+}
+
+int64_t NtpClient::peerInterval(const ntp_peer_t *peer)
+{
+    int8_t poll = peer->poll > _poll ? peer->poll : _poll;
+    return (1LL << poll) * 1000000;
+}
+
+void NtpClient::sendRequest(ntp_peer_t *peer, int64_t now_us)
+{
+    int *sock = peer->addr.ss_family == AF_INET6 ? &_sock6 : &_sock4;
+    if (*sock < 0) {
+        *sock = socket(peer->addr.ss_family, SOCK_DGRAM, IPPROTO_UDP);
+        if (*sock < 0) {
+            ESP_LOGE(TAG, "socket() failed");
+            peer->next_poll_us = now_us + NTP_BURST_INTERVAL_US;
+            return;
+        }
+    }
+
+    uint8_t packet[NTP_PACKET_SIZE] = {};
+    packet[0] = (0 << 6) | (4 << 3) | 3; // no leap warning, version 4, mode client
+    packet[2] = (uint8_t)(peer->poll > _poll ? peer->poll : _poll);
+    peer->t1_us = unix_now_us();
+    peer->xmt = unix_us_to_ntp(peer->t1_us);
+    write_timestamp(packet + 40, peer->xmt);
+
+    // Shift the reachability register; a valid response sets bit 0 again.
+    peer->reach <<= 1;
+    if (peer->burst > 0) {
+        peer->burst--;
+        peer->next_poll_us = now_us + NTP_BURST_INTERVAL_US;
+    } else {
+        peer->next_poll_us = now_us + peerInterval(peer);
+    }
+
+    if (sendto(*sock, packet, sizeof(packet), 0, (struct sockaddr *)&peer->addr,
+               peer->addr_len) != (int)sizeof(packet)) {
+        ESP_LOGD(TAG, "sendto %s failed: errno %d", peer->name, errno);
+        peer->xmt = 0;
+        return;
+    }
+    g_requests.inc();
+}
+
+void NtpClient::receiveResponse(int sock)
+{
+    uint8_t packet[NTP_PACKET_SIZE + 20];
+    struct sockaddr_storage from = {};
+    socklen_t fromLen = sizeof(from);
+    int len = recvfrom(sock, packet, sizeof(packet), MSG_DONTWAIT, (struct sockaddr *)&from,
+                       &fromLen);
+    int64_t t4 = unix_now_us();
+    if (len < NTP_PACKET_SIZE) return;
+
+    ntp_peer_t *peer = NULL;
+    for (int i = 0; i < _peerCount; i++) {
+        if (same_address(&_peers[i].addr, &from)) {
+            peer = &_peers[i];
+            break;
+        }
+    }
+    // Reject bogus, duplicate and replayed packets: the origin timestamp must
+    // echo the one request we have outstanding.
+    if (!peer || peer->xmt == 0 || read_timestamp(packet + 24) != peer->xmt) return;
+    peer->xmt = 0;
+
+    uint8_t leap = packet[0] >> 6;
+    uint8_t mode = packet[0] & 7;
+    uint8_t stratum = packet[1];
+    if (mode != 4) return;
+
+    if (stratum == 0) {
+        // Kiss-o'-Death (RFC 5905 section 7.4).
+        if (memcmp(packet + 12, "RATE", 4) == 0) {
+            int8_t poll = (peer->poll > _poll ? peer->poll : _poll) + 1;
+            peer->poll = poll > NTP_MAX_POLL ? NTP_MAX_POLL : poll;
+            peer->burst = 0;
+            peer->next_poll_us = esp_timer_get_time() + peerInterval(peer);
+            ESP_LOGW(TAG, "%s asked us to slow down, poll now %d s", peer->name, 1 << peer->poll);
+        } else if (memcmp(packet + 12, "DENY", 4) == 0 || memcmp(packet + 12, "RSTR", 4) == 0) {
+            peer->denied = true;
+            ESP_LOGW(TAG, "%s denied access, no longer polled", peer->name);
+        }
+        return;
+    }
+    if (leap == 3 || stratum > 15) return; // server not synchronized
+
+    uint64_t recvTs = read_timestamp(packet + 32);
+    uint64_t xmitTs = read_timestamp(packet + 40);
+    if (recvTs == 0 || xmitTs == 0) return;
+
+    int64_t rootDistance = short_to_us(read_u32(packet + 4)) / 2 + short_to_us(read_u32(packet + 8));
+    if (rootDistance > NTP_MAX_DISTANCE_US) return;
+
+    int64_t t1 = peer->t1_us;
+    int64_t t2 = ntp_to_unix_us(recvTs);
+    int64_t t3 = ntp_to_unix_us(xmitTs);
+
+    ntp_sample_t sample;
+    sample.offset_us = ((t2 - t1) + (t3 - t4)) / 2;
+    sample.delay_us = (t4 - t1) - (t3 - t2);
+    if (sample.delay_us < 1) sample.delay_us = 1;
+    int8_t precision = (int8_t)packet[3];
+    int64_t serverPrecision = precision >= 0 ? 1000000LL << (precision > 8 ? 8 : precision)
+                                             : 1000000LL >> (precision < -20 ? 20 : -precision);
+    sample.dispersion_us = serverPrecision + 1 + (t4 - t1) * NTP_PHI_PPM / 1000000;
+    sample.epoch_us = esp_timer_get_time();
+
+    peer->reach |= 1;
+    peer->stratum = stratum;
+    peer->root_distance_us = rootDistance;
+    g_responses.inc();
+
+    ESP_LOGD(TAG, "%s: offset %lld us, delay %lld us", peer->name, (long long)sample.offset_us,
+             (long long)sample.delay_us);
+
+    clockFilter(peer, &sample);
+    clockSelect();
+}
+
+void NtpClient::clockFilter(ntp_peer_t *peer, const ntp_sample_t *sample)
+{
+    // Popcorn spike suppressor: once the filter has settled, a single sample
+    // far outside the jitter is ignored. The next one is accepted regardless,
+    // so a genuine change of the path cannot lock the peer out.
+    if (peer->filter_count >= NTP_BURST_SAMPLES && !peer->spike &&
+        llabs(sample->offset_us - peer->offset_us) >
+            NTP_SGATE * (peer->jitter_us > NTP_JITTER_FLOOR_US ? peer->jitter_us
+                                                               : NTP_JITTER_FLOOR_US)) {
+        peer->spike = true;
+        ESP_LOGD(TAG, "%s: popcorn spike %lld us ignored", peer->name,
+                 (long long)sample->offset_us);
+        return;
+    }
+    peer->spike = false;
+
+    peer->filter[peer->filter_next] = *sample;
+    peer->filter_next = (peer->filter_next + 1) % NTP_FILTER_STAGES;
+    if (peer->filter_count < NTP_FILTER_STAGES) peer->filter_count++;
+    if (peer->filter_count >= NTP_BURST_SAMPLES) peer->burst = 0;
+
+    // Order the stored samples by delay: the shortest round trip has the
+    // least asymmetry and therefore the most trustworthy offset.
+    uint8_t order[NTP_FILTER_STAGES];
+    for (uint8_t i = 0; i < peer->filter_count; i++) {
+        uint8_t j = i;
+        while (j > 0 && peer->filter[order[j - 1]].delay_us > peer->filter[i].delay_us) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+
+    const int64_t now = esp_timer_get_time();
+    const ntp_sample_t *best = &peer->filter[order[0]];
+    peer->offset_us = best->offset_us;
+    peer->delay_us = best->delay_us;
+    peer->update_us = best->epoch_us;
+
+    int64_t dispersion = 0;
+    double jitter = 0;
+    for (int i = peer->filter_count - 1; i >= 0; i--) {
+        const ntp_sample_t *s = &peer->filter[order[i]];
+        int64_t aged = s->dispersion_us + (now - s->epoch_us) * NTP_PHI_PPM / 1000000;
+        dispersion = (dispersion + aged) / 2;
+        double d = (double)(s->offset_us - best->offset_us);
+        jitter += d * d;
+    }
+    peer->dispersion_us = dispersion;
+    peer->jitter_us = peer->filter_count > 1 ? (int64_t)sqrt(jitter / (peer->filter_count - 1)) : 0;
+}
+
+void NtpClient::clockSelect()
+{
+    const int64_t now = esp_timer_get_time();
+
+    // Candidates: reachable peers with a usable root distance. Before the
+    // first sync wait for two samples so the initial step is not taken on a
+    // single round trip.
+    ntp_peer_t *candidates[NTP_MAX_PEERS];
+    int64_t distance[NTP_MAX_PEERS];
+    int n = 0;
+    for (int i = 0; i < _peerCount; i++) {
+        ntp_peer_t *peer = &_peers[i];
+        if (peer->denied || peer->reach == 0 || peer->filter_count < (_synced ? 1 : 2)) continue;
+        int64_t lambda = root_distance(peer, now);
+        if (lambda > NTP_MAX_DISTANCE_US) continue;
+        candidates[n] = peer;
+        distance[n] = lambda;
+        n++;
+    }
+    if (n == 0) return;
+
+    // Intersection algorithm (RFC 5905 section 11.2.1): find the smallest
+    // interval containing points from the largest number of correctness
+    // intervals [offset - lambda, offset + lambda].
+    struct Endpoint {
+        int64_t value;
+        int type;
+    } endpoints[NTP_MAX_PEERS * 3];
+    int e = 0;
+    for (int i = 0; i < n; i++) {
+        endpoints[e++] = { candidates[i]->offset_us - distance[i], +1 };
+        endpoints[e++] = { candidates[i]->offset_us, 0 };
+        endpoints[e++] = { candidates[i]->offset_us + distance[i], -1 };
+    }
+    for (int i = 1; i < e; i++) {
+        Endpoint key = endpoints[i];
+        int j = i - 1;
+        while (j >= 0 && endpoints[j].value > key.value) {
+            endpoints[j + 1] = endpoints[j];
+            j--;
+        }
+        endpoints[j + 1] = key;
+    }
+
+    int64_t low = 0;
+    int64_t high = 0;
+    bool found = false;
+    for (int allow = 0; 2 * allow < n; allow++) {
+        int chime = 0;
+        int midpoints = 0;
+        low = INT64_MAX;
+        for (int i = 0; i < e; i++) {
+            chime += endpoints[i].type;
+            if (chime >= n - allow) {
+                low = endpoints[i].value;
+                break;
+            }
+            if (endpoints[i].type == 0) midpoints++;
+        }
+        chime = 0;
+        high = INT64_MIN;
+        for (int i = e - 1; i >= 0; i--) {
+            chime -= endpoints[i].type;
+            if (chime >= n - allow) {
+                high = endpoints[i].value;
+                break;
+            }
+            if (endpoints[i].type == 0) midpoints++;
+        }
+        if (midpoints <= allow && low < high) {
+            found = true;
+            break;
+        }
+    }
+    if (!found) {
+        ESP_LOGW(TAG, "No majority among %d NTP servers, clock left alone", n);
+        return;
+    }
+
+    // Combine the survivors, weighted by the inverse of their root distance.
+    double weightSum = 0;
+    double offsetSum = 0;
+    int best = -1;
+    int64_t newest = 0;
+    for (int i = 0; i < n; i++) {
+        if (candidates[i]->offset_us < low || candidates[i]->offset_us > high) continue;
+        double w = 1.0 / (double)(distance[i] > 0 ? distance[i] : 1);
+        weightSum += w;
+        offsetSum += w * (double)candidates[i]->offset_us;
+        if (best < 0 || distance[i] < distance[best]) best = i;
+        if (candidates[i]->update_us > newest) newest = candidates[i]->update_us;
+    }
+    if (best < 0 || newest <= _lastApplied_us) return;
+    _lastApplied_us = newest;
+
+    int64_t offset = (int64_t)(offsetSum / weightSum);
+    double selectionJitter = 0;
+    for (int i = 0; i < n; i++) {
+        if (candidates[i]->offset_us < low || candidates[i]->offset_us > high) continue;
+        double d = (double)(candidates[i]->offset_us - candidates[best]->offset_us);
+        selectionJitter += d * d / (double)(distance[i] > 0 ? distance[i] : 1) / weightSum;
+    }
+    double peerJitter = (double)candidates[best]->jitter_us;
+    int64_t jitter = (int64_t)sqrt(peerJitter * peerJitter + selectionJitter);
+    // Path asymmetry can hide up to half the round trip in the offset.
+    int64_t error = jitter + candidates[best]->delay_us / 2;
+    uint32_t error_us = error > UINT32_MAX ? UINT32_MAX : (uint32_t)error;
+
+    if (!_synced || llabs(offset) > NTP_STEP_THRESHOLD_US) {
+        struct timeval tv;
+        int64_t target = unix_now_us() + offset;
+        tv.tv_sec = (time_t)(target / 1000000);
+        tv.tv_usec = (suseconds_t)(target % 1000000);
+        _clk->setTime(&tv, error_us);
+        ESP_LOGI(TAG, "Clock stepped by %lld ms (%s, stratum %d)", (long long)(offset / 1000),
+                 candidates[best]->name, candidates[best]->stratum);
+
+        // Every stored sample and outstanding request refers to the old
+        // timescale. Start over with a fresh burst against the new one.
+        for (int i = 0; i < _peerCount; i++) {
+            _peers[i].filter_count = 0;
+            _peers[i].filter_next = 0;
+            _peers[i].xmt = 0;
+            _peers[i].spike = false;
+            if (!_peers[i].denied) {
+                _peers[i].burst = NTP_BURST_SAMPLES;
+                _peers[i].next_poll_us = now + NTP_BURST_INTERVAL_US;
+            }
+        }
+        _synced = true;
+        _lastApplied_us = now;
+        return;
+    }
+
+    _clk->adjustTime(offset, error_us);
+    ESP_LOGD(TAG, "Clock slewed by %lld us (jitter %lld us, poll %d s)", (long long)offset,
+             (long long)jitter, 1 << _poll);
+
+    // The correction is being removed from the clock; shift the history so
+    // the next selection does not apply it a second time.
+    for (int i = 0; i < _peerCount; i++) {
+        for (int s = 0; s < _peers[i].filter_count; s++) {
+            _peers[i].filter[s].offset_us -= offset;
+        }
+        _peers[i].offset_us -= offset;
+    }
+
+    adjustPoll(offset, jitter);
+}
+
+void NtpClient::adjustPoll(int64_t offset_us, int64_t jitter_us)
+{
+    // RFC 5905 A.5.5.3: lengthen the poll interval while the corrections stay
+    // within the noise, shorten it quickly when they do not.
+    if (jitter_us < NTP_JITTER_FLOOR_US) jitter_us = NTP_JITTER_FLOOR_US;
+    if (llabs(offset_us) < NTP_PGATE * jitter_us) {
+        _pollCounter += _poll;
+        if (_pollCounter > NTP_POLL_LIMIT) {
+            _pollCounter = 0;
+            if (_poll < NTP_MAX_POLL) {
+                _poll++;
+                ESP_LOGI(TAG, "Clock stable, poll interval now %d s", 1 << _poll);
+            }
+        }
+    } else {
+        _pollCounter -= 2 * _poll;
+        if (_pollCounter < -NTP_POLL_LIMIT) {
+            _pollCounter = 0;
+            if (_poll > NTP_MIN_POLL) {
+                _poll--;
+                ESP_LOGI(TAG, "Clock unstable, poll interval now %d s", 1 << _poll);
+            }
+        }
+    }
+}
+
+void NtpClient::_run()
+{
+    while (_running) {
+        int64_t now = esp_timer_get_time();
+
+        bool reachable = false;
+        for (int i = 0; i < _peerCount; i++) {
+            if (_peers[i].reach != 0) reachable = true;
+        }
+        if (now >= _nextResolve_us ||
+            (!reachable && now - _lastResolve_us >= NTP_RESOLVE_UNREACHABLE_US)) {
+            resolvePeers();
+            if (_peerCount == 0) {
+                vTaskDelay(pdMS_TO_TICKS(1000));
+                continue;
+            }
+        }
+
+        int64_t wake = now + 1000000;
+        for (int i = 0; i < _peerCount; i++) {
+            ntp_peer_t *peer = &_peers[i];
+            if (peer->denied) continue;
+            if (now >= peer->next_poll_us) sendRequest(peer, now);
+            if (peer->next_poll_us < wake) wake = peer->next_poll_us;
+        }
+
+        fd_set readable;
+        FD_ZERO(&readable);
+        int maxfd = -1;
+        if (_sock4 >= 0) {
+            FD_SET(_sock4, &readable);
+            maxfd = _sock4;
+        }
+        if (_sock6 >= 0) {
+            FD_SET(_sock6, &readable);
+            if (_sock6 > maxfd) maxfd = _sock6;
+        }
+
+        int64_t waitUs = wake - esp_timer_get_time();
+        if (waitUs < 10000) waitUs = 10000;
+        if (waitUs > 1000000) waitUs = 1000000;
+        if (maxfd < 0) {
+            vTaskDelay(pdMS_TO_TICKS(waitUs / 1000));
+            continue;
+        }
+        struct timeval timeout = { .tv_sec = 0, .tv_usec = (suseconds_t)waitUs };
+        if (waitUs >= 1000000) {
+            timeout.tv_sec = 1;
+            timeout.tv_usec = 0;
+        }
+        if (select(maxfd + 1, &readable, NULL, NULL, &timeout) <= 0) continue;
+        if (_sock4 >= 0 && FD_ISSET(_sock4, &readable)) receiveResponse(_sock4);
+        if (_sock6 >= 0 && FD_ISSET(_sock6, &readable)) receiveResponse(_sock6);
+    }
+
+    if (_sock4 >= 0) close(_sock4);
+    if (_sock6 >= 0) close(_sock6);
+    _sock4 = -1;
+    _sock6 = -1;
+    _tHandle = NULL;
+    vTaskDelete(NULL);
+}
@@ -23,11 +23,26 @@
 
 #include "ntpserver.h"
 #include <string.h>
+#include <stdio.h>
 #include "esp_log.h"
+#include "esp_timer.h"
 #include "udphelper.h"
+#include "metrics.h"
+#include "prometheus_text.h"
 
 static const char *TAG = "NtpServer";
 
+static MetricsCounter g_ntp_requests("hbrfeth_ntp_requests_total",
+                                     "NTP requests received on port 123");
+static MetricsCounter g_ntp_kod("hbrfeth_ntp_kod_total",
+                                "RATE Kiss-o'-Death responses sent to clients over their limit");
+static MetricsCounter g_ntp_drops("hbrfeth_ntp_drop_total",
+                                  "NTP requests dropped (rate limited or queue full)");
+
+// The exporter renders the per-client table of the one server instance that
+// is bound to port 123.
+static NtpServer *s_instance = NULL;
+
 void _ntp_udpQueueHandlerTask(void *parameter)
 {
     ((NtpServer *)parameter)->_udpQueueHandler();
@@ -53,13 +68,136 @@ inline tstamp convertToNtp(struct timeval *tv)
     return (unsigned long long)tv->tv_sec + (((unsigned long long)tv->tv_usec) << 32);
 }
 
-void NtpServer::handlePacket(pbuf *pb, ip4_addr_t addr, uint16_t port)
+static inline uint32_t now_ms()
+{
+    return (uint32_t)(esp_timer_get_time() / 1000);
+}
+
+static inline uint32_t client_hash(uint32_t addr)
+{
+    // Fibonacci hashing spreads the low-entropy host part of a /24 across the
+    // whole table.
+    return (addr * 2654435769u) >> (32 - NTP_CLIENT_TABLE_BITS);
+}
+
+ntp_admit_t NtpServer::admitClient(uint32_t addr)
+{
+    const uint32_t now = now_ms();
+    const uint32_t home = client_hash(addr);
+    ntp_admit_t verdict = NTP_ADMIT_SERVE;
+
+    portENTER_CRITICAL(&_clientMux);
+    ntp_client_entry_t *entry = NULL;
+    ntp_client_entry_t *victim = NULL;
+    for (uint32_t i = 0; i < NTP_CLIENT_PROBE_LIMIT; i++) {
+        ntp_client_entry_t *slot = &_clients[(home + i) & (NTP_CLIENT_TABLE_SIZE - 1)];
+        if (slot->addr == addr) {
+            entry = slot;
+            break;
+        }
+        if (slot->addr == 0) {
+            if (!victim || victim->addr != 0) victim = slot;
+        } else if (!victim || (victim->addr != 0 &&
+                               (uint32_t)(now - slot->last_seen_ms) >
+                                   (uint32_t)(now - victim->last_seen_ms))) {
+            victim = slot;
+        }
+    }
+    if (!entry) {
+        entry = victim;
+        memset(entry, 0, sizeof(*entry));
+        entry->addr = addr;
+        entry->tokens = NTP_RATE_BURST;
+        entry->refill_ms = now;
+    }
+
+    uint32_t refills = (now - entry->refill_ms) / NTP_RATE_REFILL_MS;
+    if (refills > 0) {
+        uint32_t tokens = entry->tokens + refills;
+        entry->tokens = tokens > NTP_RATE_BURST ? NTP_RATE_BURST : (uint8_t)tokens;
+        entry->refill_ms += refills * NTP_RATE_REFILL_MS;
+    }
+    if (entry->tokens == NTP_RATE_BURST) {
+        entry->refill_ms = now;
+    }
+
+    entry->last_seen_ms = now;
+    entry->requests++;
+    if (entry->tokens > 0) {
+        entry->tokens--;
+    } else {
+        entry->limited++;
+        // One KoD per refill interval is enough for a compliant client to back
+        // off; answering every excess request would just echo the flood.
+        if (!entry->kod_sent || (uint32_t)(now - entry->last_kod_ms) >= NTP_RATE_REFILL_MS) {
+            entry->kod_sent = true;
+            entry->last_kod_ms = now;
+            verdict = NTP_ADMIT_KOD;
+        } else {
+            verdict = NTP_ADMIT_DROP;
+        }
+    }
+    portEXIT_CRITICAL(&_clientMux);
+
+    return verdict;
+}
+
+size_t NtpServer::getClients(ntp_client_entry_t *out)
+{
+    size_t count = 0;
+    portENTER_CRITICAL(&_clientMux);
+    for (int i = 0; i < NTP_CLIENT_TABLE_SIZE; i++) {
+        if (_clients[i].addr != 0) {
+            out[count++] = _clients[i];
+        }
+    }
+    portEXIT_CRITICAL(&_clientMux);
+    return count;
+}
+
+size_t ntp_server_render_prometheus(char *out, size_t cap, size_t offset, size_t *resume)
+{
+    PrometheusText text(out, cap, offset, resume);
+
+    NtpServer *server = s_instance;
+    if (!server) return text.finish();
+
+    ntp_client_entry_t clients[NTP_CLIENT_TABLE_SIZE];
+    size_t count = server->getClients(clients);
+    if (count == 0) return text.finish();
+
+#define EMIT(...) text.emit(__VA_ARGS__)
+
+    char ip[16];
+    EMIT("# HELP hbrfeth_ntp_client_requests_total NTP requests per tracked client\n");
+    EMIT("# TYPE hbrfeth_ntp_client_requests_total counter\n");
+    for (size_t i = 0; i < count; i++) {
+        ip4_addr_t addr = { .addr = clients[i].addr };
+        ip4addr_ntoa_r(&addr, ip, sizeof(ip));
+        EMIT("hbrfeth_ntp_client_requests_total{client=\"%s\"} %u\n", ip,
+             (unsigned)clients[i].requests);
+    }
+    text.endPart();
+    EMIT("# HELP hbrfeth_ntp_client_limited_total NTP requests refused by the per-client rate limit\n");
+    EMIT("# TYPE hbrfeth_ntp_client_limited_total counter\n");
+    for (size_t i = 0; i < count; i++) {
+        ip4_addr_t addr = { .addr = clients[i].addr };
+        ip4addr_ntoa_r(&addr, ip, sizeof(ip));
+        EMIT("hbrfeth_ntp_client_limited_total{client=\"%s\"} %u\n", ip,
+             (unsigned)clients[i].limited);
+    }
+#undef EMIT
+
+    return text.finish();
+}
+
+void NtpServer::handlePacket(pbuf *pb, ip4_addr_t addr, uint16_t port, bool kod)
 {
     struct timeval tv = _clk->getTime();
     tstamp recv = convertToNtp(&tv);
 
     struct timeval lastSync = _clk->getLastSyncTime();
-    if (lastSync.tv_sec < 1577836800l) // 2020-01-01 00:00:00 GMT
+    if (!kod && lastSync.tv_sec < 1577836800l) // 2020-01-01 00:00:00 GMT
     {
         ESP_LOGE(TAG, "Ignoring ntp request because local time is not set");
         return;
@@ -87,6 +225,31 @@ void NtpServer::handlePacket(pbuf *pb, ip4_addr_t addr, uint16_t port)
     resp_addr.type = IPADDR_TYPE_V4;
     resp_addr.u_addr.ip4 = addr;
 
+    if (kod)
+    {
+        // Kiss-o'-Death: leap indicator "alarm", stratum 0 and the kiss code
+        // in the reference id. Only the origin timestamp is meaningful, so the
+        // client can match the kiss to its outstanding request.
+        ntp.flags = 3 << 6 | 4 << 3 | 4;
+        ntp.stratum = 0;
+        // Advertise the sustainable poll exponent (2^3 s = NTP_RATE_REFILL_MS).
+        if (ntp.poll < 3)
+            ntp.poll = 3;
+        ntp.precision = 0;
+        ntp.delay = 0;
+        ntp.dispersion = 0;
+        memcpy(ntp.ref_id, "RATE", sizeof(ntp.ref_id));
+        ntp.orig_time = ntp.trns_time;
+        ntp.ref_time = 0;
+        ntp.recv_time = 0;
+        ntp.trns_time = 0;
+
+        g_ntp_kod.inc();
+        _udp_sendto(_pcb, resp_pb, &resp_addr, port);
+        pbuf_free(resp_pb);
+        return;
+    }
+
     ntp.flags = 4 << 3 | 4; // version 4, mode server
     ntp.stratum = 15;       // Prefer other ntp server over us
     ntp.poll = 8;
@@ -108,7 +271,7 @@ void NtpServer::start()
 {
     if (_tHandle || _pcb || _udp_queue) return;
 
-    _udp_queue = xQueueCreate(32, sizeof(udp_event_t *));
+    _udp_queue = xQueueCreate(32, sizeof(ntp_request_t));
     if (!_udp_queue) {
         ESP_LOGE(TAG, "Failed to create NTP queue");
         return;
@@ -122,12 +285,14 @@ void NtpServer::start()
         _udp_queue = NULL;
         return;
     }
+    s_instance = this;
     _udp_recv(_pcb, &_ntp_udpReceivePaket, (void *)this);
 
     if (xTaskCreate(_ntp_udpQueueHandlerTask, "NTPServer_UDP_QueueHandler",
                     4096, this, 10, &_tHandle) != pdPASS) {
         ESP_LOGE(TAG, "Failed to create NTP server task");
         _udp_recv(_pcb, NULL, NULL);
+        s_instance = NULL;
         _udp_remove(_pcb);
         _pcb = NULL;
         vQueueDelete(_udp_queue);
@@ -143,15 +308,15 @@ void NtpServer::stop()
         _udp_remove(_pcb);
         _pcb = NULL;
     }
+    s_instance = NULL;
     if (_tHandle) {
         vTaskDelete(_tHandle);
         _tHandle = NULL;
     }
     if (_udp_queue) {
-        udp_event_t *event = NULL;
-        while (xQueueReceive(_udp_queue, &event, 0) == pdTRUE) {
-            pbuf_free(event->pb);
-            free(event);
+        ntp_request_t request;
+        while (xQueueReceive(_udp_queue, &request, 0) == pdTRUE) {
+            pbuf_free(request.pb);
         }
         vQueueDelete(_udp_queue);
         _udp_queue = NULL;
@@ -160,40 +325,44 @@ void NtpServer::stop()
 
 void NtpServer::_udpQueueHandler()
 {
-    udp_event_t *event = NULL;
+    ntp_request_t request;
 
     for (;;)
     {
-        if (xQueueReceive(_udp_queue, &event, portMAX_DELAY) == pdTRUE)
+        if (xQueueReceive(_udp_queue, &request, portMAX_DELAY) == pdTRUE)
         {
-            handlePacket(event->pb, event->addr, event->port);
-            pbuf_free(event->pb);
-            free(event);
+            handlePacket(request.pb, request.addr, request.port, request.kod);
+            pbuf_free(request.pb);
         }
     }
 }
 
 bool NtpServer::_udpReceivePacket(pbuf *pb, const ip_addr_t *addr, uint16_t port)
 {
-    udp_event_t *e = (udp_event_t *)malloc(sizeof(udp_event_t));
-    if (!e)
-    {
-        return false;
-    }
+    g_ntp_requests.inc();
 
-    e->pb = pb;
+    ntp_request_t request;
+    request.pb = pb;
 
     // Use the source address and port provided directly by lwIP in the callback
     // instead of reading raw pbuf header memory (which is unsafe and fragile).
-    e->addr.addr = addr->u_addr.ip4.addr;
-    e->port = port;
+    request.addr.addr = addr->u_addr.ip4.addr;
+    request.port = port;
+
+    ntp_admit_t verdict = admitClient(request.addr.addr);
+    if (verdict == NTP_ADMIT_DROP)
+    {
+        g_ntp_drops.inc();
+        return false;
+    }
+    request.kod = verdict == NTP_ADMIT_KOD;
 
     // Runs in the lwIP tcpip thread - never block here. If the queue is full
     // (e.g. NTP request flood), drop the packet instead of freezing the whole
     // network stack including the latency-critical raw-uart UDP bridge.
-    if (xQueueSend(_udp_queue, &e, 0) != pdPASS)
+    if (xQueueSend(_udp_queue, &request, 0) != pdPASS)
     {
-        free((void *)(e));
+        g_ntp_drops.inc();
         return false;
     }
     return true;
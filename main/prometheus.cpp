@@ -23,11 +23,16 @@
 
 #include "prometheus.h"
 #include "metrics.h"
+#include "prometheus_text.h"
 #include "monitoring.h"
 #include "sysinfo.h"
 #include "ethernet.h"
 #include "radiomoduledetector.h"
 #include "mqtt_handler.h"
+#include "ntpserver.h"
+#include "rawuartudplistener.h"
+#include "systemclock.h"
+#include "log_manager.h"
 #include "esp_app_desc.h"
 #include "esp_log.h"
 #include "esp_timer.h"
@@ -39,6 +44,7 @@
 #include "freertos/semphr.h"
 #include "lwip/sockets.h"
 #include <atomic>
+#include <inttypes.h>
 #include <string.h>
 #include <errno.h>
 #include <stdio.h>
@@ -48,6 +54,7 @@
 extern SysInfo *monitoring_get_sysinfo(void);
 extern Ethernet *monitoring_get_ethernet(void);
 extern RadioModuleDetector *monitoring_get_radiomodule(void);
+extern SystemClock *monitoring_get_systemclock(void);
 
 static const char *TAG = "prometheus";
 
@@ -109,18 +116,13 @@ static bool send_all_with_deadline(int sock, const char *data, size_t len,
     return len == 0;
 }
 
-// Render the static (non-counter) section. Counters are appended afterwards
-// by metrics_render_prometheus() to avoid duplicating the table layout here.
-static size_t render_static(char *out, size_t cap)
+// Render the static (non-counter) section, one part per metric family.
+// Counters follow from metrics_render_prometheus_part() to avoid
+// duplicating the table layout here.
+static size_t render_static(char *out, size_t cap, size_t offset, size_t *resume)
 {
-    if (cap == 0) return 0;
-    size_t len = 0;
-#define EMIT(...) do { \
-        if (len + 1 < cap) { \
-            int n = snprintf(out + len, cap - len, __VA_ARGS__); \
-            if (n > 0) len += (size_t)n < (cap - len) ? (size_t)n : (cap - len - 1); \
-        } \
-    } while (0)
+    PrometheusText text(out, cap, offset, resume);
+#define EMIT(...) text.emit(__VA_ARGS__)
 
     const esp_app_desc_t *desc = esp_app_get_description();
     EMIT("# HELP hbrfeth_info Firmware / build identification\n");
@@ -128,11 +130,13 @@ static size_t render_static(char *out, size_t cap)
     EMIT("hbrfeth_info{version=\"%s\",project=\"%s\"} 1\n",
          desc ? desc->version : "unknown",
          desc ? desc->project_name : "hb-rf-eth-ng");
+    text.endPart();
 
     uint64_t uptime_s = (uint64_t)(esp_timer_get_time() / 1000000ULL);
     EMIT("# HELP hbrfeth_uptime_seconds Device uptime since boot\n");
     EMIT("# TYPE hbrfeth_uptime_seconds counter\n");
     EMIT("hbrfeth_uptime_seconds %llu\n", (unsigned long long)uptime_s);
+    text.endPart();
 
     EMIT("# HELP hbrfeth_heap_free_bytes Free heap in bytes\n");
     EMIT("# TYPE hbrfeth_heap_free_bytes gauge\n");
@@ -140,11 +144,13 @@ static size_t render_static(char *out, size_t cap)
          (unsigned)heap_caps_get_free_size(MALLOC_CAP_INTERNAL));
     EMIT("hbrfeth_heap_free_bytes{type=\"default\"} %u\n",
          (unsigned)heap_caps_get_free_size(MALLOC_CAP_DEFAULT));
+    text.endPart();
 
     EMIT("# HELP hbrfeth_heap_largest_free_block Largest contiguous free block\n");
     EMIT("# TYPE hbrfeth_heap_largest_free_block gauge\n");
     EMIT("hbrfeth_heap_largest_free_block %u\n",
          (unsigned)heap_caps_get_largest_free_block(MALLOC_CAP_DEFAULT));
+    text.endPart();
 
     // NVS occupancy. The partition is 16 KiB and now holds MQTT credentials,
     // TLS key material, theme state and the WebUI record alongside the device
@@ -166,6 +172,7 @@ static size_t render_static(char *out, size_t cap)
             EMIT("hbrfeth_nvs_namespaces %u\n", (unsigned)nvs.namespace_count);
         }
     }
+    text.endPart();
 
     SysInfo *si = monitoring_get_sysinfo();
     if (si) {
@@ -176,15 +183,18 @@ static size_t render_static(char *out, size_t cap)
         EMIT("# TYPE hbrfeth_memory_usage_percent gauge\n");
         EMIT("hbrfeth_memory_usage_percent %.2f\n", si->getMemoryUsage());
     }
+    text.endPart();
 
     Ethernet *eth = monitoring_get_ethernet();
     EMIT("# HELP hbrfeth_eth_link_up Ethernet link state (1=up, 0=down)\n");
     EMIT("# TYPE hbrfeth_eth_link_up gauge\n");
     EMIT("hbrfeth_eth_link_up %d\n", eth ? (eth->isConnected() ? 1 : 0) : 0);
+    text.endPart();
 
     EMIT("# HELP hbrfeth_mqtt_connected MQTT broker connection state (1=connected)\n");
     EMIT("# TYPE hbrfeth_mqtt_connected gauge\n");
     EMIT("hbrfeth_mqtt_connected %d\n", mqtt_handler_is_connected() ? 1 : 0);
+    text.endPart();
 
     RadioModuleDetector *rmd = monitoring_get_radiomodule();
     if (rmd) {
@@ -196,8 +206,53 @@ static size_t render_static(char *out, size_t cap)
         EMIT("# TYPE hbrfeth_rf_module gauge\n");
         EMIT("hbrfeth_rf_module{type=\"%s\"} %d\n", type, t != RADIO_MODULE_NONE ? 1 : 0);
     }
+    text.endPart();
+
+    SystemClock *clk = monitoring_get_systemclock();
+    if (clk) {
+        clock_discipline_t d = clk->getDiscipline();
+        EMIT("# HELP hbrfeth_clock_drift_ppm Estimated crystal frequency error (positive = fast)\n");
+        EMIT("# TYPE hbrfeth_clock_drift_ppm gauge\n");
+        EMIT("hbrfeth_clock_drift_ppm %.3f\n", d.drift_ppm);
+        EMIT("# HELP hbrfeth_clock_drift_locked Drift compensation active (1=locked)\n");
+        EMIT("# TYPE hbrfeth_clock_drift_locked gauge\n");
+        EMIT("hbrfeth_clock_drift_locked %d\n", d.locked ? 1 : 0);
+        if (d.error_us >= 0) {
+            EMIT("# HELP hbrfeth_clock_offset_seconds Offset measured at the last sync (reference minus local)\n");
+            EMIT("# TYPE hbrfeth_clock_offset_seconds gauge\n");
+            EMIT("hbrfeth_clock_offset_seconds %.6f\n", (double)d.offset_us / 1e6);
+            EMIT("# HELP hbrfeth_clock_estimated_error_seconds Estimated current clock error including holdover\n");
+            EMIT("# TYPE hbrfeth_clock_estimated_error_seconds gauge\n");
+            EMIT("hbrfeth_clock_estimated_error_seconds %.6f\n", (double)d.error_us / 1e6);
+        }
+    }
+    text.endPart();
+
+    const LogLimiter &limiter = LogManager::instance().limiter();
+    EMIT("# HELP hbrfeth_log_rate_limit Per-tag log rate limit (0 = off)\n");
+    EMIT("# TYPE hbrfeth_log_rate_limit gauge\n");
+    EMIT("hbrfeth_log_rate_limit{param=\"lines_per_second\"} %u\n", (unsigned)limiter.rate());
+    EMIT("hbrfeth_log_rate_limit{param=\"burst\"} %u\n", (unsigned)limiter.burst());
+    EMIT("# HELP hbrfeth_log_lines_suppressed_total Log lines dropped by the per-tag rate limit\n");
+    EMIT("# TYPE hbrfeth_log_lines_suppressed_total counter\n");
+    EMIT("hbrfeth_log_lines_suppressed_total %" PRIu32 "\n", limiter.suppressedTotal());
+    // Only tags that actually hit the limit; the table also holds every
+    // quiet tag seen since boot.
+    bool tag_header = false;
+    for (size_t i = 0; i <= LogLimiter::TAG_SLOTS; i++) {
+        const char *tag = nullptr;
+        uint32_t suppressed = 0;
+        if (!limiter.slotTotal(i, &tag, &suppressed) || suppressed == 0) continue;
+        if (!tag_header) {
+            EMIT("# HELP hbrfeth_log_tag_lines_suppressed_total Log lines dropped per tag\n");
+            EMIT("# TYPE hbrfeth_log_tag_lines_suppressed_total counter\n");
+            tag_header = true;
+        }
+        EMIT("hbrfeth_log_tag_lines_suppressed_total{tag=\"%s\"} %" PRIu32 "\n",
+             tag ? tag : "other", suppressed);
+    }
 #undef EMIT
-    return len;
+    return text.finish();
 }
 
 static bool client_allowed(const char *client_ip)
@@ -220,11 +275,11 @@ static bool client_allowed(const char *client_ip)
 
 static void prometheus_worker_cycle()
 {
-    // Allocate the 8 KiB response workspace lazily once and retain it for the
+    // Allocate the 4 KiB response chunk lazily once and retain it for the
     // worker lifetime. Repeated malloc/free on every normal 15-second scrape
     // needlessly fragments the WROOM-32 heap over long uptimes. If the first
     // allocation hits transient pressure, later scrapes may retry.
-    static const size_t RESP_CAP = 8 * 1024;
+    static const size_t RESP_CAP = 4 * 1024;
     char *body = NULL;
     int listen_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
     int opt = 1;
@@ -289,9 +344,10 @@ static void prometheus_worker_cycle()
             continue;
         }
 
-        // Build response on heap so a very large counter table cannot blow
-        // the task stack. 8 KB comfortably covers all current metrics plus
-        // all registered counters.
+        // Build the response on the heap so a very large counter table cannot
+        // blow the task stack. The scrape goes out in chunks of at most
+        // RESP_CAP, each filled with whole metric families; HTTP/1.0 without
+        // a Content-Length ends the body when the connection closes.
         if (!body) body = (char *)malloc(RESP_CAP);
         if (!body) {
             static const char *oom = "HTTP/1.0 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n";
@@ -300,20 +356,29 @@ static void prometheus_worker_cycle()
             worker_close_socket(s_client_sock, csock);
             continue;
         }
-        size_t blen = render_static(body, RESP_CAP);
-        blen = metrics_render_prometheus(body, RESP_CAP, blen);
-
-        char header[128];
-        int hlen = snprintf(header, sizeof(header),
-                            "HTTP/1.0 200 OK\r\n"
-                            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
-                            "Content-Length: %zu\r\n\r\n", blen);
+        static const char header[] =
+            "HTTP/1.0 200 OK\r\n"
+            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n\r\n";
         const int64_t deadline = esp_timer_get_time() + 2000000;
-        if (hlen > 0) {
-            (void)(send_all_with_deadline(csock, header,
-                                         static_cast<size_t>(hlen), deadline) &&
-                   send_all_with_deadline(csock, body, blen, deadline));
+        bool sent = send_all_with_deadline(csock, header, sizeof(header) - 1, deadline);
+        size_t blen = 0;
+        size_t (*const sections[])(char *, size_t, size_t, size_t *) = {
+            render_static, metrics_render_prometheus_part, ntp_server_render_prometheus,
+            raw_uart_render_rf_prometheus,
+        };
+        for (auto render : sections) {
+            if (!sent) break;
+            size_t resume = 0;
+            do {
+                blen = render(body, RESP_CAP, blen, &resume);
+                // A full chunk; the section continues in an emptied one.
+                if (resume != 0) {
+                    sent = sent && send_all_with_deadline(csock, body, blen, deadline);
+                    blen = 0;
+                }
+            } while (sent && resume != 0);
         }
+        if (sent && blen > 0) (void)send_all_with_deadline(csock, body, blen, deadline);
 
         worker_close_socket(s_client_sock, csock);
     }
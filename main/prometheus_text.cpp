@@ -0,0 +1,72 @@
+/*
+ *  prometheus_text.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "prometheus_text.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+
+PrometheusText::PrometheusText(char *out, size_t cap, size_t offset, size_t *resume)
+    : _out(out), _cap(out ? cap : 0), _offset(offset), _resume(resume) {
+    _first = resume && *resume ? *resume - 1 : 0;
+    if (resume) *resume = 0;
+    if (_cap == 0) {
+        _stopped = true;
+    } else {
+        if (_offset >= _cap) _offset = _cap - 1;
+        _out[_offset] = '\0';
+    }
+    _partStart = _offset;
+}
+
+void PrometheusText::emit(const char *format, ...) {
+    if (!active() || _offset + 1 >= _cap) return;
+    va_list args;
+    va_start(args, format);
+    const int n = vsnprintf(_out + _offset, _cap - _offset, format, args);
+    va_end(args);
+    if (n > 0) _offset += (size_t)n < _cap - _offset ? (size_t)n : _cap - _offset - 1;
+}
+
+void PrometheusText::endPart() {
+    if (active()) {
+        // Filling the buffer exactly counts as not fitting: the text may
+        // have been cut at the last byte.
+        if (_resume && _offset + 1 >= _cap && _partStart > 0) {
+            _offset = _partStart;
+            _out[_offset] = '\0';
+            *_resume = _part + 1;
+            _stopped = true;
+        }
+        _partStart = _offset;
+    }
+    _part++;
+}
+
+size_t PrometheusText::finish() {
+    if (_cap == 0) return _offset;
+    endPart();
+    _out[_offset] = '\0';
+    return _offset;
+}
@@ -26,11 +26,73 @@
 #include <string.h>
 #include "radiomoduleconnector.h"
 #include "hmframe.h"
+#include "duty_cycle.h"
+#include "rf_traffic.h"
+#include "events.h"
+#include "esp_timer.h"
 #include "driver/gpio.h"
 #include "pins.h"
 #include "esp_log.h"
 #include <new>
 
+// Transmit duty cycle of the telegrams the CCU sends through the module.
+// The module holds commands back once the hourly 1 % budget is spent, which
+// the relay latency metrics only show afterwards; crossing a threshold here
+// emits EVENT_DUTY_CYCLE while there is still budget left. The airtime is
+// the same length-based estimate as for received telegrams, without the
+// module's own repeats, so it is a lower bound.
+static DutyCycleBudget g_duty_cycle;
+static portMUX_TYPE g_duty_cycle_mux = portMUX_INITIALIZER_UNLOCKED;
+static constexpr uint16_t DUTY_CYCLE_DECODE_MAX = 256;
+
+// Runs in sendFrame()'s context, after the frame went to the UART.
+// events_emit() is non-blocking: it only enqueues, dropping the event if the
+// queue is full, and the events task does the delivery.
+static void duty_cycle_record(const unsigned char *buffer, uint16_t len)
+{
+    unsigned char decoded[DUTY_CYCLE_DECODE_MAX];
+    HMFrame frame;
+    if (!HMFrame::TryDecode(buffer, len, decoded, sizeof(decoded), &frame) ||
+        !DutyCycleBudget::isTransmission(frame))
+        return;
+
+    const uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    portENTER_CRITICAL(&g_duty_cycle_mux);
+    const DutyCycleBudget::Level crossed = g_duty_cycle.add(now_s, RfTrafficStats::airtimeUs(frame.data_len));
+    const uint32_t used_percent = g_duty_cycle.usedPercent(now_s);
+    const uint8_t threshold = crossed == DutyCycleBudget::LEVEL_ALARM ? g_duty_cycle.alarmPercent()
+                                                                      : g_duty_cycle.warnPercent();
+    portEXIT_CRITICAL(&g_duty_cycle_mux);
+
+    if (crossed != DutyCycleBudget::LEVEL_OK)
+    {
+        char detail[96];
+        snprintf(detail, sizeof(detail), "%u %% of the hourly transmit budget used (threshold %u %%)",
+                 (unsigned)used_percent, (unsigned)threshold);
+        ESP_LOGW("RadioModuleConnector", "Duty cycle: %s", detail);
+        events_emit(EVENT_DUTY_CYCLE, detail);
+    }
+}
+
+void radio_module_get_duty_cycle(radio_module_duty_cycle_t *out)
+{
+    if (!out) return;
+    const uint32_t now_s = (uint32_t)(esp_timer_get_time() / 1000000);
+    portENTER_CRITICAL(&g_duty_cycle_mux);
+    out->airtime_ms = g_duty_cycle.usedUs(now_s) / 1000;
+    out->used_percent = g_duty_cycle.usedPercent(now_s);
+    out->level = (uint8_t)g_duty_cycle.level();
+    portEXIT_CRITICAL(&g_duty_cycle_mux);
+}
+
+void radio_module_set_duty_cycle_thresholds(uint8_t warn_percent, uint8_t alarm_percent)
+{
+    portENTER_CRITICAL(&g_duty_cycle_mux);
+    if (warn_percent != g_duty_cycle.warnPercent() || alarm_percent != g_duty_cycle.alarmPercent())
+        g_duty_cycle.configure(warn_percent, alarm_percent);
+    portEXIT_CRITICAL(&g_duty_cycle_mux);
+}
+
 void serialQueueHandlerTask(void *parameter)
 {
     ((RadioModuleConnector *)parameter)->_serialQueueHandler();
@@ -139,6 +201,7 @@ void RadioModuleConnector::resetModule()
 void RadioModuleConnector::sendFrame(unsigned char *buffer, uint16_t len)
 {
     uart_write_bytes(UART_NUM_1, (const char *)buffer, len);
+    duty_cycle_record(buffer, len);
 }
 
 void RadioModuleConnector::_serialQueueHandler()
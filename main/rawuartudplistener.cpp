@@ -23,11 +23,17 @@
 
 #include "rawuartudplistener.h"
 #include "hmframe.h"
+#include "rf_traffic.h"
+#include "rf_devices.h"
 #include "esp_log.h"
+#include <algorithm>
+#include <inttypes.h>
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include "udphelper.h"
 #include "metrics.h"
+#include "prometheus_text.h"
 #include "events.h"
 #include "esp_timer.h"
 
@@ -94,6 +100,266 @@ void raw_uart_reset_latency_high_water(void)
     g_queue_depth_max.reset();
 }
 
+// Radio traffic analytics over the frames relayed to the CCU. The UART task
+// only copies each frame into g_rf_frames after handing it to
+// sendMessage(); decoding and the table updates run in the low-priority
+// rf_traffic task. A frame that finds the queue full is left out and
+// counted. Frames longer than RF_DECODE_MAX travel without their bytes and
+// are counted as unparsed.
+static constexpr uint16_t RF_DECODE_MAX = 256;
+static constexpr UBaseType_t RF_QUEUE_DEPTH = 8;
+static constexpr uint32_t RF_TASK_STACK = 2048;
+static constexpr UBaseType_t RF_TASK_PRIORITY = 2;   // below events (3)
+
+struct RfQueuedFrame {
+    uint16_t len;   // UART bytes of the frame
+    unsigned char data[RF_DECODE_MAX];
+};
+
+static QueueHandle_t g_rf_frames = NULL;
+static StaticQueue_t g_rf_frames_buffer;
+static uint8_t g_rf_frames_storage[RF_QUEUE_DEPTH * sizeof(RfQueuedFrame)];
+static TaskHandle_t g_rf_task = NULL;
+static MetricsCounter g_rf_dropped("hbrfeth_rf_analytics_dropped_total",
+                                   "Relayed frames left out of the radio traffic analytics (queue full)");
+
+// Written by the rf_traffic task only; readers copy out under
+// rf_traffic_mutex(). A mutex rather than a spinlock, so a reader copying
+// the whole device table does not hold interrupts off.
+static RfTrafficStats g_rf_traffic;
+// Senders of received telegrams, for finding the one device that floods
+// the air.
+static RfDeviceTable g_rf_devices;
+static StaticSemaphore_t g_rf_traffic_mutex_buffer;
+// Devices with their own series in the Prometheus output, busiest first.
+static constexpr size_t RF_DEVICE_METRICS = 8;
+
+static SemaphoreHandle_t rf_traffic_mutex()
+{
+    static SemaphoreHandle_t mutex = xSemaphoreCreateMutexStatic(&g_rf_traffic_mutex_buffer);
+    return mutex;
+}
+
+static uint32_t rf_now_s()
+{
+    return (uint32_t)(esp_timer_get_time() / 1000000);
+}
+
+// Runs in the rf_traffic task.
+static void rf_traffic_record(const RfQueuedFrame &queued)
+{
+    static unsigned char decoded[RF_DECODE_MAX];
+    const uint16_t len = queued.len;
+    HMFrame frame;
+    const bool parsed = len <= RF_DECODE_MAX &&
+                        HMFrame::TryDecode(queued.data, len, decoded, sizeof(decoded), &frame);
+    uint32_t address = 0;
+    bool has_rssi = false;
+    int8_t rssi = 0;
+    const bool has_sender = parsed && RfDeviceTable::sender(frame, &address, &has_rssi, &rssi);
+    const uint32_t now_s = rf_now_s();
+
+    xSemaphoreTake(rf_traffic_mutex(), portMAX_DELAY);
+    if (parsed)
+        g_rf_traffic.record(frame, len, now_s);
+    else
+        g_rf_traffic.recordUnparsed(len, now_s);
+    if (has_sender)
+        g_rf_devices.record(address, now_s, has_rssi, rssi);
+    xSemaphoreGive(rf_traffic_mutex());
+}
+
+static void rf_traffic_task(void *)
+{
+    static RfQueuedFrame queued;
+    for (;;) {
+        if (xQueueReceive(g_rf_frames, &queued, portMAX_DELAY) == pdTRUE)
+            rf_traffic_record(queued);
+    }
+}
+
+// Runs on the UART task: a copy and a non-blocking send.
+static void rf_traffic_post(const unsigned char *buffer, uint16_t len)
+{
+    if (g_rf_frames == NULL) return;
+    RfQueuedFrame queued;
+    queued.len = len;
+    if (len <= RF_DECODE_MAX) memcpy(queued.data, buffer, len);
+    if (xQueueSend(g_rf_frames, &queued, 0) != pdTRUE) g_rf_dropped.inc();
+}
+
+// Once, under the listener's lifecycle mutex; the task lives for the uptime.
+static void rf_traffic_start()
+{
+    if (g_rf_task != NULL) return;
+    if (g_rf_frames == NULL) {
+        g_rf_frames = xQueueCreateStatic(RF_QUEUE_DEPTH, sizeof(RfQueuedFrame),
+                                         g_rf_frames_storage, &g_rf_frames_buffer);
+    }
+    if (g_rf_frames == NULL || rf_traffic_mutex() == NULL ||
+        xTaskCreate(rf_traffic_task, "rf_traffic", RF_TASK_STACK, NULL, RF_TASK_PRIORITY,
+                    &g_rf_task) != pdPASS) {
+        // The relay does not need it; the analytics just stay empty.
+        ESP_LOGE(TAG, "Failed to start radio traffic analytics");
+        g_rf_task = NULL;
+    }
+}
+
+size_t raw_uart_get_rf_devices(RfDeviceTable::Device *out, size_t cap, uint32_t *now_s,
+                               uint32_t *evictions)
+{
+    if (!out) return 0;
+    xSemaphoreTake(rf_traffic_mutex(), portMAX_DELAY);
+    const size_t count = g_rf_devices.snapshot(out, cap);
+    if (evictions) *evictions = g_rf_devices.evictions();
+    xSemaphoreGive(rf_traffic_mutex());
+    if (now_s) *now_s = rf_now_s();
+    return count;
+}
+
+void raw_uart_get_rf_rates(raw_uart_rf_rates_t *out)
+{
+    if (!out) return;
+    const uint32_t now_s = rf_now_s();
+    xSemaphoreTake(rf_traffic_mutex(), portMAX_DELAY);
+    const RfRateWindow::Totals minute = g_rf_traffic.lastMinute(now_s);
+    const RfRateWindow::Totals hour = g_rf_traffic.lastHour(now_s);
+    xSemaphoreGive(rf_traffic_mutex());
+
+    out->frames_1m     = minute.frames;
+    out->bytes_1m      = minute.bytes;
+    out->airtime_1m_ms = minute.airtime_us / 1000;
+    out->frames_1h     = hour.frames;
+    out->bytes_1h      = hour.bytes;
+    out->airtime_1h_ms = hour.airtime_us / 1000;
+}
+
+static const char *rf_destination_name(uint8_t destination)
+{
+    switch (destination) {
+    case HM_DST_HMSYSTEM: return "hmsystem";
+    case HM_DST_TRX: return "trx";
+    case HM_DST_HMIP: return "hmip";
+    case HM_DST_LLMAC: return "llmac";
+    case HM_DST_COMMON: return "common";
+    default: return "other";
+    }
+}
+
+size_t raw_uart_render_rf_prometheus(char *out, size_t cap, size_t offset, size_t *resume)
+{
+    PrometheusText text(out, cap, offset, resume);
+
+    // Copied out under the lock, which the rf_traffic task needs for every
+    // frame; rendering into the response buffer happens after.
+    RfTrafficStats::Kind kinds[RfTrafficStats::MAX_KINDS + 1];
+    raw_uart_rf_rates_t rates;
+    raw_uart_get_rf_rates(&rates);
+    xSemaphoreTake(rf_traffic_mutex(), portMAX_DELAY);
+    const size_t count = g_rf_traffic.kindCount();
+    for (size_t i = 0; i < count; i++) kinds[i] = g_rf_traffic.kind(i);
+    const uint32_t unparsed = g_rf_traffic.unparsed();
+    xSemaphoreGive(rf_traffic_mutex());
+
+    // One part per metric family; the kind and device series go out in
+    // their own chunks when the buffer is full.
+#define EMIT(...) text.emit(__VA_ARGS__)
+
+    EMIT("# HELP hbrfeth_rf_frames Frames from the radio module over the sliding window\n");
+    EMIT("# TYPE hbrfeth_rf_frames gauge\n");
+    EMIT("hbrfeth_rf_frames{window=\"1m\"} %" PRIu32 "\n", rates.frames_1m);
+    EMIT("hbrfeth_rf_frames{window=\"1h\"} %" PRIu32 "\n", rates.frames_1h);
+    EMIT("# HELP hbrfeth_rf_bytes UART bytes from the radio module over the sliding window\n");
+    EMIT("# TYPE hbrfeth_rf_bytes gauge\n");
+    EMIT("hbrfeth_rf_bytes{window=\"1m\"} %" PRIu32 "\n", rates.bytes_1m);
+    EMIT("hbrfeth_rf_bytes{window=\"1h\"} %" PRIu32 "\n", rates.bytes_1h);
+    EMIT("# HELP hbrfeth_rf_airtime_seconds Estimated airtime of received telegrams over the sliding window\n");
+    EMIT("# TYPE hbrfeth_rf_airtime_seconds gauge\n");
+    EMIT("hbrfeth_rf_airtime_seconds{window=\"1m\"} %" PRIu32 ".%03" PRIu32 "\n",
+         rates.airtime_1m_ms / 1000, rates.airtime_1m_ms % 1000);
+    EMIT("hbrfeth_rf_airtime_seconds{window=\"1h\"} %" PRIu32 ".%03" PRIu32 "\n",
+         rates.airtime_1h_ms / 1000, rates.airtime_1h_ms % 1000);
+    radio_module_duty_cycle_t duty = {};
+    radio_module_get_duty_cycle(&duty);
+    EMIT("# HELP hbrfeth_rf_tx_airtime_seconds Estimated airtime of telegrams sent through the module over the last hour\n");
+    EMIT("# TYPE hbrfeth_rf_tx_airtime_seconds gauge\n");
+    EMIT("hbrfeth_rf_tx_airtime_seconds{window=\"1h\"} %" PRIu32 ".%03" PRIu32 "\n",
+         duty.airtime_ms / 1000, duty.airtime_ms % 1000);
+    EMIT("# HELP hbrfeth_rf_duty_cycle_percent Share of the hourly 1 %% transmit budget used\n");
+    EMIT("# TYPE hbrfeth_rf_duty_cycle_percent gauge\n");
+    EMIT("hbrfeth_rf_duty_cycle_percent %" PRIu32 "\n", duty.used_percent);
+    EMIT("# HELP hbrfeth_rf_unparsed_frames_total Frames from the radio module that could not be decoded\n");
+    EMIT("# TYPE hbrfeth_rf_unparsed_frames_total counter\n");
+    EMIT("hbrfeth_rf_unparsed_frames_total %" PRIu32 "\n", unparsed);
+    text.endPart();
+    if (count > 0) {
+        EMIT("# HELP hbrfeth_rf_kind_frames_total Frames from the radio module per destination and command\n");
+        EMIT("# TYPE hbrfeth_rf_kind_frames_total counter\n");
+        for (size_t i = 0; i < count; i++) {
+            if (kinds[i].overflow)
+                EMIT("hbrfeth_rf_kind_frames_total{destination=\"other\",command=\"other\"} %" PRIu32 "\n",
+                     kinds[i].frames);
+            else
+                EMIT("hbrfeth_rf_kind_frames_total{destination=\"%s\",command=\"0x%02x\"} %" PRIu32 "\n",
+                     rf_destination_name(kinds[i].destination), kinds[i].command, kinds[i].frames);
+        }
+    }
+    text.endPart();
+    if (count > 0) {
+        EMIT("# HELP hbrfeth_rf_kind_bytes_total UART bytes from the radio module per destination and command\n");
+        EMIT("# TYPE hbrfeth_rf_kind_bytes_total counter\n");
+        for (size_t i = 0; i < count; i++) {
+            if (kinds[i].overflow)
+                EMIT("hbrfeth_rf_kind_bytes_total{destination=\"other\",command=\"other\"} %" PRIu32 "\n",
+                     kinds[i].bytes);
+            else
+                EMIT("hbrfeth_rf_kind_bytes_total{destination=\"%s\",command=\"0x%02x\"} %" PRIu32 "\n",
+                     rf_destination_name(kinds[i].destination), kinds[i].command, kinds[i].bytes);
+        }
+    }
+    text.endPart();
+
+    // Only the prometheus task renders, so the device copy can be static
+    // instead of 2 KiB of its stack.
+    static RfDeviceTable::Device devices[RfDeviceTable::CAPACITY];
+    uint32_t evictions = 0;
+    const size_t device_count = raw_uart_get_rf_devices(devices, RfDeviceTable::CAPACITY, NULL,
+                                                        &evictions);
+    const size_t shown = std::min(device_count, RF_DEVICE_METRICS);
+    std::partial_sort(devices, devices + shown, devices + device_count,
+                      [](const RfDeviceTable::Device &a, const RfDeviceTable::Device &b) {
+                          return a.frames > b.frames;
+                      });
+    EMIT("# HELP hbrfeth_rf_devices Radio devices tracked in the device table\n");
+    EMIT("# TYPE hbrfeth_rf_devices gauge\n");
+    EMIT("hbrfeth_rf_devices %u\n", (unsigned)device_count);
+    EMIT("# HELP hbrfeth_rf_device_evictions_total Devices dropped from the full device table\n");
+    EMIT("# TYPE hbrfeth_rf_device_evictions_total counter\n");
+    EMIT("hbrfeth_rf_device_evictions_total %" PRIu32 "\n", evictions);
+    text.endPart();
+    if (shown > 0) {
+        EMIT("# HELP hbrfeth_rf_device_frames Frames heard from the busiest radio devices while tracked\n");
+        EMIT("# TYPE hbrfeth_rf_device_frames gauge\n");
+        for (size_t i = 0; i < shown; i++) {
+            EMIT("hbrfeth_rf_device_frames{address=\"%06" PRIX32 "\"} %" PRIu32 "\n",
+                 devices[i].address, devices[i].frames);
+        }
+    }
+    text.endPart();
+    if (shown > 0) {
+        EMIT("# HELP hbrfeth_rf_device_rssi_dbm Last RSSI the radio module reported for the busiest devices\n");
+        EMIT("# TYPE hbrfeth_rf_device_rssi_dbm gauge\n");
+        for (size_t i = 0; i < shown; i++) {
+            if (!devices[i].has_rssi) continue;
+            EMIT("hbrfeth_rf_device_rssi_dbm{address=\"%06" PRIX32 "\"} %d\n",
+                 devices[i].address, devices[i].rssi);
+        }
+    }
+#undef EMIT
+
+    return text.finish();
+}
+
 void _raw_uart_udpQueueHandlerTask(void *parameter)
 {
     ((RawUartUdpListener *)parameter)->_udpQueueHandler();
@@ -415,6 +681,7 @@ void RawUartUdpListener::handleFrame(unsigned char *buffer, uint16_t len)
     }
 
     sendMessage(7, buffer, len);
+    rf_traffic_post(buffer, len);
 }
 
 void RawUartUdpListener::start()
@@ -494,6 +761,7 @@ void RawUartUdpListener::start()
     }
     _tHandle.store(task, std::memory_order_release);
 
+    rf_traffic_start();
     _radioModuleConnector->setFrameHandler(this, false);
     xSemaphoreGive(_lifecycleMutex);
 
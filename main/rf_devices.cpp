@@ -0,0 +1,142 @@
+/*
+ *  rf_devices.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "rf_devices.h"
+
+#include <string.h>
+
+namespace {
+
+// Where the receive events carry the sender. BidCos (Co_CPU app, TRX):
+// status, info, RSSI, then the radio header: counter, flags, type, sender,
+// receiver. HmIP: status, info, RSSI, then control and counter before the
+// sender. The RSSI byte is the magnitude of a negative dBm value.
+struct SenderLayout {
+    uint8_t destination;
+    uint8_t command;
+    uint8_t rssi_offset;
+    uint8_t address_offset;
+};
+
+constexpr uint8_t RX_EVENT = 0x05;
+constexpr SenderLayout SENDER_LAYOUTS[] = {
+    {HM_DST_TRX, RX_EVENT, 2, 6},
+    {HM_DST_HMIP, RX_EVENT, 2, 5},
+};
+
+}  // namespace
+
+void RfDeviceTable::clear() {
+    memset(_nodes, 0, sizeof(_nodes));
+    memset(_heads, NONE, sizeof(_heads));
+    _newest = NONE;
+    _oldest = NONE;
+    _count = 0;
+    _evictions = 0;
+}
+
+size_t RfDeviceTable::bucket(uint32_t address) {
+    // Multiplicative hash: addresses are often handed out in sequence.
+    return (size_t)((address * 2654435761u) >> 16) & (BUCKETS - 1);
+}
+
+void RfDeviceTable::unlinkRecency(uint8_t index) {
+    Node &node = _nodes[index];
+    if (node.newer != NONE) _nodes[node.newer].older = node.older;
+    else _newest = node.older;
+    if (node.older != NONE) _nodes[node.older].newer = node.newer;
+    else _oldest = node.newer;
+}
+
+void RfDeviceTable::pushNewest(uint8_t index) {
+    Node &node = _nodes[index];
+    node.newer = NONE;
+    node.older = _newest;
+    if (_newest != NONE) _nodes[_newest].newer = index;
+    _newest = index;
+    if (_oldest == NONE) _oldest = index;
+}
+
+void RfDeviceTable::unlinkChain(uint8_t index) {
+    uint8_t *link = &_heads[bucket(_nodes[index].device.address)];
+    while (*link != index) link = &_nodes[*link].chain;
+    *link = _nodes[index].chain;
+}
+
+void RfDeviceTable::record(uint32_t address, uint32_t now_s, bool has_rssi, int8_t rssi) {
+    address &= 0xffffff;
+    const size_t head = bucket(address);
+    uint8_t index = _heads[head];
+    while (index != NONE && _nodes[index].device.address != address) index = _nodes[index].chain;
+
+    if (index != NONE) {
+        unlinkRecency(index);
+    } else {
+        if (_count < CAPACITY) {
+            index = (uint8_t)_count++;
+        } else {
+            index = _oldest;
+            unlinkRecency(index);
+            unlinkChain(index);
+            _evictions++;
+        }
+        _nodes[index].device = {address, 0, 0, 0, false};
+        _nodes[index].chain = _heads[head];
+        _heads[head] = index;
+    }
+    pushNewest(index);
+
+    Device &device = _nodes[index].device;
+    device.frames++;
+    device.last_seen_s = now_s;
+    if (has_rssi) {
+        device.rssi = rssi;
+        device.has_rssi = true;
+    }
+}
+
+size_t RfDeviceTable::snapshot(Device *out, size_t cap) const {
+    size_t n = 0;
+    for (uint8_t index = _newest; index != NONE && n < cap; index = _nodes[index].older) {
+        out[n++] = _nodes[index].device;
+    }
+    return n;
+}
+
+bool RfDeviceTable::sender(const HMFrame &frame, uint32_t *address, bool *has_rssi, int8_t *rssi) {
+    for (const SenderLayout &layout : SENDER_LAYOUTS) {
+        if (frame.destination != layout.destination || frame.command != layout.command) continue;
+        if (!frame.data || frame.data_len < layout.address_offset + 3u) return false;
+        const unsigned char *data = frame.data;
+        *address = ((uint32_t)data[layout.address_offset] << 16) |
+                   ((uint32_t)data[layout.address_offset + 1] << 8) |
+                   data[layout.address_offset + 2];
+        const uint8_t magnitude = data[layout.rssi_offset];
+        // 0 means the module did not measure one.
+        *has_rssi = magnitude != 0;
+        *rssi = (int8_t)(magnitude > 127 ? -127 : -(int)magnitude);
+        return true;
+    }
+    return false;
+}
@@ -0,0 +1,103 @@
+/*
+ *  rf_traffic.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+
+#include "rf_traffic.h"
+
+void RfRateWindow::addTo(Bucket *bucket, uint32_t tag, uint32_t frames, uint32_t bytes,
+                         uint32_t airtime_us) {
+    if (bucket->tag != tag) {
+        bucket->tag = tag;
+        bucket->totals = {};
+    }
+    bucket->totals.frames += frames;
+    bucket->totals.bytes += bytes;
+    bucket->totals.airtime_us += airtime_us;
+}
+
+RfRateWindow::Totals RfRateWindow::sum(const Bucket *buckets, uint32_t tag) {
+    Totals totals = {};
+    for (size_t i = 0; i < 60; i++) {
+        // Tags are unit + 1 so a zeroed bucket never matches; anything older
+        // than 60 units (or from a wrapped clock) is stale.
+        if (buckets[i].tag == 0 || tag - buckets[i].tag >= 60) continue;
+        totals.frames += buckets[i].totals.frames;
+        totals.bytes += buckets[i].totals.bytes;
+        totals.airtime_us += buckets[i].totals.airtime_us;
+    }
+    return totals;
+}
+
+void RfRateWindow::add(uint32_t now_s, uint32_t frames, uint32_t bytes, uint32_t airtime_us) {
+    const uint32_t minute = now_s / 60;
+    addTo(&_seconds[now_s % 60], now_s + 1, frames, bytes, airtime_us);
+    addTo(&_minutes[minute % 60], minute + 1, frames, bytes, airtime_us);
+}
+
+RfRateWindow::Totals RfRateWindow::lastMinute(uint32_t now_s) const {
+    return sum(_seconds, now_s + 1);
+}
+
+RfRateWindow::Totals RfRateWindow::lastHour(uint32_t now_s) const {
+    return sum(_minutes, now_s / 60 + 1);
+}
+
+bool RfTrafficStats::isAirFrame(const HMFrame &frame) {
+    switch (frame.destination) {
+        case HM_DST_HMIP:  return frame.command != HM_CMD_HMIP_ACK;
+        case HM_DST_LLMAC: return frame.command != HM_CMD_LLMAC_ACK;
+        case HM_DST_TRX:   return frame.command != HM_CMD_TRX_ACK;
+        default:           return false;
+    }
+}
+
+uint32_t RfTrafficStats::airtimeUs(uint16_t payload_len) {
+    return (uint32_t)(((uint64_t)(payload_len + AIR_OVERHEAD_BYTES) * 8 * 1000000) / AIR_BITRATE);
+}
+
+void RfTrafficStats::record(const HMFrame &frame, uint16_t wire_len, uint32_t now_s) {
+    Kind *kind = &_overflow;
+    for (size_t i = 0; i < _kind_count; i++) {
+        if (_kinds[i].destination == frame.destination && _kinds[i].command == frame.command) {
+            kind = &_kinds[i];
+            break;
+        }
+    }
+    if (kind == &_overflow && _kind_count < MAX_KINDS) {
+        kind = &_kinds[_kind_count++];
+        *kind = {frame.destination, frame.command, false, 0, 0};
+    }
+    kind->frames++;
+    kind->bytes += wire_len;
+    _window.add(now_s, 1, wire_len, isAirFrame(frame) ? airtimeUs(frame.data_len) : 0);
+}
+
+void RfTrafficStats::recordUnparsed(uint16_t wire_len, uint32_t now_s) {
+    _unparsed++;
+    _window.add(now_s, 1, wire_len, 0);
+}
+
+RfTrafficStats::Kind RfTrafficStats::kind(size_t index) const {
+    if (index < _kind_count) return _kinds[index];
+    return _overflow;
+}
@@ -25,11 +25,15 @@
 #include "log_manager.h"
 #include "monitoring.h"
 #include "crash_blackbox.h"
+#include "events.h"
+#include "metrics.h"
+#include "syslog_batch.h"
+#include "log_entry.h"
+#include "tls_resume.h"
 #include "settings.h"
 #include "esp_log.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "freertos/queue.h"
 #include "freertos/semphr.h"
 #include "lwip/sockets.h"
 #include "lwip/netdb.h"
@@ -39,8 +43,10 @@
 #include <atomic>
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <errno.h>
 #include <time.h>
+#include <sys/time.h>
 
 extern Settings *monitoring_get_settings(void);
 extern SemaphoreHandle_t g_net_fetch_mutex;
@@ -66,24 +72,49 @@ static std::atomic<bool>         s_running{false};
 static std::atomic<bool>         s_restart_requested{false};
 static std::atomic<TaskHandle_t> s_task{NULL};
 static std::atomic<uint32_t>     s_min_severity{7};
-static QueueHandle_t             s_queue = NULL;
-
-// The logging hot path only copies one bounded raw line. Parsing, wall-clock
-// access, hostname selection and RFC 5424 formatting all happen in the worker.
-static constexpr size_t SYSLOG_RAW_LINE_MAX = 384;
-struct syslog_entry {
-    char  line[SYSLOG_RAW_LINE_MAX];
-    size_t len;
-};
-
-// Queue depth: 16 bounded raw entries. Halved from the original 32 to ease
-// heap pressure on the WROOM-32 (no PSRAM)
-// when syslog is enabled. Syslog forwarding is best-effort UDP; a full
-// queue already drops new lines via xQueueSend(..., 0) in enqueue(), so
-// the lower depth trades burst capacity for ~8 KB of freed heap that is
-// better spent on other TLS handshakes or a manual firmware upload. 16 still
-// covers the typical smart-home log volume.
-static constexpr int QUEUE_DEPTH = 16;
+// Logging tasks currently inside syslog_subscriber(). The worker waits for
+// this to reach zero before it deletes itself, so a preempted caller never
+// notifies a task that no longer exists.
+static std::atomic<uint32_t>     s_producers{0};
+
+// The logging hot path copies one bounded log entry into a preallocated
+// record queue, with no allocation and no lock. Rendering, parsing,
+// wall-clock access, hostname selection and RFC 5424 formatting all happen
+// in the worker, which drains the queue in batches.
+//
+// 4 KiB hold about a hundred deferred entries, where the former FreeRTOS
+// queue held 16 fixed 264-byte slots in the same space. The batch buffer
+// behind it collects octet-counted frames for one TCP/TLS write. Both are
+// allocated on the first start and kept for the whole boot, like the queue
+// was: a producer that raced syslog_stop() may still be writing.
+static constexpr size_t SYSLOG_QUEUE_BYTES = 4096;
+static constexpr size_t SYSLOG_BATCH_BYTES = 1400;   // one TCP segment
+static constexpr uint32_t SYSLOG_BATCH_LINES = 32;
+// How long the worker lets a burst gather after the first line before it
+// writes; a queue that fills to half wakes it early.
+static constexpr TickType_t SYSLOG_BATCH_WINDOW = pdMS_TO_TICKS(100);
+
+// Every queue record starts with what only the logging task knows: a length
+// byte, then for the structured formats the core and the task name. The
+// entry follows.
+static constexpr size_t SYSLOG_META_MAX = 2 + configMAX_TASK_NAME_LEN;
+
+static SyslogQueue s_queue;
+static char *s_batch = NULL;
+static std::atomic<bool> s_structured{false};
+
+static MetricsCounter g_lines_sent("hbrfeth_syslog_lines_total",
+                                   "Log lines delivered to the syslog transport");
+static MetricsCounter g_bytes_sent("hbrfeth_syslog_bytes_total",
+                                   "Syslog bytes written, framing included");
+static MetricsCounter g_writes("hbrfeth_syslog_writes_total",
+                               "Syslog transport writes (UDP datagrams or TCP/TLS batches)");
+static MetricsCounter g_dropped("hbrfeth_syslog_dropped_total",
+                                "Log lines dropped because the syslog queue was full");
+static MetricsCounter g_send_failed("hbrfeth_syslog_send_failed_total",
+                                    "Log lines lost to a failed or skipped syslog write");
+static MetricsHighWater g_batch_lines_max("hbrfeth_syslog_batch_lines_max",
+                                          "Most log lines forwarded in one worker wakeup");
 
 static void normalise_config(syslog_config_t *dst,
                              const syslog_config_t *src)
@@ -92,6 +123,7 @@ static void normalise_config(syslog_config_t *dst,
     dst->server[sizeof(dst->server) - 1] = '\0';
     dst->hostname[sizeof(dst->hostname) - 1] = '\0';
     if (dst->min_severity > 7) dst->min_severity = 7;
+    if (dst->format > SYSLOG_FORMAT_JSON) dst->format = SYSLOG_FORMAT_RFC5424;
 
     if (dst->hostname[0] == '\0') {
         Settings *settings = monitoring_get_settings();
@@ -106,119 +138,44 @@ static void normalise_config(syslog_config_t *dst,
     }
 }
 
-static int severity_from_level(char level)
-{
-    switch (level) {
-        case 'E': return 3;  // ERROR
-        case 'W': return 4;  // WARNING
-        case 'I': return 5;  // NOTICE/INFO
-        case 'D': return 7;  // DEBUG
-        case 'V': return 7;  // VERBOSE -> DEBUG
-        default:  return 5;
-    }
-}
-
-// ---------------------------------------------------------------------------
-// ESP-IDF log line parsing.
-//
-// Default IDF format:  "I (12345) TAG: user message"
-//   - pos 0:   level letter V/D/I/W/E/?
-//   - then " (<digits>) "
-//   - then TAG up to ": "
-//   - then user message (may contain spaces)
-//
-// Returns false if the line could not be parsed (in which case we fall back
-// to severity INFO with tag "fw" and the whole line as message).
-// ---------------------------------------------------------------------------
-static bool parse_idf_line(const char *line, size_t len,
-                           int *severity_out, char *tag_out, size_t tag_cap,
-                           const char **msg_out, size_t *msg_len_out)
-{
-    if (len < 6 || line[1] != ' ' || line[2] != '(') return false;
-
-    *severity_out = severity_from_level(line[0]);
-
-    // Find the closing paren of "(<timestamp>)"
-    size_t i = 3;
-    while (i < len && line[i] != ')') i++;
-    if (i >= len) return false;
-    i++;                       // skip ')'
-    if (i >= len || line[i] != ' ') return false;
-    i++;                       // skip ' '
-
-    // Tag: everything up to ": "
-    size_t tag_start = i;
-    while (i + 1 < len && !(line[i] == ':' && line[i + 1] == ' ')) i++;
-    if (i + 1 >= len) return false;
-    size_t tag_len = i - tag_start;
-    if (tag_len == 0 || tag_len >= tag_cap) tag_len = tag_cap - 1;
-    memcpy(tag_out, line + tag_start, tag_len);
-    tag_out[tag_len] = '\0';
-
-    i += 2;  // skip ": "
-    *msg_out = line + i;
-    *msg_len_out = len - i;
-    return true;
-}
-
-static void format_rfc5424(char *out, size_t cap, size_t *out_len,
-                           int severity, const char *tag,
-                           const char *msg, size_t msg_len,
-                           const char *hostname)
-{
-    // Facility = 1 (user-level). PRI = facility*8 + severity.
-    int pri = 8 + severity;
-
-    // Wall-clock work belongs to the worker, never the LogManager callback.
-    // If time conversion fails, RFC 5424 permits NILVALUE ("-").
-    time_t secs = time(NULL);
-    struct tm tmv;
-    char ts[24];
-    if (gmtime_r(&secs, &tmv) == NULL ||
-        strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", &tmv) == 0) {
-        strcpy(ts, "-");
-    }
-
-    // Cap msg_len to avoid blowing the fixed buffer.
-    if (msg_len > 384) msg_len = 384;
-
-    int n = snprintf(out, cap, "<%d>1 %s %s fw %s - - %.*s\n",
-                     pri, ts,
-                     (hostname && hostname[0]) ? hostname : "hb-rf-eth-ng",
-                     tag ? tag : "fw",
-                     (int)msg_len, msg ? msg : "");
-    if (n < 0) {
-        *out_len = 0;
-        return;
-    }
-    if ((size_t)n >= cap) n = cap - 1;
-    *out_len = (size_t)n;
-}
-
 // ---------------------------------------------------------------------------
 // Subscriber hook called from LogManager::write().
 // ---------------------------------------------------------------------------
-void syslog_subscriber(const char *line, size_t len, uint64_t end_offset)
+void syslog_subscriber(const uint8_t *entry, size_t len, uint64_t end_offset)
 {
     (void)end_offset;
-    if (!line || len == 0 ||
-        !s_running.load(std::memory_order_acquire) || !s_queue) return;
+    if (!entry || len == 0 || len > LOG_ENTRY_MAX ||
+        !s_running.load(std::memory_order_acquire)) return;
 
-    const int severity = severity_from_level(line[0]);
+    const int severity = syslog_severity_from_level(log_entry_level(entry, len));
     if (severity > static_cast<int>(
             s_min_severity.load(std::memory_order_relaxed))) return;
 
-    // Heap-allocate: syslog_entry is ~392 bytes and this hook runs on
-    // whichever task issued ESP_LOG — including the 4 KB timer-service
-    // task. xQueueSend copies into the queue's internal storage, so the
-    // allocation is transient and freed immediately.
-    struct syslog_entry *e = (struct syslog_entry *)malloc(sizeof(*e));
-    if (!e) return;
-    e->len = len < sizeof(e->line) ? len : sizeof(e->line);
-    memcpy(e->line, line, e->len);
-
-    xQueueSend(s_queue, e, 0);
-    free(e);
+    uint8_t meta[SYSLOG_META_MAX];
+    size_t meta_len = 1;
+    meta[0] = 0;
+    if (s_structured.load(std::memory_order_relaxed)) {
+        const char *task = pcTaskGetName(NULL);
+        const size_t task_len = task ? strnlen(task, configMAX_TASK_NAME_LEN) : 0;
+        meta[1] = (uint8_t)xPortGetCoreID();
+        if (task_len > 0) memcpy(meta + 2, task, task_len);
+        meta[0] = (uint8_t)(1 + task_len);
+        meta_len = 2 + task_len;
+    }
+
+    s_producers.fetch_add(1, std::memory_order_acq_rel);
+    if (s_running.load(std::memory_order_acquire)) {
+        bool wake = false;
+        if (!s_queue.push(meta, meta_len, entry, len, &wake)) {
+            g_dropped.inc();
+        } else if (wake) {
+            // Only the first line of a batch and a half-full queue wake the
+            // worker; everything else waits for the batch window.
+            TaskHandle_t task = s_task.load(std::memory_order_acquire);
+            if (task) xTaskNotifyGive(task);
+        }
+    }
+    s_producers.fetch_sub(1, std::memory_order_acq_rel);
 }
 
 // ---------------------------------------------------------------------------
@@ -336,8 +293,9 @@ static int resolve_and_connect_tcp(const char *host, uint16_t port)
 //
 // This wrapper keeps the SSL context alive across messages (mirroring how the
 // TCP transport already keeps its socket). Reconnect/rehandshake happens only
-// on write failure or idle timeout. The g_net_fetch_mutex is still taken per
-// send to keep the cross-subsystem handshake-serialisation invariant.
+// on write failure or idle timeout, and resumes the cached session. The
+// g_net_fetch_mutex is still taken per send to keep the cross-subsystem
+// handshake-serialisation invariant.
 // ---------------------------------------------------------------------------
 struct syslog_tls_session {
     bool                 initialised = false;   // ssl/conf/net init done
@@ -413,22 +371,28 @@ static bool syslog_tls_connect(syslog_tls_session *s, const char *host, uint16_t
     mbedtls_ssl_set_bio(&s->ssl, &s->net_fd, mbedtls_net_send, mbedtls_net_recv, NULL);
     mbedtls_ssl_set_hostname(&s->ssl, host);
 
+    // Reconnects after an idle teardown or a dropped connection resume the
+    // previous session instead of paying for a full handshake.
+    const int64_t resume_start = tls_resume_begin(&s->ssl, host, port);
     const TickType_t handshake_start = xTaskGetTickCount();
     int r;
     for (;;) {
         if (!s_running.load(std::memory_order_acquire) ||
             tick_timeout_elapsed(handshake_start,
                                  SYSLOG_TLS_HANDSHAKE_TIMEOUT)) {
+            tls_resume_end(&s->ssl, host, port, resume_start, false);
             syslog_tls_teardown(s);
             return false;
         }
         r = mbedtls_ssl_handshake(&s->ssl);
         if (r == 0) break;
         if (r != MBEDTLS_ERR_SSL_WANT_READ && r != MBEDTLS_ERR_SSL_WANT_WRITE) {
+            tls_resume_end(&s->ssl, host, port, resume_start, false);
             syslog_tls_teardown(s);
             return false;
         }
     }
+    tls_resume_end(&s->ssl, host, port, resume_start, true);
     s->handshake_ok = true;
     s->last_use_tick = xTaskGetTickCount();
     return true;
@@ -476,116 +440,263 @@ static constexpr TickType_t SYSLOG_TLS_IDLE_CLOSE_TICKS =
 // ---------------------------------------------------------------------------
 // Worker task.
 // ---------------------------------------------------------------------------
-static void syslog_task(void *pv)
-{
-  for (;;) {
-    ESP_LOGI(TAG, "syslog forwarder started -> %s:%u transport=%u",
-             s_cfg.server, s_cfg.port, s_cfg.transport);
 
+// Transport state of one forwarder cycle, owned by the worker.
+struct syslog_link {
     // Persistent TCP socket for the TCP transport.
-    int tcp_sock = -1;
+    int                  tcp_sock = -1;
     // Persistent UDP socket + resolved destination for the UDP transport.
     // Reused across log lines so we don't open/close a socket (and re-resolve
     // via getaddrinfo, which allocates) on every single message — that lwIP /
     // getaddrinfo churn adds up under high log volume and contributes to heap
     // fragmentation on the WROOM-32. Mirrors how the TCP path already keeps
     // its socket; rebuilt lazily only after a send failure.
-    int udp_sock = -1;
-    struct sockaddr_in udp_dst;
-    memset(&udp_dst, 0, sizeof(udp_dst));
+    int                  udp_sock = -1;
+    struct sockaddr_in   udp_dst = {};
+    // Persistent TLS session for the TLS transport. Lives on the worker's
+    // stack; mbedtls contexts inside it are set up lazily.
+    syslog_tls_session   tls;
+};
 
-    // Persistent TLS session for the TLS transport. Allocated once on the
-    // worker's stack; mbedtls contexts inside it are set up lazily.
-    syslog_tls_session tls;
+// UDP — one message per datagram (RFC 5426), sent as soon as it is
+// formatted; a batch costs one wakeup, not one send.
+static bool syslog_send_datagram(syslog_link *link, const char *buf, size_t len)
+{
+    if (link->udp_sock < 0 &&
+        s_running.load(std::memory_order_acquire)) {
+        link->udp_sock = resolve_and_connect_udp(s_cfg.server, s_cfg.port,
+                                                 &link->udp_dst);
+    }
+    if (link->udp_sock < 0) return false;
+    ssize_t w = sendto(link->udp_sock, buf, len, 0,
+                       (struct sockaddr *)&link->udp_dst, sizeof(link->udp_dst));
+    if (w < 0) {
+        // Socket went bad (e.g. interface cycled) — drop and rebuild on the
+        // next line. Best-effort, like the TCP path.
+        close(link->udp_sock);
+        link->udp_sock = -1;
+        return false;
+    }
+    return true;
+}
 
-    while (s_running.load()) {
-        struct syslog_entry e;
-        if (xQueueReceive(s_queue, &e, pdMS_TO_TICKS(500)) != pdTRUE) {
-            // Idle: opportunistically release the TLS session's mbedtls
-            // contexts if it has been quiet for a while, so the ~6-8 KB
-            // returns to the heap. Re-connected on the next log line.
-            if (tls.handshake_ok) {
-                const TickType_t now = xTaskGetTickCount();
-                if ((TickType_t)(now - tls.last_use_tick) >=
-                    SYSLOG_TLS_IDLE_CLOSE_TICKS) {
-                    syslog_tls_teardown(&tls);
-                }
-            }
-            continue;
+// TCP / TLS — one write for a whole batch of octet-counted frames.
+static bool syslog_send_stream(syslog_link *link, const char *buf, size_t len)
+{
+    if (s_cfg.transport == 1) {
+        // TCP — reconnect lazily and reuse the socket.
+        if (link->tcp_sock < 0 &&
+            s_running.load(std::memory_order_acquire)) {
+            link->tcp_sock = resolve_and_connect_tcp(s_cfg.server, s_cfg.port);
         }
-        if (e.len == 0) continue;
-
-        int severity = 6;
-        char tag[32] = "fw";
-        const char *message = e.line;
-        size_t message_len = e.len;
-        parse_idf_line(e.line, e.len, &severity, tag, sizeof(tag),
-                       &message, &message_len);
-
-        char wire[512];
-        size_t wire_len = 0;
-        format_rfc5424(wire, sizeof(wire), &wire_len, severity, tag,
-                       message, message_len, s_cfg.hostname);
-        if (wire_len == 0) continue;
-
-        if (s_cfg.transport == 0) {
-            // UDP — keep a persistent socket + resolved destination (analogous
-            // to the TCP path) instead of open/close + getaddrinfo per line.
-            if (udp_sock < 0 &&
-                s_running.load(std::memory_order_acquire)) {
-                udp_sock = resolve_and_connect_udp(s_cfg.server, s_cfg.port, &udp_dst);
+        if (link->tcp_sock < 0) return false;
+        size_t written = 0;
+        while (written < len) {
+            ssize_t w = send(link->tcp_sock, buf + written, len - written, 0);
+            if (w <= 0) {
+                // A frame cut short here dies with the connection; the
+                // receiver never sees it spliced into the next one.
+                close(link->tcp_sock);
+                link->tcp_sock = -1;
+                return false;
             }
-            if (udp_sock >= 0) {
-                ssize_t w = sendto(udp_sock, wire, wire_len, 0,
-                                   (struct sockaddr *)&udp_dst, sizeof(udp_dst));
-                if (w < 0) {
-                    // Socket went bad (e.g. interface cycled) — drop and rebuild
-                    // on the next line. Best-effort, like the TCP path.
-                    close(udp_sock);
-                    udp_sock = -1;
-                }
+            written += (size_t)w;
+        }
+        return true;
+    }
+
+    // TLS — persistent session, reconnect on failure.
+    //
+    // Skip while a manual firmware upload is in progress: the upload owns
+    // g_net_fetch_mutex while writing, and contending for it (or opening a
+    // second TLS context) risks starving the upload of heap. The batch is
+    // dropped; the queue keeps moving.
+    bool sent = false;
+    if (!net_fetch_ota_active() && g_net_fetch_mutex) {
+        if (xSemaphoreTake(g_net_fetch_mutex, 0) == pdTRUE) {
+            crash_blackbox_net_op_begin("syslog_tls");
+            events_close_idle_connections();
+            // Stop may race with the non-blocking mutex acquisition.
+            // Recheck after ownership so no TLS setup begins while the
+            // lifecycle is already unwinding.
+            if (s_running.load(std::memory_order_acquire)) {
+                sent = syslog_tls_send(&link->tls, s_cfg.server, s_cfg.port,
+                                       buf, len);
             }
-        } else if (s_cfg.transport == 1) {
-            // TCP — reconnect lazily and reuse the socket.
-            if (tcp_sock < 0 &&
-                s_running.load(std::memory_order_acquire)) {
-                tcp_sock = resolve_and_connect_tcp(s_cfg.server, s_cfg.port);
+            crash_blackbox_net_op_end();
+            xSemaphoreGive(g_net_fetch_mutex);
+        }
+    }
+    return sent;
+}
+
+static void syslog_account(bool sent, uint32_t lines, size_t bytes)
+{
+    if (sent) {
+        g_lines_sent.inc(lines);
+        g_bytes_sent.inc((uint32_t)bytes);
+        g_writes.inc();
+    } else {
+        g_send_failed.inc(lines);
+    }
+}
+
+// Forward everything queued. Only the message of each line is rendered; its
+// severity, tag and capture time come with the entry. For TCP and TLS the
+// frames collect in s_batch and go out in as few writes as fit.
+static void syslog_drain(syslog_link *link)
+{
+    const syslog_format_t format = static_cast<syslog_format_t>(s_cfg.format);
+    // Wall-clock work belongs to the worker, never the LogManager callback.
+    // RFC 5424 carries one timestamp per drain: a batch spans at most the
+    // batch window. If time conversion fails, RFC 5424 permits NILVALUE
+    // ("-"). The structured formats date every line from its capture time
+    // against one clock reading per drain.
+    char ts[24] = "-";
+    uint64_t epoch_now_ms = 0;
+    const uint32_t uptime_now_ms = esp_log_timestamp();
+    if (format == SYSLOG_FORMAT_RFC5424) {
+        time_t secs = time(NULL);
+        struct tm tmv;
+        if (gmtime_r(&secs, &tmv) == NULL ||
+            strftime(ts, sizeof(ts), "%Y-%m-%dT%H:%M:%SZ", &tmv) == 0) {
+            strcpy(ts, "-");
+        }
+    } else {
+        struct timeval tv;
+        if (gettimeofday(&tv, NULL) == 0 && tv.tv_sec >= 1577836800l) {  // 2020-01-01
+            epoch_now_ms = (uint64_t)tv.tv_sec * 1000 + (uint64_t)(tv.tv_usec / 1000);
+        }
+    }
+
+    const bool stream = s_cfg.transport != 0;
+    uint8_t record[SYSLOG_META_MAX + LOG_ENTRY_MAX];
+    char message[LOG_LINE_MAX];
+    char tag[32];
+    char task[configMAX_TASK_NAME_LEN + 1];
+    char wire[SYSLOG_FRAME_MAX];
+    size_t batch_len = 0;
+    uint32_t batch_lines = 0;
+    uint32_t lines = 0;
+
+    while (s_running.load(std::memory_order_acquire)) {
+        const size_t len = s_queue.pop(record, sizeof(record));
+        if (len == 0) break;
+        const size_t meta_len = 1 + (size_t)record[0];
+        if (meta_len >= len) continue;
+        const uint8_t *entry = record + meta_len;
+        const size_t entry_len = len - meta_len;
+        const size_t message_len = log_entry_message(entry, entry_len, message, sizeof(message));
+        // Nothing to send: a blank line, or a corrupt entry.
+        if (message_len == 0) continue;
+
+        const char level = log_entry_level(entry, entry_len);
+        const int severity = level ? syslog_severity_from_level(level) : 6;
+        if (log_entry_tag(entry, entry_len, tag, sizeof(tag)) == 0) strcpy(tag, "fw");
+        lines++;
+
+        char *out = stream ? s_batch + batch_len : wire;
+        size_t cap = stream ? SYSLOG_BATCH_BYTES - batch_len : sizeof(wire);
+        if (stream && cap < SYSLOG_FRAME_MAX) {
+            syslog_account(syslog_send_stream(link, s_batch, batch_len),
+                           batch_lines, batch_len);
+            batch_len = 0;
+            batch_lines = 0;
+            out = s_batch;
+            cap = SYSLOG_BATCH_BYTES;
+        }
+        if (cap > SYSLOG_FRAME_MAX) cap = SYSLOG_FRAME_MAX;
+
+        size_t n;
+        if (format == SYSLOG_FORMAT_RFC5424) {
+            n = syslog_format_frame(out, cap, severity, tag, message, message_len,
+                                    s_cfg.hostname, ts, stream);
+        } else {
+            SyslogFields fields = {};
+            fields.severity = severity;
+            fields.level = level;
+            fields.tag = tag;
+            fields.core = -1;
+            fields.task = "";
+            if (record[0] >= 1 && record[0] <= sizeof(task)) {
+                const size_t task_len = (size_t)record[0] - 1;
+                fields.core = record[1];
+                memcpy(task, record + 2, task_len);
+                task[task_len] = '\0';
+                fields.task = task;
             }
-            if (tcp_sock >= 0) {
-                ssize_t w = send(tcp_sock, wire, wire_len, 0);
-                if (w <= 0) {
-                    close(tcp_sock);
-                    tcp_sock = -1;
-                }
+            fields.uptime_ms = log_entry_timestamp(entry);
+            if (epoch_now_ms > 0) {
+                // Signed: a line captured during the drain is newer than
+                // the clock reading.
+                const int32_t age_ms = (int32_t)(uptime_now_ms - fields.uptime_ms);
+                fields.epoch_ms = (uint64_t)((int64_t)epoch_now_ms - age_ms);
             }
-        } else {
-            // TLS — persistent session, reconnect on failure.
-            //
-            // Skip while a manual firmware upload is in progress: the upload
-            // owns g_net_fetch_mutex while writing, and contending
-            // for it (or opening a second TLS context) risks starving the
-            // upload of heap. The log line is dropped; the queue keeps moving.
-            if (!net_fetch_ota_active() && g_net_fetch_mutex) {
-                if (xSemaphoreTake(g_net_fetch_mutex, 0) == pdTRUE) {
-                    crash_blackbox_net_op_begin("syslog_tls");
-                    // Stop may race with the non-blocking mutex acquisition.
-                    // Recheck after ownership so no TLS setup begins while the
-                    // lifecycle is already unwinding.
-                    if (s_running.load(std::memory_order_acquire)) {
-                        syslog_tls_send(&tls, s_cfg.server, s_cfg.port,
-                                        wire, wire_len);
+            n = syslog_format_structured(out, cap, format, fields, message, message_len,
+                                         s_cfg.hostname, stream);
+        }
+        if (n == 0) continue;
+
+        if (!stream) {
+            syslog_account(syslog_send_datagram(link, wire, n), 1, n);
+            continue;
+        }
+        batch_len += n;
+        if (++batch_lines >= SYSLOG_BATCH_LINES) {
+            syslog_account(syslog_send_stream(link, s_batch, batch_len),
+                           batch_lines, batch_len);
+            batch_len = 0;
+            batch_lines = 0;
+        }
+    }
+    if (batch_lines > 0) {
+        syslog_account(syslog_send_stream(link, s_batch, batch_len),
+                       batch_lines, batch_len);
+    }
+    if (lines > 0) g_batch_lines_max.record(lines);
+}
+
+static void syslog_task(void *pv)
+{
+  for (;;) {
+    ESP_LOGI(TAG, "syslog forwarder started -> %s:%u transport=%u",
+             s_cfg.server, s_cfg.port, s_cfg.transport);
+
+    syslog_link link;
+
+    while (s_running.load()) {
+        if (s_queue.usedBytes() == 0) {
+            ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(500));
+            if (s_queue.usedBytes() == 0) {
+                // Idle: opportunistically release the TLS session's mbedtls
+                // contexts if it has been quiet for a while, so the ~6-8 KB
+                // returns to the heap. Re-connected on the next log line.
+                if (link.tls.handshake_ok) {
+                    const TickType_t now = xTaskGetTickCount();
+                    if ((TickType_t)(now - link.tls.last_use_tick) >=
+                        SYSLOG_TLS_IDLE_CLOSE_TICKS) {
+                        syslog_tls_teardown(&link.tls);
                     }
-                    crash_blackbox_net_op_end();
-                    xSemaphoreGive(g_net_fetch_mutex);
                 }
+                continue;
             }
         }
+        // The first line of a burst woke us; let the rest of it arrive
+        // unless the queue is already half full or a stop is pending.
+        if (s_queue.usedBytes() < SYSLOG_QUEUE_BYTES / 2) {
+            ulTaskNotifyTake(pdTRUE, SYSLOG_BATCH_WINDOW);
+        }
+        syslog_drain(&link);
     }
 
-    if (tcp_sock >= 0) close(tcp_sock);
-    if (udp_sock >= 0) close(udp_sock);
-    syslog_tls_teardown(&tls);
+    if (link.tcp_sock >= 0) close(link.tcp_sock);
+    if (link.udp_sock >= 0) close(link.udp_sock);
+    syslog_tls_teardown(&link.tls);
     ESP_LOGI(TAG, "syslog forwarder stopped");
+    // A logging task that passed the running check before the stop may
+    // still be about to notify this task; let it leave before s_task can
+    // be cleared and the task deleted.
+    while (s_producers.load(std::memory_order_acquire) != 0) vTaskDelay(1);
     SemaphoreHandle_t mutex = syslog_mutex();
     xSemaphoreTake(mutex, portMAX_DELAY);
     if (s_restart_requested.exchange(false, std::memory_order_acq_rel)) {
@@ -594,7 +705,8 @@ static void syslog_task(void *pv)
         // instead of racing a second task against the old cleanup path.
         memcpy(&s_cfg, &s_pending_cfg, sizeof(s_cfg));
         s_min_severity.store(s_cfg.min_severity, std::memory_order_release);
-        if (s_queue) xQueueReset(s_queue);
+        s_structured.store(s_cfg.format != SYSLOG_FORMAT_RFC5424, std::memory_order_release);
+        s_queue.discard();
         s_running.store(true, std::memory_order_release);
         LogManager::instance().addSubscriber(syslog_subscriber);
         xSemaphoreGive(mutex);
@@ -645,16 +757,20 @@ esp_err_t syslog_start(const syslog_config_t *config)
 
     normalise_config(&s_cfg, config);
     s_min_severity.store(s_cfg.min_severity, std::memory_order_release);
+    s_structured.store(s_cfg.format != SYSLOG_FORMAT_RFC5424, std::memory_order_release);
 
-    if (s_queue == NULL) {
-        s_queue = xQueueCreate(QUEUE_DEPTH, sizeof(struct syslog_entry));
-        if (!s_queue) {
+    if (!s_queue.attached()) {
+        // Never freed: see SYSLOG_QUEUE_BYTES.
+        char *storage = (char *)malloc(SYSLOG_QUEUE_BYTES + SYSLOG_BATCH_BYTES);
+        if (!storage) {
             xSemaphoreGive(mutex);
             ESP_LOGE(TAG, "queue create failed");
             return ESP_ERR_NO_MEM;
         }
+        s_queue.attach(storage, SYSLOG_QUEUE_BYTES);
+        s_batch = storage + SYSLOG_QUEUE_BYTES;
     }
-    xQueueReset(s_queue);
+    s_queue.discard();
 
     s_restart_requested.store(false, std::memory_order_release);
     s_running.store(true, std::memory_order_release);
@@ -692,9 +808,8 @@ esp_err_t syslog_stop(void)
     s_running.store(false, std::memory_order_release);
     LogManager::instance().removeSubscriber(syslog_subscriber);
 
-    // Wake the worker by sending a no-op so it exits its queue wait.
-    struct syslog_entry empty = {};
-    if (s_queue) xQueueSend(s_queue, &empty, 0);
+    // Wake the worker so it leaves its queue wait.
+    xTaskNotifyGive(task);
     xSemaphoreGive(mutex);
 
     // Connect and socket I/O are bounded to 3 s; handshake/write loops also
@@ -0,0 +1,307 @@
+/*
+ *  syslog_batch.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "syslog_batch.h"
+#include <new>
+#include <stdio.h>
+#include <string.h>
+
+static constexpr uint32_t READY = 0x80000000u;
+
+static uint32_t record_words(size_t len) {
+    return 1 + (uint32_t)((len + 3) / 4);
+}
+
+void SyslogQueue::attach(void *storage, size_t bytes) {
+    const uint32_t count = (uint32_t)(bytes / sizeof(uint32_t));
+    std::atomic<uint32_t> *words = static_cast<std::atomic<uint32_t> *>(storage);
+    for (uint32_t i = 0; i < count; i++) new (&words[i]) std::atomic<uint32_t>(0);
+    _mask = count - 1;
+    _head.store(0, std::memory_order_relaxed);
+    _tail.store(0, std::memory_order_relaxed);
+    _words.store(words, std::memory_order_release);
+}
+
+bool SyslogQueue::push(const uint8_t *data, size_t len, bool *wake) {
+    return push(nullptr, 0, data, len, wake);
+}
+
+bool SyslogQueue::push(const uint8_t *prefix, size_t prefix_len, const uint8_t *data,
+                       size_t len, bool *wake) {
+    if (wake) *wake = false;
+    std::atomic<uint32_t> *words = _words.load(std::memory_order_acquire);
+    const size_t total = prefix_len + len;
+    const uint32_t need = record_words(total);
+    if (!words || total == 0 || total > MAX_RECORD || need > _mask + 1) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint32_t head = _head.load(std::memory_order_relaxed);
+    uint32_t used;
+    do {
+        // Acquire pairs with the consumer's release of the tail: the words
+        // it zeroed are visible before this producer writes over them.
+        used = head - _tail.load(std::memory_order_acquire);
+        if (used + need > _mask + 1) {
+            _dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!_head.compare_exchange_weak(head, head + need, std::memory_order_relaxed));
+
+    // Pack the bytes little-endian into the data words, then publish.
+    for (uint32_t w = 1; w < need; w++) {
+        uint32_t value = 0;
+        const size_t at = (size_t)(w - 1) * 4;
+        for (size_t b = 0; b < 4 && at + b < total; b++) {
+            const size_t i = at + b;
+            value |= (uint32_t)(i < prefix_len ? prefix[i] : data[i - prefix_len]) << (8 * b);
+        }
+        words[(head + w) & _mask].store(value, std::memory_order_relaxed);
+    }
+    words[head & _mask].store((uint32_t)total | READY, std::memory_order_release);
+
+    if (wake) {
+        const uint32_t half = (_mask + 1) / 2;
+        *wake = used == 0 || (used < half && used + need >= half);
+    }
+    return true;
+}
+
+size_t SyslogQueue::consume(uint8_t *dst, size_t max) {
+    std::atomic<uint32_t> *words = _words.load(std::memory_order_acquire);
+    if (!words) return 0;
+    const uint32_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) return 0;
+    const uint32_t header = words[tail & _mask].load(std::memory_order_acquire);
+    if (!(header & READY)) return 0;
+
+    const size_t len = header & ~READY;
+    const uint32_t need = record_words(len);
+    const bool keep = dst && len <= max;
+    for (uint32_t w = 1; w < need; w++) {
+        std::atomic<uint32_t> &word = words[(tail + w) & _mask];
+        if (keep) {
+            const uint32_t value = word.load(std::memory_order_relaxed);
+            const size_t at = (size_t)(w - 1) * 4;
+            for (size_t b = 0; b < 4 && at + b < len; b++) dst[at + b] = (uint8_t)(value >> (8 * b));
+        }
+        word.store(0, std::memory_order_relaxed);
+    }
+    words[tail & _mask].store(0, std::memory_order_relaxed);
+    _tail.store(tail + need, std::memory_order_release);
+    if (dst && !keep) {
+        _dropped.fetch_add(1, std::memory_order_relaxed);
+        return consume(dst, max);
+    }
+    return len;
+}
+
+size_t SyslogQueue::pop(uint8_t *dst, size_t max) {
+    return consume(dst, max);
+}
+
+void SyslogQueue::discard() {
+    while (consume(nullptr, 0) > 0) {
+    }
+}
+
+size_t SyslogQueue::usedBytes() const {
+    const uint32_t used = _head.load(std::memory_order_relaxed) -
+                          _tail.load(std::memory_order_relaxed);
+    return (size_t)used * sizeof(uint32_t);
+}
+
+int syslog_severity_from_level(char level)
+{
+    switch (level) {
+        case 'E': return 3;  // ERROR
+        case 'W': return 4;  // WARNING
+        case 'I': return 5;  // NOTICE/INFO
+        case 'D': return 7;  // DEBUG
+        case 'V': return 7;  // VERBOSE -> DEBUG
+        default:  return 5;
+    }
+}
+
+size_t syslog_format_frame(char *out, size_t cap, int severity, const char *tag,
+                           const char *msg, size_t msg_len, const char *hostname,
+                           const char *timestamp, bool octet_counted)
+{
+    // Room for "NNN " in front; a frame never reaches four digits.
+    static constexpr size_t PREFIX = 4;
+    if (cap <= PREFIX) return 0;
+    // An unparsed line still ends in the newline the UART needed; the frame
+    // adds its own terminator or length.
+    if (msg_len > 0 && msg && msg[msg_len - 1] == '\n') msg_len--;
+    if (msg_len > SYSLOG_MSG_MAX) msg_len = SYSLOG_MSG_MAX;
+
+    // Facility = 1 (user-level). PRI = facility*8 + severity.
+    char *body = octet_counted ? out + PREFIX : out;
+    const size_t body_cap = octet_counted ? cap - PREFIX : cap;
+    int n = snprintf(body, body_cap, "<%d>1 %s %s fw %s - - %.*s%s",
+                     8 + severity, timestamp ? timestamp : "-",
+                     (hostname && hostname[0]) ? hostname : "hb-rf-eth-ng",
+                     tag ? tag : "fw", (int)msg_len, msg ? msg : "",
+                     octet_counted ? "" : "\n");
+    if (n < 0) return 0;
+    size_t body_len = (size_t)n < body_cap ? (size_t)n : body_cap - 1;
+    if (!octet_counted) return body_len;
+
+    char prefix[PREFIX + 1];
+    const int p = snprintf(prefix, sizeof(prefix), "%u ", (unsigned)body_len);
+    if (p <= 0 || (size_t)p > PREFIX) return 0;
+    memmove(out + p, body, body_len);
+    memcpy(out, prefix, (size_t)p);
+    return (size_t)p + body_len;
+}
+
+// ---------------------------------------------------------------------------
+// GELF / JSON lines.
+// ---------------------------------------------------------------------------
+struct JsonOut {
+    char *out;
+    size_t cap;
+    size_t n;
+    bool full;
+};
+
+static void json_raw(JsonOut *j, const char *text, size_t len)
+{
+    if (j->full || len > j->cap - j->n) {
+        j->full = true;
+        return;
+    }
+    memcpy(j->out + j->n, text, len);
+    j->n += len;
+}
+
+static void json_printf_u64(JsonOut *j, const char *key, uint64_t value)
+{
+    char buf[48];
+    const int n = snprintf(buf, sizeof(buf), ",\"%s\":%llu", key, (unsigned long long)value);
+    if (n > 0) json_raw(j, buf, (size_t)n);
+}
+
+// Quoted, escaped string. With keep > 0 the text is cut, between
+// characters, so that keep bytes stay free behind the closing quote.
+static void json_string(JsonOut *j, const char *text, size_t len, size_t keep)
+{
+    json_raw(j, "\"", 1);
+    for (size_t i = 0; i < len && !j->full; i++) {
+        const unsigned char c = (unsigned char)text[i];
+        char esc[8];
+        size_t esc_len = 1;
+        esc[0] = (char)c;
+        if (c == '"' || c == '\\') {
+            esc[0] = '\\';
+            esc[1] = (char)c;
+            esc_len = 2;
+        } else if (c == '\n' || c == '\r' || c == '\t') {
+            esc[0] = '\\';
+            esc[1] = c == '\n' ? 'n' : (c == '\r' ? 'r' : 't');
+            esc_len = 2;
+        } else if (c < 0x20 || c == 0x7F) {
+            // Colour escapes and other control bytes.
+            esc_len = (size_t)snprintf(esc, sizeof(esc), "\\u%04x", c);
+        }
+        if (keep > 0 && j->n + esc_len + 1 + keep > j->cap) {
+            // Do not leave half of a UTF-8 sequence behind.
+            while (j->n > 0 && i > 0 && ((unsigned char)text[i] & 0xC0) == 0x80) {
+                i--;
+                j->n--;
+            }
+            break;
+        }
+        json_raw(j, esc, esc_len);
+    }
+    json_raw(j, "\"", 1);
+}
+
+size_t syslog_format_structured(char *out, size_t cap, syslog_format_t format,
+                                const SyslogFields &fields, const char *msg,
+                                size_t msg_len, const char *hostname, bool stream)
+{
+    if (!out || cap == 0) return 0;
+    if (msg_len > 0 && msg && msg[msg_len - 1] == '\n') msg_len--;
+    if (msg_len > SYSLOG_MSG_MAX) msg_len = SYSLOG_MSG_MAX;
+    if (!msg) msg_len = 0;
+    const char *host = (hostname && hostname[0]) ? hostname : "hb-rf-eth-ng";
+    const char *tag = fields.tag ? fields.tag : "";
+    const char *task = fields.task ? fields.task : "";
+    const char level[2] = {fields.level ? fields.level : '-', '\0'};
+    const bool gelf = format == SYSLOG_FORMAT_GELF;
+
+    JsonOut j = {out, cap, 0, false};
+    char buf[48];
+    if (gelf) {
+        json_raw(&j, "{\"version\":\"1.1\",\"host\":", 24);
+        json_string(&j, host, strlen(host), 0);
+        if (fields.epoch_ms > 0) {
+            const int n = snprintf(buf, sizeof(buf), ",\"timestamp\":%llu.%03u",
+                                   (unsigned long long)(fields.epoch_ms / 1000),
+                                   (unsigned)(fields.epoch_ms % 1000));
+            if (n > 0) json_raw(&j, buf, (size_t)n);
+        }
+        json_printf_u64(&j, "level", (uint64_t)fields.severity);
+        json_raw(&j, ",\"_level\":", 10);
+        json_string(&j, level, 1, 0);
+        json_raw(&j, ",\"_tag\":", 8);
+        json_string(&j, tag, strlen(tag), 0);
+        json_raw(&j, ",\"_task\":", 9);
+        json_string(&j, task, strlen(task), 0);
+        if (fields.core >= 0) json_printf_u64(&j, "_core", (uint64_t)fields.core);
+        json_printf_u64(&j, "_uptime_ms", fields.uptime_ms);
+        json_raw(&j, ",\"short_message\":", 17);
+    } else {
+        if (fields.epoch_ms > 0) {
+            const int n = snprintf(buf, sizeof(buf), "{\"ts\":%llu.%03u,\"uptime_ms\":%u",
+                                   (unsigned long long)(fields.epoch_ms / 1000),
+                                   (unsigned)(fields.epoch_ms % 1000),
+                                   (unsigned)fields.uptime_ms);
+            if (n > 0) json_raw(&j, buf, (size_t)n);
+        } else {
+            const int n = snprintf(buf, sizeof(buf), "{\"ts\":null,\"uptime_ms\":%u",
+                                   (unsigned)fields.uptime_ms);
+            if (n > 0) json_raw(&j, buf, (size_t)n);
+        }
+        json_raw(&j, ",\"host\":", 8);
+        json_string(&j, host, strlen(host), 0);
+        json_printf_u64(&j, "severity", (uint64_t)fields.severity);
+        json_raw(&j, ",\"level\":", 9);
+        json_string(&j, level, 1, 0);
+        json_raw(&j, ",\"tag\":", 7);
+        json_string(&j, tag, strlen(tag), 0);
+        json_raw(&j, ",\"task\":", 8);
+        json_string(&j, task, strlen(task), 0);
+        if (fields.core >= 0) json_printf_u64(&j, "core", (uint64_t)fields.core);
+        json_raw(&j, ",\"msg\":", 7);
+    }
+
+    // The message goes last and gives way: "}" and the terminator stay.
+    const bool terminated = stream || !gelf;
+    json_string(&j, msg_len ? msg : "", msg_len, terminated ? 2 : 1);
+    json_raw(&j, "}", 1);
+    if (terminated) json_raw(&j, gelf ? "\0" : "\n", 1);
+    return j.full ? 0 : j.n;
+}
@@ -29,6 +29,7 @@
 #include "freertos/task.h"
 #include "pins.h"
 #include "monitoring.h"
+#include "log_journal.h"
 #include <atomic>
 
 static const char *TAG = "SystemReset";
@@ -201,6 +202,9 @@ static void full_system_restart_impl(bool operation_reserved) {
     vTaskDelay(pdMS_TO_TICKS(50));
 
     ESP_LOGI(TAG, "Peripherals reset complete. Restarting ESP32...");
+    // Pending journal lines would otherwise wait for the next batch, which
+    // never comes.
+    log_journal_flush();
     esp_restart();
 }
 
@@ -24,34 +24,42 @@
 #include "systemclock.h"
 #include <sys/time.h>
 #include <time.h>
+#include <math.h>
 #include "esp_log.h"
+#include "esp_timer.h"
+#include "metrics.h"
 
 static const char *TAG = "SystemClock";
 
+static MetricsCounter g_clock_steps("hbrfeth_clock_steps_total",
+                                    "System clock steps (initial sync, GPS/DCF updates, gross errors)");
+static MetricsCounter g_clock_slews("hbrfeth_clock_slews_total",
+                                    "System clock corrections applied by slewing");
+
 #define get_tzname(isdst) isdst > 0 ? *(tzname + 1) : *tzname
 
-void updateRtcTask(void *parameter)
+static int64_t timeval_to_us(const struct timeval *tv)
 {
-    Rtc *_rtc = (Rtc *)parameter;
-
-    for (;;)
-    {
-        if (ulTaskNotifyTake(pdTRUE, portMAX_DELAY) != 1)
-            continue;
-
-        struct timeval tv;
-        gettimeofday(&tv, NULL);
-        _rtc->SetTime(tv);
+    return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
 
-        struct tm now;
-        localtime_r(&tv.tv_sec, &now);
+static struct timeval us_to_timeval(int64_t us)
+{
+    struct timeval tv;
+    tv.tv_sec = (time_t)(us / 1000000);
+    tv.tv_usec = (suseconds_t)(us % 1000000);
+    return tv;
+}
 
-        ESP_LOGI(TAG, "Updated RTC to %02d-%02d-%02d %02d:%02d:%02d %s", now.tm_year + 1900, now.tm_mon + 1, now.tm_mday, now.tm_hour, now.tm_min, now.tm_sec, get_tzname(now.tm_isdst));
-    }
+static void systemClockTask(void *parameter)
+{
+    ((SystemClock *)parameter)->_run();
+    vTaskDelete(NULL);
 }
 
 SystemClock::SystemClock(Rtc *rtc) : _rtc(rtc)
 {
+    _adjustMutex = xSemaphoreCreateMutex();
 }
 
 void SystemClock::start(void)
@@ -68,12 +76,14 @@ void SystemClock::start(void)
         struct tm *now = localtime(&nowtime);
 
         ESP_LOGI(TAG, "Updated time from RTC to %02d-%02d-%02d %02d:%02d:%02d %s", now->tm_year + 1900, now->tm_mon + 1, now->tm_mday, now->tm_hour, now->tm_min, now->tm_sec, get_tzname(now->tm_isdst));
+    }
 
-        if (xTaskCreate(updateRtcTask, "SystemClock_RtcUpdateTask",
-                        4096, _rtc, 10, &_tHandle) != pdPASS) {
-            _tHandle = NULL;
-            ESP_LOGE(TAG, "Failed to create RTC update task");
-        }
+    // The task also runs without an RTC: it applies the drift compensation.
+    _running = true;
+    if (xTaskCreate(systemClockTask, "SystemClock", 4096, this, 10, &_tHandle) != pdPASS) {
+        _tHandle = NULL;
+        _running = false;
+        ESP_LOGE(TAG, "Failed to create system clock task");
     }
 }
 
@@ -81,24 +91,197 @@ void SystemClock::stop(void)
 {
     if (_tHandle != NULL)
     {
-        vTaskDelete(_tHandle);
+        _running = false;
+        xTaskNotifyGive(_tHandle);
         _tHandle = NULL;
     }
 }
 
-void SystemClock::setTime(struct timeval *tv)
+void SystemClock::_run()
+{
+    portENTER_CRITICAL(&_syncTimeMux);
+    _lastTick_us = esp_timer_get_time();
+    portEXIT_CRITICAL(&_syncTimeMux);
+
+    while (_running)
+    {
+        if (ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(CLOCK_DISCIPLINE_TICK_MS)) == 0)
+        {
+            disciplineTick();
+            continue;
+        }
+        if (!_running || !_rtc)
+            continue;
+
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        _rtc->SetTime(tv);
+
+        struct tm now;
+        localtime_r(&tv.tv_sec, &now);
+
+        ESP_LOGI(TAG, "Updated RTC to %02d-%02d-%02d %02d:%02d:%02d %s", now.tm_year + 1900, now.tm_mon + 1, now.tm_mday, now.tm_hour, now.tm_min, now.tm_sec, get_tzname(now.tm_isdst));
+    }
+}
+
+// Fold one phase sample into the drift estimate. `offset_us` is the error of
+// the local clock (reference minus local) just before it gets corrected.
+// Callers hold _adjustMutex, which serialises every writer of the discipline
+// state; _syncTimeMux only covers copying it in and out, so the soft-float
+// math runs with interrupts enabled.
+void SystemClock::discipline(int64_t offset_us, uint32_t error_us)
+{
+    int64_t now = esp_timer_get_time();
+    if (error_us < CLOCK_MIN_SAMPLE_ERROR_US)
+        error_us = CLOCK_MIN_SAMPLE_ERROR_US;
+
+    portENTER_CRITICAL(&_syncTimeMux);
+    double drift = _drift_ppm;
+    double driftVar = _driftVar;
+    bool locked = _locked;
+    int64_t lastSample_us = _lastSample_us;
+    int64_t lastTick_us = _lastTick_us;
+    uint32_t lastError_us = _lastError_us;
+    double tickResidual_us = _tickResidual_us;
+    portEXIT_CRITICAL(&_syncTimeMux);
+
+    // Compensation accrued since the last tick has not reached the clock yet.
+    // Count it as applied: the caller's correction covers it from here on.
+    double pending = locked ? -drift * (double)(now - lastTick_us) / 1e6 : 0;
+    double residual = (double)offset_us - pending - tickResidual_us;
+
+    double dt = (double)(now - lastSample_us) / 1e6;
+    bool outlier = false;
+    if (lastSample_us != 0 && dt >= 1.0)
+    {
+        double measured = -residual / dt; // residual frequency error, ppm
+        driftVar += CLOCK_DRIFT_WANDER_PPM2_PER_S * dt;
+        if (fabs(drift + measured) > CLOCK_MAX_DRIFT_PPM)
+        {
+            // A phase jump (reboot of the source, manual time change), not drift.
+            outlier = true;
+        }
+        else
+        {
+            double prevErr = (double)lastError_us;
+            double curErr = (double)error_us;
+            double r = (prevErr * prevErr + curErr * curErr) / (dt * dt);
+            double k = driftVar / (driftVar + r);
+            drift += k * measured;
+            driftVar *= 1.0 - k;
+            locked = true;
+        }
+    }
+
+    portENTER_CRITICAL(&_syncTimeMux);
+    _drift_ppm = drift;
+    _driftVar = driftVar;
+    _locked = locked;
+    _lastTick_us = now;
+    _tickResidual_us = 0;
+    _lastSample_us = now;
+    _lastError_us = error_us;
+    _lastOffset_us = offset_us;
+    portEXIT_CRITICAL(&_syncTimeMux);
+
+    if (outlier)
+        ESP_LOGW(TAG, "Ignoring %lld us clock offset for drift estimation", (long long)offset_us);
+    else
+        ESP_LOGD(TAG, "Offset %lld us, drift %.3f +/- %.3f ppm", (long long)offset_us, drift,
+                 sqrt(driftVar));
+}
+
+// Remove the estimated drift accumulated since the previous tick. Whole
+// microseconds are added on top of any correction adjtime() is still working
+// off; the fraction carries over to the next tick.
+void SystemClock::disciplineTick()
+{
+    // Taken first: discipline() writes the tick state under the same mutex.
+    xSemaphoreTake(_adjustMutex, portMAX_DELAY);
+    int64_t now = esp_timer_get_time();
+
+    portENTER_CRITICAL(&_syncTimeMux);
+    bool locked = _locked;
+    double drift = _drift_ppm;
+    int64_t lastTick_us = _lastTick_us;
+    double tickResidual_us = _tickResidual_us;
+    portEXIT_CRITICAL(&_syncTimeMux);
+
+    double correction = 0;
+    if (locked)
+        correction = -drift * (double)(now - lastTick_us) / 1e6 + tickResidual_us;
+    int64_t apply = (int64_t)correction;
+
+    portENTER_CRITICAL(&_syncTimeMux);
+    _lastTick_us = now;
+    _tickResidual_us = correction - (double)apply;
+    portEXIT_CRITICAL(&_syncTimeMux);
+
+    if (apply == 0)
+    {
+        xSemaphoreGive(_adjustMutex);
+        return;
+    }
+
+    struct timeval remaining;
+    int64_t outstanding = 0;
+    if (adjtime(NULL, &remaining) == 0)
+        outstanding = timeval_to_us(&remaining);
+    struct timeval delta = us_to_timeval(outstanding + apply);
+    if (adjtime(&delta, NULL) != 0)
+        ESP_LOGW(TAG, "adjtime(%lld us) refused, drift compensation skipped", (long long)apply);
+    xSemaphoreGive(_adjustMutex);
+}
+
+void SystemClock::markSynced(const struct timeval *tv)
 {
-    settimeofday(tv, NULL);
     portENTER_CRITICAL(&_syncTimeMux);
     _lastSyncTime = *tv;
     portEXIT_CRITICAL(&_syncTimeMux);
 
-    if (_tHandle != NULL)
+    if (_tHandle != NULL && _rtc)
     {
         xTaskNotifyGive(_tHandle);
     }
 }
 
+void SystemClock::setTime(struct timeval *tv, uint32_t error_us)
+{
+    xSemaphoreTake(_adjustMutex, portMAX_DELAY);
+    struct timeval now;
+    gettimeofday(&now, NULL);
+    discipline(timeval_to_us(tv) - timeval_to_us(&now), error_us);
+
+    g_clock_steps.inc();
+    settimeofday(tv, NULL);
+    xSemaphoreGive(_adjustMutex);
+
+    markSynced(tv);
+}
+
+void SystemClock::adjustTime(int64_t offset_us, uint32_t error_us)
+{
+    struct timeval delta = us_to_timeval(offset_us);
+    struct timeval now;
+
+    xSemaphoreTake(_adjustMutex, portMAX_DELAY);
+    if (adjtime(&delta, NULL) != 0)
+    {
+        xSemaphoreGive(_adjustMutex);
+        ESP_LOGW(TAG, "adjtime(%lld us) refused, stepping instead", (long long)offset_us);
+        gettimeofday(&now, NULL);
+        now = us_to_timeval(timeval_to_us(&now) + offset_us);
+        setTime(&now, error_us);
+        return;
+    }
+    discipline(offset_us, error_us);
+    xSemaphoreGive(_adjustMutex);
+
+    g_clock_slews.inc();
+    gettimeofday(&now, NULL);
+    markSynced(&now);
+}
+
 struct timeval SystemClock::getTime()
 {
     struct timeval tv;
@@ -114,6 +297,33 @@ struct timeval SystemClock::getLastSyncTime()
     return tv;
 }
 
+clock_discipline_t SystemClock::getDiscipline()
+{
+    int64_t now = esp_timer_get_time();
+    clock_discipline_t d;
+
+    portENTER_CRITICAL(&_syncTimeMux);
+    d.drift_ppm = _drift_ppm;
+    d.offset_us = _lastOffset_us;
+    d.locked = _locked;
+    double driftVar = _driftVar;
+    int64_t lastSample_us = _lastSample_us;
+    uint32_t lastError_us = _lastError_us;
+    portEXIT_CRITICAL(&_syncTimeMux);
+
+    d.error_us = -1;
+    if (lastSample_us != 0)
+    {
+        // Source error at the last sample plus what the remaining frequency
+        // uncertainty (including wander since then) has accumulated in holdover.
+        double age = (double)(now - lastSample_us) / 1e6;
+        double sigma = sqrt(driftVar + CLOCK_DRIFT_WANDER_PPM2_PER_S * age);
+        d.error_us = (int64_t)lastError_us + (int64_t)(sigma * age);
+    }
+
+    return d;
+}
+
 struct tm SystemClock::getLocalTime(void)
 {
     time_t now;
@@ -0,0 +1,131 @@
+/*
+ *  tls_resume.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "tls_resume.h"
+#include "tls_session_cache.h"
+#include "metrics.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include <inttypes.h>
+#include <stdlib.h>
+
+static const char *TAG = "TLSResume";
+
+static TlsSessionCache s_cache;
+static StaticSemaphore_t s_cache_mutex_buffer;
+
+static MetricsCounter g_handshakes("hbrfeth_tls_handshakes_total",
+                                   "Completed TLS client handshakes (syslog, SMTP)");
+static MetricsCounter g_resumed("hbrfeth_tls_resumed_total",
+                                "TLS client handshakes abbreviated by session resumption");
+static MetricsCounter g_handshake_ms("hbrfeth_tls_handshake_ms_total",
+                                     "Time spent in completed TLS client handshakes");
+static MetricsHighWater g_handshake_ms_max("hbrfeth_tls_handshake_ms_max",
+                                           "Longest completed TLS client handshake");
+
+static SemaphoreHandle_t cache_mutex()
+{
+    static SemaphoreHandle_t mutex =
+        xSemaphoreCreateMutexStatic(&s_cache_mutex_buffer);
+    return mutex;
+}
+
+int64_t tls_resume_begin(mbedtls_ssl_context *ssl, const char *host, uint16_t port)
+{
+    const int64_t now = esp_timer_get_time();
+    SemaphoreHandle_t mutex = cache_mutex();
+    if (!ssl || !host || !mutex) return now;
+
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    size_t len = 0;
+    const uint8_t *blob = s_cache.find(host, port, now, &len);
+    if (blob) {
+        mbedtls_ssl_session session;
+        mbedtls_ssl_session_init(&session);
+        // set_session copies; a blob from another mbedTLS build or one the
+        // server no longer accepts just means a full handshake.
+        if (mbedtls_ssl_session_load(&session, blob, len) != 0 ||
+            mbedtls_ssl_set_session(ssl, &session) != 0) {
+            s_cache.forget(host, port);
+        }
+        mbedtls_ssl_session_free(&session);
+    }
+    xSemaphoreGive(mutex);
+    return now;
+}
+
+// Serialize the session just negotiated into a blob of its exact size.
+static uint8_t *save_session(mbedtls_ssl_context *ssl, size_t *len)
+{
+    mbedtls_ssl_session session;
+    mbedtls_ssl_session_init(&session);
+    uint8_t *blob = NULL;
+    if (mbedtls_ssl_get_session(ssl, &session) == 0) {
+        size_t need = 0;
+        mbedtls_ssl_session_save(&session, NULL, 0, &need);
+        if (need > 0 && need <= TlsSessionCache::SESSION_MAX) {
+            blob = (uint8_t *)malloc(need);
+            if (blob && mbedtls_ssl_session_save(&session, blob, need, len) != 0) {
+                free(blob);
+                blob = NULL;
+            }
+        }
+    }
+    mbedtls_ssl_session_free(&session);
+    return blob;
+}
+
+void tls_resume_end(mbedtls_ssl_context *ssl, const char *host, uint16_t port,
+                    int64_t start_us, bool ok)
+{
+    SemaphoreHandle_t mutex = cache_mutex();
+    if (!ssl || !host || !mutex) return;
+
+    if (!ok) {
+        xSemaphoreTake(mutex, portMAX_DELAY);
+        s_cache.forget(host, port);
+        xSemaphoreGive(mutex);
+        return;
+    }
+
+    const int64_t now = esp_timer_get_time();
+    const uint32_t ms = (uint32_t)((now - start_us) / 1000);
+    const bool resumed = mbedtls_ssl_session_reused(ssl) != 0;
+    g_handshakes.inc();
+    g_handshake_ms.inc(ms);
+    g_handshake_ms_max.record(ms);
+    if (resumed) g_resumed.inc();
+    ESP_LOGD(TAG, "%s:%u %s handshake in %" PRIu32 " ms", host, port,
+             resumed ? "resumed" : "full", ms);
+
+    // A resumed session under TLS 1.2 may carry a fresh ticket; store it
+    // either way. Serialising happens outside the lock.
+    size_t len = 0;
+    uint8_t *blob = save_session(ssl, &len);
+    if (!blob) return;
+    xSemaphoreTake(mutex, portMAX_DELAY);
+    s_cache.adopt(host, port, now, blob, len);
+    xSemaphoreGive(mutex);
+}
@@ -0,0 +1,100 @@
+/*
+ *  tls_session_cache.cpp is part of the HB-RF-ETH firmware v2.0
+ *
+ *  Original work Copyright 2022 Alexander Reinert
+ *  https://github.com/alexreinert/HB-RF-ETH
+ *
+ *  Modified work Copyright 2025 Xerolux
+ *  Modernized fork - Updated to ESP-IDF 6.0 and modern toolchains
+ *
+ *  The HB-RF-ETH firmware is licensed under a
+ *  Creative Commons Attribution-NonCommercial-ShareAlike 4.0 International License.
+ *
+ *  You should have received a copy of the license along with this
+ *  work.  If not, see <http://creativecommons.org/licenses/by-nc-sa/4.0/>.
+ *
+ *  Unless required by applicable law or agreed to in writing, software
+ *  distributed under the License is distributed on an "AS IS" BASIS,
+ *  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *  See the License for the specific language governing permissions and
+ *  limitations under the License.
+ *
+ */
+
+#include "tls_session_cache.h"
+#include <stdlib.h>
+#include <string.h>
+
+TlsSessionCache::Slot *TlsSessionCache::slotFor(const char *host, uint16_t port) {
+    for (Slot &slot : _slots) {
+        if (slot.blob && slot.port == port && strcmp(slot.host, host) == 0) return &slot;
+    }
+    return nullptr;
+}
+
+void TlsSessionCache::release(Slot &slot) {
+    free(slot.blob);
+    slot = Slot();
+}
+
+const uint8_t *TlsSessionCache::find(const char *host, uint16_t port, int64_t now_us,
+                                     size_t *len) {
+    if (!host) return nullptr;
+    Slot *slot = slotFor(host, port);
+    if (!slot) return nullptr;
+    if (now_us - slot->stored_us > MAX_AGE_US) {
+        release(*slot);
+        return nullptr;
+    }
+    *len = slot->len;
+    return slot->blob;
+}
+
+bool TlsSessionCache::adopt(const char *host, uint16_t port, int64_t now_us, uint8_t *blob,
+                            size_t len) {
+    if (!host || !blob || len == 0 || len > SESSION_MAX || strlen(host) >= HOST_MAX) {
+        free(blob);
+        return false;
+    }
+    Slot *slot = slotFor(host, port);
+    if (!slot) {
+        // A free slot, else the one stored longest ago.
+        slot = &_slots[0];
+        for (Slot &candidate : _slots) {
+            if (!candidate.blob) {
+                slot = &candidate;
+                break;
+            }
+            if (candidate.stored_us < slot->stored_us) slot = &candidate;
+        }
+    }
+    release(*slot);
+    strcpy(slot->host, host);
+    slot->port = port;
+    slot->stored_us = now_us;
+    slot->blob = blob;
+    slot->len = len;
+    return true;
+}
+
+void TlsSessionCache::forget(const char *host, uint16_t port) {
+    if (!host) return;
+    Slot *slot = slotFor(host, port);
+    if (slot) release(*slot);
+}
+
+void TlsSessionCache::clear() {
+    for (Slot &slot : _slots) release(slot);
+}
+
+size_t TlsSessionCache::entries() const {
+    size_t count = 0;
+    for (const Slot &slot : _slots) count += slot.blob != nullptr;
+    return count;
+}
+
+size_t TlsSessionCache::bytes() const {
+    size_t total = 0;
+    for (const Slot &slot : _slots) total += slot.len;
+    return total;
+}
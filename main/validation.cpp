@@ -460,8 +460,57 @@ bool validateServerAddress(const char *server, size_t maxLength)
 
 bool validateNtpServer(const char *ntpServer)
 {
-    // NTP server validation uses the generic server address validation
-    return validateServerAddress(ntpServer, MAX_NTP_SERVER_LENGTH);
+    if (ntpServer == NULL || ntpServer[0] == '\0')
+    {
+        ESP_LOGW(TAG, "NTP server is NULL or empty");
+        return false;
+    }
+
+    size_t len = strlen(ntpServer);
+    if (len > MAX_NTP_SERVER_LENGTH)
+    {
+        ESP_LOGW(TAG, "NTP server list too long: %zu (max %d)", len, MAX_NTP_SERVER_LENGTH);
+        return false;
+    }
+
+    // The setting holds a comma-separated list of up to MAX_NTP_SERVERS
+    // entries; each one uses the generic server address validation.
+    int count = 0;
+    const char *start = ntpServer;
+    for (;;)
+    {
+        const char *end = strchr(start, ',');
+        size_t entryLen = end ? (size_t)(end - start) : strlen(start);
+        while (entryLen > 0 && *start == ' ')
+        {
+            start++;
+            entryLen--;
+        }
+        while (entryLen > 0 && start[entryLen - 1] == ' ')
+        {
+            entryLen--;
+        }
+
+        if (++count > MAX_NTP_SERVERS)
+        {
+            ESP_LOGW(TAG, "Too many NTP servers (max %d)", MAX_NTP_SERVERS);
+            return false;
+        }
+
+        char entry[MAX_NTP_SERVER_LENGTH + 1];
+        memcpy(entry, start, entryLen);
+        entry[entryLen] = '\0';
+        if (!validateServerAddress(entry, MAX_NTP_SERVER_LENGTH))
+        {
+            return false;
+        }
+
+        if (!end)
+        {
+            return true;
+        }
+        start = end + 1;
+    }
 }
 
 bool validateCcuAddress(const char *address)
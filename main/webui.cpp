@@ -27,6 +27,7 @@
 #include <ctype.h>
 #include <inttypes.h>
 #include <sys/param.h>
+#include <algorithm>
 #include <atomic>
 #include <memory>
 #include <new>
@@ -49,6 +50,7 @@
 #include "security_headers.h"
 #include "secure_utils.h"
 #include "log_manager.h"
+#include "log_journal.h"
 #include "reset_info.h"
 #include "nvs_storage_lock.h"
 #include "crash_blackbox.h"
@@ -63,6 +65,7 @@
 #include "semver.h"
 #include "validation.h"
 #include "log_stream.h"
+#include "json_writer.h"
 #include "pins.h"
 
 static const char *TAG = "WebUI";
@@ -1541,17 +1544,70 @@ esp_err_t get_log_handler_func(httpd_req_t *req)
     }
 
     uint64_t offset = 0;
-    char query[32];
+    LogManager::LogFilter filter;
+    char query[128];
+    // A cut query would silently drop its filters and return the whole log.
+    if (httpd_req_get_url_query_len(req) >= sizeof(query)) {
+        return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "query too long");
+    }
     if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
-        char param[24];
-        if (httpd_query_key_value(query, "offset", param, sizeof(param)) == ESP_OK) {
+        char param[LOG_INDEX_TAG_MAX];
+        if (httpd_query_key_value(query, "offset", param, sizeof(param)) == ESP_OK ||
+            httpd_query_key_value(query, "since", param, sizeof(param)) == ESP_OK) {
             offset = strtoull(param, NULL, 10);
         }
+        // "level=W" and "level>=W" (sent as "level%3E=W" once encoded) both
+        // mean W and more severe.
+        if (httpd_query_key_value(query, "level", param, sizeof(param)) == ESP_OK ||
+            httpd_query_key_value(query, "level>", param, sizeof(param)) == ESP_OK ||
+            httpd_query_key_value(query, "level%3E", param, sizeof(param)) == ESP_OK) {
+            filter.max_rank = log_level_rank((char)toupper((unsigned char)param[0]));
+            if (filter.max_rank == 0 || param[1] != '\0') {
+                return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST,
+                                           "level must be one of E, W, I, D, V");
+            }
+        }
+        if (httpd_query_key_value(query, "tag", filter.tag, sizeof(filter.tag)) == ESP_ERR_HTTPD_RESULT_TRUNC) {
+            return httpd_resp_send_err(req, HTTPD_400_BAD_REQUEST, "tag too long");
+        }
     }
 
     httpd_resp_set_type(req, "text/plain");
     httpd_resp_set_hdr(req, "Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
 
+    if (filter.max_rank != 0 || filter.tag[0] != '\0') {
+        // Filtered: only the matching lines, found through the log index and
+        // streamed in chunks up to one end offset fixed in advance, so the
+        // next poll from X-Log-Total neither skips nor repeats a line.
+        const uint64_t snapshot_end = LogManager::instance().getTotalWritten();
+        char totalWrittenStr[24];
+        snprintf(totalWrittenStr, sizeof(totalWrittenStr), "%" PRIu64, snapshot_end);
+        httpd_resp_set_hdr(req, "X-Log-Total", totalWrittenStr);
+
+        constexpr size_t CHUNK_SIZE = 1024;
+        char *chunk = static_cast<char *>(malloc(CHUNK_SIZE));
+        if (!chunk)
+        {
+            return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                                       "Could not allocate log buffer");
+        }
+        esp_err_t result = ESP_OK;
+        while (offset < snapshot_end)
+        {
+            const uint64_t before = offset;
+            const size_t count = LogManager::instance().readFiltered(
+                filter, &offset, snapshot_end, chunk, CHUNK_SIZE);
+            if (count > 0) result = httpd_resp_send_chunk(req, chunk, count);
+            if (result != ESP_OK || (count == 0 && offset == before)) break;
+        }
+        free(chunk);
+        if (result == ESP_OK)
+        {
+            result = httpd_resp_send_chunk(req, nullptr, 0);
+        }
+        return result;
+    }
+
     // Body and absolute end offset come from one locked snapshot. A log line
     // arriving between two independent reads must not make the client skip or
     // duplicate bytes on its next request.
@@ -1863,12 +1919,10 @@ esp_err_t get_log_download_handler_func(httpd_req_t *req)
     esp_err_t result = ESP_OK;
     while (absolute_offset < snapshot_end)
     {
-        const uint64_t remaining = snapshot_end - absolute_offset;
-        const size_t requested = remaining < CHUNK_SIZE
-            ? static_cast<size_t>(remaining)
-            : CHUNK_SIZE;
+        // Offsets count stored log entries, not rendered text, so the
+        // remaining distance says nothing about the chunk size needed.
         const size_t count = LogManager::instance().readChunk(
-            &absolute_offset, chunk, requested);
+            &absolute_offset, chunk, CHUNK_SIZE);
         if (count == 0) break;
 
         result = httpd_resp_send_chunk(req, chunk, count);
@@ -1890,6 +1944,152 @@ httpd_uri_t get_log_download_handler = {
     .handler = get_log_download_handler_func,
     .user_ctx = NULL};
 
+// GET /api/log/journal?offset=N - the persistent journal from journal
+// position N (0: everything still held). X-Journal-End is the position to
+// continue from.
+esp_err_t get_log_journal_handler_func(httpd_req_t *req)
+{
+    add_security_headers(req);
+    if (validate_auth(req) != ESP_OK)
+    {
+        httpd_resp_set_status(req, "401 Not authorized");
+        httpd_resp_sendstr(req, "401 Not authorized");
+        return ESP_OK;
+    }
+
+    uint64_t position = 0;
+    char query[64];
+    if (httpd_req_get_url_query_str(req, query, sizeof(query)) == ESP_OK) {
+        char param[24];
+        if (httpd_query_key_value(query, "offset", param, sizeof(param)) == ESP_OK) {
+            position = strtoull(param, NULL, 10);
+        }
+    }
+
+    constexpr size_t CHUNK_SIZE = 1024;
+    char *chunk = static_cast<char *>(malloc(CHUNK_SIZE));
+    if (!chunk)
+    {
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                                   "Could not allocate log journal buffer");
+    }
+
+    // The first chunk is read before the headers go out so X-Journal-End can
+    // name the end of what this response delivers.
+    uint64_t end = 0;
+    size_t count = log_journal_read(&position, chunk, CHUNK_SIZE, &end);
+    char end_header[24];
+    snprintf(end_header, sizeof(end_header), "%llu", (unsigned long long)end);
+    httpd_resp_set_type(req, "text/plain");
+    httpd_resp_set_hdr(req, "X-Journal-End", end_header);
+    httpd_resp_set_hdr(req, "Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
+
+    esp_err_t result = ESP_OK;
+    while (count > 0)
+    {
+        result = httpd_resp_send_chunk(req, chunk, count);
+        if (result != ESP_OK || position >= end) break;
+        vTaskDelay(pdMS_TO_TICKS(1));
+        uint64_t ignored = 0;
+        count = log_journal_read(&position, chunk,
+                                 end - position < CHUNK_SIZE ? (size_t)(end - position) : CHUNK_SIZE,
+                                 &ignored);
+    }
+
+    free(chunk);
+    if (result == ESP_OK)
+    {
+        result = httpd_resp_send_chunk(req, nullptr, 0);
+    }
+    return result;
+}
+
+httpd_uri_t get_log_journal_handler = {
+    .uri = "/api/log/journal",
+    .method = HTTP_GET,
+    .handler = get_log_journal_handler_func,
+    .user_ctx = NULL};
+
+// /api/rf/devices — the radio devices heard in the frames relayed to the
+// CCU, busiest first, so the one battery device flooding the air can be
+// found without an RF sniffer. Counts start when a device enters the table
+// and are lost when it is evicted as the least recently heard.
+esp_err_t get_rf_devices_handler_func(httpd_req_t *req)
+{
+    add_security_headers(req);
+    if (validate_auth(req) != ESP_OK)
+    {
+        httpd_resp_set_status(req, "401 Not authorized");
+        httpd_resp_sendstr(req, "401 Not authorized");
+        return ESP_OK;
+    }
+
+    // About 80 bytes per device; both buffers only live for the request.
+    constexpr size_t BODY_CAP = 96 * RfDeviceTable::CAPACITY + 128;
+    RfDeviceTable::Device *devices = static_cast<RfDeviceTable::Device *>(
+        malloc(sizeof(RfDeviceTable::Device) * RfDeviceTable::CAPACITY));
+    char *body = static_cast<char *>(malloc(BODY_CAP));
+    if (!devices || !body)
+    {
+        free(devices);
+        free(body);
+        return httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                                   "Could not allocate device list");
+    }
+
+    uint32_t now_s = 0;
+    uint32_t evictions = 0;
+    const size_t count = raw_uart_get_rf_devices(devices, RfDeviceTable::CAPACITY, &now_s, &evictions);
+    std::sort(devices, devices + count,
+              [](const RfDeviceTable::Device &a, const RfDeviceTable::Device &b) {
+                  return a.frames > b.frames;
+              });
+
+    JsonWriter json(body, BODY_CAP);
+    json.beginObject();
+    json.number("capacity", (uint64_t)RfDeviceTable::CAPACITY);
+    json.number("evictions", (uint64_t)evictions);
+    json.beginArray("devices");
+    for (size_t i = 0; i < count; i++)
+    {
+        char address[8];
+        snprintf(address, sizeof(address), "%06" PRIX32, devices[i].address);
+        json.beginObject();
+        json.string("address", address);
+        json.number("frames", (uint64_t)devices[i].frames);
+        json.number("lastSeenSeconds", (uint64_t)(now_s - devices[i].last_seen_s));
+        if (devices[i].has_rssi)
+            json.number("rssi", (int64_t)devices[i].rssi);
+        else
+            json.null("rssi");
+        json.endObject();
+    }
+    json.endArray();
+    json.endObject();
+    free(devices);
+
+    esp_err_t result;
+    if (json.ok())
+    {
+        httpd_resp_set_type(req, "application/json");
+        httpd_resp_set_hdr(req, "Cache-Control", "no-store, no-cache, must-revalidate, max-age=0");
+        result = httpd_resp_send(req, json.c_str(), json.length());
+    }
+    else
+    {
+        result = httpd_resp_send_err(req, HTTPD_500_INTERNAL_SERVER_ERROR,
+                                     "Device list too large");
+    }
+    free(body);
+    return result;
+}
+
+httpd_uri_t get_rf_devices_handler = {
+    .uri = "/api/rf/devices",
+    .method = HTTP_GET,
+    .handler = get_rf_devices_handler_func,
+    .user_ctx = NULL};
+
 // Prometheus metrics disabled - feature code available in prometheus.cpp.disabled
 
 WebUI::WebUI(Settings *settings, LED *statusLED, SysInfo *sysInfo, Ethernet *ethernet, RawUartUdpListener *rawUartUdpListener, RadioModuleConnector *radioModuleConnector, RadioModuleDetector *radioModuleDetector)
@@ -1963,7 +2163,9 @@ void WebUI::start()
         httpd_register_uri_handler(_httpd_handle, &post_log_enable_handler);
         httpd_register_uri_handler(_httpd_handle, &post_log_disable_handler);
         httpd_register_uri_handler(_httpd_handle, &get_log_download_handler);
+        httpd_register_uri_handler(_httpd_handle, &get_log_journal_handler);
         httpd_register_uri_handler(_httpd_handle, &get_crash_log_handler);
+        httpd_register_uri_handler(_httpd_handle, &get_rf_devices_handler);
 
         httpd_register_uri_handler(_httpd_handle, &main_js_gz_handler);
         httpd_register_uri_handler(_httpd_handle, &main_css_gz_handler);
@@ -133,6 +133,9 @@ static esp_err_t add_monitoring_backup(cJSON *root)
     cJSON_AddStringToObject(mqtt, "tlsKeyfile", config->mqtt.tls_keyfile);
     cJSON_AddBoolToObject(mqtt, "commandEnabled", config->mqtt.command_enabled);
     cJSON_AddStringToObject(mqtt, "commandToken", config->mqtt.command_token);
+    cJSON_AddNumberToObject(mqtt, "statusRefreshMinutes", config->mqtt.status_refresh_minutes);
+    cJSON_AddBoolToObject(mqtt, "stateDocument", config->mqtt.state_document);
+    cJSON_AddBoolToObject(mqtt, "protocolV5", config->mqtt.protocol_v5);
 
     cJSON_AddBoolToObject(prometheus, "enabled", config->prometheus.enabled);
     cJSON_AddNumberToObject(prometheus, "port", config->prometheus.port);
@@ -144,6 +147,9 @@ static esp_err_t add_monitoring_backup(cJSON *root)
     cJSON_AddNumberToObject(syslog, "transport", config->syslog.transport);
     cJSON_AddNumberToObject(syslog, "minSeverity", config->syslog.min_severity);
     cJSON_AddStringToObject(syslog, "hostname", config->syslog.hostname);
+    cJSON_AddNumberToObject(syslog, "rateLimit", config->syslog.rate_limit);
+    cJSON_AddNumberToObject(syslog, "rateBurst", config->syslog.rate_burst);
+    cJSON_AddNumberToObject(syslog, "format", config->syslog.format);
 
     cJSON_AddBoolToObject(notify, "enabled", config->notify.enabled);
     cJSON_AddNumberToObject(notify, "channels", config->notify.channels);
@@ -160,6 +166,9 @@ static esp_err_t add_monitoring_backup(cJSON *root)
     cJSON_AddStringToObject(notify, "smtpTo", config->notify.smtp_to);
     cJSON_AddNumberToObject(notify, "cooldownSeconds", config->notify.cooldown_seconds);
     cJSON_AddNumberToObject(notify, "eventMask", config->notify.event_mask);
+    cJSON_AddNumberToObject(notify, "dutyCycleWarn", config->notify.duty_cycle_warn);
+    cJSON_AddNumberToObject(notify, "dutyCycleAlarm", config->notify.duty_cycle_alarm);
+    cJSON_AddNumberToObject(notify, "digestSeconds", config->notify.digest_seconds);
 
     delete config;
     return ESP_OK;
@@ -226,6 +235,12 @@ static esp_err_t parse_monitoring_backup(const cJSON *root, monitoring_config_t
     if (valid && config->mqtt.command_token[0] != '\0') {
         valid = validateMqttCommandToken(config->mqtt.command_token);
     }
+    // Optional: older backups keep the current values.
+    if (backup_get_uint(mqtt, "statusRefreshMinutes", 1440, &number)) {
+        config->mqtt.status_refresh_minutes = static_cast<uint16_t>(number);
+    }
+    backup_get_bool(mqtt, "stateDocument", &config->mqtt.state_document);
+    backup_get_bool(mqtt, "protocolV5", &config->mqtt.protocol_v5);
 
     valid = valid && backup_get_bool(prometheus, "enabled", &config->prometheus.enabled) &&
             backup_get_uint(prometheus, "port", UINT16_MAX, &number);
@@ -249,6 +264,18 @@ static esp_err_t parse_monitoring_backup(const cJSON *root, monitoring_config_t
     if (valid && (config->syslog.enabled || config->syslog.server[0] != '\0')) {
         valid = validateServerAddress(config->syslog.server, sizeof(config->syslog.server) - 1);
     }
+    // Optional like eventMask below: older backups have no log rate limit
+    // and keep whatever the device uses now.
+    unsigned rate = 0;
+    if (backup_get_uint(syslog, "rateLimit", LogLimiter::MAX_RATE, &rate)) {
+        config->syslog.rate_limit = static_cast<uint16_t>(rate);
+    }
+    if (backup_get_uint(syslog, "rateBurst", LogLimiter::MAX_BURST, &rate) && rate > 0) {
+        config->syslog.rate_burst = static_cast<uint16_t>(rate);
+    }
+    if (backup_get_uint(syslog, "format", 2, &rate)) {
+        config->syslog.format = static_cast<uint8_t>(rate);
+    }
 
     valid = valid && backup_get_bool(notify, "enabled", &config->notify.enabled) &&
             backup_get_uint(notify, "channels", 7, &number);
@@ -290,6 +317,15 @@ static esp_err_t parse_monitoring_backup(const cJSON *root, monitoring_config_t
     if (backup_get_uint(notify, "eventMask", NOTIFY_EVENT_ALL, &event_mask)) {
         config->notify.event_mask = static_cast<uint16_t>(event_mask);
     }
+    if (backup_get_uint(notify, "dutyCycleWarn", 100, &number)) {
+        config->notify.duty_cycle_warn = static_cast<uint8_t>(number);
+    }
+    if (backup_get_uint(notify, "dutyCycleAlarm", 100, &number)) {
+        config->notify.duty_cycle_alarm = static_cast<uint8_t>(number);
+    }
+    if (backup_get_uint(notify, "digestSeconds", 3600, &number)) {
+        config->notify.digest_seconds = static_cast<uint16_t>(number);
+    }
     // Same CRLF/control-char rejection as the normal POST /api/monitoring
     // path (monitoring_api.cpp): these three fields are interpolated
     // verbatim into raw SMTP protocol lines / an HTTP header, so a crafted
@@ -169,6 +169,7 @@ esp_err_t post_ota_update_handler_func(httpd_req_t *req)
         }
         net_gate_held = true;
         crash_blackbox_net_op_begin("webui_ota_upload");
+        events_close_idle_connections();
     }
 
     esp_ota_handle_t ota_handle = 0;
@@ -22,6 +22,7 @@
 
 #include "monitoring.h"
 #include "crash_blackbox.h"
+#include "events.h"
 #include "nvs_storage_lock.h"
 #include "security_headers.h"
 #include "webui_compatibility.h"
@@ -834,6 +835,7 @@ esp_err_t post_webui_update_handler(httpd_req_t *req)
         }
         net_locked = true;
         crash_blackbox_net_op_begin("webui_storage_upload");
+        events_close_idle_connections();
     }
 
     char expected_sha256[SHA256_HEX_LENGTH + 1] = {};
@@ -1241,6 +1243,20 @@ void webui_storage_update_abort()
     invalidate_image_locked(reason);
 }
 
+bool webui_storage_with_files(void (*fn)(const char *basePath, size_t freeBytes,
+                                         void *context),
+                              void *context)
+{
+    StorageLock lock;
+    if (!lock || !fn || !s_status.mounted || s_status.updateActive) return false;
+
+    size_t total = 0;
+    size_t used = 0;
+    if (esp_spiffs_info(PARTITION_LABEL, &total, &used) != ESP_OK) return false;
+    fn(BASE_PATH, total > used ? total - used : 0, context);
+    return true;
+}
+
 esp_err_t hb_webui_register_uri_handler(httpd_handle_t server,
                                         const httpd_uri_t *uri_handler)
 {
@@ -0,0 +1,395 @@
+#include "dcf_decoder.h"
+
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <random>
+#include <type_traits>
+#include <vector>
+
+// Replays DCF77 edge traces through the soft-decision decoder and through a
+// copy of the hard-threshold decoder it replaced, and compares time to first
+// sync and the rate of wrong decodes. Traces are synthesized with injected
+// noise; a recorded trace ("<t_us> <level>" per line) can be replayed by
+// passing its path as the only argument.
+
+struct Edge {
+    int64_t t_us;
+    int state;
+};
+
+struct Decode {
+    time_t epoch;
+    int64_t mark_us;
+};
+
+// ---------------------------------------------------------------------------
+// Previous decoder, kept verbatim in behavior as the baseline.
+
+class LegacyDecoder
+{
+    uint64_t _buffer = 0;
+    uint8_t _bufferPos = 0;
+    int64_t _previousSecondMark = 0;
+    int64_t _secondMark = 0;
+
+    bool checkParity(uint8_t start, uint8_t end)
+    {
+        int parity = 0;
+        for (int pos = start; pos <= end; pos++)
+            parity ^= (int)((_buffer >> pos) & 1);
+        return parity == 0;
+    }
+
+    static uint8_t bcd2bin(uint8_t val) { return val - 6 * (val >> 4); }
+
+    static int is_leap(unsigned int y)
+    {
+        return (y % 4) == 0 && ((y % 100) != 0 || ((y + 1900) % 400) == 0);
+    }
+
+    static time_t dcf2epoch(struct tm *dcf_tm, uint8_t tz)
+    {
+        static const unsigned ndays[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+        time_t res = 0;
+        for (int i = 70; i < dcf_tm->tm_year; ++i)
+            res += is_leap(i) ? 366 : 365;
+        for (int i = 0; i < dcf_tm->tm_mon; ++i) {
+            res += ndays[i];
+            if (i == 1 && is_leap(dcf_tm->tm_year))
+                res++;
+        }
+        res += dcf_tm->tm_mday - 1;
+        res *= 24;
+        res += dcf_tm->tm_hour;
+        res -= tz ^ 3;
+        res *= 60;
+        res += dcf_tm->tm_min;
+        res *= 60;
+        return res;
+    }
+
+public:
+    bool edge(int64_t flankTime, int state, Decode *out)
+    {
+        if (!state) {
+            _previousSecondMark = _secondMark;
+            _secondMark = flankTime;
+            return false;
+        }
+
+        int64_t secondLength = _secondMark - _previousSecondMark;
+        int64_t pulseLength = flankTime - _secondMark;
+
+        uint64_t pulseValue;
+        if (pulseLength > 80000 && pulseLength < 135000)
+            pulseValue = 0;
+        else if (pulseLength > 180000 && pulseLength < 235000)
+            pulseValue = 1;
+        else
+            return false;
+
+        if (secondLength > 970000 && secondLength < 1035000) {
+            if (_bufferPos < 59) {
+                _bufferPos++;
+                _buffer |= (pulseValue << _bufferPos);
+            }
+            return false;
+        }
+        if (!(secondLength > 1970000 && secondLength < 2035000))
+            return false;
+
+        bool decoded = false;
+        uint8_t timezone = (uint8_t)((_buffer >> 17) & 3);
+        if (!(_bufferPos < 58 || _bufferPos > 59 || (int)(_buffer & 1) != 0 ||
+              (int)((_buffer >> 20) & 1) != 1 || timezone == 0 || timezone == 3 ||
+              !checkParity(21, 28) || !checkParity(29, 35) || !checkParity(36, 58))) {
+            struct tm dcf_tm = {};
+            dcf_tm.tm_year = 100 + bcd2bin((int)((_buffer >> 50) & 0xff));
+            dcf_tm.tm_mon = bcd2bin((int)((_buffer >> 45) & 0x1f)) - 1;
+            dcf_tm.tm_mday = bcd2bin((int)((_buffer >> 36) & 0x3f));
+            dcf_tm.tm_hour = bcd2bin((int)((_buffer >> 29) & 0x3f));
+            dcf_tm.tm_min = bcd2bin((int)((_buffer >> 21) & 0x7f));
+            if (!(dcf_tm.tm_mon < 0 || dcf_tm.tm_mon > 11 || dcf_tm.tm_mday < 1 ||
+                  dcf_tm.tm_mday > 31 || dcf_tm.tm_hour < 0 || dcf_tm.tm_hour > 23 ||
+                  dcf_tm.tm_min < 0 || dcf_tm.tm_min > 59)) {
+                out->epoch = dcf2epoch(&dcf_tm, timezone);
+                out->mark_us = _secondMark;
+                decoded = true;
+            }
+        }
+
+        _buffer = pulseValue;
+        _bufferPos = 0;
+        return decoded;
+    }
+};
+
+// ---------------------------------------------------------------------------
+// Trace synthesis.
+
+static bool isCest(time_t utc)
+{
+    // Last Sunday of March / October, 01:00 UTC.
+    struct tm t;
+    gmtime_r(&utc, &t);
+    auto lastSunday = [&](int month) {
+        struct tm m = {};
+        m.tm_year = t.tm_year;
+        m.tm_mon = month;
+        m.tm_mday = 31;
+        m.tm_hour = 1;
+        time_t end = timegm(&m);
+        struct tm e;
+        gmtime_r(&end, &e);
+        return end - (time_t)e.tm_wday * 86400;
+    };
+    return utc >= lastSunday(2) && utc < lastSunday(9);
+}
+
+static void bcd(uint8_t *bits, int first, int count, int value)
+{
+    int v = (value / 10) << 4 | (value % 10);
+    for (int i = 0; i < count; i++)
+        bits[first + i] = (v >> i) & 1;
+}
+
+static uint8_t evenParity(const uint8_t *bits, int first, int last)
+{
+    uint8_t p = 0;
+    for (int i = first; i <= last; i++)
+        p ^= bits[i];
+    return p;
+}
+
+// Bits sent during the minute that ends at `next` (UTC).
+static void frameFor(time_t next, uint8_t *bits)
+{
+    bool cest = isCest(next);
+    time_t local = next + (cest ? 7200 : 3600);
+    struct tm t;
+    gmtime_r(&local, &t);
+    memset(bits, 0, 59);
+    for (int i = 1; i < 15; i++)
+        bits[i] = (uint8_t)((next / 60 + i) & 1); // weather bits: arbitrary
+    bits[17] = cest;
+    bits[18] = !cest;
+    bits[20] = 1;
+    bcd(bits, 21, 7, t.tm_min);
+    bits[28] = evenParity(bits, 21, 27);
+    bcd(bits, 29, 6, t.tm_hour);
+    bits[35] = evenParity(bits, 29, 34);
+    bcd(bits, 36, 6, t.tm_mday);
+    bcd(bits, 42, 3, t.tm_wday == 0 ? 7 : t.tm_wday);
+    bcd(bits, 45, 5, t.tm_mon + 1);
+    bcd(bits, 50, 8, t.tm_year % 100);
+    bits[58] = evenParity(bits, 36, 57);
+}
+
+struct Noise {
+    const char *name;
+    double drop;    // pulse lost entirely
+    double glitch;  // short spurious carrier dip somewhere in the second
+    double split;   // pulse interrupted by a short spike
+    double stretch; // pulse length off by up to +/-70 ms
+    double jitter_us;
+};
+
+struct Trace {
+    std::vector<Edge> edges;
+    std::vector<std::pair<time_t, int64_t>> marks; // true minute marks
+};
+
+static Trace synthesize(time_t start, int seconds, const Noise &noise, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<double> u(0, 1);
+    std::normal_distribution<double> jitter(0, noise.jitter_us);
+    Trace trace;
+    std::vector<Edge> raw;
+
+    const int64_t base = 1000000000; // arbitrary esp_timer epoch
+    for (int s = 0; s < seconds; s++) {
+        time_t now = start + s;
+        int sec = (int)(now % 60);
+        int64_t t0 = base + (int64_t)s * 1000000 + (int64_t)jitter(rng);
+        if (sec == 0)
+            trace.marks.push_back({now, t0});
+        if (sec == 59)
+            continue; // minute marker: no carrier reduction
+
+        uint8_t bits[59];
+        frameFor(now - sec + 60, bits);
+        int64_t len = bits[sec] ? 200000 : 100000;
+        len += (int64_t)jitter(rng);
+        if (u(rng) < noise.stretch)
+            len += (int64_t)((u(rng) * 2 - 1) * 70000);
+
+        if (u(rng) >= noise.drop) {
+            if (u(rng) < noise.split && len > 60000) {
+                int64_t at = t0 + 20000 + (int64_t)(u(rng) * (double)(len - 40000));
+                raw.push_back({t0, 0});
+                raw.push_back({at, 1});
+                raw.push_back({at + 8000 + (int64_t)(u(rng) * 10000), 0});
+                raw.push_back({t0 + len, 1});
+            } else {
+                raw.push_back({t0, 0});
+                raw.push_back({t0 + len, 1});
+            }
+        }
+        if (u(rng) < noise.glitch) {
+            int64_t at = t0 + 250000 + (int64_t)(u(rng) * 700000);
+            raw.push_back({at, 0});
+            raw.push_back({at + 5000 + (int64_t)(u(rng) * 40000), 1});
+        }
+    }
+
+    // Deliver in time order through the same 5 ms gate as the ISR, reading
+    // the level the pin has after the edge.
+    std::sort(raw.begin(), raw.end(), [](const Edge &a, const Edge &b) { return a.t_us < b.t_us; });
+    int64_t last = 0;
+    for (const Edge &e : raw) {
+        if (e.t_us - last < 5000)
+            continue;
+        last = e.t_us;
+        trace.edges.push_back(e);
+    }
+    return trace;
+}
+
+struct Score {
+    int runs = 0;
+    int synced = 0;
+    double ttfs_s = 0; // summed over synced runs
+    int decodes = 0;
+    int wrong = 0;
+};
+
+template <typename Decoder>
+static void replay(Decoder &decoder, const Trace &trace, int64_t t_begin, Score &score)
+{
+    bool first = true;
+    score.runs++;
+    for (const Edge &e : trace.edges) {
+        Decode d;
+        dcf_time_t soft;
+        bool ok;
+        if constexpr (std::is_same<Decoder, DcfDecoder>::value) {
+            ok = decoder.edge(e.t_us, e.state, &soft);
+            d.epoch = soft.epoch;
+            d.mark_us = soft.mark_us;
+        } else {
+            ok = decoder.edge(e.t_us, e.state, &d);
+        }
+        if (!ok)
+            continue;
+        score.decodes++;
+
+        bool correct = false;
+        for (const auto &mark : trace.marks) {
+            if (mark.first == d.epoch) {
+                int64_t diff = d.mark_us - mark.second;
+                correct = diff > -DCF_SLOT_TOLERANCE_US && diff < DCF_SLOT_TOLERANCE_US;
+                break;
+            }
+        }
+        if (!correct) {
+            score.wrong++;
+            continue;
+        }
+        if (first) {
+            first = false;
+            score.synced++;
+            score.ttfs_s += (double)(e.t_us - t_begin) / 1e6;
+        }
+    }
+}
+
+static int replayFile(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    if (!f) {
+        perror(path);
+        return 1;
+    }
+    DcfDecoder soft;
+    LegacyDecoder legacy;
+    long long t;
+    int state;
+    while (fscanf(f, "%lld %d", &t, &state) == 2) {
+        dcf_time_t s;
+        Decode l;
+        if (soft.edge(t, state, &s))
+            printf("soft   %lld %lld\n", (long long)s.epoch, (long long)s.mark_us);
+        if (legacy.edge(t, state, &l))
+            printf("legacy %lld %lld\n", (long long)l.epoch, (long long)l.mark_us);
+    }
+    fclose(f);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 1)
+        return replayFile(argv[1]);
+
+    static const Noise scenarios[] = {
+        {"clean", 0, 0, 0, 0, 3000},
+        {"light", 0.01, 0.02, 0.02, 0.02, 5000},
+        {"moderate", 0.03, 0.08, 0.05, 0.05, 8000},
+        {"heavy", 0.06, 0.15, 0.10, 0.10, 10000},
+    };
+    const int runs = 40;
+    const int seconds = 20 * 60;
+
+    std::mt19937 rng(77);
+    Score results[4][2];
+    for (int n = 0; n < 4; n++) {
+        for (int r = 0; r < runs; r++) {
+            // Random start second, every fifth run across a DST switch.
+            time_t start = (r % 5 == 0 ? 1743296400 : 1760000000) - 600 + (time_t)(rng() % 86400 % 3600);
+            Trace trace = synthesize(start, seconds, scenarios[n], rng);
+            DcfDecoder soft;
+            LegacyDecoder legacy;
+            int64_t begin = trace.edges.empty() ? 0 : trace.edges.front().t_us;
+            replay(soft, trace, begin, results[n][0]);
+            replay(legacy, trace, begin, results[n][1]);
+        }
+    }
+
+    printf("%-9s %-7s %7s %10s %8s %6s\n", "noise", "decoder", "synced", "avg ttfs", "decodes", "wrong");
+    for (int n = 0; n < 4; n++) {
+        for (int d = 0; d < 2; d++) {
+            const Score &s = results[n][d];
+            printf("%-9s %-7s %4d/%-2d %9.1fs %8d %6d\n", scenarios[n].name,
+                   d == 0 ? "soft" : "legacy", s.synced, s.runs,
+                   s.synced ? s.ttfs_s / s.synced : 0.0, s.decodes, s.wrong);
+        }
+    }
+
+    for (int n = 0; n < 4; n++) {
+        const Score &soft = results[n][0];
+        const Score &legacy = results[n][1];
+        // Never a wrong time, at any noise level.
+        assert(soft.wrong == 0);
+        // At least as many runs synced, and more minutes decoded.
+        assert(soft.synced >= legacy.synced);
+        assert(soft.decodes >= legacy.decodes);
+    }
+    // A clean signal syncs every run, faster than a full minute after the
+    // first marker because the partial first minute is used.
+    assert(results[0][0].synced == runs);
+    assert(results[0][0].ttfs_s / runs < results[0][1].ttfs_s / runs);
+    // Noise the old decoder barely survives still syncs nearly always.
+    assert(results[3][0].synced >= runs * 9 / 10);
+
+    dcf_time_t unused;
+    DcfDecoder idle;
+    for (int i = 0; i < 600; i++)
+        assert(!idle.edge(1000000 + (int64_t)i * 137000, i & 1, &unused));
+
+    printf("dcf decoder replay ok\n");
+    return 0;
+}
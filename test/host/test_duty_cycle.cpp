@@ -0,0 +1,127 @@
+#include "duty_cycle.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+// 1 % of the budget: 360 ms of airtime.
+static constexpr uint32_t PERCENT_US = DutyCycleBudget::BUDGET_US / 100;
+
+static void test_thresholds_fire_once()
+{
+    DutyCycleBudget budget;
+    budget.configure(50, 80);
+    assert(budget.add(0, 49 * PERCENT_US) == DutyCycleBudget::LEVEL_OK);
+    assert(budget.add(1, PERCENT_US) == DutyCycleBudget::LEVEL_WARN);
+    assert(budget.add(2, PERCENT_US) == DutyCycleBudget::LEVEL_OK);   // already warned
+    assert(budget.level() == DutyCycleBudget::LEVEL_WARN);
+    assert(budget.add(3, 40 * PERCENT_US) == DutyCycleBudget::LEVEL_ALARM);
+    assert(budget.usedPercent(3) == 91 && budget.usedUs(3) == 91 * PERCENT_US);
+
+    // Straight past both thresholds: only the higher level is reported.
+    DutyCycleBudget jump;
+    assert(jump.add(0, 100 * PERCENT_US) == DutyCycleBudget::LEVEL_ALARM);
+    assert(jump.usedPercent(0) == 100);
+
+    DutyCycleBudget off;
+    off.configure(0, 0);
+    assert(off.add(0, 200 * PERCENT_US) == DutyCycleBudget::LEVEL_OK);
+    assert(off.usedPercent(0) == 200);
+}
+
+static void test_window_slides()
+{
+    DutyCycleBudget budget;
+    budget.add(5, 30 * PERCENT_US);
+    budget.add(1805, 30 * PERCENT_US);
+    assert(budget.usedPercent(3599) == 60);
+    assert(budget.usedPercent(3600) == 30);   // the bucket of second 5 left the hour
+    assert(budget.usedPercent(5399) == 30);
+    assert(budget.usedPercent(5400) == 0);
+
+    // An idle gap longer than the window clears everything at once.
+    budget.add(6000, 10 * PERCENT_US);
+    assert(budget.usedPercent(1000000) == 0);
+    budget.add(1000001, PERCENT_US);
+    assert(budget.usedPercent(1000001) == 1);
+}
+
+static void test_rearms_below_margin()
+{
+    DutyCycleBudget budget;
+    budget.configure(50, 80);
+    budget.add(0, 10 * PERCENT_US);
+    assert(budget.add(1800, 45 * PERCENT_US) == DutyCycleBudget::LEVEL_WARN);
+    // Dropping to 45 % (inside the margin) and rising again stays quiet.
+    assert(budget.usedPercent(3600) == 45 && budget.level() == DutyCycleBudget::LEVEL_WARN);
+    assert(budget.add(3601, 6 * PERCENT_US) == DutyCycleBudget::LEVEL_OK);   // back to 51 %
+    // Below 40 % the warning is re-armed.
+    assert(budget.usedPercent(5400) == 6);
+    assert(budget.level() == DutyCycleBudget::LEVEL_OK);
+    assert(budget.add(5401, 50 * PERCENT_US) == DutyCycleBudget::LEVEL_WARN);
+
+    // New thresholds start from a clean level.
+    budget.configure(20, 40);
+    assert(budget.add(5402, 0) == DutyCycleBudget::LEVEL_ALARM);
+}
+
+static void test_transmissions()
+{
+    unsigned char data[20] = {};
+    HMFrame frame;
+    frame.data = data;
+    frame.destination = HM_DST_HMIP;
+    frame.data_len = 20;
+    assert(DutyCycleBudget::isTransmission(frame));
+    frame.destination = HM_DST_TRX;
+    assert(DutyCycleBudget::isTransmission(frame));
+    frame.data_len = 2;   // e.g. a version query
+    assert(!DutyCycleBudget::isTransmission(frame));
+    frame.destination = HM_DST_COMMON;
+    frame.data_len = 20;
+    assert(!DutyCycleBudget::isTransmission(frame));
+}
+
+// A runaway program switching 4 actuators every 20 s (a 30-byte telegram
+// plus two repeats each, ~80 ms on air) against an otherwise quiet CCU.
+// The module only starts holding commands back once the budget is used up;
+// the warning has to come well before that, while the queue-wait metrics
+// still show nothing.
+static void benchmark()
+{
+    constexpr uint32_t telegram_us = 3 * 26400;
+    DutyCycleBudget budget;
+    uint32_t warn_s = 0, alarm_s = 0, exhausted_s = 0, adds = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t now = 0; now < 2 * 3600 && !exhausted_s; now++) {
+        const uint32_t sends = now % 20 == 0 ? 4 : (now % 60 == 0 ? 1 : 0);
+        for (uint32_t i = 0; i < sends; i++) {
+            const DutyCycleBudget::Level crossed = budget.add(now, telegram_us);
+            adds++;
+            if (crossed == DutyCycleBudget::LEVEL_WARN) warn_s = now;
+            if (crossed == DutyCycleBudget::LEVEL_ALARM) alarm_s = now;
+        }
+        if (budget.usedPercent(now) >= 100) exhausted_s = now;
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    assert(warn_s > 0 && alarm_s > warn_s && exhausted_s > alarm_s);
+    assert(exhausted_s - warn_s >= 10 * 60);
+    printf("duty cycle (4 actuators every 20 s): warning after %u min, alarm after %u min, "
+           "budget exhausted after %u min; %zu bytes, %.0f ns per update\n",
+           warn_s / 60, alarm_s / 60, exhausted_s / 60, sizeof(DutyCycleBudget),
+           std::chrono::duration<double, std::nano>(end - start).count() / adds);
+}
+
+int main()
+{
+    test_thresholds_fire_once();
+    test_window_slides();
+    test_rearms_below_margin();
+    test_transmissions();
+    benchmark();
+    printf("duty cycle tests passed\n");
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include "json_writer.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static void test_document()
+{
+    char buf[256];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    json.string("ip", "192.168.1.10");
+    json.number("cpu_usage", "12.5");
+    json.number("uptime", (uint64_t)3600);
+    json.number("offset", (int64_t)-42);
+    json.boolean("eth_connected", true);
+    json.null("dns2");
+    json.beginObject("device");
+    json.beginArray("identifiers");
+    json.string(nullptr, "hb-rf-eth-ABC");
+    json.endArray();
+    json.endObject();
+    json.raw("extra", "[1,2]", 5);
+    json.endObject();
+    assert(json.ok());
+    assert(json.length() == strlen(buf));
+    assert(std::string(buf) ==
+           "{\"ip\":\"192.168.1.10\",\"cpu_usage\":12.5,\"uptime\":3600,\"offset\":-42,"
+           "\"eth_connected\":true,\"dns2\":null,"
+           "\"device\":{\"identifiers\":[\"hb-rf-eth-ABC\"]},\"extra\":[1,2]}");
+}
+
+static void test_escaping()
+{
+    char buf[128];
+    JsonWriter json(buf, sizeof(buf));
+    json.beginObject();
+    json.string("reason", "panic \"x\"\\\n\x01");
+    json.string("k\"", "ä");
+    json.number("empty", "");
+    json.endObject();
+    assert(json.ok());
+    assert(std::string(buf) ==
+           "{\"reason\":\"panic \\\"x\\\"\\\\\\n\\u0001\",\"k\\\"\":\"ä\",\"empty\":null}");
+}
+
+static void test_overflow_and_misuse()
+{
+    // Every capacity either fits the whole document or reports failure;
+    // the buffer stays NUL-terminated and is never overrun.
+    const std::string full = "{\"a\":\"0123456789\",\"b\":[true,false]}";
+    for (size_t cap = 1; cap <= full.size() + 1; cap++) {
+        char buf[64];
+        memset(buf, 'X', sizeof(buf));
+        JsonWriter json(buf, cap);
+        json.beginObject();
+        json.string("a", "0123456789");
+        json.beginArray("b");
+        json.boolean(nullptr, true);
+        json.boolean(nullptr, false);
+        json.endArray();
+        json.endObject();
+        assert(json.ok() == (cap > full.size()));
+        assert(json.length() < cap && buf[json.length()] == '\0');
+        assert(buf[cap] == 'X');
+        if (json.ok()) assert(std::string(buf) == full);
+    }
+
+    char buf[64];
+    JsonWriter unclosed(buf, sizeof(buf));
+    unclosed.beginObject();
+    assert(!unclosed.ok());
+
+    JsonWriter crossed(buf, sizeof(buf));
+    crossed.beginObject();
+    crossed.beginArray("a");
+    crossed.endObject();
+    assert(!crossed.ok());
+
+    JsonWriter keyless(buf, sizeof(buf));
+    keyless.beginObject();
+    keyless.number(nullptr, "1");
+    keyless.endObject();
+    assert(!keyless.ok());
+
+    JsonWriter nothing(nullptr, 0);
+    nothing.beginObject();
+    nothing.endObject();
+    assert(!nothing.ok());
+}
+
+int main()
+{
+    test_document();
+    test_escaping();
+    test_overflow_and_misuse();
+    printf("json writer tests passed\n");
+    return 0;
+}
@@ -0,0 +1,290 @@
+#include "log_archive.h"
+#include "log_entry.h"
+
+#include <cassert>
+#include <chrono>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+// Format strings as ESP_LOGx expands them with CONFIG_LOG_COLORS, taken from
+// lines this firmware actually logs. They stand in for the DROM segment.
+#define LINE(colour, level, text) "\033[0;" colour "m" level " (%" PRIu32 ") %s: " text "\033[0m\n"
+static const char *const FORMATS[] = {
+    LINE("32", "I", "Ethernet Link Up"),
+    LINE("32", "I", "Connected to %s:%u, rssi %d"),
+    LINE("33", "W", "Deferred MQTT retry failed: %s"),
+    LINE("31", "E", "Received raw-uart packet from invalid address."),
+    LINE("32", "I", "Updated time from RTC to %02d-%02d-%02d %02d:%02d:%02d %s"),
+    LINE("33", "W", "CheckMK response send failed after %u/%u bytes (errno %d)"),
+    LINE("32", "I", "free heap %u bytes, largest block %u"),
+    LINE("31", "E", "OTA connection closed prematurely, received %u of %u bytes"),
+    LINE("32", "I", "NTP sync from %s, offset %ld us"),
+    LINE("33", "W", "dropping event %d: firmware upload still active after wait"),
+};
+static const char *const TAGS[] = {"eth", "mqtt", "raw_uart", "rtc", "checkmk", "heap", "ota", "ntp",
+                                   "events"};
+
+static bool in_flash(const void *ptr)
+{
+    for (const char *fmt : FORMATS) {
+        if (ptr == fmt) return true;
+    }
+    for (const char *tag : TAGS) {
+        if (ptr == tag) return true;
+    }
+    return false;
+}
+
+static size_t encode(uint8_t *out, uint32_t ts, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    size_t len = log_entry_encode_deferred(out, LOG_ENTRY_MAX, ts, fmt, args, in_flash);
+    va_end(args);
+    return len;
+}
+
+struct Capture {
+    std::vector<uint8_t> bytes;
+    std::vector<size_t> ends;
+    size_t text_bytes = 0;
+};
+
+// A chatty but ordinary capture: periodic status lines, a burst of raw-uart
+// complaints and a few lines formatted at run time (stored as text).
+static Capture capture_trace(int lines)
+{
+    Capture capture;
+    uint32_t seed = 7;
+    auto next = [&]() {
+        seed = seed * 1103515245u + 12345u;
+        return seed >> 16;
+    };
+    char host[] = "192.168.1.20";
+    for (int i = 0; i < lines; i++) {
+        uint8_t entry[LOG_ENTRY_MAX];
+        const uint32_t ts = 1000 + (uint32_t)i * 37;
+        const unsigned pick = next() % 16;
+        size_t len = 0;
+        switch (pick) {
+            case 0: len = encode(entry, ts, FORMATS[0], ts, TAGS[0]); break;
+            case 1: len = encode(entry, ts, FORMATS[1], ts, TAGS[1], host, 1883u, -(int)(next() % 90)); break;
+            case 2: len = encode(entry, ts, FORMATS[2], ts, TAGS[1], "ESP_ERR_TIMEOUT"); break;
+            case 3: case 4: case 5: case 6:
+                len = encode(entry, ts, FORMATS[3], ts, TAGS[2]); break;
+            case 7: len = encode(entry, ts, FORMATS[4], ts, TAGS[3], 24, 5, 17, (int)(ts / 3600000) % 24,
+                                 (int)(ts / 60000) % 60, (int)(ts / 1000) % 60, "UTC"); break;
+            case 8: len = encode(entry, ts, FORMATS[5], ts, TAGS[4], (unsigned)(next() % 4096), 4096u, 104); break;
+            case 9: case 10:
+                len = encode(entry, ts, FORMATS[6], ts, TAGS[5], 120000u + next() % 8000, 60000u + next() % 4000);
+                break;
+            case 11: len = encode(entry, ts, FORMATS[7], ts, TAGS[6], (unsigned)next(), 1500000u); break;
+            case 12: len = encode(entry, ts, FORMATS[8], ts, TAGS[7], "pool.ntp.org", (long)(next() % 2000) - 1000); break;
+            case 13: len = encode(entry, ts, FORMATS[9], ts, TAGS[8], (int)(next() % 12)); break;
+            default: {
+                char text[LOG_ENTRY_MAX];
+                const int n = snprintf(text, sizeof(text),
+                                       "\033[0;32mI (%" PRIu32 ") webui: GET /api/log?offset=%u 200\033[0m\n",
+                                       ts, (unsigned)next());
+                len = log_entry_encode_text(entry, sizeof(entry), ts, text, (size_t)n);
+                break;
+            }
+        }
+        assert(len > 0);
+        char rendered[LOG_LINE_MAX];
+        capture.text_bytes += log_entry_render(entry, len, rendered, sizeof(rendered));
+        capture.bytes.insert(capture.bytes.end(), entry, entry + len);
+        capture.ends.push_back(capture.bytes.size());
+    }
+    return capture;
+}
+
+static std::vector<uint8_t> storage_for(size_t pool)
+{
+    return std::vector<uint8_t>(LogArchive::storageSize(pool));
+}
+
+// Feed entries [from, to) of the capture at their stream positions.
+static void feed(LogArchive &archive, const Capture &capture, size_t from, size_t to,
+                 uint64_t base = 0)
+{
+    for (size_t i = from; i < to; i++) {
+        const size_t start = i == 0 ? 0 : capture.ends[i - 1];
+        archive.append(base + start, capture.bytes.data() + start, capture.ends[i] - start);
+    }
+}
+
+static std::vector<uint8_t> read_all(LogArchive &archive, uint64_t *first)
+{
+    std::vector<uint8_t> out;
+    uint64_t offset = 0;
+    uint8_t buf[300];
+    bool started = false;
+    for (;;) {
+        const size_t n = archive.read(&offset, buf, sizeof(buf));
+        if (n == 0) break;
+        if (!started) {
+            *first = offset - n;
+            started = true;
+        }
+        out.insert(out.end(), buf, buf + n);
+    }
+    return out;
+}
+
+static void test_coder_roundtrip()
+{
+    std::vector<uint8_t> storage = storage_for(4096);
+    LogArchive archive;
+    archive.attach(storage.data(), 4096);
+
+    uint8_t out[LogArchive::SEGMENT_SIZE + 64];
+    uint8_t back[LogArchive::SEGMENT_SIZE];
+    uint8_t src[LogArchive::SEGMENT_SIZE];
+    uint32_t seed = 3;
+    for (int round = 0; round < 2000; round++) {
+        // Mix of incompressible noise, long runs and short repeats.
+        const size_t len = (size_t)(round * 37) % (sizeof(src) + 1);
+        for (size_t i = 0; i < len; i++) {
+            seed = seed * 1103515245u + 12345u;
+            const unsigned mode = (round / 7) % 3;
+            src[i] = mode == 0 ? (uint8_t)(seed >> 16)
+                   : mode == 1 ? (uint8_t)(i / 300)
+                   : (uint8_t)("ESP log line "[(i + (seed >> 28)) % 13]);
+        }
+        const size_t n = archive.compress(src, len, out);
+        assert(n <= LogArchive::compressBound(len));
+        assert(archive.decompress(out, n, back, sizeof(back)) == len);
+        assert(memcmp(src, back, len) == 0);
+        if (n > 2) {
+            // Truncated or corrupted input is refused, never overruns.
+            assert(archive.decompress(out, n, back, len ? len - 1 : 0) == 0 || len == 0);
+            out[n / 2] ^= 0xA5;
+            (void)archive.decompress(out, n, back, sizeof(back));
+        }
+    }
+}
+
+static void test_history_reads_back_exactly()
+{
+    const Capture capture = capture_trace(1500);
+    const size_t pool = 64 * 1024;   // holds the whole trace
+    std::vector<uint8_t> storage = storage_for(pool);
+    LogArchive archive;
+    archive.attach(storage.data(), pool);
+    const uint64_t base = (1ull << 32) - 5000;   // across the 32-bit boundary
+    feed(archive, capture, 0, capture.ends.size(), base);
+
+    assert(archive.oldest() == base);
+    assert(archive.end() == base + capture.bytes.size());
+    uint64_t first = 0;
+    const std::vector<uint8_t> back = read_all(archive, &first);
+    assert(first == base);
+    assert(back == capture.bytes);
+}
+
+static void test_eviction_keeps_newest_whole_entries()
+{
+    const Capture capture = capture_trace(4000);
+    const size_t pool = 4096;
+    std::vector<uint8_t> storage = storage_for(pool);
+    LogArchive archive;
+    archive.attach(storage.data(), pool);
+    feed(archive, capture, 0, capture.ends.size());
+
+    assert(archive.compressedBytes() <= pool);
+    assert(archive.end() == capture.bytes.size());
+    uint64_t first = 0;
+    const std::vector<uint8_t> back = read_all(archive, &first);
+    // The oldest held byte starts an entry and everything after it survives.
+    bool boundary = first == 0;
+    for (size_t end : capture.ends) boundary = boundary || end == first;
+    assert(boundary);
+    assert(back.size() == capture.bytes.size() - first);
+    assert(memcmp(back.data(), capture.bytes.data() + first, back.size()) == 0);
+}
+
+static void test_gap_starts_new_segment()
+{
+    const Capture capture = capture_trace(200);
+    std::vector<uint8_t> storage = storage_for(8192);
+    LogArchive archive;
+    archive.attach(storage.data(), 8192);
+    feed(archive, capture, 0, 50);
+    // Entries 50..99 were overwritten in the ring before they were drained.
+    feed(archive, capture, 100, 200);
+
+    uint64_t offset = capture.ends[60];   // inside the gap
+    uint8_t buf[64];
+    const size_t n = archive.read(&offset, buf, sizeof(buf));
+    assert(n > 0 && offset - n == capture.ends[99]);
+    assert(memcmp(buf, capture.bytes.data() + capture.ends[99], n) == 0);
+
+    // Out-of-order appends are ignored, the held history never changes.
+    const uint64_t end = archive.end();
+    archive.append(capture.ends[10], capture.bytes.data(), 20);
+    assert(archive.end() == end);
+
+    archive.reset();
+    assert(archive.oldest() == archive.end());
+    offset = 0;
+    assert(archive.read(&offset, buf, sizeof(buf)) == 0);
+}
+
+// Compression ratio and CPU per line on the capture trace. The pool is the
+// 8 KiB the firmware reserves next to its 4 KiB live ring.
+static void benchmark()
+{
+    const Capture capture = capture_trace(20000);
+    const size_t lines = capture.ends.size();
+    const size_t pool = 8192;
+    std::vector<uint8_t> storage = storage_for(pool);
+    LogArchive archive;
+    archive.attach(storage.data(), pool);
+
+    auto t0 = std::chrono::steady_clock::now();
+    feed(archive, capture, 0, lines);
+    auto t1 = std::chrono::steady_clock::now();
+
+    const double ratio = (double)archive.rawBytes() / (double)archive.compressedBytes();
+    const double held_lines = (double)archive.rawBytes() * lines / (double)capture.bytes.size();
+
+    // Read the held history back the way a WebUI download does.
+    uint8_t buf[512];
+    size_t read_bytes = 0;
+    auto t2 = std::chrono::steady_clock::now();
+    for (int round = 0; round < 20; round++) {
+        uint64_t offset = 0;
+        for (size_t n; (n = archive.read(&offset, buf, sizeof(buf))) > 0;) read_bytes += n;
+    }
+    auto t3 = std::chrono::steady_clock::now();
+
+    const double append_ns = std::chrono::duration<double, std::nano>(t1 - t0).count() / lines;
+    const double read_lines = held_lines * 20;
+    const double read_ns = std::chrono::duration<double, std::nano>(t3 - t2).count() / read_lines;
+    assert(read_bytes > 0);
+    assert(ratio > 2.0);
+    const double held_text = held_lines * (double)capture.text_bytes / lines;
+    printf("archive: %zu lines, %.1f entry bytes/line, compression %.2fx; an 8 KiB pool "
+           "holds %.0f lines (%.1f KiB of text, %.1fx a plain text ring of that size); "
+           "%.0f ns/line to stage and compress, %.0f ns/line to read back\n",
+           lines, (double)capture.bytes.size() / lines, ratio, held_lines,
+           held_text / 1024.0, held_text / (double)pool, append_ns, read_ns);
+}
+
+int main()
+{
+    log_entry_set_static_fn(in_flash);
+    test_coder_roundtrip();
+    test_history_reads_back_exactly();
+    test_eviction_keeps_newest_whole_entries();
+    test_gap_starts_new_segment();
+    benchmark();
+    printf("log archive tests passed\n");
+    return 0;
+}
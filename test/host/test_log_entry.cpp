@@ -0,0 +1,386 @@
+#include "log_entry.h"
+
+#include <cassert>
+#include <chrono>
+#include <cinttypes>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Stand-in for the ESP32 DROM segment: format strings and "TAG" strings used
+// by the tests live in this array, so the predicate can tell them from
+// stack/heap strings exactly like esp_ptr_in_drom() does on the device.
+static const char flash[] =
+    "\033[0;32mI (%" PRIu32 ") %s: Connected to %s:%u, rssi %d\033[0m\n\0"
+    "mqtt\0"
+    "I (%lu) %s: %-8s|%8.3f|%+05d|%#x|%c|%p|%%|%zu|%lld|%jd|%td|%hhu|%hd\n\0"
+    "%*d|%-*.*s|%.3s|%.*s|%s\n\0"
+    "%s %s\n\0"
+    "%n\n\0"
+    "%Lf\n\0"
+    "%e %g %a %E %G\n\0"
+    "%llu %llx %lu\n\0";
+
+static const char *flash_string(int index)
+{
+    const char *p = flash;
+    for (int i = 0; i < index; i++) p += strlen(p) + 1;
+    return p;
+}
+
+static bool in_flash(const void *ptr)
+{
+    const char *p = static_cast<const char *>(ptr);
+    return p >= flash && p < flash + sizeof(flash);
+}
+
+static size_t encode(uint8_t *out, size_t cap, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const size_t len = log_entry_encode_deferred(out, cap, 1234, fmt, args, in_flash);
+    va_end(args);
+    return len;
+}
+
+static std::string expected(const char *fmt, ...)
+{
+    char buf[1024];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    return buf;
+}
+
+static std::string render(const uint8_t *entry, size_t len)
+{
+    char buf[LOG_LINE_MAX];
+    const size_t n = log_entry_render(entry, len, buf, sizeof(buf));
+    assert(n == strlen(buf));
+    return std::string(buf, n);
+}
+
+#define CHECK_ROUNDTRIP(fmt, ...)                                             \
+    do {                                                                      \
+        uint8_t entry[LOG_ENTRY_MAX];                                         \
+        const size_t len = encode(entry, sizeof(entry), fmt, __VA_ARGS__);    \
+        assert(len > 0);                                                      \
+        assert(log_entry_length(entry, len) == len);                          \
+        assert(log_entry_timestamp(entry) == 1234);                           \
+        const std::string want = expected(fmt, __VA_ARGS__);                  \
+        const std::string got = render(entry, len);                           \
+        if (got != want) {                                                    \
+            fprintf(stderr, "mismatch:\n  want %s  got  %s", want.c_str(),    \
+                    got.c_str());                                             \
+        }                                                                     \
+        assert(got == want);                                                  \
+    } while (0)
+
+static void test_roundtrip_matches_vsnprintf()
+{
+    const char *tag = flash_string(1);
+    char ram_host[] = "broker.local";
+    CHECK_ROUNDTRIP(flash_string(0), (uint32_t)123456, tag, ram_host, 8883u, -67);
+
+    int local = 0;
+    CHECK_ROUNDTRIP(flash_string(2), 99ul, tag, "flash-ish", 3.14159, -42, 0xBEEFu, 'Z',
+                    (void *)&local, (size_t)123456789, -9000000000000LL,
+                    (intmax_t)INT64_MIN, (ptrdiff_t)-17, (unsigned char)250, (short)-300);
+    CHECK_ROUNDTRIP(flash_string(2), 0ul, tag, "", -0.0, 0, 0u, ' ', (void *)nullptr,
+                    (size_t)0, 0LL, (intmax_t)INT64_MAX, (ptrdiff_t)0,
+                    (unsigned char)0, (short)0);
+
+    char text[] = "abcdefghijklmnop";
+    CHECK_ROUNDTRIP(flash_string(3), 6, 42, -10, 4, text, text, 2, text, text);
+    CHECK_ROUNDTRIP(flash_string(7), 1e-300, 6.02e23, 1.0 / 3, -2.5e10, 1e100);
+    CHECK_ROUNDTRIP(flash_string(8), 18446744073709551615ULL, 0x0123456789abcdefULL,
+                    4294967295ul);
+}
+
+static void test_strings_are_captured_at_log_time()
+{
+    const char *tag = flash_string(1);
+    char ram[] = "before";
+    uint8_t entry[LOG_ENTRY_MAX];
+    const size_t len = encode(entry, sizeof(entry), flash_string(4), tag, ram);
+    assert(len > 0);
+    strcpy(ram, "AFTER!");
+    assert(render(entry, len) == "mqtt before\n");
+
+    // Flash strings are kept by reference: one tag byte plus a pointer, no
+    // copy of the characters.
+    uint8_t by_ref[LOG_ENTRY_MAX];
+    const size_t ref_len = encode(by_ref, sizeof(by_ref), flash_string(4), tag, tag);
+    assert(ref_len == LOG_ENTRY_HEADER_SIZE + sizeof(uintptr_t) +
+                      2 * (1 + sizeof(const char *)));
+    assert(render(by_ref, ref_len) == "mqtt mqtt\n");
+
+    uint8_t null_entry[LOG_ENTRY_MAX];
+    const size_t null_len =
+        encode(null_entry, sizeof(null_entry), flash_string(4), tag, (const char *)nullptr);
+    assert(null_len > 0);
+    assert(render(null_entry, null_len) == "mqtt (null)\n");
+}
+
+static void test_unsupported_lines_fall_back()
+{
+    uint8_t entry[LOG_ENTRY_MAX];
+    int sink = 0;
+    assert(encode(entry, sizeof(entry), flash_string(5), &sink) == 0);
+    assert(encode(entry, sizeof(entry), flash_string(6), (long double)1.0) == 0);
+
+    // Format string built at run time (not in flash).
+    char ram_fmt[] = "%d\n";
+    assert(encode(entry, sizeof(entry), ram_fmt, 1) == 0);
+
+    // Inline copy larger than the entry: refused, never silently cut.
+    std::string big(400, 'x');
+    assert(encode(entry, sizeof(entry), flash_string(4), flash_string(1), big.c_str()) == 0);
+
+    // Text entries carry the formatted line, cut to the entry size.
+    uint8_t text_entry[LOG_ENTRY_MAX];
+    const char line[] = "W (5) wifi: plain text\n";
+    size_t len = log_entry_encode_text(text_entry, sizeof(text_entry), 77, line, strlen(line));
+    assert(len == LOG_ENTRY_HEADER_SIZE + strlen(line));
+    assert(log_entry_timestamp(text_entry) == 77);
+    assert(log_entry_first_char(text_entry, len) == 'W');
+    assert(render(text_entry, len) == line);
+
+    // Formatting straight into the entry body is allowed.
+    uint8_t in_place[LOG_ENTRY_MAX];
+    const int n = snprintf(reinterpret_cast<char *>(in_place + LOG_ENTRY_HEADER_SIZE),
+                           sizeof(in_place) - LOG_ENTRY_HEADER_SIZE, "E (1) x: %d\n", 5);
+    len = log_entry_encode_text(in_place, sizeof(in_place), 1,
+                                reinterpret_cast<char *>(in_place + LOG_ENTRY_HEADER_SIZE),
+                                (size_t)n);
+    assert(render(in_place, len) == "E (1) x: 5\n");
+}
+
+static void test_level_behind_colour()
+{
+    uint8_t entry[LOG_ENTRY_MAX];
+    size_t len = encode(entry, sizeof(entry), flash_string(0), (uint32_t)5, flash_string(1),
+                        "10.0.0.2", 1883u, -61);
+    assert(len > 0);
+    assert(log_entry_first_char(entry, len) == '\033');
+    assert(log_entry_level(entry, len) == 'I');
+
+    const char *lines[] = {"W (5) wifi: x\n", "\033[0;31mE (5) x: y\n", "Whatever\n", "\033[0m"};
+    const char levels[] = {'W', 'E', 0, 0};
+    for (size_t i = 0; i < 4; i++) {
+        len = log_entry_encode_text(entry, sizeof(entry), 0, lines[i], strlen(lines[i]));
+        assert(log_entry_level(entry, len) == levels[i]);
+    }
+    len = encode(entry, sizeof(entry), flash_string(4), flash_string(1), "x");
+    assert(log_entry_level(entry, len) == 0);
+}
+
+static void test_tag_without_rendering()
+{
+    uint8_t entry[LOG_ENTRY_MAX];
+    char tag[16];
+    size_t len = encode(entry, sizeof(entry), flash_string(0), (uint32_t)5, flash_string(1),
+                        "10.0.0.2", 1883u, -61);
+    assert(log_entry_tag(entry, len, tag, sizeof(tag)) == 4 && strcmp(tag, "mqtt") == 0);
+
+    // A tag copied at capture time, and one cut to the caller's buffer.
+    char stack_tag[] = "RawUartUdpListener";
+    len = encode(entry, sizeof(entry), flash_string(0), (uint32_t)5, stack_tag, "x", 1u, 1);
+    assert(log_entry_tag(entry, len, tag, sizeof(tag)) == sizeof(tag) - 1);
+    assert(strncmp(tag, stack_tag, sizeof(tag) - 1) == 0);
+
+    const char *lines[] = {"\033[0;31mE (5) eth: link down\n", "W (5) a b: x\n", "Whatever\n",
+                           "I (5) no separator\n"};
+    const char *tags[] = {"eth", "a b", "", ""};
+    for (size_t i = 0; i < 4; i++) {
+        len = log_entry_encode_text(entry, sizeof(entry), 0, lines[i], strlen(lines[i]));
+        assert(log_entry_tag(entry, len, tag, sizeof(tag)) == strlen(tags[i]));
+        assert(strcmp(tag, tags[i]) == 0);
+    }
+    len = encode(entry, sizeof(entry), flash_string(4), flash_string(1), "x");
+    assert(log_entry_tag(entry, len, tag, sizeof(tag)) == 0);
+}
+
+static void test_message_without_prefix()
+{
+    uint8_t entry[LOG_ENTRY_MAX];
+    char message[LOG_LINE_MAX];
+    size_t len = encode(entry, sizeof(entry), flash_string(0), (uint32_t)5, flash_string(1),
+                        "10.0.0.2", 1883u, -61);
+    const char connected[] = "Connected to 10.0.0.2:1883, rssi -61";
+    assert(log_entry_message(entry, len, message, sizeof(message)) == sizeof(connected) - 1);
+    assert(strcmp(message, connected) == 0);
+    assert(log_entry_message(entry, len, message, 8) == 7 && strcmp(message, "Connect") == 0);
+
+    const char *lines[] = {"\033[0;31mE (5) eth: link down\033[0m\n", "W (5) a b: x: y\n",
+                           "Whatever\n", "I (5) no separator\n"};
+    const char *messages[] = {"link down", "x: y", "Whatever", "I (5) no separator"};
+    for (size_t i = 0; i < 4; i++) {
+        len = log_entry_encode_text(entry, sizeof(entry), 0, lines[i], strlen(lines[i]));
+        assert(log_entry_message(entry, len, message, sizeof(message)) == strlen(messages[i]));
+        assert(strcmp(message, messages[i]) == 0);
+    }
+    len = encode(entry, sizeof(entry), flash_string(4), flash_string(1), "x");
+    assert(log_entry_message(entry, len, message, sizeof(message)) == 6);
+    assert(strcmp(message, "mqtt x") == 0);
+}
+
+static void test_render_caps_and_keeps_newline()
+{
+    std::string huge(600, 'y');
+    huge += "\n";
+    static uint8_t entry[1024];
+    const size_t len = log_entry_encode_text(entry, sizeof(entry), 0, huge.data(), huge.size());
+    const std::string out = render(entry, len);
+    assert(out.size() == LOG_LINE_MAX - 1);
+    assert(out.back() == '\n');
+
+    char small[16];
+    const size_t n = log_entry_render(entry, len, small, sizeof(small));
+    assert(n == sizeof(small) - 1 && small[n - 1] == '\n' && small[n] == '\0');
+}
+
+static void test_header_rejects_noise()
+{
+    uint8_t entry[LOG_ENTRY_MAX];
+    const size_t len = encode(entry, sizeof(entry), flash_string(4), flash_string(1), "x");
+    assert(log_entry_length(entry, len) == len);
+    assert(log_entry_length(entry, LOG_ENTRY_HEADER_SIZE - 1) == 0);
+    assert(log_entry_first_char(entry, len) == 0);   // format starts with %s
+
+    uint8_t copy[LOG_ENTRY_MAX];
+    for (int byte = 0; byte < 5; byte++) {
+        memcpy(copy, entry, len);
+        copy[byte] ^= 0x40;
+        assert(log_entry_length(copy, len) == 0);
+    }
+
+    // With the magic matching, random bytes pass as a header about once in
+    // 32768 tries (kind and check byte).
+    uint32_t seed = 1;
+    int false_positives = 0;
+    for (int i = 0; i < 200000; i++) {
+        uint8_t noise[LOG_ENTRY_HEADER_SIZE];
+        for (uint8_t &b : noise) {
+            seed = seed * 1103515245u + 12345u;
+            b = (uint8_t)(seed >> 16);
+        }
+        noise[0] = LOG_ENTRY_MAGIC;   // worst case: magic already matches
+        if (log_entry_length(noise, sizeof(noise)) != 0) false_positives++;
+    }
+    assert(false_positives < 50);
+}
+
+// A reader that resynchronises mid-ring can take an inline %s copy for an
+// entry; the pointers it reads back then are arbitrary bytes. Each must pass
+// the predicate again, or the entry is corrupt.
+static void test_forged_pointers_read_as_corrupt()
+{
+    char message[LOG_LINE_MAX];
+    char tag[16];
+    uint8_t entry[LOG_ENTRY_MAX];
+    const size_t len = encode(entry, sizeof(entry), flash_string(0), (uint32_t)5,
+                              flash_string(1), "10.0.0.2", 1883u, -61);
+    assert(render(entry, len).size() > 0);
+
+    static char ram_format[] = "I (%lu) %s: forged\n";
+    uint8_t forged[LOG_ENTRY_MAX];
+    memcpy(forged, entry, len);
+    const uintptr_t ram_word = (uintptr_t)ram_format;
+    memcpy(forged + LOG_ENTRY_HEADER_SIZE, &ram_word, sizeof(ram_word));
+    assert(log_entry_length(forged, len) == len);   // the header cannot tell
+    assert(render(forged, len).empty());
+    assert(log_entry_first_char(forged, len) == 0 && log_entry_level(forged, len) == 0);
+    assert(log_entry_tag(forged, len, tag, sizeof(tag)) == 0);
+    assert(log_entry_message(forged, len, message, sizeof(message)) == 0);
+
+    // A string kept by reference: format word, then tag byte and pointer.
+    const size_t tag_word = LOG_ENTRY_HEADER_SIZE + 2 * sizeof(uintptr_t) + 1;
+    static char ram_tag[] = "forged";
+    const uintptr_t tag_ptr = (uintptr_t)ram_tag;
+    memcpy(forged, entry, len);
+    memcpy(forged + tag_word, &tag_ptr, sizeof(tag_ptr));
+    assert(render(forged, len).empty());
+    assert(log_entry_tag(forged, len, tag, sizeof(tag)) == 0);
+    assert(log_entry_message(forged, len, message, sizeof(message)) == 0);
+
+    // Without a predicate nothing deferred is trusted; text entries still are.
+    log_entry_set_static_fn(nullptr);
+    assert(render(entry, len).empty() && log_entry_level(entry, len) == 0);
+    const char line[] = "W (5) wifi: plain text\n";
+    const size_t text_len = log_entry_encode_text(forged, sizeof(forged), 0, line, strlen(line));
+    assert(render(forged, text_len) == line);
+    log_entry_set_static_fn(in_flash);
+}
+
+// The capture path runs vsnprintf on every logging task today. Compare its
+// cost and size with the deferred encoder for a typical ESP_LOG line.
+static void benchmark()
+{
+    const char *fmt = flash_string(0);
+    const char *tag = flash_string(1);
+    char host[] = "broker.local";
+    constexpr int iterations = 200000;
+
+    auto format_line = [&](char *buf, size_t cap, ...) {
+        va_list args;
+        va_start(args, cap);
+        const int n = vsnprintf(buf, cap, fmt, args);
+        va_end(args);
+        return n;
+    };
+
+    char text[256];
+    volatile size_t sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        sink = sink + (size_t)format_line(text, sizeof(text), (uint32_t)i, tag, host, 1883u, -60);
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    uint8_t entry[LOG_ENTRY_MAX];
+    size_t entry_len = 0;
+    for (int i = 0; i < iterations; i++) {
+        entry_len = encode(entry, sizeof(entry), fmt, (uint32_t)i, tag, host, 1883u, -60);
+        sink = sink + entry_len;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    char rendered[LOG_LINE_MAX];
+    for (int i = 0; i < iterations / 10; i++) {
+        sink = sink + log_entry_render(entry, entry_len, rendered, sizeof(rendered));
+    }
+    auto t3 = std::chrono::steady_clock::now();
+
+    const double format_ns =
+        std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations;
+    const double encode_ns =
+        std::chrono::duration<double, std::nano>(t2 - t1).count() / iterations;
+    const double render_ns =
+        std::chrono::duration<double, std::nano>(t3 - t2).count() / (iterations / 10);
+    const size_t text_len = (size_t)format_line(text, sizeof(text), (uint32_t)(iterations - 1),
+                                                tag, host, 1883u, -60);
+    assert(entry_len < text_len);
+    printf("capture: vsnprintf %.0f ns/line (%zu bytes), deferred %.0f ns/line "
+           "(%zu bytes), %.1fx faster, %.1fx denser; render on read %.0f ns\n",
+           format_ns, text_len, encode_ns, entry_len, format_ns / encode_ns,
+           (double)(text_len + LOG_ENTRY_HEADER_SIZE) / (double)entry_len, render_ns);
+}
+
+int main()
+{
+    log_entry_set_static_fn(in_flash);
+    test_roundtrip_matches_vsnprintf();
+    test_strings_are_captured_at_log_time();
+    test_unsupported_lines_fall_back();
+    test_level_behind_colour();
+    test_tag_without_rendering();
+    test_message_without_prefix();
+    test_render_caps_and_keeps_newline();
+    test_header_rejects_noise();
+    test_forged_pointers_read_as_corrupt();
+    benchmark();
+    printf("log entry tests passed\n");
+    return 0;
+}
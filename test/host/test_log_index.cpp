@@ -0,0 +1,224 @@
+#include "log_entry.h"
+#include "log_index.h"
+
+#include <atomic>
+#include <cassert>
+#include <cinttypes>
+#include <cstdarg>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static uint32_t tag_hash(const char *tag)
+{
+    return log_tag_hash(tag, strlen(tag));
+}
+
+static void test_find_filters_and_orders()
+{
+    LogIndex index;
+    // Lines of 20 bytes: I, E, W, E (other tag), D.
+    index.record(20, 20, log_level_rank('I'), tag_hash("mqtt"));
+    index.record(40, 20, log_level_rank('E'), tag_hash("mqtt"));
+    index.record(60, 20, log_level_rank('W'), tag_hash("eth"));
+    index.record(80, 20, log_level_rank('E'), tag_hash("eth"));
+    index.record(100, 20, log_level_rank('D'), tag_hash("mqtt"));
+
+    LogIndex::Hit hits[8];
+    size_t n = index.find(0, 100, log_level_rank('W'), LogIndex::ANY_TAG, hits, 8);
+    assert(n == 3 && hits[0].start == 20 && hits[1].start == 40 && hits[2].start == 60);
+    assert(hits[0].len == 20);
+
+    n = index.find(0, 100, log_level_rank('E'), tag_hash("eth"), hits, 8);
+    assert(n == 1 && hits[0].start == 60);
+    n = index.find(0, 100, 0, tag_hash("mqtt"), hits, 8);
+    assert(n == 3 && hits[2].start == 80);
+
+    // Bounded by from, end and max.
+    n = index.find(30, 100, 0, LogIndex::ANY_TAG, hits, 8);
+    assert(n == 3 && hits[0].start == 40);
+    n = index.find(0, 60, 0, LogIndex::ANY_TAG, hits, 8);
+    assert(n == 3 && hits[2].start == 40);
+    n = index.find(0, 100, 0, LogIndex::ANY_TAG, hits, 2);
+    assert(n == 2 && hits[0].start == 0 && hits[1].start == 20);
+
+    assert(index.coveredFrom(0, 100) == 0);
+    assert(index.coveredFrom(40, 100) == 40);
+    index.clear();
+    assert(index.find(0, 100, 0, LogIndex::ANY_TAG, hits, 8) == 0);
+    assert(index.coveredFrom(0, 100) == 100);
+}
+
+static void test_coverage_gaps_and_wrap()
+{
+    LogIndex index;
+    // [0, 30) never recorded, then a lapped index: only the newest SLOTS
+    // lines are vouched for.
+    uint64_t end = 30;
+    for (size_t i = 0; i < LogIndex::SLOTS + 10; i++) {
+        end += 10;
+        index.record(end, 10, 3, 0);
+    }
+    const uint64_t floor = end - LogIndex::SLOTS * 10;
+    assert(index.coveredFrom(0, end) == floor);
+    assert(index.coveredFrom(floor + 50, end) == floor + 50);
+
+    // A line whose record is missing makes the whole range unvouched.
+    end += 10;
+    index.record(end + 10, 10, 3, 0);
+    assert(index.coveredFrom(0, end + 10) == end + 10);
+    assert(index.coveredFrom(end, end + 10) == end);
+
+    // Offsets past 2^32 are reconstructed from the query end.
+    LogIndex high;
+    const uint64_t base = (5ull << 32) - 15;
+    high.record(base, 15, 1, 0);
+    high.record(base + 20, 20, 1, 0);   // low word wraps through 0
+    LogIndex::Hit hits[4];
+    assert(high.find(0, base + 20, 0, LogIndex::ANY_TAG, hits, 4) == 2);
+    assert(hits[0].start == base - 15 && hits[1].start == base);
+    assert(high.coveredFrom(0, base + 20) == base - 15);
+}
+
+// Concurrent writers never make find() return an entry that was not
+// recorded; the reader only ever sees consistent slots.
+static void test_concurrent_record()
+{
+    static LogIndex index;
+    std::atomic<uint64_t> stream{0};
+    std::atomic<bool> stop{false};
+    std::vector<std::thread> writers;
+    for (int t = 0; t < 4; t++) {
+        writers.emplace_back([&] {
+            while (!stop.load(std::memory_order_relaxed)) {
+                const uint64_t end = stream.fetch_add(16) + 16;
+                // Rank and tag are derived from the offset so the reader can
+                // check every hit.
+                index.record(end, 16, (uint8_t)(1 + (end / 16) % 5), (uint32_t)(end / 16));
+            }
+        });
+    }
+    uint32_t checked = 0;
+    for (int round = 0; round < 20000; round++) {
+        const uint64_t end = stream.load();
+        LogIndex::Hit hits[8];
+        const size_t n = index.find(end > 4096 ? end - 4096 : 0, end, 1, LogIndex::ANY_TAG, hits, 8);
+        for (size_t i = 0; i < n; i++) {
+            assert(hits[i].len == 16 && hits[i].start % 16 == 0);
+            assert(1 + ((hits[i].start + 16) / 16) % 5 == 1);
+            if (i > 0) assert(hits[i].start > hits[i - 1].start);
+            checked++;
+        }
+    }
+    stop.store(true);
+    for (std::thread &thread : writers) thread.join();
+    assert(checked > 0);
+}
+
+// Captured the way the device does it: deferred, rendered on read. Every
+// string the benchmark logs is a literal, like ESP_LOGx formats and tags.
+static bool always_static(const void *)
+{
+    return true;
+}
+
+static size_t encode(uint8_t *out, size_t cap, const char *fmt, ...)
+{
+    va_list args;
+    va_start(args, fmt);
+    const size_t len = log_entry_encode_deferred(out, cap, 0, fmt, args, always_static);
+    va_end(args);
+    return len;
+}
+
+// Errors-only query over a log of mixed lines, the way /api/log answered it
+// before (render every line and ship it) and now (seek to the candidates,
+// check and render only those).
+static void benchmark()
+{
+    static const char *tags[] = {"RawUartUdpListener", "mqtt", "eth", "webui", "sysinfo"};
+    static const char *formats[] = {
+        "\033[0;31mE (%" PRIu32 ") %s: frame %d rssi -%d queue %d\033[0m\n",
+        "\033[0;33mW (%" PRIu32 ") %s: frame %d rssi -%d queue %d\033[0m\n",
+        "\033[0;32mI (%" PRIu32 ") %s: frame %d rssi -%d queue %d\033[0m\n",
+    };
+    std::vector<uint8_t> stream;
+    LogIndex index;
+    uint32_t errors = 0;
+    uint32_t seed = 1;
+    constexpr int lines = LogIndex::SLOTS;
+    for (int i = 0; i < lines; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const char level = (seed >> 16) % 50 == 0 ? 'E' : (seed >> 16) % 10 == 0 ? 'W' : 'I';
+        errors += level == 'E';
+        const char *tag = tags[(seed >> 8) % 5];
+        uint8_t entry[LOG_ENTRY_MAX];
+        const size_t entry_len = encode(entry, sizeof(entry), formats[level == 'E' ? 0 : level == 'W' ? 1 : 2],
+                                        (uint32_t)(i * 7), tag, i, 40 + i % 50, i % 13);
+        assert(entry_len > 0);
+        stream.insert(stream.end(), entry, entry + entry_len);
+        index.record(stream.size(), entry_len, log_level_rank(level), tag_hash(tag));
+    }
+    assert(index.coveredFrom(0, stream.size()) == 0);
+
+    char line[LOG_LINE_MAX];
+    size_t full_bytes = 0;
+    size_t filtered_bytes = 0;
+    uint32_t matched = 0;
+    constexpr int rounds = 200;
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        full_bytes = 0;
+        for (size_t at = 0; at < stream.size();) {
+            const size_t len = log_entry_length(&stream[at], stream.size() - at);
+            full_bytes += log_entry_render(&stream[at], len, line, sizeof(line));
+            at += len;
+        }
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < rounds; r++) {
+        filtered_bytes = 0;
+        matched = 0;
+        uint64_t position = 0;
+        for (;;) {
+            LogIndex::Hit hits[8];
+            const size_t n = index.find(position, stream.size(), log_level_rank('E'),
+                                        LogIndex::ANY_TAG, hits, 8);
+            for (size_t i = 0; i < n; i++) {
+                const uint8_t *entry = &stream[hits[i].start];
+                assert(log_entry_length(entry, hits[i].len) == hits[i].len);
+                assert(log_entry_level(entry, hits[i].len) == 'E');
+                filtered_bytes += log_entry_render(entry, hits[i].len, line, sizeof(line));
+                matched++;
+                position = hits[i].start + hits[i].len;
+            }
+            if (n < 8) break;
+        }
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    assert(matched == errors);
+    assert(filtered_bytes * 10 < full_bytes);
+
+    const double full_us = std::chrono::duration<double, std::micro>(t1 - t0).count() / rounds;
+    const double filtered_us = std::chrono::duration<double, std::micro>(t2 - t1).count() / rounds;
+    printf("errors-only query over %d lines: full render %.1f us / %zu bytes, indexed %.1f us / "
+           "%zu bytes (%u lines), %.1fx less time, %.0fx less transfer\n",
+           lines, full_us, full_bytes, filtered_us, filtered_bytes, matched,
+           full_us / filtered_us, (double)full_bytes / (double)filtered_bytes);
+}
+
+int main()
+{
+    log_entry_set_static_fn(always_static);
+    test_find_filters_and_orders();
+    test_coverage_gaps_and_wrap();
+    test_concurrent_record();
+    benchmark();
+    printf("log index tests passed\n");
+    return 0;
+}
@@ -0,0 +1,201 @@
+#include "log_journal_store.h"
+
+#include <unistd.h>
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static std::string make_dir()
+{
+    char dir[] = "/tmp/journal-XXXXXX";
+    assert(mkdtemp(dir));
+    return dir;
+}
+
+static void remove_dir(const std::string &dir)
+{
+    remove((dir + "/journal.log").c_str());
+    remove((dir + "/journal.old").c_str());
+    rmdir(dir.c_str());
+}
+
+static std::string read_all(LogJournalStore &store, uint64_t from = 0)
+{
+    std::string text;
+    char buf[7];   // odd size: chunks end anywhere
+    uint64_t position = from;
+    size_t n;
+    while ((n = store.read(&position, buf, sizeof(buf))) > 0) text.append(buf, n);
+    assert(position == store.end());
+    return text;
+}
+
+static void test_append_and_rotate()
+{
+    const std::string dir = make_dir();
+    LogJournalStore store;
+    store.configure(dir.c_str(), LogJournalStore::HEADER_SIZE + 10);
+    assert(store.end() == 0 && store.size() == 0 && read_all(store).empty());
+
+    assert(store.append("aaaa\n", 5));
+    assert(store.append("bbbb\n", 5));
+    assert(read_all(store) == "aaaa\nbbbb\n");
+    // A third line retires the full file; a fourth drops the first two.
+    assert(store.append("cccc\n", 5));
+    assert(read_all(store) == "aaaa\nbbbb\ncccc\n");
+    assert(store.append("dddddddd\n", 9));
+    assert(store.oldest() == 10 && store.end() == 24);
+    assert(read_all(store) == "cccc\ndddddddd\n");
+    assert(store.size() == 14);
+
+    // Positions stay absolute: a reader that saw "cccc\n" resumes at 15, one
+    // that fell behind is clamped to the oldest byte held.
+    assert(read_all(store, 15) == "dddddddd\n");
+    assert(read_all(store, 3) == "cccc\ndddddddd\n");
+    uint64_t position = 1000;
+    char buf[8];
+    assert(store.read(&position, buf, sizeof(buf)) == 0 && position == 24);
+
+    // Longer than a file: cut to what one file holds.
+    assert(store.append("0123456789abcdef", 16));
+    assert(read_all(store, 24) == "0123456789");
+    assert(!store.append("", 0));
+    remove_dir(dir);
+}
+
+// A new instance sees the journal a previous boot left, and continues it.
+static void test_survives_reboot()
+{
+    const std::string dir = make_dir();
+    {
+        LogJournalStore store;
+        store.configure(dir.c_str(), 64);
+        for (int i = 0; i < 20; i++) {
+            char line[16];
+            const int n = snprintf(line, sizeof(line), "line %02d\n", i);
+            assert(store.append(line, (size_t)n));
+        }
+    }
+    LogJournalStore store;
+    store.configure(dir.c_str(), 64);
+    const uint64_t end = store.end();
+    assert(end == 20 * 8);
+    const std::string before = read_all(store);
+    assert(before.size() >= 48 && before.size() <= 96);
+    assert(before.compare(before.size() - 8, 8, "line 19\n") == 0);
+    assert(store.append("boot\n", 5));
+    assert(read_all(store, end) == "boot\n");
+    remove_dir(dir);
+}
+
+static void write_file(const std::string &path, const std::string &data)
+{
+    FILE *file = fopen(path.c_str(), "wb");
+    assert(file);
+    assert(fwrite(data.data(), 1, data.size(), file) == data.size());
+    fclose(file);
+}
+
+static void test_recovers_damaged_files()
+{
+    const std::string dir = make_dir();
+    LogJournalStore store;
+    store.configure(dir.c_str(), 64);
+    assert(store.append("one\n", 4));
+
+    // A torn header (power cut while creating a file) is discarded.
+    write_file(dir + "/journal.log", "HBJ");
+    assert(store.end() == 0 && read_all(store).empty());
+    assert(store.append("two\n", 4));
+    assert(read_all(store) == "two\n");
+
+    // Rotation cut after the rename: only the previous file is left, and the
+    // next append continues from its end.
+    remove((dir + "/journal.old").c_str());
+    assert(rename((dir + "/journal.log").c_str(), (dir + "/journal.old").c_str()) == 0);
+    assert(store.end() == 4);
+    assert(store.append("three\n", 6));
+    assert(read_all(store) == "two\nthree\n");
+
+    // A previous file that does not lead into the current one is stale.
+    LogJournalStore other;
+    const std::string stale_dir = make_dir();
+    other.configure(stale_dir.c_str(), 64);
+    assert(other.append("stale\n", 6));
+    assert(rename((stale_dir + "/journal.log").c_str(), (dir + "/journal.old").c_str()) == 0);
+    assert(read_all(store) == "three\n");
+    assert(access((dir + "/journal.old").c_str(), F_OK) != 0);
+    remove_dir(stale_dir);
+    remove_dir(dir);
+}
+
+static void test_write_budget()
+{
+    constexpr int64_t hour = 3600LL * 1000 * 1000;
+    LogWriteBudget budget;
+    budget.configure(3600, 1000, 0);   // one byte per second
+    assert(budget.available(0) == 1000);
+    assert(budget.take(600, 0));
+    assert(!budget.take(600, 0));
+    assert(budget.take(400, 0) && budget.available(0) == 0);
+
+    // Polled every 1.5 s: fractions of a byte carry over, none is lost.
+    int64_t now = 0;
+    for (int i = 0; i < 100; i++) budget.available(now += 1500000);
+    assert(budget.available(now) == 150);
+    assert(budget.available(now + hour) == 1000);   // capped at the burst
+
+    budget.configure(0, 0, 0);
+    assert(!budget.take(1, hour) && budget.take(0, hour));
+}
+
+// Flash wear of the journal against the obvious implementation, one append
+// per line: SPIFFS programs whole 256-byte pages and erases 4 KiB blocks, so
+// both the number of writes and the padded page programs count.
+static void benchmark()
+{
+    constexpr size_t page = 256;
+    constexpr size_t batch = 4096;
+    constexpr int lines = 20000;
+    const std::string dir = make_dir();
+    LogJournalStore store;
+    store.configure(dir.c_str(), 16 * 1024);
+
+    std::string pending;
+    uint32_t line_writes = 0, line_pages = 0, batch_writes = 0, batch_pages = 0;
+    for (int i = 0; i < lines; i++) {
+        char line[96];
+        const int n = snprintf(line, sizeof(line), "I (%d) raw_uart: frame %d from 0x%06X\n",
+                               i * 37, i, 0x100000 + i);
+        line_writes++;
+        line_pages += (uint32_t)((n + page - 1) / page);
+        if (pending.size() + (size_t)n > batch) {
+            assert(store.append(pending.data(), pending.size()));
+            batch_writes++;
+            batch_pages += (uint32_t)((pending.size() + page - 1) / page);
+            pending.clear();
+        }
+        pending.append(line, (size_t)n);
+    }
+    assert(batch_writes * 50 < line_writes);
+    assert(batch_pages * 5 < line_pages);
+    printf("log journal: %d lines, per line %u writes / %u pages programmed, "
+           "batched %u writes / %u pages\n",
+           lines, line_writes, line_pages, batch_writes, batch_pages);
+    remove_dir(dir);
+}
+
+int main()
+{
+    test_append_and_rotate();
+    test_survives_reboot();
+    test_recovers_damaged_files();
+    test_write_budget();
+    benchmark();
+    printf("log journal store tests passed\n");
+    return 0;
+}
@@ -0,0 +1,165 @@
+#include "log_limiter.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+// Tags are compared by pointer, like the TAG constants ESP_LOGx passes.
+static const char RAW_UART[] = "raw_uart";
+static const char MQTT[] = "mqtt";
+
+static void test_disabled_admits_everything()
+{
+    LogLimiter limiter;
+    for (int i = 0; i < 10000; i++) assert(limiter.admit(RAW_UART, 0));
+    assert(limiter.suppressedTotal() == 0);
+    assert(!limiter.summaryDue(LogLimiter::SUMMARY_INTERVAL_US * 2));
+}
+
+static void test_burst_then_rate()
+{
+    LogLimiter limiter;
+    limiter.configure(10, 5, 0);   // one line per 100 ms, five at once
+    uint32_t now = 1000;
+    int admitted = 0;
+    for (int i = 0; i < 100; i++) admitted += limiter.admit(RAW_UART, now);
+    assert(admitted == 5);
+    assert(limiter.suppressedTotal() == 95);
+
+    // A steady flood for ten seconds gets exactly the configured rate.
+    admitted = 0;
+    for (int ms = 1; ms <= 10000; ms++) {
+        now += 1000;
+        for (int j = 0; j < 3; j++) admitted += limiter.admit(RAW_UART, now);
+    }
+    assert(admitted == 100);
+
+    // Quiet for a while refills the bucket to the burst, not beyond.
+    now += 60 * 1000 * 1000;
+    admitted = 0;
+    for (int i = 0; i < 50; i++) admitted += limiter.admit(RAW_UART, now);
+    assert(admitted == 5);
+}
+
+static void test_tags_are_independent()
+{
+    LogLimiter limiter;
+    limiter.configure(1, 2, 0);
+    for (int i = 0; i < 1000; i++) limiter.admit(RAW_UART, 5000);
+    assert(limiter.admit(MQTT, 5000));
+    assert(limiter.admit(MQTT, 5000));
+    assert(!limiter.admit(MQTT, 5000));
+
+    // Tags beyond the table share the overflow bucket.
+    static char tags[LogLimiter::TAG_SLOTS + 4][8];
+    for (size_t i = 0; i < LogLimiter::TAG_SLOTS + 4; i++) {
+        snprintf(tags[i], sizeof(tags[i]), "t%zu", i);
+        limiter.admit(tags[i], 5000);
+    }
+    const char *tag = nullptr;
+    uint32_t suppressed = 0;
+    assert(limiter.slotTotal(0, &tag, &suppressed) && tag == RAW_UART && suppressed == 998);
+    assert(limiter.slotTotal(LogLimiter::TAG_SLOTS, &tag, &suppressed) && tag == nullptr);
+    assert(suppressed == 4);   // two overflow tags got the burst of two
+    assert(!limiter.slotTotal(LogLimiter::TAG_SLOTS + 1, &tag, &suppressed));
+}
+
+static void test_summaries()
+{
+    LogLimiter limiter;
+    limiter.configure(1, 1, 0);
+    uint32_t now = LogLimiter::SUMMARY_INTERVAL_US;
+    assert(!limiter.summaryDue(now));   // nothing suppressed yet
+    for (int i = 0; i < 11; i++) limiter.admit(RAW_UART, now);
+    for (int i = 0; i < 4; i++) limiter.admit(MQTT, now);
+    assert(limiter.summaryDue(now));
+    assert(!limiter.summaryDue(now));   // once per interval
+
+    size_t cursor = 0;
+    const char *tag = nullptr;
+    uint32_t count = 0;
+    assert(limiter.takeSummary(&cursor, &tag, &count) && tag == RAW_UART && count == 10);
+    assert(limiter.takeSummary(&cursor, &tag, &count) && tag == MQTT && count == 3);
+    assert(!limiter.takeSummary(&cursor, &tag, &count));
+
+    limiter.admit(RAW_UART, now + 1);
+    assert(!limiter.summaryDue(now + LogLimiter::SUMMARY_INTERVAL_US - 1));
+    assert(limiter.summaryDue(now + LogLimiter::SUMMARY_INTERVAL_US));
+    cursor = 0;
+    assert(limiter.takeSummary(&cursor, &tag, &count) && tag == RAW_UART && count == 1);
+    assert(limiter.suppressedTotal() == 14);
+}
+
+static void test_clock_wrap()
+{
+    LogLimiter limiter;
+    // The 32-bit microsecond clock wraps every ~71 minutes; a storm across
+    // the wrap keeps its rate.
+    uint32_t now = UINT32_MAX - 500000;
+    limiter.configure(100, 3, now);
+    int admitted = 0;
+    for (int ms = 0; ms < 1000; ms++, now += 1000) {
+        for (int j = 0; j < 5; j++) admitted += limiter.admit(RAW_UART, now);
+    }
+    assert(admitted >= 100 && admitted <= 103);
+
+    // A bucket last used half a wrap ago must not look like it is far in
+    // the future and lock the tag out.
+    now += 0x80000000u + 12345;
+    assert(limiter.admit(RAW_UART, now));
+}
+
+// Several tasks flooding the same tag never get more than burst + rate.
+static void test_concurrent_flood()
+{
+    LogLimiter limiter;
+    limiter.configure(1000, 20, 0);
+    std::atomic<uint32_t> clock{0};
+    std::atomic<int> admitted{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 200000; i++) {
+                const uint32_t now = clock.fetch_add(1, std::memory_order_relaxed) / 8;
+                if (limiter.admit(RAW_UART, now)) admitted.fetch_add(1);
+            }
+        });
+    }
+    for (std::thread &thread : threads) thread.join();
+    const int elapsed_ms = (int)(clock.load() / 8 / 1000);
+    assert(admitted.load() <= 20 + elapsed_ms + 1);
+    assert(admitted.load() >= elapsed_ms / 2);
+    assert(limiter.suppressedTotal() == 800000u - (uint32_t)admitted.load());
+}
+
+static void benchmark()
+{
+    LogLimiter limiter;
+    limiter.configure(20, 50, 0);
+    static char tags[24][8];
+    for (int i = 0; i < 24; i++) snprintf(tags[i], sizeof(tags[i]), "tag%d", i);
+    constexpr int iterations = 2000000;
+    volatile int sink = 0;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) sink = sink + limiter.admit(tags[i % 24], (uint32_t)i);
+    auto t1 = std::chrono::steady_clock::now();
+    printf("limiter: %.0f ns per line with 24 tags in the table\n",
+           std::chrono::duration<double, std::nano>(t1 - t0).count() / iterations);
+}
+
+int main()
+{
+    test_disabled_admits_everything();
+    test_burst_then_rate();
+    test_tags_are_independent();
+    test_summaries();
+    test_clock_wrap();
+    test_concurrent_flood();
+    benchmark();
+    printf("log limiter tests passed\n");
+    return 0;
+}
@@ -0,0 +1,402 @@
+#include "log_ring.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Producer stall injected between reservation and copy, to force commit
+// ordering and lapping deterministically.
+static std::atomic<bool> test_hook_armed{false};
+static std::atomic<bool> test_hook_stalled{false};
+static std::atomic<bool> test_hook_release{false};
+static thread_local bool test_hook_victim = false;
+
+extern "C" void log_ring_test_after_reserve(void)
+{
+    if (!test_hook_victim || !test_hook_armed.load(std::memory_order_acquire)) {
+        return;
+    }
+    test_hook_stalled.store(true, std::memory_order_release);
+    while (!test_hook_release.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+// One self-checking line: "<thread>:<seq>:<padding>:<checksum>\n". The
+// padding varies the length so lines straddle the ring end at every phase.
+static std::string make_line(int thread, uint32_t seq)
+{
+    char head[32];
+    snprintf(head, sizeof(head), "%d:%u:", thread, (unsigned)seq);
+    std::string line(head);
+    line.append((seq * 7 + (uint32_t)thread) % 61, (char)('a' + thread));
+    uint32_t sum = 0;
+    for (char c : line) sum = sum * 31 + (unsigned char)c;
+    char tail[16];
+    snprintf(tail, sizeof(tail), ":%08x\n", (unsigned)sum);
+    return line + tail;
+}
+
+// Returns false for a torn or corrupted line; fills thread/seq otherwise.
+static bool parse_line(const std::string &line, int *thread, uint32_t *seq)
+{
+    unsigned t = 0;
+    unsigned s = 0;
+    if (sscanf(line.c_str(), "%u:%u:", &t, &s) != 2) return false;
+    if (line != make_line((int)t, s)) return false;
+    *thread = (int)t;
+    *seq = s;
+    return true;
+}
+
+// Lines never exceed 1 GiB; longer jumps are split so each write stays well
+// inside the 2^31 window the 32-bit words can disambiguate.
+static uint64_t advance_detached(LogRing &ring, uint64_t bytes)
+{
+    static const char dummy = 0;
+    uint64_t end = ring.committed();
+    while (bytes > 0) {
+        const uint64_t step = bytes < (UINT64_C(1) << 30) ? bytes : (UINT64_C(1) << 30);
+        end = ring.write(&dummy, (size_t)step);   // detached: nothing copied
+        assert(ring.committed() == end);
+        bytes -= step;
+    }
+    return end;
+}
+
+static std::string read_all(const LogRing &ring)
+{
+    std::string out;
+    char chunk[1000];
+    uint64_t offset = ring.oldest();
+    for (;;) {
+        const uint64_t before = offset;
+        const size_t count = ring.read(&offset, chunk, sizeof(chunk));
+        assert(offset - count == before);   // never skips inside a quiet ring
+        if (count == 0) break;
+        out.append(chunk, count);
+    }
+    return out;
+}
+
+struct Record {
+    uint64_t end;
+    uint32_t len;
+};
+
+// Large ring, no overwrite: every byte of every line must be readable at
+// exactly the offset write() reported, in reservation order, while a reader
+// tails the ring concurrently and never observes a gap or a torn byte.
+static void test_no_loss_byte_exact(uint64_t base)
+{
+    constexpr int thread_count = 8;
+    constexpr uint32_t lines_per_thread = 20000;
+    static char storage[1u << 23];
+    LogRing ring;
+    assert(advance_detached(ring, base) == base);
+    memset(storage, 0, sizeof(storage));
+    ring.attach(storage, sizeof(storage));
+    ring.markStart();
+
+    std::vector<std::vector<Record>> records(thread_count);
+    std::atomic<int> running{thread_count};
+    std::string tailed;
+    std::thread reader([&]() {
+        uint64_t offset = base;
+        char chunk[512];
+        for (;;) {
+            const bool last = running.load(std::memory_order_acquire) == 0;
+            const uint64_t before = offset;
+            const size_t count = ring.read(&offset, chunk, sizeof(chunk));
+            assert(offset - count == before);
+            tailed.append(chunk, count);
+            if (count == 0 && last) break;
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < thread_count; t++) {
+        writers.emplace_back([&, t]() {
+            records[t].reserve(lines_per_thread);
+            for (uint32_t seq = 0; seq < lines_per_thread; seq++) {
+                const std::string line = make_line(t, seq);
+                const uint64_t end = ring.write(line.data(), line.size());
+                records[t].push_back({end, (uint32_t)line.size()});
+            }
+            running.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    for (std::thread &writer : writers) writer.join();
+    reader.join();
+
+    uint64_t total = 0;
+    for (const auto &per_thread : records) {
+        for (const Record &r : per_thread) total += r.len;
+    }
+    assert(total < sizeof(storage));
+    assert(ring.committed() == base + total);
+    assert(ring.oldest() == base);
+
+    const std::string stream = read_all(ring);
+    assert(stream.size() == total);
+    assert(tailed == stream);
+
+    // Each write's reported range holds exactly that line, and the ranges
+    // tile the stream: nothing lost, nothing duplicated, nothing overlapping.
+    std::vector<uint8_t> owned(total, 0);
+    for (int t = 0; t < thread_count; t++) {
+        uint64_t previous_end = base;
+        for (uint32_t seq = 0; seq < lines_per_thread; seq++) {
+            const Record &r = records[t][seq];
+            assert(r.end - r.len >= previous_end);   // program order kept
+            previous_end = r.end;
+            const size_t at = (size_t)(r.end - r.len - base);
+            assert(stream.compare(at, r.len, make_line(t, seq)) == 0);
+            for (size_t i = at; i < at + r.len; i++) {
+                assert(owned[i] == 0);
+                owned[i] = 1;
+            }
+        }
+    }
+
+    // And the stream itself parses into complete, per-thread ordered lines.
+    std::vector<uint32_t> next(thread_count, 0);
+    size_t pos = 0;
+    while (pos < stream.size()) {
+        const size_t nl = stream.find('\n', pos);
+        assert(nl != std::string::npos);
+        int t = -1;
+        uint32_t seq = 0;
+        assert(parse_line(stream.substr(pos, nl + 1 - pos), &t, &seq));
+        assert(seq == next[t]);
+        next[t]++;
+        pos = nl + 1;
+    }
+    for (int t = 0; t < thread_count; t++) assert(next[t] == lines_per_thread);
+
+    printf("no-loss (base %llu): %llu bytes, %d x %u lines byte-exact\n",
+           (unsigned long long)base, (unsigned long long)total, thread_count,
+           (unsigned)lines_per_thread);
+}
+
+// Small ring under heavy overwrite: a concurrent reader may lose old lines
+// (that is what a ring does) but must never be handed a corrupted byte.
+static void test_overwrite_never_returns_torn_bytes()
+{
+    constexpr int thread_count = 6;
+    constexpr uint32_t lines_per_thread = 100000;
+    static char storage[4096];
+    LogRing ring;
+    ring.attach(storage, sizeof(storage));
+    ring.markStart();
+
+    std::atomic<int> running{thread_count};
+    uint64_t lines_checked = 0;
+    uint64_t resyncs = 0;
+    std::thread reader([&]() {
+        uint64_t offset = 0;
+        std::string pending;
+        bool synced = true;
+        char chunk[300];
+        std::vector<int64_t> last(thread_count, -1);
+        for (;;) {
+            const bool last_round = running.load(std::memory_order_acquire) == 0;
+            // Tail like a live viewer: reading at the very oldest byte of a
+            // small ring loses nearly every race against the producers.
+            const uint64_t commit = ring.committed();
+            if (commit - offset > sizeof(storage) / 2) {
+                offset = commit - sizeof(storage) / 4;
+                pending.clear();
+                synced = false;
+                resyncs++;
+            }
+            const uint64_t before = offset;
+            const size_t count = ring.read(&offset, chunk, sizeof(chunk));
+            if (count == 0) {
+                if (last_round) break;
+                continue;
+            }
+            if (offset - count != before) {
+                // Lapped: the bytes in between are gone. Resync on the next
+                // line boundary.
+                pending.clear();
+                synced = false;
+                resyncs++;
+            }
+            pending.append(chunk, count);
+            size_t pos = 0;
+            if (!synced) {
+                const size_t nl = pending.find('\n');
+                if (nl == std::string::npos) {
+                    pending.clear();
+                    continue;
+                }
+                pos = nl + 1;
+                synced = true;
+            }
+            for (;;) {
+                const size_t nl = pending.find('\n', pos);
+                if (nl == std::string::npos) break;
+                int t = -1;
+                uint32_t seq = 0;
+                assert(parse_line(pending.substr(pos, nl + 1 - pos), &t, &seq));
+                assert((int64_t)seq > last[t]);
+                last[t] = seq;
+                lines_checked++;
+                pos = nl + 1;
+            }
+            pending.erase(0, pos);
+        }
+    });
+
+    std::vector<std::thread> writers;
+    for (int t = 0; t < thread_count; t++) {
+        writers.emplace_back([&, t]() {
+            for (uint32_t seq = 0; seq < lines_per_thread; seq++) {
+                const std::string line = make_line(t, seq);
+                ring.write(line.data(), line.size());
+            }
+            running.fetch_sub(1, std::memory_order_release);
+        });
+    }
+    for (std::thread &writer : writers) writer.join();
+    reader.join();
+
+    // The final window is one full ring of intact lines after a boundary.
+    const std::string tail = read_all(ring);
+    assert(tail.size() == sizeof(storage));
+    assert(ring.committed() - ring.oldest() == sizeof(storage));
+    size_t pos = tail.find('\n') + 1;
+    while (pos < tail.size()) {
+        const size_t nl = tail.find('\n', pos);
+        int t = -1;
+        uint32_t seq = 0;
+        assert(parse_line(tail.substr(pos, nl + 1 - pos), &t, &seq));
+        pos = nl + 1;
+    }
+    assert(lines_checked > 0);
+    printf("overwrite: %llu lines verified by a concurrent reader, %llu resyncs\n",
+           (unsigned long long)lines_checked, (unsigned long long)resyncs);
+}
+
+// A producer stalled after reserving holds back the commit point: later
+// producers finish, but readers must not see past the gap until it is filled,
+// and then see everything in reservation order.
+static void test_commit_waits_for_stalled_producer()
+{
+    static char storage[4096];
+    LogRing ring;
+    ring.attach(storage, sizeof(storage));
+    ring.markStart();
+    ring.write("first\n", 6);
+
+    test_hook_stalled.store(false);
+    test_hook_release.store(false);
+    test_hook_armed.store(true, std::memory_order_release);
+    uint64_t stalled_end = 0;
+    std::thread victim([&]() {
+        test_hook_victim = true;
+        stalled_end = ring.write("stalled\n", 8);
+    });
+    while (!test_hook_stalled.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    const uint64_t later_end = ring.write("later\n", 6);
+    assert(later_end == 6 + 8 + 6);
+    assert(ring.committed() == 6);
+    assert(read_all(ring) == "first\n");
+
+    test_hook_release.store(true, std::memory_order_release);
+    victim.join();
+    test_hook_armed.store(false);
+    assert(stalled_end == 6 + 8);
+    assert(ring.committed() == 20);
+    assert(read_all(ring) == "first\nstalled\nlater\n");
+}
+
+// A producer stalled for more than a full ring wakes up and writes stale
+// bytes over newer lines. Readers must discard everything it may have hit.
+static void test_lapped_producer_is_fenced_off()
+{
+    static char storage[256];
+    LogRing ring;
+    ring.attach(storage, sizeof(storage));
+    ring.markStart();
+
+    test_hook_stalled.store(false);
+    test_hook_release.store(false);
+    test_hook_armed.store(true, std::memory_order_release);
+    std::thread victim([&]() {
+        test_hook_victim = true;
+        const std::string stale(40, 'X');
+        ring.write(stale.data(), stale.size());
+    });
+    while (!test_hook_stalled.load(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+
+    uint32_t seq = 0;
+    uint64_t end = 0;
+    while (end < 40 + 3 * sizeof(storage)) {
+        const std::string line = make_line(1, seq++);
+        end = ring.write(line.data(), line.size());
+    }
+    test_hook_release.store(true, std::memory_order_release);
+    victim.join();
+    test_hook_armed.store(false);
+
+    assert(ring.committed() == end);
+    const std::string tail = read_all(ring);
+    assert(tail.find('X') == std::string::npos);
+    assert(tail.size() <= sizeof(storage));
+}
+
+// Stream offsets keep counting across the 32-bit wrap of the shared words.
+static void test_offsets_cross_32_bit_wrap()
+{
+    static char storage[2048];
+    LogRing ring;
+    const uint64_t near_wrap = (UINT64_C(1) << 32) - 3000;
+    uint64_t end = advance_detached(ring, near_wrap);
+    assert(end == near_wrap);
+
+    ring.attach(storage, sizeof(storage));
+    ring.markStart();
+    std::string expected;
+    for (uint32_t seq = 0; seq < 200; seq++) {
+        const std::string line = make_line(2, seq);
+        end = ring.write(line.data(), line.size());
+        expected += line;
+    }
+    assert(end == near_wrap + expected.size());
+    assert(end > (UINT64_C(1) << 32));
+    assert(ring.committed() == end);
+    assert(read_all(ring) ==
+           expected.substr(expected.size() - sizeof(storage)));
+
+    // A reader holding an offset from before the wrap resumes exactly.
+    uint64_t offset = end - 10;
+    char chunk[32];
+    assert(ring.read(&offset, chunk, sizeof(chunk)) == 10);
+    assert(offset == end);
+    assert(memcmp(chunk, expected.data() + expected.size() - 10, 10) == 0);
+}
+
+int main()
+{
+    test_commit_waits_for_stalled_producer();
+    test_lapped_producer_is_fenced_off();
+    test_offsets_cross_32_bit_wrap();
+    test_no_loss_byte_exact(0);
+    // Same run with the 32-bit words wrapping mid-test.
+    test_no_loss_byte_exact((UINT64_C(1) << 32) - 1000000);
+    test_overwrite_never_returns_torn_bytes();
+    printf("log ring tests passed\n");
+    return 0;
+}
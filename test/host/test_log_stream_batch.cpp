@@ -0,0 +1,269 @@
+#include "log_stream_batch.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <string>
+#include <vector>
+
+// The browser side of the stream protocol (systemlog.vue), reduced to what
+// decides correctness: frames wholly before the client's offset are stale,
+// frames starting past it are a gap and make the client resynchronise.
+struct Client {
+    uint64_t offset = 0;
+    std::string text;
+    uint32_t gaps = 0;
+
+    void receive(const char *frame, size_t len)
+    {
+        const std::string data(frame, len);
+        assert(data.compare(0, 12, "stream data ") == 0);
+        const size_t header_end = data.find('\n');
+        assert(header_end != std::string::npos);
+        char *rest = nullptr;
+        const uint64_t end = strtoull(data.c_str() + 12, &rest, 10);
+        const uint64_t span = strtoull(rest, nullptr, 10);
+        assert(span > 0 && end >= span);
+        if (end <= offset) return;
+        if (end - span > offset) {
+            gaps++;
+            return;
+        }
+        offset = end;
+        text += data.substr(header_end + 1);
+    }
+};
+
+static void deliver(const LogStreamBatch &batch, uint64_t checkpoint, Client *client,
+                    uint32_t *frames = nullptr)
+{
+    char frame[LogStreamBatch::FRAME_MAX];
+    uint64_t position = checkpoint;
+    size_t len;
+    while ((len = batch.nextFrame(&position, frame, sizeof(frame), nullptr)) > 0) {
+        client->receive(frame, len);
+        if (frames) (*frames)++;
+    }
+}
+
+static void test_adjacent_lines_share_a_frame()
+{
+    LogStreamBatch batch;
+    assert(batch.append("a\n", 2, 20, 20));
+    assert(batch.append("bb\n", 3, 50, 30));
+    assert(batch.append("", 0, 60, 10));   // rendered to nothing, range still covered
+    assert(batch.append("ccc\n", 4, 75, 15));
+
+    char frame[LogStreamBatch::FRAME_MAX];
+    uint64_t position = 0;
+    uint32_t lines = 0;
+    const size_t len = batch.nextFrame(&position, frame, sizeof(frame), &lines);
+    assert(std::string(frame, len) == "stream data 75 75\na\nbb\nccc\n");
+    assert(position == 75 && lines == 4);
+    assert(!batch.hasFrameAfter(position));
+    assert(batch.nextFrame(&position, frame, sizeof(frame), &lines) == 0);
+    assert(batch.nextFrame(&position, frame, 100, &lines) == 0);   // too small
+}
+
+// Two tasks logging at once may publish their lines in reverse stream order.
+static void test_out_of_order_lines_are_sorted()
+{
+    LogStreamBatch batch;
+    assert(batch.append("first\n", 6, 100, 40));
+    assert(batch.append("third\n", 6, 180, 40));
+    assert(batch.append("second\n", 7, 140, 40));
+
+    Client client;
+    client.offset = 60;
+    uint32_t frames = 0;
+    deliver(batch, client.offset, &client, &frames);
+    assert(frames == 1 && client.gaps == 0);
+    assert(client.text == "first\nsecond\nthird\n" && client.offset == 180);
+}
+
+static void test_missing_range_ends_the_frame()
+{
+    LogStreamBatch batch;
+    assert(batch.append("a\n", 2, 10, 10));
+    assert(batch.append("c\n", 2, 30, 10));   // [10, 20) never arrived
+
+    Client client;
+    uint32_t frames = 0;
+    deliver(batch, 0, &client, &frames);
+    assert(frames == 2);
+    assert(client.text == "a\n" && client.offset == 10 && client.gaps == 1);
+}
+
+// A subscriber whose snapshot already holds the start of the batch gets only
+// the rest, with a header that says so.
+static void test_checkpoint_inside_batch()
+{
+    LogStreamBatch batch;
+    assert(batch.append("a\n", 2, 10, 10));
+    assert(batch.append("b\n", 2, 20, 10));
+    assert(batch.append("c\n", 2, 30, 10));
+
+    char frame[LogStreamBatch::FRAME_MAX];
+    uint64_t position = 20;
+    const size_t len = batch.nextFrame(&position, frame, sizeof(frame), nullptr);
+    assert(std::string(frame, len) == "stream data 30 10\nc\n");
+    assert(!batch.hasFrameAfter(30));
+    assert(batch.hasFrameAfter(29));
+}
+
+static void test_limits()
+{
+    LogStreamBatch batch;
+    std::string line(LogStreamBatch::TEXT_MAX / 2, 'x');
+    assert(batch.append(line.data(), line.size(), 10, 10));
+    assert(batch.append(line.data(), line.size(), 20, 10));
+    assert(!batch.append("y", 1, 30, 10));   // text full
+    char frame[LogStreamBatch::FRAME_MAX];
+    uint64_t position = 0;
+    assert(batch.nextFrame(&position, frame, sizeof(frame), nullptr) <= LogStreamBatch::FRAME_MAX);
+
+    batch.clear();
+    for (size_t i = 0; i < LogStreamBatch::LINES_MAX; i++) {
+        assert(batch.append("z", 1, (i + 1) * 5, 5));
+    }
+    assert(!batch.append("z", 1, 1000, 5));   // line slots full
+    assert(!LogStreamBatch().append("z", 1, 4, 5));   // span before the stream start
+}
+
+// Synthetic log storm against a model of the device pipeline: the 8-item
+// publish queue, the 8-slot send pool and an HTTP server task that completes
+// one WebSocket send every 2 ms. Any lost hand-off forces every client to
+// reconnect and resynchronise, as on the device.
+struct StormResult {
+    uint32_t lines = 0;
+    uint32_t frames = 0;
+    uint32_t resyncs = 0;
+};
+
+static StormResult storm(bool coalesce)
+{
+    constexpr int duration_ms = 5000;
+    constexpr int lines_per_ms = 2;
+    constexpr int subscribers = 2;
+    constexpr size_t publish_queue = 8;
+    constexpr size_t send_slots = 8;
+    constexpr int send_ms = 2;
+    constexpr int flush_ms = 50;
+
+    struct Item {
+        uint64_t end;
+        uint32_t span;
+        std::string text;
+    };
+    struct Work {
+        int subscriber;
+        std::string frame;
+    };
+
+    StormResult result;
+    LogStreamBatch batch;
+    std::deque<Item> queue;
+    std::deque<Work> in_flight;
+    Client clients[subscribers];
+    uint64_t checkpoint = 0;
+    uint64_t stream_end = 0;
+    bool overflow = false;
+    int window_start = -1;
+    uint32_t seed = 7;
+
+    auto flush = [&] {
+        for (int s = 0; s < subscribers && !overflow; s++) {
+            char frame[LogStreamBatch::FRAME_MAX];
+            uint64_t position = checkpoint;
+            while (batch.hasFrameAfter(position)) {
+                if (in_flight.size() == send_slots) {
+                    overflow = true;
+                    break;
+                }
+                uint32_t lines = 0;
+                const size_t len = batch.nextFrame(&position, frame, sizeof(frame), &lines);
+                in_flight.push_back({s, std::string(frame, len)});
+                result.frames++;
+                result.lines += lines;
+            }
+        }
+        batch.clear();
+        window_start = -1;
+    };
+
+    for (int ms = 0; ms < duration_ms; ms++) {
+        if (ms % send_ms == 0 && !in_flight.empty()) {
+            const Work &work = in_flight.front();
+            clients[work.subscriber].receive(work.frame.data(), work.frame.size());
+            in_flight.pop_front();
+        }
+
+        for (int i = 0; i < lines_per_ms; i++) {
+            seed = seed * 1103515245u + 12345u;
+            const uint32_t span = 40 + (seed >> 16) % 60;
+            stream_end += span;
+            char text[160];
+            snprintf(text, sizeof(text), "I (%d) storm: line %llu %.*s\n", ms,
+                     (unsigned long long)stream_end, (int)(span - 30), "................"
+                     "................................................................");
+            if (queue.size() == publish_queue) overflow = true;
+            else queue.push_back({stream_end, span, text});
+        }
+
+        if (overflow) {
+            // Close every client; each reconnects with a fresh snapshot.
+            result.resyncs++;
+            queue.clear();
+            in_flight.clear();
+            batch.clear();
+            window_start = -1;
+            checkpoint = stream_end;
+            for (Client &client : clients) client = Client{stream_end, "", 0};
+            overflow = false;
+            continue;
+        }
+
+        while (!queue.empty() && !overflow) {
+            const Item &item = queue.front();
+            if (window_start < 0) window_start = ms;
+            if (!batch.append(item.text.data(), item.text.size(), item.end, item.span)) {
+                flush();
+                batch.append(item.text.data(), item.text.size(), item.end, item.span);
+                window_start = ms;
+            }
+            queue.pop_front();
+            if (!coalesce) flush();
+        }
+        if (window_start >= 0 && ms - window_start >= flush_ms) flush();
+    }
+    for (const Client &client : clients) assert(client.gaps == 0);
+    return result;
+}
+
+static void benchmark()
+{
+    const StormResult single = storm(false);
+    const StormResult batched = storm(true);
+    assert(batched.resyncs == 0);
+    assert(single.resyncs > batched.resyncs);
+    assert(batched.frames * 5 < batched.lines);
+    printf("log storm (2000 lines/s, 2 clients, 5 s): per line %.0f frames/s, %u resyncs; "
+           "coalesced %.0f frames/s carrying %.0f line deliveries/s, %u hand-offs saved, %u resyncs\n",
+           single.frames / 5.0, single.resyncs, batched.frames / 5.0, batched.lines / 5.0,
+           batched.lines - batched.frames, batched.resyncs);
+}
+
+int main()
+{
+    test_adjacent_lines_share_a_frame();
+    test_out_of_order_lines_are_sorted();
+    test_missing_range_ends_the_frame();
+    test_checkpoint_inside_batch();
+    test_limits();
+    benchmark();
+    printf("log stream batch tests passed\n");
+    return 0;
+}
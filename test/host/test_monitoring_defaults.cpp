@@ -18,14 +18,23 @@ static void test_empty_namespace_uses_complete_defaults()
     assert(std::strcmp(config.mqtt.topic_prefix, "hb-rf-eth-ng") == 0);
     assert(std::strcmp(config.mqtt.ha_discovery_prefix, "homeassistant") == 0);
     assert(config.mqtt.command_enabled);
+    assert(config.mqtt.status_refresh_minutes == 15);
+    assert(!config.mqtt.state_document);
+    assert(!config.mqtt.protocol_v5);
 
     assert(config.prometheus.port == 9100);
     assert(std::strcmp(config.prometheus.allowed_hosts, "*") == 0);
     assert(config.syslog.port == 514);
     assert(config.syslog.min_severity == 6);
+    assert(config.syslog.rate_limit == 20);
+    assert(config.syslog.rate_burst == 50);
+    assert(config.syslog.format == 0);
     assert(config.notify.smtp_port == 587);
     assert(config.notify.smtp_tls == 1);
     assert(config.notify.cooldown_seconds == 300);
+    assert(config.notify.duty_cycle_warn == 50);
+    assert(config.notify.duty_cycle_alarm == 80);
+    assert(config.notify.digest_seconds == 0);
 }
 
 static void test_partial_namespace_preserves_mqtt_and_repairs_missing_checkmk()
@@ -63,8 +72,15 @@ static void test_invalid_scalar_values_are_repaired_without_erasing_secrets()
     config.syslog.port = 0;
     config.syslog.transport = 9;
     config.syslog.min_severity = 9;
+    config.syslog.rate_limit = 5000;
+    config.syslog.rate_burst = 0;
+    config.syslog.format = 7;
+    config.mqtt.status_refresh_minutes = 9999;
     config.notify.smtp_port = 0;
     config.notify.smtp_tls = 9;
+    config.notify.duty_cycle_warn = 150;
+    config.notify.duty_cycle_alarm = 255;
+    config.notify.digest_seconds = 9000;
     std::strcpy(config.mqtt.password, "keep-me");
     std::strcpy(config.mqtt.command_token, "KeepMe123");
 
@@ -76,8 +92,15 @@ static void test_invalid_scalar_values_are_repaired_without_erasing_secrets()
     assert(config.syslog.port == 514);
     assert(config.syslog.transport == 0);
     assert(config.syslog.min_severity == 6);
+    assert(config.syslog.rate_limit == 1000);
+    assert(config.syslog.rate_burst == 50);
+    assert(config.syslog.format == 0);
+    assert(config.mqtt.status_refresh_minutes == 1440);
     assert(config.notify.smtp_port == 587);
     assert(config.notify.smtp_tls == 1);
+    assert(config.notify.duty_cycle_warn == 50);
+    assert(config.notify.duty_cycle_alarm == 80);
+    assert(config.notify.digest_seconds == 3600);
     assert(std::strcmp(config.mqtt.password, "keep-me") == 0);
     assert(std::strcmp(config.mqtt.command_token, "KeepMe123") == 0);
 }
@@ -94,6 +117,7 @@ static void test_event_mask_defaults_to_every_supported_event()
     assert((config.notify.event_mask & NOTIFY_EVENT_ETH_LINK_DOWN) != 0);
     assert((config.notify.event_mask & NOTIFY_EVENT_CCU_DISCONNECTED) != 0);
     assert((config.notify.event_mask & NOTIFY_EVENT_LOW_HEAP) != 0);
+    assert((config.notify.event_mask & NOTIFY_EVENT_DUTY_CYCLE) != 0);
 }
 
 static void test_event_mask_normalization_drops_unknown_bits_but_keeps_none()
@@ -0,0 +1,148 @@
+#include "mqtt_discovery_cache.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+// One discovery pass as mqtt_handler.cpp runs it: every entity whose content
+// changed is published (and recorded); returns the number of publishes.
+static size_t pass(MqttDiscoveryCache &cache, const std::vector<uint32_t> &contents,
+                   uint32_t key_base = 1000)
+{
+    size_t published = 0;
+    cache.beginPass();
+    for (size_t i = 0; i < contents.size(); i++) {
+        const uint32_t key = key_base + (uint32_t)i;
+        if (!cache.changed(key, contents[i])) continue;
+        cache.record(key, contents[i]);
+        published++;
+    }
+    cache.endPass();
+    return published;
+}
+
+static void test_reconnect_publishes_only_changes()
+{
+    MqttDiscoveryCache cache;
+    std::vector<uint32_t> contents = {11, 12, 13, 14, 15};
+    assert(pass(cache, contents) == 5);
+    assert(cache.size() == 5 && cache.dirty());
+    cache.markClean();
+
+    assert(pass(cache, contents) == 0 && !cache.dirty());
+    contents[2] = 99;   // e.g. a renamed entity or a new firmware version
+    assert(pass(cache, contents) == 1 && cache.dirty());
+    cache.markClean();
+
+    // A failed publish is not recorded: tried again on the next pass.
+    contents[0] = 77;
+    cache.beginPass();
+    assert(cache.changed(1000, 77));
+    assert(pass(cache, contents) == 1);
+    assert(pass(cache, contents) == 0);
+
+    // Home Assistant restarted: everything again.
+    cache.clear();
+    assert(pass(cache, contents) == 5);
+
+    // A different discovery prefix or broker means different keys; the old
+    // entries are dropped at the end of the pass.
+    cache.markClean();
+    assert(pass(cache, contents, 2000) == 5);
+    assert(cache.size() == 5 && cache.dirty());
+}
+
+static void test_retired_entities_are_dropped()
+{
+    MqttDiscoveryCache cache;
+    assert(pass(cache, {1, 2, 3}) == 3);
+    cache.markClean();
+    assert(pass(cache, {1, 2}) == 0);
+    assert(cache.size() == 2 && cache.dirty());
+}
+
+static void test_persistence()
+{
+    MqttDiscoveryCache cache;
+    const std::vector<uint32_t> contents = {0xdeadbeef, 0, 0x12345678};
+    pass(cache, contents);
+    uint8_t blob[1 + MqttDiscoveryCache::MAX_ENTITIES * 8];
+    assert(cache.serialize(blob, 4) == 0);
+    const size_t len = cache.serialize(blob, sizeof(blob));
+    assert(len == cache.serializedSize() && len == 25);
+
+    MqttDiscoveryCache rebooted;
+    assert(rebooted.deserialize(blob, len));
+    assert(rebooted.size() == 3 && !rebooted.dirty());
+    assert(pass(rebooted, contents) == 0);
+
+    assert(!rebooted.deserialize(blob, len - 1) && rebooted.size() == 0);
+    blob[0] = 9;
+    assert(!rebooted.deserialize(blob, len));
+    assert(!rebooted.deserialize(nullptr, 0));
+    assert(rebooted.deserialize(blob, 0) == false);
+    const uint8_t empty[] = {1};
+    assert(rebooted.deserialize(empty, 1) && rebooted.size() == 0);
+}
+
+static void test_full_table()
+{
+    MqttDiscoveryCache cache;
+    std::vector<uint32_t> contents(MqttDiscoveryCache::MAX_ENTITIES + 1, 5);
+    assert(pass(cache, contents) == contents.size());
+    assert(cache.size() == MqttDiscoveryCache::MAX_ENTITIES);
+    assert(!cache.record(1, 5));
+    // The entity that did not fit is republished every time; the rest not.
+    assert(pass(cache, contents) == 1);
+}
+
+// A week of a flaky broker link: 40 discovery entities, 12 reconnects a
+// day, a reboot every other day, a firmware update (new sw_version in every
+// config) once, and Home Assistant restarting twice.
+static void benchmark()
+{
+    constexpr size_t entities = 40;
+    constexpr int days = 7;
+    constexpr int reconnects_per_day = 12;
+    std::vector<uint32_t> contents(entities);
+    for (size_t i = 0; i < entities; i++) contents[i] = (uint32_t)i * 7919u;
+
+    MqttDiscoveryCache cache;
+    uint8_t nvs[1 + MqttDiscoveryCache::MAX_ENTITIES * 8];
+    size_t nvs_len = 0;
+    size_t always = 0, cached = 0, nvs_writes = 0;
+    for (int day = 0; day < days; day++) {
+        if (day % 2 == 0) assert(cache.deserialize(nvs, nvs_len) || nvs_len == 0);
+        if (day == 3) {
+            for (uint32_t &content : contents) content ^= 0x5a5a5a5a;
+        }
+        for (int r = 0; r < reconnects_per_day; r++) {
+            if ((day == 1 || day == 5) && r == 6) cache.clear();
+            always += entities;
+            cached += pass(cache, contents);
+            if (cache.dirty()) {
+                nvs_len = cache.serialize(nvs, sizeof(nvs));
+                cache.markClean();
+                nvs_writes++;
+            }
+        }
+    }
+    assert(cached == entities * 4);   // first connect, two HA restarts, the update
+    assert(nvs_writes == 4);
+    printf("ha discovery, %d reconnects: %zu config publishes without cache, %zu with "
+           "(%zu NVS writes of %zu bytes)\n",
+           days * reconnects_per_day, always, cached, nvs_writes, nvs_len);
+}
+
+int main()
+{
+    test_reconnect_publishes_only_changes();
+    test_retired_entities_are_dropped();
+    test_persistence();
+    test_full_table();
+    benchmark();
+    printf("mqtt discovery cache tests passed\n");
+    return 0;
+}
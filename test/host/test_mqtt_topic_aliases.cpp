@@ -0,0 +1,336 @@
+#include "mqtt_topic_aliases.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// Every topic is published once before it qualifies for an alias.
+static uint16_t assign_hot(MqttTopicAliases &aliases, uint16_t topic, bool *bind)
+{
+    const uint16_t alias = aliases.assign(topic, bind);
+    if (alias) return alias;
+    assert(!*bind);
+    return aliases.assign(topic, bind);
+}
+
+static void test_bind_then_reuse()
+{
+    MqttTopicAliases aliases;
+    aliases.reset(3);
+    bool bind = false;
+    assert(aliases.assign(7, &bind) == 0 && !bind);   // first sighting
+    assert(aliases.assign(7, &bind) == 1 && bind);
+    assert(assign_hot(aliases, 9, &bind) == 2 && bind);
+    assert(aliases.assign(7, &bind) == 1 && !bind);
+    assert(assign_hot(aliases, 4, &bind) == 3 && bind);
+
+    // Full: the least recently used alias (9 on 2) is rebound.
+    assert(assign_hot(aliases, 5, &bind) == 2 && bind);
+    assert(aliases.assign(9, &bind) == 1 && bind);   // 7 was older than 4
+    assert(aliases.assign(4, &bind) == 3 && !bind);
+
+    // A lost publish binds again; a new session forgets everything.
+    aliases.drop(3);
+    assert(aliases.assign(4, &bind) == 3 && bind);
+    aliases.drop(0);
+    aliases.drop(99);
+    aliases.reset(3);
+    assert(aliases.assign(4, &bind) == 0 && !bind);
+    assert(aliases.assign(4, &bind) == 1 && bind);
+}
+
+// A topic seen again only after a long gap stays unaliased, and cannot evict
+// the topics published every cycle.
+static void test_cold_topics_keep_their_topic()
+{
+    MqttTopicAliases aliases;
+    aliases.reset(2);
+    bool bind = false;
+    assert(aliases.assign(40, &bind) == 0);
+    for (uint32_t i = 0; i <= MqttTopicAliases::HOT_WINDOW; i++) {
+        assert(aliases.assign((uint16_t)(i % 2), &bind) <= 2);
+    }
+    assert(aliases.assign(40, &bind) == 0 && !bind);
+    assert(aliases.assign(0, &bind) == 1 && !bind);
+    assert(aliases.assign(1, &bind) == 2 && !bind);
+}
+
+static void test_limits()
+{
+    MqttTopicAliases aliases;
+    bool bind = true;
+    assert(aliases.assign(1, &bind) == 0 && !bind);   // never reset: disabled
+    aliases.reset(0);
+    assert(aliases.assign(1, &bind) == 0 && !bind);
+    assert(aliases.assign(1, &bind) == 0 && !bind);
+    aliases.reset(1000);
+    assert(aliases.maximum() == MqttTopicAliases::MAX_ALIASES);
+    assert(aliases.assign(MqttTopicAliases::MAX_TOPICS, &bind) == 0);
+    assert(aliases.assign(MqttTopicAliases::MAX_TOPICS, &bind) == 0 && !bind);
+
+    // The broker refused alias 3: aliases above 2 are forgotten, not reused.
+    for (uint16_t topic = 0; topic < 4; topic++) assert(assign_hot(aliases, topic, &bind) == topic + 1);
+    aliases.limit(2);
+    assert(aliases.maximum() == 2);
+    assert(aliases.assign(0, &bind) == 1 && !bind);
+    assert(aliases.assign(2, &bind) == 2 && bind);
+    aliases.limit(5);
+    assert(aliases.maximum() == 2);
+}
+
+// The connection drops between picking an alias-only publish and sending
+// it. The new session must not see an alias it never bound.
+static void test_reset_on_reconnect()
+{
+    MqttTopicAliases aliases;
+    aliases.reset(4);
+    bool bind = false;
+    assert(assign_hot(aliases, 3, &bind) == 1 && bind);
+    assert(assign_hot(aliases, 5, &bind) == 2 && bind);
+    assert(aliases.sameSession());
+    aliases.limit(1);
+
+    assert(aliases.assign(3, &bind) == 1 && !bind);   // picked alias-only
+    aliases.endSession();   // MQTT_EVENT_DISCONNECTED
+    aliases.endSession();   // MQTT_EVENT_BEFORE_CONNECT
+    assert(!aliases.sameSession());   // so the publish sends its topic
+
+    // The next publish starts the new session with the full maximum.
+    assert(aliases.assign(5, &bind) == 0 && !bind);
+    assert(aliases.sameSession());
+    assert(aliases.maximum() == 4);
+    assert(aliases.assign(5, &bind) == 1 && bind);
+    assert(aliases.assign(3, &bind) == 0 && !bind);
+    assert(aliases.assign(3, &bind) == 2 && bind);
+}
+
+// ---------------------------------------------------------------------------
+// Bytes on the wire, 3.1.1 against 5, with a broker stand-in that decodes
+// every PUBLISH the way Mosquitto does: aliases resolve per session, and the
+// retained store must end up identical in both protocols.
+
+static void put_varint(std::vector<uint8_t> &out, size_t value)
+{
+    do {
+        uint8_t byte = value % 128;
+        value /= 128;
+        out.push_back(value ? byte | 0x80 : byte);
+    } while (value);
+}
+
+static void put_u16(std::vector<uint8_t> &out, size_t value)
+{
+    out.push_back((uint8_t)(value >> 8));
+    out.push_back((uint8_t)value);
+}
+
+static void put_string(std::vector<uint8_t> &out, const std::string &text)
+{
+    put_u16(out, text.size());
+    out.insert(out.end(), text.begin(), text.end());
+}
+
+struct Publish {
+    std::string topic;
+    std::string payload;
+    bool retain = true;
+    uint16_t alias = 0;
+    uint32_t expiry_s = 0;
+    const char *unit = nullptr;
+};
+
+static std::vector<uint8_t> encode(const Publish &message, bool v5)
+{
+    std::vector<uint8_t> body;
+    put_string(body, message.topic);
+    if (v5) {
+        std::vector<uint8_t> properties;
+        if (message.expiry_s) {
+            properties.push_back(0x02);
+            for (int shift = 24; shift >= 0; shift -= 8) properties.push_back((uint8_t)(message.expiry_s >> shift));
+        }
+        if (message.alias) {
+            properties.push_back(0x23);
+            put_u16(properties, message.alias);
+        }
+        if (message.unit) {
+            properties.push_back(0x26);
+            put_string(properties, "unit");
+            put_string(properties, message.unit);
+        }
+        put_varint(body, properties.size());
+        body.insert(body.end(), properties.begin(), properties.end());
+    }
+    body.insert(body.end(), message.payload.begin(), message.payload.end());
+
+    std::vector<uint8_t> packet;
+    packet.push_back(0x30 | (message.retain ? 1 : 0));   // PUBLISH, QoS 0
+    put_varint(packet, body.size());
+    packet.insert(packet.end(), body.begin(), body.end());
+    return packet;
+}
+
+struct Broker {
+    bool v5;
+    uint16_t alias_maximum;
+    std::map<uint16_t, std::string> aliases;
+    std::map<std::string, std::string> retained;
+    std::map<std::string, std::string> units;
+    size_t bytes = 0;
+
+    void receive(const std::vector<uint8_t> &packet)
+    {
+        bytes += packet.size();
+        size_t at = 1;
+        size_t remaining = 0;
+        for (size_t shift = 0;; shift += 7) {
+            remaining |= (size_t)(packet[at] & 0x7F) << shift;
+            if (!(packet[at++] & 0x80)) break;
+        }
+        assert((packet[0] & 0xF0) == 0x30 && at + remaining == packet.size());
+        auto u16 = [&] { at += 2; return (size_t)(packet[at - 2] << 8 | packet[at - 1]); };
+        auto string = [&] { const size_t n = u16(); at += n; return std::string((const char *)&packet[at - n], n); };
+
+        std::string topic = string();
+        std::string unit;
+        if (v5) {
+            size_t length = 0;
+            for (size_t shift = 0;; shift += 7) {
+                length |= (size_t)(packet[at] & 0x7F) << shift;
+                if (!(packet[at++] & 0x80)) break;
+            }
+            const size_t end = at + length;
+            uint16_t alias = 0;
+            while (at < end) {
+                const uint8_t id = packet[at++];
+                if (id == 0x02) at += 4;
+                else if (id == 0x23) alias = (uint16_t)u16();
+                else if (id == 0x26 && string() == "unit") unit = string();
+                else assert(false);
+            }
+            if (alias) {
+                assert(alias <= alias_maximum);
+                if (topic.empty()) topic = aliases.at(alias);
+                else aliases[alias] = topic;
+            }
+        }
+        assert(!topic.empty());
+        if (packet[0] & 1) retained[topic] = std::string((const char *)&packet[at], packet.size() - at);
+        if (!unit.empty()) units[topic] = unit;
+    }
+};
+
+struct StatusTopic {
+    const char *name;
+    const char *unit;
+    uint32_t change_every;   // cycles, 0 = never
+};
+
+static const StatusTopic STATUS[] = {
+    {"online", nullptr, 0}, {"serial", nullptr, 0}, {"firmware_version", nullptr, 0},
+    {"webui_version", nullptr, 0}, {"board_revision", nullptr, 0}, {"cpu_usage", "%", 2},
+    {"memory_usage", "%", 3}, {"uptime", "s", 1}, {"uptime_text", nullptr, 1},
+    {"free_heap", "B", 2}, {"min_free_heap", "B", 30}, {"ccu_queue_wait_max_ms", "ms", 10},
+    {"ccu_queue_depth_max", nullptr, 20}, {"ccu_delayed_frames", nullptr, 15},
+    {"ccu_dropped_frames", nullptr, 0}, {"nvs_used_entries", nullptr, 0},
+    {"nvs_free_entries", nullptr, 0}, {"nvs_usage", "%", 0}, {"last_reset_reason", nullptr, 0},
+    {"eth_connected", nullptr, 0}, {"eth_link_speed", "Mbit/s", 0}, {"eth_duplex", nullptr, 0},
+    {"ip_address", nullptr, 0}, {"netmask", nullptr, 0}, {"gateway", nullptr, 0},
+    {"dns1", nullptr, 0}, {"dns2", nullptr, 0}, {"ipv6_addresses", nullptr, 0},
+    {"radio_module_type", nullptr, 0}, {"radio_module_serial", nullptr, 0},
+    {"radio_module_firmware", nullptr, 0}, {"ntp_synced", nullptr, 0},
+    {"last_ntp_sync", nullptr, 60},
+};
+static constexpr uint16_t STATUS_COUNT = sizeof(STATUS) / sizeof(STATUS[0]);
+static constexpr uint16_t EVENT_TOPIC = STATUS_COUNT;
+
+struct Traffic {
+    size_t first_cycle = 0;
+    size_t steady = 0;   // every later cycle
+    uint32_t steady_cycles = 0;
+    Broker broker;
+};
+
+// One hour at the 60 s cadence behind a 15 minute refresh interval: the
+// first cycle publishes everything, the refresh cycles republish
+// everything, the others only the values that changed; an event every
+// 20 minutes.
+static Traffic run_hour(bool v5)
+{
+    Traffic traffic;
+    traffic.broker.v5 = v5;
+    traffic.broker.alias_maximum = 10;   // Mosquitto's default max_topic_alias
+    MqttTopicAliases aliases;
+    aliases.reset(v5 ? 10 : 0);
+    const std::string prefix = "hb-rf-eth/";
+
+    auto send = [&](uint16_t id, const std::string &subtopic, const std::string &payload,
+                    bool retain, uint32_t expiry_s, const char *unit) {
+        Publish message;
+        message.topic = prefix + subtopic;
+        message.payload = payload;
+        message.retain = retain;
+        if (v5) {
+            bool bind = false;
+            message.alias = aliases.assign(id, &bind);
+            if (message.alias && !bind) message.topic.clear();
+            message.expiry_s = expiry_s;
+            message.unit = unit;
+        }
+        const size_t before = traffic.broker.bytes;
+        traffic.broker.receive(encode(message, v5));
+        return traffic.broker.bytes - before;
+    };
+
+    for (uint32_t cycle = 0; cycle < 60; cycle++) {
+        size_t bytes = 0;
+        for (uint16_t id = 0; id < STATUS_COUNT; id++) {
+            const StatusTopic &topic = STATUS[id];
+            const bool changed = topic.change_every && cycle % topic.change_every == 0;
+            if (cycle % 15 != 0 && !changed) continue;
+            char payload[32];
+            snprintf(payload, sizeof(payload), "%u", topic.change_every ? cycle / topic.change_every * 7 + id : id);
+            bytes += send(id, std::string("status/") + topic.name, payload, true, 0, topic.unit);
+        }
+        if (cycle % 20 == 10) {
+            bytes += send(EVENT_TOPIC, "event/mqtt_reconnected", "{\"uptime\":1234}", false, 300, nullptr);
+        }
+        if (cycle == 0) {
+            traffic.first_cycle = bytes;
+        } else {
+            traffic.steady += bytes;
+            traffic.steady_cycles++;
+        }
+    }
+    return traffic;
+}
+
+static void benchmark()
+{
+    const Traffic v311 = run_hour(false);
+    const Traffic v5 = run_hour(true);
+    assert(v5.broker.retained == v311.broker.retained);
+    assert(v5.broker.units.at("hb-rf-eth/status/cpu_usage") == "%");
+    assert(v311.broker.units.empty());
+    assert(v5.steady * 10 < v311.steady * 8);
+    assert(v5.broker.bytes < v311.broker.bytes);
+    printf("MQTT bytes on the wire, 1 h at 60 s cycles: 3.1.1 first cycle %zu B, %.0f B/cycle after; "
+           "MQTT 5 (10 aliases, units, event expiry) first cycle %zu B, %.0f B/cycle after (%.0f %%)\n",
+           v311.first_cycle, (double)v311.steady / v311.steady_cycles, v5.first_cycle,
+           (double)v5.steady / v5.steady_cycles, 100.0 * (double)v5.steady / (double)v311.steady);
+}
+
+int main()
+{
+    test_bind_then_reuse();
+    test_cold_topics_keep_their_topic();
+    test_limits();
+    test_reset_on_reconnect();
+    benchmark();
+    printf("mqtt topic alias tests passed\n");
+    return 0;
+}
@@ -0,0 +1,127 @@
+#include "mqtt_topic_table.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// The status subtopics mqtt_handler.cpp publishes every cycle.
+static const char *const SUBTOPICS[] = {
+    "status/online", "status/serial", "status/firmware_version", "status/webui_version",
+    "status/board_revision", "status/cpu_usage", "status/memory_usage", "status/uptime",
+    "status/uptime_text", "status/free_heap", "status/min_free_heap",
+    "status/ccu_queue_wait_max_ms", "status/ccu_queue_depth_max", "status/ccu_delayed_frames",
+    "status/ccu_dropped_frames", "status/nvs_used_entries", "status/nvs_free_entries",
+    "status/nvs_usage", "status/last_reset_reason", "status/eth_connected",
+    "status/eth_link_speed", "status/eth_duplex", "status/ip_address", "status/netmask",
+    "status/gateway", "status/dns1", "status/dns2", "status/ipv6_addresses",
+    "status/radio_module_type", "status/radio_module_serial", "status/radio_module_firmware",
+    "status/ntp_synced", "status/last_ntp_sync", "status/task_stacks",
+};
+static constexpr size_t COUNT = sizeof(SUBTOPICS) / sizeof(SUBTOPICS[0]);
+
+static void test_build_and_lookup()
+{
+    MqttTopicTable table;
+    assert(table.count() == 0 && table.bytes() == 0);
+    assert(strcmp(table.topic(0), "") == 0 && table.length(0) == 0);
+
+    assert(table.build("hb-rf-eth-ng", SUBTOPICS, COUNT));
+    assert(table.count() == COUNT);
+    size_t bytes = 0;
+    for (size_t i = 0; i < COUNT; i++) {
+        const std::string expected = std::string("hb-rf-eth-ng/") + SUBTOPICS[i];
+        assert(table.topic(i) == expected);
+        assert(table.length(i) == expected.size());
+        bytes += expected.size() + 1;
+    }
+    assert(table.bytes() == bytes);
+    assert(strcmp(table.topic(COUNT), "") == 0 && table.length(COUNT) == 0);
+
+    // A rebuild (new prefix after a config change) replaces every topic.
+    const char *const other[] = {"state", "command/"};
+    assert(table.build("home/gw", other, 2));
+    assert(table.count() == 2);
+    assert(strcmp(table.topic(0), "home/gw/state") == 0);
+    assert(strcmp(table.topic(1), "home/gw/command/") == 0 && table.length(1) == 16);
+    assert(strcmp(table.topic(2), "") == 0);
+
+    // The longest configurable prefix (64 characters).
+    const std::string prefix(64, 'p');
+    assert(table.build(prefix.c_str(), SUBTOPICS, COUNT));
+    assert(table.topic(COUNT - 1) == prefix + "/status/task_stacks");
+    assert(table.build("", other, 1) && strcmp(table.topic(0), "/state") == 0);
+}
+
+static void test_rejects()
+{
+    MqttTopicTable table;
+    const char *many[MqttTopicTable::MAX_TOPICS + 1];
+    for (const char *&subtopic : many) subtopic = "x";
+    assert(table.build("p", many, MqttTopicTable::MAX_TOPICS));
+    assert(!table.build("p", many, MqttTopicTable::MAX_TOPICS + 1));
+    assert(table.count() == 0 && strcmp(table.topic(0), "") == 0);
+
+    const char *const with_null[] = {"a", nullptr};
+    assert(!table.build("p", with_null, 2) && table.count() == 0);
+    assert(!table.build(nullptr, SUBTOPICS, COUNT));
+}
+
+// What esp_mqtt_client_publish() does with the topic: measure it and copy
+// it into the outgoing PUBLISH packet together with the payload.
+static char packet[512];
+static size_t publish(const char *topic, const char *payload)
+{
+    const size_t topic_len = strlen(topic);
+    const size_t payload_len = strlen(payload);
+    memcpy(packet + 2, topic, topic_len);
+    memcpy(packet + 2 + topic_len, payload, payload_len);
+    return topic_len + payload_len;
+}
+
+// Topic preparation per status cycle: snprintf of every topic on the
+// publisher stack against a lookup in the interned table, both followed
+// by the publish itself.
+static void benchmark()
+{
+    constexpr int cycles = 200000;
+    const char *prefix = "hb-rf-eth-ng";
+    MqttTopicTable table;
+    assert(table.build(prefix, SUBTOPICS, COUNT));
+
+    volatile size_t sink = 0;
+    using clock = std::chrono::steady_clock;
+
+    auto start = clock::now();
+    for (int c = 0; c < cycles; c++) {
+        for (size_t i = 0; i < COUNT; i++) {
+            char topic[160];
+            snprintf(topic, sizeof(topic), "%s/%s", prefix, SUBTOPICS[i]);
+            sink = sink + publish(topic, "12.5");
+        }
+    }
+    const double formatted = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+    start = clock::now();
+    for (int c = 0; c < cycles; c++) {
+        for (size_t i = 0; i < COUNT; i++) {
+            sink = sink + publish(table.topic(i), "12.5");
+        }
+    }
+    const double interned = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+
+    printf("mqtt topics: %zu topics per cycle, %zu-byte table; snprintf + publish %.0f ns/cycle, "
+           "table lookup + publish %.0f ns/cycle\n",
+           COUNT, table.bytes(), formatted / cycles, interned / cycles);
+}
+
+int main()
+{
+    test_build_and_lookup();
+    test_rejects();
+    benchmark();
+    printf("mqtt topic table tests passed\n");
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include "mqtt_value_cache.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+static bool wants(const MqttValueCache &cache, uint8_t id, const char *payload, uint32_t now)
+{
+    return cache.wants(id, payload, strlen(payload), now);
+}
+
+static void publish(MqttValueCache &cache, uint8_t id, const char *payload, uint32_t now,
+                    double value = 0)
+{
+    cache.published(id, payload, strlen(payload), now, value);
+}
+
+static void test_only_changes_are_published()
+{
+    MqttValueCache cache;
+    cache.setRefreshInterval(900);
+    assert(wants(cache, 1, "HB-RF-ETH", 0));   // never published
+    publish(cache, 1, "HB-RF-ETH", 0);
+    assert(!wants(cache, 1, "HB-RF-ETH", 60));
+    assert(wants(cache, 1, "HB-RF-ETH 2", 60));
+    assert(wants(cache, 2, "HB-RF-ETH", 60));   // ids are independent
+
+    // Unchanged values are refreshed once the interval has passed.
+    assert(!wants(cache, 1, "HB-RF-ETH", 899));
+    assert(wants(cache, 1, "HB-RF-ETH", 900));
+    publish(cache, 1, "HB-RF-ETH", 900);
+    assert(!wants(cache, 1, "HB-RF-ETH", 960));
+
+    // A reconnect publishes everything again.
+    cache.invalidate();
+    assert(wants(cache, 1, "HB-RF-ETH", 961));
+
+    // Interval 0 disables the cache.
+    publish(cache, 1, "HB-RF-ETH", 961);
+    cache.setRefreshInterval(0);
+    assert(wants(cache, 1, "HB-RF-ETH", 961));
+
+    // Ids beyond the table are always published.
+    assert(wants(cache, MqttValueCache::SLOTS, "x", 0));
+}
+
+static void test_deadband()
+{
+    MqttValueCache cache;
+    cache.setRefreshInterval(900);
+    char text[16];
+    auto wants_heap = [&](double value, uint32_t now) {
+        snprintf(text, sizeof(text), "%.0f", value);
+        return cache.wantsNumber(3, value, 4096, text, strlen(text), now);
+    };
+    assert(wants_heap(100000, 0));
+    publish(cache, 3, "100000", 0, 100000);
+    assert(!wants_heap(100000, 60));
+    assert(!wants_heap(97000, 60));    // within 4 KiB
+    assert(!wants_heap(103500, 120));
+    assert(wants_heap(95000, 180));    // drifted past the deadband
+    assert(wants_heap(100001, 900));   // refresh interval
+
+    // Without a deadband every change of the rendered text counts.
+    publish(cache, 4, "12.5", 0, 12.5);
+    assert(!cache.wantsNumber(4, 12.51, 0, "12.5", 4, 60));
+    assert(cache.wantsNumber(4, 12.6, 0, "12.6", 4, 60));
+}
+
+// One status cycle of the firmware (the ~34 status topics of
+// mqtt_handler_publish_status) over a simulated day: identity and network
+// values are constant, uptime ticks every cycle, CPU and heap jitter.
+static void benchmark()
+{
+    constexpr int cycles = 24 * 60;
+    constexpr int constant_topics = 27;
+    MqttValueCache cache;
+    cache.setRefreshInterval(15 * 60);
+    uint32_t published = 0, avoided = 0, seed = 11;
+    char text[32];
+    auto offer = [&](uint8_t id, const char *payload, uint32_t now, bool numeric, double value,
+                     double deadband) {
+        const size_t len = strlen(payload);
+        const bool wanted = numeric ? cache.wantsNumber(id, value, deadband, payload, len, now)
+                                    : cache.wants(id, payload, len, now);
+        if (!wanted) {
+            avoided++;
+            return;
+        }
+        cache.published(id, payload, len, now, value);
+        published++;
+    };
+    for (int cycle = 0; cycle < cycles; cycle++) {
+        const uint32_t now = (uint32_t)cycle * 60;
+        for (uint8_t id = 0; id < constant_topics; id++) {
+            snprintf(text, sizeof(text), "value-%u", id);
+            offer(id, text, now, false, 0, 0);
+        }
+        seed = seed * 1103515245u + 12345u;
+        const double cpu = 8.0 + (seed >> 16) % 40 / 10.0;
+        snprintf(text, sizeof(text), "%.1f", cpu);
+        offer(27, text, now, true, cpu, 2.0);
+        const double heap = 120000 - (seed >> 8) % 6000;
+        snprintf(text, sizeof(text), "%.0f", heap);
+        offer(28, text, now, true, heap, 4096);
+        snprintf(text, sizeof(text), "%u", now);
+        offer(29, text, now, true, now, 0);   // uptime
+        snprintf(text, sizeof(text), "0 d, %u h, %u m", now / 3600, now / 60 % 60);
+        offer(30, text, now, false, 0, 0);    // uptime_text
+        for (uint8_t id = 31; id < 34; id++) {
+            offer(id, "0", now, true, 0, 0);  // CCU latency counters
+        }
+    }
+    const uint32_t total = published + avoided;
+    assert(total == cycles * 34u);
+    assert(published * 5 < total);
+    printf("mqtt status cache: %d cycles, %u of %u publishes (%.1f per cycle instead of 34), "
+           "%u avoided\n",
+           cycles, published, total, (double)published / cycles, avoided);
+}
+
+int main()
+{
+    test_only_changes_are_published();
+    test_deadband();
+    benchmark();
+    printf("mqtt value cache tests passed\n");
+    return 0;
+}
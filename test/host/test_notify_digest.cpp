@@ -0,0 +1,149 @@
+#include "notify_digest.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static constexpr int64_t SECOND = 1000000;
+
+static void test_repeats_fold_into_one_entry()
+{
+    NotifyDigest digest;
+    assert(digest.empty() && !digest.due(0));
+    digest.add(0, 1 * SECOND, "link down", 1 * SECOND, 60 * SECOND);
+    digest.add(1, 2 * SECOND, "link up", 2 * SECOND, 60 * SECOND);
+    digest.add(0, 3 * SECOND, "link down again", 3 * SECOND, 60 * SECOND);
+    assert(digest.size() == 2 && digest.events() == 3 && digest.unlisted() == 0);
+    assert(digest.contains(0) && digest.contains(1) && !digest.contains(2));
+
+    const NotifyDigest::Entry &down = digest.entry(0);
+    assert(down.id == 0 && down.count == 2);
+    assert(down.first_us == 1 * SECOND && down.last_us == 3 * SECOND);
+    assert(std::strcmp(down.detail, "link down again") == 0);
+    assert(digest.entry(1).count == 1);
+
+    digest.clear();
+    assert(digest.empty() && digest.size() == 0 && digest.events() == 0);
+}
+
+// The window opens with the first event and does not move with later ones.
+static void test_window()
+{
+    NotifyDigest digest;
+    digest.add(3, 10 * SECOND, nullptr, 10 * SECOND, 30 * SECOND);
+    assert(digest.deadline() == 40 * SECOND);
+    digest.add(3, 39 * SECOND, nullptr, 39 * SECOND, 30 * SECOND);
+    assert(!digest.due(39 * SECOND) && digest.due(40 * SECOND));
+    assert(digest.entry(0).detail[0] == '\0');
+}
+
+static void test_limits()
+{
+    NotifyDigest digest;
+    for (uint8_t id = 0; id < NotifyDigest::SLOTS + 3; id++) {
+        digest.add(id, 0, "x", 0, SECOND);
+    }
+    assert(digest.size() == NotifyDigest::SLOTS);
+    assert(digest.unlisted() == 3 && digest.events() == NotifyDigest::SLOTS + 3);
+
+    const std::string long_detail(300, 'd');
+    digest.clear();
+    for (int i = 0; i < 70000; i++) digest.add(5, i, long_detail.c_str(), 0, SECOND);
+    assert(digest.entry(0).count == UINT16_MAX && digest.events() == 70000);
+    assert(std::strlen(digest.entry(0).detail) == NotifyDigest::DETAIL_MAX - 1);
+}
+
+static void test_keep_alive()
+{
+    NotifyKeepAlive keep(10 * SECOND);
+    const uint32_t hook = NotifyKeepAlive::key("https://example.org/hook", "secret");
+    assert(hook == NotifyKeepAlive::key("https://example.org/hook", "secret"));
+    assert(hook != NotifyKeepAlive::key("https://example.org/hook", "other"));
+    assert(hook != NotifyKeepAlive::key("https://example.org/hooks", "ecret"));
+    assert(NotifyKeepAlive::key("https://example.org/", nullptr) ==
+           NotifyKeepAlive::key("https://example.org/", ""));
+
+    assert(!keep.open() && !keep.reusable(0, hook) && !keep.expired(100 * SECOND));
+    keep.used(5 * SECOND, hook);
+    assert(keep.reusable(15 * SECOND, hook));
+    assert(!keep.reusable(6 * SECOND, hook + 1));   // endpoint changed
+    assert(!keep.expired(15 * SECOND) && keep.expired(15 * SECOND + 1));
+    assert(!keep.reusable(15 * SECOND + 1, hook));
+    keep.reset();
+    assert(!keep.open() && !keep.reusable(6 * SECOND, hook));
+}
+
+// A flapping Ethernet link with the cooldown off: a down/up pair every 5 s
+// for two minutes, delivered to webhook and Telegram. Counts the TLS
+// handshakes of one connection per notification (the previous behaviour)
+// against connection reuse alone and against 60 s digests with reuse.
+struct FlapResult {
+    uint32_t notifications = 0;
+    uint32_t handshakes = 0;
+};
+
+static FlapResult flap(int64_t digest_window_us, bool reuse)
+{
+    constexpr int channels = 2;
+    constexpr int64_t duration_us = 120 * SECOND;
+    constexpr int64_t flap_us = 5 * SECOND;
+
+    FlapResult result;
+    NotifyDigest digest;
+    NotifyKeepAlive keep[channels] = {NotifyKeepAlive(10 * SECOND), NotifyKeepAlive(10 * SECOND)};
+    const uint32_t key[channels] = {NotifyKeepAlive::key("https://hooks.example.org/a", "s"),
+                                    NotifyKeepAlive::key("https://api.telegram.org/botX/sendMessage", "")};
+
+    auto deliver = [&](int64_t now) {
+        result.notifications++;
+        for (int c = 0; c < channels; c++) {
+            if (!reuse || !keep[c].reusable(now, key[c])) result.handshakes++;
+            if (reuse) keep[c].used(now, key[c]);
+        }
+    };
+
+    for (int64_t now = 0; now < duration_us + digest_window_us; now += SECOND / 2) {
+        if (now < duration_us && now % flap_us == 0) {
+            const uint8_t id = (now / flap_us) % 2 ? 1 : 0;
+            if (digest_window_us > 0) digest.add(id, now, "eth0", now, digest_window_us);
+            else deliver(now);
+        }
+        if (digest.due(now)) {
+            deliver(now);
+            digest.clear();
+        }
+        for (NotifyKeepAlive &k : keep) {
+            if (k.expired(now)) k.reset();
+        }
+    }
+    return result;
+}
+
+static void benchmark()
+{
+    constexpr uint32_t events = 24;
+    const FlapResult single = flap(0, false);
+    const FlapResult reused = flap(0, true);
+    const FlapResult digests = flap(60 * SECOND, true);
+    assert(single.notifications == events && single.handshakes == events * 2);
+    assert(reused.handshakes == 2);
+    assert(digests.notifications == 2 && digests.handshakes == 4);
+    printf("notify flapping link (24 events, 2 channels): per event %.2f handshakes/event, "
+           "reused connection %.2f handshakes/event, 60 s digest %u notifications, "
+           "%.2f handshakes/event\n",
+           single.handshakes / (double)events, reused.handshakes / (double)events,
+           digests.notifications, digests.handshakes / (double)events);
+}
+
+int main()
+{
+    test_repeats_fold_into_one_entry();
+    test_window();
+    test_limits();
+    test_keep_alive();
+    benchmark();
+    printf("notify digest tests passed\n");
+    return 0;
+}
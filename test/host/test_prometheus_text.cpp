@@ -0,0 +1,93 @@
+#include "prometheus_text.h"
+
+#include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+// Five families of two lines each, the shape of the firmware's renderers.
+static size_t render(char *out, size_t cap, size_t offset, size_t *resume)
+{
+    PrometheusText text(out, cap, offset, resume);
+    for (int family = 0; family < 5; family++) {
+        text.emit("# TYPE family_%d gauge\n", family);
+        text.emit("family_%d %d\n", family, family * 100);
+        text.endPart();
+    }
+    return text.finish();
+}
+
+static std::string whole()
+{
+    char out[512];
+    const size_t len = render(out, sizeof(out), 0, nullptr);
+    assert(strlen(out) == len);
+    return std::string(out, len);
+}
+
+// Sent the way the exporter does: flush whenever the renderer stops early.
+static std::string chunked(size_t cap, size_t offset, size_t *chunks)
+{
+    char out[512];
+    std::string sent;
+    memset(out, 'x', offset);
+    size_t len = offset;
+    size_t resume = 0;
+    *chunks = 0;
+    do {
+        len = render(out, cap, len, &resume);
+        assert(strlen(out) == len && len < cap);
+        if (resume != 0) {
+            sent.append(out, len);
+            (*chunks)++;
+            len = 0;
+        }
+    } while (resume != 0);
+    sent.append(out, len);
+    (*chunks)++;
+    return sent.substr(offset);
+}
+
+static void test_whole_parts_per_chunk()
+{
+    const std::string expected = whole();
+    size_t chunks = 0;
+    assert(chunked(512, 0, &chunks) == expected && chunks == 1);
+    // Families are 33-35 bytes: two per 80-byte chunk, never one cut in half.
+    assert(chunked(80, 0, &chunks) == expected && chunks == 3);
+    // Text already in the buffer is sent before the first family that does
+    // not fit next to it.
+    assert(chunked(80, 60, &chunks) == expected && chunks == 4);
+}
+
+// A family larger than the whole buffer is cut, not retried forever.
+static void test_oversized_part()
+{
+    char out[16];
+    size_t resume = 0;
+    const size_t len = render(out, sizeof(out), 0, &resume);
+    assert(len == sizeof(out) - 1 && strlen(out) == len);
+    assert(resume == 2);   // the next call starts with the second family
+
+    resume = 0;
+    assert(render(out, 0, 0, &resume) == 0 && resume == 0);
+    assert(render(nullptr, 16, 3, &resume) == 3 && resume == 0);
+}
+
+// Without resume the text is cut at cap like before.
+static void test_truncating()
+{
+    char out[50];
+    const size_t len = render(out, sizeof(out), 0, nullptr);
+    assert(len == sizeof(out) - 1);
+    assert(whole().compare(0, len, out) == 0);
+}
+
+int main()
+{
+    test_whole_parts_per_chunk();
+    test_oversized_part();
+    test_truncating();
+    printf("prometheus text tests passed\n");
+    return 0;
+}
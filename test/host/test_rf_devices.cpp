@@ -0,0 +1,140 @@
+#include "rf_devices.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+
+static void test_counts_and_recency()
+{
+    RfDeviceTable table;
+    table.record(0x123456, 10, true, -70);
+    table.record(0xabcdef, 11, false, 0);
+    table.record(0x123456, 12, false, 0);   // keeps the last measured RSSI
+    assert(table.size() == 2 && table.evictions() == 0);
+
+    RfDeviceTable::Device devices[RfDeviceTable::CAPACITY];
+    assert(table.snapshot(devices, RfDeviceTable::CAPACITY) == 2);
+    assert(devices[0].address == 0x123456 && devices[0].frames == 2);
+    assert(devices[0].last_seen_s == 12 && devices[0].has_rssi && devices[0].rssi == -70);
+    assert(devices[1].address == 0xabcdef && devices[1].frames == 1 && !devices[1].has_rssi);
+    assert(table.snapshot(devices, 1) == 1);
+
+    table.record(0x01123456, 13, false, 0);   // only 24 bits are an address
+    assert(table.size() == 2);
+    table.clear();
+    assert(table.size() == 0 && table.snapshot(devices, RfDeviceTable::CAPACITY) == 0);
+}
+
+static void test_evicts_least_recently_heard()
+{
+    RfDeviceTable table;
+    for (uint32_t i = 0; i < RfDeviceTable::CAPACITY; i++) table.record(0x100000 + i, i, false, 0);
+    table.record(0x100000, 100, false, 0);   // the oldest is heard again
+    table.record(0x200000, 101, false, 0);   // evicts 0x100001
+    assert(table.size() == RfDeviceTable::CAPACITY && table.evictions() == 1);
+
+    RfDeviceTable::Device devices[RfDeviceTable::CAPACITY];
+    const size_t n = table.snapshot(devices, RfDeviceTable::CAPACITY);
+    assert(n == RfDeviceTable::CAPACITY);
+    assert(devices[0].address == 0x200000 && devices[1].address == 0x100000);
+    assert(devices[1].frames == 2);
+    for (size_t i = 0; i < n; i++) assert(devices[i].address != 0x100001);
+
+    // The evicted device starts over, and the chains stay consistent.
+    for (uint32_t round = 0; round < 3; round++) {
+        for (uint32_t i = 0; i < 200; i++) table.record(0x300000 + i * 7, 200 + i, false, 0);
+    }
+    assert(table.size() == RfDeviceTable::CAPACITY);
+    table.record(0x100001, 1000, false, 0);
+    table.snapshot(devices, RfDeviceTable::CAPACITY);
+    assert(devices[0].address == 0x100001 && devices[0].frames == 1);
+}
+
+static void test_sender()
+{
+    unsigned char bidcos[] = {0x01, 0x00, 0x41, 0x2a, 0xa2, 0x10, 0x3b, 0x4c, 0x5d, 0x11, 0x22, 0x33};
+    HMFrame frame;
+    frame.destination = HM_DST_TRX;
+    frame.command = 0x05;
+    frame.data = bidcos;
+    frame.data_len = sizeof(bidcos);
+    uint32_t address = 0;
+    bool has_rssi = false;
+    int8_t rssi = 0;
+    assert(RfDeviceTable::sender(frame, &address, &has_rssi, &rssi));
+    assert(address == 0x3b4c5d && has_rssi && rssi == -65);
+
+    unsigned char hmip[] = {0x01, 0x00, 0x00, 0x90, 0x07, 0x0a, 0x0b, 0x0c, 0x01, 0x02};
+    frame.destination = HM_DST_HMIP;
+    frame.data = hmip;
+    frame.data_len = sizeof(hmip);
+    assert(RfDeviceTable::sender(frame, &address, &has_rssi, &rssi));
+    assert(address == 0x0a0b0c && !has_rssi);
+
+    frame.data_len = 7;   // too short for the address
+    assert(!RfDeviceTable::sender(frame, &address, &has_rssi, &rssi));
+    frame.data_len = sizeof(hmip);
+    frame.command = HM_CMD_HMIP_ACK;
+    assert(!RfDeviceTable::sender(frame, &address, &has_rssi, &rssi));
+}
+
+// 300 devices, one of them a flooding battery sensor sending a third of all
+// frames. The table must find it while only holding CAPACITY devices, at a
+// per-frame cost that does not depend on how many devices were heard.
+static void benchmark()
+{
+    constexpr uint32_t frames = 2000000;
+    constexpr uint32_t devices = 300;
+    constexpr uint32_t flooder = 0x2c1a07;
+    RfDeviceTable table;
+    std::map<uint32_t, uint32_t> reference;
+    uint32_t seed = 11;
+    uint32_t flooder_frames = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const uint32_t address = (seed >> 16) % 3 == 0 ? flooder : 0x100000 + ((seed >> 8) % devices) * 13;
+        if (address == flooder) flooder_frames++;
+        table.record(address, i / 20, true, -60);
+    }
+    auto end = std::chrono::steady_clock::now();
+
+    // Same stream into an ordered map, the obvious unbounded alternative.
+    seed = 11;
+    auto map_start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frames; i++) {
+        seed = seed * 1103515245u + 12345u;
+        const uint32_t address = (seed >> 16) % 3 == 0 ? flooder : 0x100000 + ((seed >> 8) % devices) * 13;
+        reference[address]++;
+    }
+    auto map_end = std::chrono::steady_clock::now();
+
+    RfDeviceTable::Device snapshot[RfDeviceTable::CAPACITY];
+    const size_t n = table.snapshot(snapshot, RfDeviceTable::CAPACITY);
+    uint32_t top = 0;
+    for (size_t i = 0; i < n; i++) {
+        if (snapshot[i].frames > snapshot[top].frames) top = (uint32_t)i;
+    }
+    assert(snapshot[top].address == flooder && snapshot[top].frames == flooder_frames);
+    assert(reference[flooder] == flooder_frames);
+    assert(table.evictions() > 0);
+
+    const double table_ns = std::chrono::duration<double, std::nano>(end - start).count() / frames;
+    const double map_ns = std::chrono::duration<double, std::nano>(map_end - map_start).count() / frames;
+    printf("rf devices (300 devices, 1 flooder, %u frames): table %zu bytes, %.1f ns/frame, "
+           "%u evictions; std::map %zu entries, %.1f ns/frame\n",
+           frames, sizeof(RfDeviceTable), table_ns, table.evictions(), reference.size(), map_ns);
+}
+
+int main()
+{
+    test_counts_and_recency();
+    test_evicts_least_recently_heard();
+    test_sender();
+    benchmark();
+    printf("rf devices tests passed\n");
+    return 0;
+}
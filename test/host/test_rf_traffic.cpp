@@ -0,0 +1,170 @@
+#include "rf_traffic.h"
+
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+
+static void test_rate_window()
+{
+    RfRateWindow window;
+    RfRateWindow::Totals totals = window.lastMinute(0);
+    assert(totals.frames == 0 && totals.bytes == 0 && totals.airtime_us == 0);
+
+    window.add(0, 1, 10, 100);
+    window.add(30, 2, 20, 200);
+    window.add(59, 1, 5, 0);
+    totals = window.lastMinute(59);
+    assert(totals.frames == 4 && totals.bytes == 35 && totals.airtime_us == 300);
+    totals = window.lastMinute(60);   // second 0 left the window
+    assert(totals.frames == 3 && totals.bytes == 25);
+    totals = window.lastMinute(90);
+    assert(totals.frames == 1 && totals.bytes == 5);
+
+    // The hour keeps minutes 0 .. 59 and loses them one by one.
+    assert(window.lastHour(90).frames == 4);
+    window.add(3599, 1, 1, 1);
+    assert(window.lastHour(3599).frames == 5);
+    assert(window.lastHour(3600).frames == 1);
+
+    // A bucket reused after an idle hour starts from zero.
+    window.add(7230, 1, 1, 1);
+    assert(window.lastMinute(7230).frames == 1 && window.lastHour(7230).frames == 1);
+    assert(window.lastMinute(100000).frames == 0 && window.lastHour(100000).frames == 0);
+}
+
+static uint16_t make_frame(uint8_t destination, uint8_t command, uint16_t data_len,
+                           unsigned char *out, uint16_t cap)
+{
+    unsigned char data[256];
+    for (uint16_t i = 0; i < data_len; i++) data[i] = (unsigned char)(0xf8 + i % 8);   // forces escapes
+    HMFrame frame;
+    frame.destination = destination;
+    frame.command = command;
+    frame.counter = 7;
+    frame.data = data;
+    frame.data_len = data_len;
+    return frame.encode(out, cap, true);
+}
+
+static void test_unescape_and_parse()
+{
+    unsigned char wire[300];
+    const uint16_t wire_len = make_frame(HM_DST_HMIP, 0x05, 40, wire, sizeof(wire));
+    assert(wire_len > 48);   // escapes added
+
+    unsigned char decoded[300];
+    const uint16_t len = HMFrame::unescape(wire, wire_len, decoded, sizeof(decoded));
+    assert(len == 48);
+    HMFrame frame;
+    assert(HMFrame::TryParse(decoded, len, &frame));
+    assert(frame.destination == HM_DST_HMIP && frame.command == 0x05 && frame.data_len == 40);
+    assert(HMFrame::unescape(wire, wire_len, decoded, 20) == 0);   // does not fit
+
+    HMFrame decoded_frame;
+    assert(HMFrame::TryDecode(wire, wire_len, decoded, sizeof(decoded), &decoded_frame));
+    assert(decoded_frame.command == 0x05 && decoded_frame.data == decoded + 6);
+    assert(!HMFrame::TryDecode(wire, wire_len, decoded, 20, &decoded_frame));
+    wire[wire_len - 1] ^= 0x01;   // CRC
+    assert(!HMFrame::TryDecode(wire, wire_len, decoded, sizeof(decoded), &decoded_frame));
+}
+
+static void test_kinds_and_airtime()
+{
+    RfTrafficStats stats;
+    HMFrame frame;
+    frame.destination = HM_DST_HMIP;
+    frame.command = 0x05;
+    frame.data_len = 14;
+    stats.record(frame, 30, 100);
+    stats.record(frame, 30, 101);
+    frame.command = HM_CMD_HMIP_ACK;
+    frame.data_len = 1;
+    stats.record(frame, 9, 101);
+    frame.destination = HM_DST_COMMON;
+    frame.command = HM_CMD_COMMON_IDENTIFY;
+    stats.record(frame, 9, 102);
+    stats.recordUnparsed(12, 102);
+
+    assert(stats.kindCount() == 3 && stats.unparsed() == 1);
+    const RfTrafficStats::Kind first = stats.kind(0);
+    assert(!first.overflow && first.destination == HM_DST_HMIP && first.command == 0x05);
+    assert(first.frames == 2 && first.bytes == 60);
+
+    // Only the two received telegrams take airtime: (14 + 11) bytes at 10 kbit/s.
+    assert(RfTrafficStats::airtimeUs(14) == 20000);
+    const RfRateWindow::Totals minute = stats.lastMinute(102);
+    assert(minute.frames == 5 && minute.bytes == 90 && minute.airtime_us == 40000);
+
+    // Pairs past the table share the overflow entry, listed last.
+    frame.destination = HM_DST_LLMAC;
+    for (uint32_t command = 0x10; command < 0x10 + RfTrafficStats::MAX_KINDS; command++) {
+        frame.command = (uint8_t)command;
+        stats.record(frame, 10, 103);
+    }
+    assert(stats.kindCount() == RfTrafficStats::MAX_KINDS + 1);
+    const RfTrafficStats::Kind overflow = stats.kind(RfTrafficStats::MAX_KINDS);
+    assert(overflow.overflow && overflow.frames == 3 && overflow.bytes == 30);
+}
+
+// A busy installation: 5 telegrams per second for two hours. The windows
+// against the obvious implementation, a list of every frame of the last
+// hour that is trimmed and summed on each query.
+static void benchmark()
+{
+    constexpr uint32_t seconds = 2 * 3600;
+    constexpr uint32_t per_second = 5;
+    struct Entry {
+        uint32_t at_s;
+        uint16_t bytes;
+        uint32_t airtime_us;
+    };
+
+    RfTrafficStats stats;
+    std::deque<Entry> naive;
+    size_t naive_peak = 0;
+    double stats_ns = 0, naive_ns = 0;
+    uint32_t checks = 0;
+    for (uint32_t now = 0; now < seconds; now++) {
+        HMFrame frame;
+        frame.destination = HM_DST_HMIP;
+        frame.command = (uint8_t)(now % 4);
+        frame.data_len = (uint16_t)(10 + now % 30);
+        const uint16_t wire_len = frame.data_len + 8;
+
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < per_second; i++) stats.record(frame, wire_len, now);
+        const RfRateWindow::Totals hour = stats.lastHour(now);
+        auto mid = std::chrono::steady_clock::now();
+        for (uint32_t i = 0; i < per_second; i++) {
+            naive.push_back({now, wire_len, RfTrafficStats::airtimeUs(frame.data_len)});
+        }
+        while (naive.front().at_s / 60 + 59 < now / 60) naive.pop_front();
+        uint32_t bytes = 0;
+        for (const Entry &entry : naive) bytes += entry.bytes;
+        auto end = std::chrono::steady_clock::now();
+
+        if (naive.size() > naive_peak) naive_peak = naive.size();
+        assert(bytes == hour.bytes && naive.size() == hour.frames);
+        checks++;
+        stats_ns += std::chrono::duration<double, std::nano>(mid - start).count();
+        naive_ns += std::chrono::duration<double, std::nano>(end - mid).count();
+    }
+    assert(checks == seconds);
+    assert(sizeof(RfTrafficStats) * 50 < naive_peak * sizeof(Entry));
+    printf("rf traffic (5 frames/s, 2 h, hourly total every second): buckets %zu bytes, "
+           "%.0f ns/s; frame list peak %zu bytes, %.0f ns/s\n",
+           sizeof(RfTrafficStats), stats_ns / seconds, naive_peak * sizeof(Entry), naive_ns / seconds);
+}
+
+int main()
+{
+    test_rate_window();
+    test_unescape_and_parse();
+    test_kinds_and_airtime();
+    benchmark();
+    printf("rf traffic tests passed\n");
+    return 0;
+}
@@ -0,0 +1,422 @@
+#include "syslog_batch.h"
+#include "log_entry.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+static void test_queue_order_and_wrap()
+{
+    alignas(4) static uint8_t storage[256];
+    SyslogQueue queue;
+    assert(!SyslogQueue::validCapacity(100) && SyslogQueue::validCapacity(256));
+    queue.attach(storage, sizeof(storage));
+    assert(queue.capacityBytes() == 256);
+
+    uint8_t out[64];
+    assert(queue.pop(out, sizeof(out)) == 0);
+
+    // Records of every length, many times around the ring.
+    for (int round = 0; round < 500; round++) {
+        uint8_t record[40];
+        const size_t len = 1 + (size_t)(round % 40);
+        for (size_t i = 0; i < len; i++) record[i] = (uint8_t)(round + i);
+        bool wake = false;
+        assert(queue.push(record, len, &wake));
+        assert(wake);   // queue was empty
+        assert(queue.pop(out, sizeof(out)) == len);
+        assert(memcmp(out, record, len) == 0);
+        assert(queue.usedBytes() == 0);
+    }
+    assert(queue.dropped() == 0);
+}
+
+static void test_queue_full_drops_exactly()
+{
+    alignas(4) static uint8_t storage[256];
+    SyslogQueue queue;
+    queue.attach(storage, sizeof(storage));
+
+    // 60 bytes = 16 words with the header: four fit in 64 words.
+    uint8_t record[60] = {};
+    int wakes = 0;
+    for (int i = 0; i < 6; i++) {
+        record[0] = (uint8_t)i;
+        bool wake = false;
+        assert(queue.push(record, sizeof(record), &wake) == (i < 4));
+        wakes += wake;
+    }
+    assert(wakes == 2);   // empty, then half full
+    assert(queue.dropped() == 2);
+
+    uint8_t out[64];
+    for (int i = 0; i < 4; i++) {
+        assert(queue.pop(out, sizeof(out)) == sizeof(record));
+        assert(out[0] == i);
+    }
+    assert(queue.pop(out, sizeof(out)) == 0);
+
+    // Larger than the caller's buffer: skipped and counted.
+    assert(queue.push(record, sizeof(record)));
+    assert(queue.push(record, 3));
+    assert(queue.pop(out, 8) == 3);
+    assert(queue.dropped() == 3);
+
+    assert(queue.push(record, 10));
+    queue.discard();
+    assert(queue.usedBytes() == 0 && queue.pop(out, sizeof(out)) == 0);
+    assert(!queue.push(record, 0));
+
+    // A record in two parts reads back as one.
+    const uint8_t prefix[3] = {2, 1, 'x'};
+    assert(queue.push(prefix, sizeof(prefix), reinterpret_cast<const uint8_t *>("hello"), 5));
+    assert(queue.pop(out, sizeof(out)) == 8);
+    assert(memcmp(out, "\x02\x01xhello", 8) == 0);
+    assert(!queue.push(prefix, 0, record, 0));
+}
+
+// Several producers against one consumer: every record arrives intact and
+// exactly once, or is counted as dropped.
+static void test_queue_concurrent()
+{
+    alignas(4) static uint8_t storage[4096];
+    SyslogQueue queue;
+    queue.attach(storage, sizeof(storage));
+    constexpr int producers = 4;
+    constexpr int per_producer = 200000;
+    std::atomic<int> done{0};
+    std::atomic<uint32_t> pushed{0};
+    std::vector<std::thread> threads;
+    for (int t = 0; t < producers; t++) {
+        threads.emplace_back([&, t] {
+            uint8_t record[64];
+            for (int i = 0; i < per_producer; i++) {
+                const size_t len = 8 + (size_t)(i % 56);
+                record[0] = (uint8_t)t;
+                memcpy(record + 1, &i, sizeof(i));
+                uint8_t sum = 0;
+                for (size_t b = 5; b < len - 1; b++) sum += record[b] = (uint8_t)(i * b);
+                record[len - 1] = sum;
+                if (queue.push(record, len)) pushed.fetch_add(1, std::memory_order_relaxed);
+            }
+            done.fetch_add(1);
+        });
+    }
+
+    int last[producers];
+    for (int &l : last) l = -1;
+    uint32_t popped = 0;
+    uint8_t out[64];
+    for (;;) {
+        const bool finished = done.load() == producers;
+        const size_t len = queue.pop(out, sizeof(out));
+        if (len == 0) {
+            if (finished && queue.usedBytes() == 0) break;
+            continue;
+        }
+        int i;
+        memcpy(&i, out + 1, sizeof(i));
+        assert(out[0] < producers && i > last[out[0]]);   // per-producer order
+        last[out[0]] = i;
+        assert(len == 8 + (size_t)(i % 56));
+        uint8_t sum = 0;
+        for (size_t b = 5; b < len - 1; b++) sum += out[b];
+        assert(out[len - 1] == sum);
+        popped++;
+    }
+    for (std::thread &thread : threads) thread.join();
+    assert(popped == pushed.load());
+    assert(pushed.load() + queue.dropped() == (uint32_t)(producers * per_producer));
+}
+
+// What the worker takes from an entry instead of parsing the rendered line.
+struct Line {
+    int severity = 6;
+    char level = 0;
+    char tag[32] = "fw";
+    char message[LOG_LINE_MAX] = {};
+    size_t message_len = 0;
+};
+
+static Line fields_of(const uint8_t *entry, size_t len)
+{
+    Line line;
+    line.message_len = log_entry_message(entry, len, line.message, sizeof(line.message));
+    line.level = log_entry_level(entry, len);
+    if (line.level) line.severity = syslog_severity_from_level(line.level);
+    if (log_entry_tag(entry, len, line.tag, sizeof(line.tag)) == 0) strcpy(line.tag, "fw");
+    return line;
+}
+
+static size_t text_entry(uint8_t *entry, const char *text)
+{
+    return log_entry_encode_text(entry, LOG_ENTRY_MAX, 1234, text, strlen(text));
+}
+
+static void test_entry_fields_and_frame()
+{
+    uint8_t entry[LOG_ENTRY_MAX];
+    size_t len = text_entry(entry, "\033[0;33mW (1234) mqtt: broker gone\033[0m\n");
+    Line line = fields_of(entry, len);
+    assert(line.severity == 4 && strcmp(line.tag, "mqtt") == 0);
+    assert(std::string(line.message, line.message_len) == "broker gone");
+    line = fields_of(entry, text_entry(entry, "garbage\n"));
+    assert(line.severity == 6 && strcmp(line.tag, "fw") == 0 &&
+           std::string(line.message) == "garbage");
+
+    char frame[SYSLOG_FRAME_MAX];
+    const char msg[] = "broker gone";
+    size_t n = syslog_format_frame(frame, sizeof(frame), 4, "mqtt", msg, strlen(msg), "hb",
+                                   "2026-01-02T03:04:05Z", false);
+    assert(std::string(frame, n) == "<12>1 2026-01-02T03:04:05Z hb fw mqtt - - broker gone\n");
+
+    n = syslog_format_frame(frame, sizeof(frame), 4, "mqtt", msg, strlen(msg), "hb", "-", true);
+    const std::string counted(frame, n);
+    const std::string body = "<12>1 - hb fw mqtt - - broker gone";
+    assert(counted == std::to_string(body.size()) + " " + body);
+
+    // The longest message still fits a frame, and its prefix matches.
+    std::string big(2000, 'x');
+    n = syslog_format_frame(frame, sizeof(frame), 7, "t", big.data(), big.size(),
+                            std::string(63, 'h').c_str(), "2026-01-02T03:04:05Z", true);
+    assert(n > SYSLOG_MSG_MAX && n <= SYSLOG_FRAME_MAX);
+    assert((size_t)atoi(frame) == n - (size_t)(strchr(frame, ' ') + 1 - frame));
+}
+
+static void test_structured_formats()
+{
+    SyslogFields fields = {};
+    fields.severity = 4;
+    fields.level = 'W';
+    fields.tag = "mqtt";
+    fields.task = "mqtt_task";
+    fields.core = 1;
+    fields.uptime_ms = 1234;
+    fields.epoch_ms = 1767323045678ull;
+
+    char frame[SYSLOG_FRAME_MAX];
+    const char msg[] = "broker \"gone\"\tagain";
+    size_t n = syslog_format_structured(frame, sizeof(frame), SYSLOG_FORMAT_GELF, fields, msg,
+                                        strlen(msg), "hb", false);
+    const std::string gelf =
+        "{\"version\":\"1.1\",\"host\":\"hb\",\"timestamp\":1767323045.678,\"level\":4,"
+        "\"_level\":\"W\",\"_tag\":\"mqtt\",\"_task\":\"mqtt_task\",\"_core\":1,"
+        "\"_uptime_ms\":1234,\"short_message\":\"broker \\\"gone\\\"\\tagain\"}";
+    assert(std::string(frame, n) == gelf);
+    // GELF over TCP: NUL-terminated frames.
+    n = syslog_format_structured(frame, sizeof(frame), SYSLOG_FORMAT_GELF, fields, msg,
+                                 strlen(msg), "hb", true);
+    assert(std::string(frame, n) == gelf + std::string(1, '\0'));
+
+    fields.epoch_ms = 0;   // clock not set
+    fields.core = -1;
+    fields.task = "";
+    n = syslog_format_structured(frame, sizeof(frame), SYSLOG_FORMAT_JSON, fields, "up\n", 3,
+                                 "hb", false);
+    assert(std::string(frame, n) ==
+           "{\"ts\":null,\"uptime_ms\":1234,\"host\":\"hb\",\"severity\":4,\"level\":\"W\","
+           "\"tag\":\"mqtt\",\"task\":\"\",\"msg\":\"up\"}\n");
+
+    // Control bytes are escaped; a long message is cut between characters
+    // and the frame stays closed.
+    n = syslog_format_structured(frame, sizeof(frame), SYSLOG_FORMAT_JSON, fields,
+                                 "\033[0m", 4, "hb", false);
+    assert(std::string(frame, n).find("\"msg\":\"\\u001b[0m\"}\n") != std::string::npos);
+    std::string long_msg;
+    for (int i = 0; i < 300; i++) long_msg += "\xc3\xa4";   // "ä"
+    for (size_t cap = 150; cap <= sizeof(frame); cap += 7) {
+        n = syslog_format_structured(frame, cap, SYSLOG_FORMAT_GELF, fields, long_msg.data(),
+                                     long_msg.size(), "hb", true);
+        assert(n > 0 && n <= cap);
+        const std::string out(frame, n);
+        assert(out.compare(out.size() - 3, 3, std::string("\"}") + '\0') == 0);
+        const size_t start = out.find("\"short_message\":\"") + 17;
+        assert((out.size() - 3 - start) % 2 == 0);   // whole characters only
+    }
+    assert(syslog_format_structured(frame, 20, SYSLOG_FORMAT_GELF, fields, "x", 1, "hb",
+                                    false) == 0);
+}
+
+// Local syslog sink: accepts one connection and parses RFC 6587 octet-counted
+// frames until the peer closes.
+struct Sink {
+    int listener = -1;
+    uint16_t port = 0;
+    std::thread thread;
+    std::atomic<uint32_t> frames{0};
+    bool framing_ok = true;
+
+    void start()
+    {
+        listener = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        assert(bind(listener, (sockaddr *)&addr, sizeof(addr)) == 0);
+        socklen_t addr_len = sizeof(addr);
+        assert(getsockname(listener, (sockaddr *)&addr, &addr_len) == 0);
+        port = ntohs(addr.sin_port);
+        assert(listen(listener, 1) == 0);
+        thread = std::thread([this] { serve(); });
+    }
+
+    void serve()
+    {
+        const int fd = accept(listener, nullptr, nullptr);
+        std::string pending;
+        char buf[65536];
+        ssize_t n;
+        while ((n = recv(fd, buf, sizeof(buf), 0)) > 0) {
+            pending.append(buf, (size_t)n);
+            size_t at = 0;
+            for (;;) {
+                const size_t space = pending.find(' ', at);
+                if (space == std::string::npos) break;
+                const size_t len = strtoul(pending.c_str() + at, nullptr, 10);
+                if (pending.size() < space + 1 + len) break;
+                framing_ok = framing_ok && len > 0 && pending[space + 1] == '<';
+                frames.fetch_add(1, std::memory_order_relaxed);
+                at = space + 1 + len;
+            }
+            pending.erase(0, at);
+        }
+        framing_ok = framing_ok && pending.empty();
+        close(fd);
+    }
+
+    void stop()
+    {
+        thread.join();
+        close(listener);
+    }
+};
+
+static int connect_to(uint16_t port)
+{
+    const int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(connect(fd, (sockaddr *)&addr, sizeof(addr)) == 0);
+    // Without Nagle every send() leaves as its own segment, which is what
+    // the device sees on an idle connection.
+    const int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+static void send_all(int fd, const char *buf, size_t len)
+{
+    while (len > 0) {
+        const ssize_t w = send(fd, buf, len, 0);
+        assert(w > 0);
+        buf += w;
+        len -= (size_t)w;
+    }
+}
+
+// Forward the same log lines through the queue to a local sink, once with a
+// send per line (the former worker) and once batched the way the worker now
+// drains: up to 32 frames in one write of at most 1400 bytes.
+static double forward(bool batched, int lines, uint32_t *writes)
+{
+    alignas(4) static uint8_t storage[4096];
+    SyslogQueue queue;
+    queue.attach(storage, sizeof(storage));
+    Sink sink;
+    sink.start();
+    const int fd = connect_to(sink.port);
+
+    char batch[1400];
+    size_t batch_len = 0;
+    uint32_t batch_lines = 0;
+    *writes = 0;
+    auto flush = [&] {
+        if (batch_len == 0) return;
+        send_all(fd, batch, batch_len);
+        (*writes)++;
+        batch_len = 0;
+        batch_lines = 0;
+    };
+
+    auto t0 = std::chrono::steady_clock::now();
+    for (int i = 0; i < lines;) {
+        // A producer burst fills the queue, then the worker drains it.
+        char line[160];
+        for (int burst = 0; burst < 48 && i < lines; burst++, i++) {
+            const int n = snprintf(line, sizeof(line),
+                                   "\033[0;32mI (%d) raw_uart: frame %d from 0x%06X rssi -%d\033[0m\n",
+                                   i, i, 0x100000 + i, 40 + i % 50);
+            uint8_t entry[LOG_ENTRY_MAX];
+            const size_t len = log_entry_encode_text(entry, sizeof(entry), (uint32_t)i, line,
+                                                     (size_t)n);
+            assert(queue.push(entry, len));
+        }
+        uint8_t record[LOG_ENTRY_MAX];
+        size_t len;
+        while ((len = queue.pop(record, sizeof(record))) > 0) {
+            const Line fields = fields_of(record, len);
+            if (!batched) {
+                char frame[SYSLOG_FRAME_MAX];
+                const size_t n = syslog_format_frame(frame, sizeof(frame), fields.severity,
+                                                     fields.tag, fields.message,
+                                                     fields.message_len, "hb-rf-eth", "-", true);
+                send_all(fd, frame, n);
+                (*writes)++;
+                continue;
+            }
+            if (sizeof(batch) - batch_len < SYSLOG_FRAME_MAX) flush();
+            batch_len += syslog_format_frame(batch + batch_len, sizeof(batch) - batch_len,
+                                             fields.severity, fields.tag, fields.message,
+                                             fields.message_len, "hb-rf-eth", "-", true);
+            if (++batch_lines >= 32) flush();
+        }
+        flush();
+    }
+    shutdown(fd, SHUT_WR);
+    sink.stop();
+    close(fd);
+    auto t1 = std::chrono::steady_clock::now();
+
+    assert(sink.framing_ok);
+    assert(sink.frames.load() == (uint32_t)lines);
+    return lines / std::chrono::duration<double>(t1 - t0).count();
+}
+
+static void benchmark()
+{
+    constexpr int lines = 200000;
+    uint32_t single_writes = 0, batch_writes = 0;
+    const double single = forward(false, lines, &single_writes);
+    const double batched = forward(true, lines, &batch_writes);
+    assert(batch_writes * 10 < single_writes);
+    printf("syslog tcp: per line %.0f lines/s (%u writes), batched %.0f lines/s (%u writes), "
+           "%.1fx\n",
+           single, single_writes, batched, batch_writes, batched / single);
+}
+
+int main()
+{
+    test_queue_order_and_wrap();
+    test_queue_full_drops_exactly();
+    test_queue_concurrent();
+    test_entry_fields_and_frame();
+    test_structured_formats();
+    benchmark();
+    printf("syslog batch tests passed\n");
+    return 0;
+}
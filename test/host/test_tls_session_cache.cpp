@@ -0,0 +1,93 @@
+#include "tls_session_cache.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+static uint8_t *blob_of(const char *text)
+{
+    const size_t len = strlen(text);
+    uint8_t *blob = static_cast<uint8_t *>(malloc(len));
+    memcpy(blob, text, len);
+    return blob;
+}
+
+static std::string found(TlsSessionCache &cache, const char *host, uint16_t port, int64_t now)
+{
+    size_t len = 0;
+    const uint8_t *blob = cache.find(host, port, now, &len);
+    return blob ? std::string(reinterpret_cast<const char *>(blob), len) : std::string();
+}
+
+static void test_keyed_by_host_and_port()
+{
+    TlsSessionCache cache;
+    assert(found(cache, "logs.example.net", 6514, 0).empty());
+    assert(cache.adopt("logs.example.net", 6514, 0, blob_of("syslog"), 6));
+    assert(cache.adopt("mail.example.net", 465, 0, blob_of("smtp"), 4));
+
+    assert(found(cache, "logs.example.net", 6514, 1) == "syslog");
+    assert(found(cache, "mail.example.net", 465, 1) == "smtp");
+    // Never offered to another name or port: resumption skips verification.
+    assert(found(cache, "logs.example.net", 514, 1).empty());
+    assert(found(cache, "LOGS.example.net", 6514, 1).empty());
+    assert(found(cache, "mail.example.net.evil", 465, 1).empty());
+
+    // A newer session replaces the old one in place.
+    assert(cache.adopt("logs.example.net", 6514, 2, blob_of("syslog-2"), 8));
+    assert(found(cache, "logs.example.net", 6514, 3) == "syslog-2");
+    assert(cache.entries() == 2 && cache.bytes() == 12);
+
+    cache.forget("logs.example.net", 6514);
+    assert(found(cache, "logs.example.net", 6514, 4).empty());
+    assert(cache.entries() == 1);
+}
+
+static void test_rejects_what_it_cannot_keep()
+{
+    TlsSessionCache cache;
+    uint8_t *big = static_cast<uint8_t *>(calloc(TlsSessionCache::SESSION_MAX + 1, 1));
+    assert(!cache.adopt("a", 1, 0, big, TlsSessionCache::SESSION_MAX + 1));   // freed
+    const std::string long_host(TlsSessionCache::HOST_MAX, 'h');
+    assert(!cache.adopt(long_host.c_str(), 1, 0, blob_of("x"), 1));
+    assert(!cache.adopt(nullptr, 1, 0, blob_of("x"), 1));
+    assert(!cache.adopt("a", 1, 0, nullptr, 1));
+    assert(cache.entries() == 0);
+}
+
+static void test_expiry_and_eviction()
+{
+    TlsSessionCache cache;
+    assert(cache.adopt("a", 1, 0, blob_of("a"), 1));
+    assert(found(cache, "a", 1, TlsSessionCache::MAX_AGE_US) == "a");
+    assert(found(cache, "a", 1, TlsSessionCache::MAX_AGE_US + 1).empty());
+    assert(cache.entries() == 0);   // expired blobs are freed on lookup
+
+    // A full table gives up the session stored longest ago.
+    char host[8];
+    for (size_t i = 0; i < TlsSessionCache::SLOTS; i++) {
+        snprintf(host, sizeof(host), "h%zu", i);
+        assert(cache.adopt(host, 443, 100 + (int64_t)i, blob_of(host), strlen(host)));
+    }
+    assert(cache.adopt("h0", 443, 200, blob_of("h0-new"), 6));   // refresh h0
+    assert(cache.adopt("new", 443, 300, blob_of("new"), 3));
+    assert(cache.entries() == TlsSessionCache::SLOTS);
+    assert(found(cache, "h1", 443, 301).empty());
+    assert(found(cache, "h0", 443, 301) == "h0-new");
+    assert(found(cache, "new", 443, 301) == "new");
+
+    cache.clear();
+    assert(cache.entries() == 0 && cache.bytes() == 0);
+}
+
+int main()
+{
+    test_keyed_by_host_and_port();
+    test_rejects_what_it_cannot_keep();
+    test_expiry_and_eviction();
+    printf("tls session cache tests passed\n");
+    return 0;
+}
@@ -331,6 +331,29 @@ void test_ntp_invalid_too_long(void)
     TEST_ASSERT_FALSE(validateNtpServer(longServer));
 }
 
+// ==========================================
+// NTP Server Lists
+// ==========================================
+
+void test_ntp_valid_server_list(void)
+{
+    // Comma-separated lists, optionally with spaces after the separator
+    TEST_ASSERT_TRUE(validateNtpServer("0.de.pool.ntp.org,ptbtime1.ptb.de"));
+    TEST_ASSERT_TRUE(validateNtpServer("192.168.1.1, 192.168.1.2:123"));
+    TEST_ASSERT_TRUE(validateNtpServer("[2001:db8::1]:123,time.google.com"));
+    TEST_ASSERT_TRUE(validateNtpServer("a.example,b.example,c.example,d.example"));
+}
+
+void test_ntp_invalid_server_list(void)
+{
+    // Empty entries, invalid members and more than MAX_NTP_SERVERS entries
+    TEST_ASSERT_FALSE(validateNtpServer("pool.ntp.org,"));
+    TEST_ASSERT_FALSE(validateNtpServer(",pool.ntp.org"));
+    TEST_ASSERT_FALSE(validateNtpServer("pool.ntp.org,,time.google.com"));
+    TEST_ASSERT_FALSE(validateNtpServer("pool.ntp.org,-bad.example"));
+    TEST_ASSERT_FALSE(validateNtpServer("a.example,b.example,c.example,d.example,e.example"));
+}
+
 // ==========================================
 // Main test runner
 // ==========================================
@@ -394,6 +417,10 @@ void setup()
     // Invalid length tests
     RUN_TEST(test_ntp_invalid_too_long);
 
+    // Server lists
+    RUN_TEST(test_ntp_valid_server_list);
+    RUN_TEST(test_ntp_invalid_server_list);
+
     UNITY_END();
 }
 
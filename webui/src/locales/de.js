@@ -167,6 +167,7 @@ export default {
     dcf: 'DCF',
     gps: 'GPS',
     ntpServer: 'NTP Server',
+    ntpServerHint: 'Bis zu vier Server, durch Kommas getrennt. Ein einzelner Pool-Name wie pool.ntp.org wird auf vier Pool-Server erweitert.',
     dcfOffset: 'DCF Versatz',
     gpsBaudrate: 'GPS Baudrate',
 
@@ -450,6 +451,12 @@ export default {
       haDiscoveryEnabled: 'Home Assistant Discovery',
       haDiscoveryPrefix: 'Discovery Präfix',
       haDiscoveryPrefixHelp: 'Standard: homeassistant',
+      statusRefreshMinutes: 'Status-Auffrischung (Minuten)',
+      statusRefreshMinutesHelp: 'Status-Topics werden veröffentlicht, wenn sich ihr Wert ändert. Unveränderte Werte werden nach diesem Intervall erneut gesendet; 0 = jeder Wert jede Minute',
+      stateDocument: 'Status als ein JSON-Dokument',
+      stateDocumentHelp: 'Veröffentlicht alle Statuswerte als ein einziges Retained-JSON-Dokument unter …/state statt je eines Topics. Home-Assistant-Discovery folgt der Einstellung; das Online-Topic bleibt separat',
+      protocolV5: 'MQTT 5',
+      protocolV5Help: 'Verbindet per MQTT 5: Häufig gesendete Topics werden als kurze Topic-Aliase übertragen, Events verfallen nach 5 Minuten und Werte tragen ihre Einheit als User-Property. Erfordert einen MQTT-5-Broker (z. B. Mosquitto 2)',
       serverRequired: 'Bitte einen MQTT-Server angeben, wenn MQTT aktiviert ist.',
       commands: {
         title: 'Kommando-Topics',
@@ -520,7 +527,16 @@ export default {
       severityInfo: 'INFO',
       severityDebug: 'DEBUG',
       hostname: 'Hostname-Override',
-      hostnameHelp: 'Leer = Geräte-Hostname verwenden'
+      hostnameHelp: 'Leer = Geräte-Hostname verwenden',
+      format: 'Nachrichtenformat',
+      formatRfc5424: 'RFC 5424',
+      formatGelf: 'GELF',
+      formatJson: 'JSON Lines',
+      formatHelp: 'GELF und JSON Lines senden Schweregrad, Tag, Task, Kern und Laufzeit als eigene Felder für Graylog, Loki oder Elasticsearch',
+      rateLimit: 'Log-Ratenlimit (Zeilen/s pro Tag)',
+      rateLimitHelp: 'Gilt für alle Logs. Überzählige Zeilen eines flutenden Subsystems werden verworfen und als "N lines suppressed" zusammengefasst. 0 = aus',
+      rateBurst: 'Burst (Zeilen)',
+      rateBurstHelp: 'Zeilen, die ein Subsystem auf einmal loggen darf, bevor das Limit greift'
     },
     notify: {
       title: 'Ereignis-Benachrichtigungen',
@@ -530,6 +546,8 @@ export default {
       channelEmail: 'E-Mail',
       cooldown: 'Cooldown (Sekunden)',
       cooldownHelp: 'Pro Ereignistyp wird innerhalb dieses Fensters nur einmal benachrichtigt',
+      digest: 'Sammelfenster (Sekunden)',
+      digestHelp: 'Ereignisse innerhalb dieses Fensters werden gemeinsam als eine Benachrichtigung pro Kanal gesendet; 0 sendet jedes Ereignis sofort',
       eventsSection: 'Ereignisauswahl',
       eventsHelp: 'Nur die hier ausgewählten Ereignisse lösen eine Benachrichtigung aus. Die Testbenachrichtigung wird unabhängig davon immer gesendet.',
       eventsSelectAll: 'Alle auswählen',
@@ -546,6 +564,10 @@ export default {
       eventCcuConnected: 'CCU verbunden',
       eventCcuDisconnected: 'CCU getrennt',
       eventLowHeap: 'Wenig freier Speicher',
+      eventDutyCycle: 'Funk-Duty-Cycle wird knapp',
+      dutyCycleWarn: 'Duty-Cycle-Warnung (% des Budgets)',
+      dutyCycleAlarm: 'Duty-Cycle-Alarm (% des Budgets)',
+      dutyCycleHelp: 'Anteil des stündlichen Sendebudgets von 1 %, ab dem benachrichtigt wird, geschätzt aus den über das Funkmodul gesendeten Telegrammen. 0 deaktiviert die Schwelle.',
       webhookSection: 'Webhook',
       webhookUrl: 'URL',
       webhookSecret: 'Secret',
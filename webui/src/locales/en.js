@@ -167,6 +167,7 @@ export default {
     dcf: 'DCF',
     gps: 'GPS',
     ntpServer: 'NTP Server',
+    ntpServerHint: 'Up to four servers, separated by commas. A single pool name such as pool.ntp.org is expanded to four pool servers.',
     dcfOffset: 'DCF Offset',
     gpsBaudrate: 'GPS Baudrate',
 
@@ -449,6 +450,12 @@ export default {
       haDiscoveryEnabled: 'Home Assistant Discovery',
       haDiscoveryPrefix: 'Discovery Prefix',
       haDiscoveryPrefixHelp: 'Default: homeassistant',
+      statusRefreshMinutes: 'Status refresh (minutes)',
+      statusRefreshMinutesHelp: 'Status topics are published when their value changes. Unchanged values are republished after this interval; 0 = every value every minute',
+      stateDocument: 'State as one JSON document',
+      stateDocumentHelp: 'Publishes all status values as one retained JSON document on …/state instead of one topic each. Home Assistant discovery follows the setting; the online topic stays separate',
+      protocolV5: 'MQTT 5',
+      protocolV5Help: 'Connects with MQTT 5: frequently published topics are sent as short topic aliases, events expire after 5 minutes and values carry their unit as a user property. Requires an MQTT 5 broker (e.g. Mosquitto 2)',
       serverRequired: 'Please enter an MQTT server address when MQTT is enabled.',
       commands: {
         title: 'Command Topics',
@@ -519,7 +526,16 @@ export default {
       severityInfo: 'INFO',
       severityDebug: 'DEBUG',
       hostname: 'Hostname Override',
-      hostnameHelp: 'Empty = use device hostname'
+      hostnameHelp: 'Empty = use device hostname',
+      format: 'Message format',
+      formatRfc5424: 'RFC 5424',
+      formatGelf: 'GELF',
+      formatJson: 'JSON lines',
+      formatHelp: 'GELF and JSON lines send severity, tag, task, core and uptime as separate fields for Graylog, Loki or Elasticsearch',
+      rateLimit: 'Log rate limit (lines/s per tag)',
+      rateLimitHelp: 'Applies to all logs. Excess lines from a flooding subsystem are dropped and summarised as "N lines suppressed". 0 = off',
+      rateBurst: 'Burst (lines)',
+      rateBurstHelp: 'Lines a subsystem may log at once before the limit applies'
     },
     notify: {
       title: 'Event Notifications',
@@ -529,6 +545,8 @@ export default {
       channelEmail: 'Email',
       cooldown: 'Cooldown (seconds)',
       cooldownHelp: 'Per event type, at most one notification is sent within this window',
+      digest: 'Digest window (seconds)',
+      digestHelp: 'Events within this window are sent together as one notification per channel; 0 sends every event at once',
       eventsSection: 'Event selection',
       eventsHelp: 'Only the events selected here trigger a notification. The test notification is always sent regardless.',
       eventsSelectAll: 'Select all',
@@ -545,6 +563,10 @@ export default {
       eventCcuConnected: 'CCU connected',
       eventCcuDisconnected: 'CCU disconnected',
       eventLowHeap: 'Low free memory',
+      eventDutyCycle: 'Radio duty cycle running low',
+      dutyCycleWarn: 'Duty cycle warning (% of budget)',
+      dutyCycleAlarm: 'Duty cycle alarm (% of budget)',
+      dutyCycleHelp: 'Share of the hourly 1 % transmit budget after which a notification is sent, estimated from the telegrams sent through the radio module. 0 disables the threshold.',
       webhookSection: 'Webhook',
       webhookUrl: 'URL',
       webhookSecret: 'Secret',
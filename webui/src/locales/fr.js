@@ -167,6 +167,7 @@ export default {
     dcf: 'DCF',
     gps: 'GPS',
     ntpServer: 'Serveur NTP',
+    ntpServerHint: 'Jusqu\'à quatre serveurs, séparés par des virgules. Un nom de pool unique comme pool.ntp.org est étendu à quatre serveurs du pool.',
     dcfOffset: 'Décalage DCF',
     gpsBaudrate: 'Débit GPS',
 
@@ -450,6 +451,12 @@ export default {
       haDiscoveryEnabled: 'Découverte Home Assistant',
       haDiscoveryPrefix: 'Préfixe de découverte',
       haDiscoveryPrefixHelp: 'Par défaut : homeassistant',
+      statusRefreshMinutes: 'Rafraîchissement de l\'état (minutes)',
+      statusRefreshMinutesHelp: 'Les topics d\'état sont publiés lorsque leur valeur change. Les valeurs inchangées sont republiées après cet intervalle ; 0 = chaque valeur chaque minute',
+      stateDocument: 'État en un seul document JSON',
+      stateDocumentHelp: 'Publie toutes les valeurs d\'état dans un seul document JSON retenu sur …/state au lieu d\'un topic chacune. La découverte Home Assistant suit ce réglage ; le topic online reste séparé',
+      protocolV5: 'MQTT 5',
+      protocolV5Help: 'Se connecte en MQTT 5 : les topics publiés souvent sont envoyés sous forme d\'alias courts, les événements expirent après 5 minutes et les valeurs portent leur unité en user property. Nécessite un broker MQTT 5 (p. ex. Mosquitto 2)',
       commands: {
         title: 'Topics de commande',
         enableHelp: 'Permet de redémarrer l’appareil via MQTT. La réinitialisation d’usine et l’OTA ne sont volontairement pas disponibles comme commandes MQTT.',
@@ -520,7 +527,16 @@ export default {
       severityInfo: 'INFO',
       severityDebug: 'DEBUG',
       hostname: 'Remplacement du nom d\'hôte',
-      hostnameHelp: 'Vide = utiliser le nom d\'hôte de l\'appareil'
+      hostnameHelp: 'Vide = utiliser le nom d\'hôte de l\'appareil',
+      format: 'Format des messages',
+      formatRfc5424: 'RFC 5424',
+      formatGelf: 'GELF',
+      formatJson: 'JSON Lines',
+      formatHelp: 'GELF et JSON Lines envoient gravité, tag, tâche, cœur et temps de fonctionnement comme champs séparés pour Graylog, Loki ou Elasticsearch',
+      rateLimit: 'Limite de débit des logs (lignes/s par tag)',
+      rateLimitHelp: 'S\'applique à tous les logs. Les lignes excédentaires d\'un sous-système trop bavard sont ignorées et résumées par "N lines suppressed". 0 = désactivé',
+      rateBurst: 'Rafale (lignes)',
+      rateBurstHelp: 'Lignes qu\'un sous-système peut journaliser d\'un coup avant que la limite s\'applique'
     },
     notify: {
       title: 'Notifications d\'événements',
@@ -530,6 +546,8 @@ export default {
       channelEmail: 'E-mail',
       cooldown: 'Intervalle (secondes)',
       cooldownHelp: 'Pour chaque type d\'événement, une seule notification est envoyée pendant cette fenêtre',
+      digest: 'Fenêtre de regroupement (secondes)',
+      digestHelp: 'Les événements de cette fenêtre sont envoyés ensemble, en une notification par canal ; 0 envoie chaque événement immédiatement',
       eventsSection: 'Sélection des événements',
       eventsHelp: 'Seuls les événements sélectionnés ici déclenchent une notification. La notification de test est toujours envoyée.',
       eventsSelectAll: 'Tout sélectionner',
@@ -546,6 +564,10 @@ export default {
       eventCcuConnected: 'CCU connectée',
       eventCcuDisconnected: 'CCU déconnectée',
       eventLowHeap: 'Mémoire libre faible',
+      eventDutyCycle: 'Duty cycle radio presque épuisé',
+      dutyCycleWarn: 'Avertissement duty cycle (% du budget)',
+      dutyCycleAlarm: 'Alarme duty cycle (% du budget)',
+      dutyCycleHelp: 'Part du budget d\'émission horaire de 1 % à partir de laquelle une notification est envoyée, estimée à partir des télégrammes émis par le module radio. 0 désactive le seuil.',
       webhookSection: 'Webhook',
       webhookUrl: 'URL',
       webhookSecret: 'Secret',
@@ -167,6 +167,7 @@ export default {
     dcf: 'DCF',
     gps: 'GPS',
     ntpServer: 'Server NTP',
+    ntpServerHint: 'Fino a quattro server, separati da virgole. Un singolo nome di pool come pool.ntp.org viene esteso a quattro server del pool.',
     dcfOffset: 'Offset DCF',
     gpsBaudrate: 'Baudrate GPS',
 
@@ -450,6 +451,12 @@ webuiUpdate: {
       haDiscoveryEnabled: 'Home Assistant Discovery',
       haDiscoveryPrefix: 'Prefisso Discovery',
       haDiscoveryPrefixHelp: 'Predefinito: homeassistant',
+      statusRefreshMinutes: 'Aggiornamento stato (minuti)',
+      statusRefreshMinutesHelp: 'I topic di stato vengono pubblicati quando il loro valore cambia. I valori invariati vengono ripubblicati dopo questo intervallo; 0 = ogni valore ogni minuto',
+      stateDocument: 'Stato come unico documento JSON',
+      stateDocumentHelp: 'Pubblica tutti i valori di stato come un unico documento JSON retained su …/state invece di un topic ciascuno. La discovery di Home Assistant segue l\'impostazione; il topic online resta separato',
+      protocolV5: 'MQTT 5',
+      protocolV5Help: 'Si connette con MQTT 5: i topic pubblicati spesso vengono inviati come alias brevi, gli eventi scadono dopo 5 minuti e i valori riportano la loro unità come user property. Richiede un broker MQTT 5 (ad es. Mosquitto 2)',
       commands: {
         title: 'Topic dei comandi',
         enableHelp: 'Consente il riavvio del dispositivo tramite MQTT. Il ripristino di fabbrica e OTA non sono disponibili come comandi MQTT.',
@@ -520,7 +527,16 @@ webuiUpdate: {
       severityInfo: 'INFO',
       severityDebug: 'DEBUG',
       hostname: 'Override hostname',
-      hostnameHelp: 'Vuoto = usa l\'hostname del dispositivo'
+      hostnameHelp: 'Vuoto = usa l\'hostname del dispositivo',
+      format: 'Formato dei messaggi',
+      formatRfc5424: 'RFC 5424',
+      formatGelf: 'GELF',
+      formatJson: 'JSON Lines',
+      formatHelp: 'GELF e JSON Lines inviano gravità, tag, task, core e uptime come campi separati per Graylog, Loki o Elasticsearch',
+      rateLimit: 'Limite di frequenza log (righe/s per tag)',
+      rateLimitHelp: 'Vale per tutti i log. Le righe in eccesso di un sottosistema che inonda il log vengono scartate e riassunte come "N lines suppressed". 0 = disattivato',
+      rateBurst: 'Burst (righe)',
+      rateBurstHelp: 'Righe che un sottosistema può registrare in una volta prima che il limite intervenga'
     },
     notify: {
       title: 'Notifiche degli eventi',
@@ -530,6 +546,8 @@ webuiUpdate: {
       channelEmail: 'E-mail',
       cooldown: 'Intervallo (secondi)',
       cooldownHelp: 'Per ogni tipo di evento viene inviata una sola notifica durante questa finestra',
+      digest: 'Finestra di raggruppamento (secondi)',
+      digestHelp: 'Gli eventi in questa finestra vengono inviati insieme in una notifica per canale; 0 invia ogni evento subito',
       eventsSection: 'Selezione degli eventi',
       eventsHelp: 'Solo gli eventi selezionati qui attivano una notifica. La notifica di test viene sempre inviata.',
       eventsSelectAll: 'Seleziona tutto',
@@ -546,6 +564,10 @@ webuiUpdate: {
       eventCcuConnected: 'CCU connessa',
       eventCcuDisconnected: 'CCU disconnessa',
       eventLowHeap: 'Memoria libera insufficiente',
+      eventDutyCycle: 'Duty cycle radio quasi esaurito',
+      dutyCycleWarn: 'Avviso duty cycle (% del budget)',
+      dutyCycleAlarm: 'Allarme duty cycle (% del budget)',
+      dutyCycleHelp: 'Quota del budget di trasmissione orario dell\'1 % oltre la quale viene inviata una notifica, stimata dai telegrammi inviati tramite il modulo radio. 0 disattiva la soglia.',
       webhookSection: 'Webhook',
       webhookUrl: 'URL',
       webhookSecret: 'Secret',
@@ -539,7 +539,14 @@ export const useMonitoringStore = defineStore('monitoring', {
       // Phase A: command-topic security
       commandEnabled: true,
       commandToken: '',
-      commandTokenSet: false
+      commandTokenSet: false,
+      // Unchanged retained status values are republished after this many
+      // minutes; 0 publishes every topic on every cycle.
+      statusRefreshMinutes: 15,
+      // Publish the status as one JSON document on <prefix>/state
+      stateDocument: false,
+      // Connect with MQTT 5 (topic aliases, event expiry, unit properties)
+      protocolV5: false
     },
     prometheus: {
       enabled: false,
@@ -552,7 +559,13 @@ export const useMonitoringStore = defineStore('monitoring', {
       port: 514,
       transport: 0,
       minSeverity: 6,
-      hostname: ''
+      hostname: '',
+      // 0 = RFC 5424, 1 = GELF, 2 = JSON lines
+      format: 0,
+      // Per-tag log rate limit; applies to all captured logs, not only to
+      // forwarding. 0 lines per second switches it off.
+      rateLimit: 20,
+      rateBurst: 50
     },
     notify: {
       enabled: false,
@@ -576,8 +589,13 @@ export const useMonitoringStore = defineStore('monitoring', {
       // everything so a firmware that predates the field keeps behaving as
       // it did. `eventMaskSupported` tells the UI which bits this firmware
       // actually knows, so the checkbox list follows the device.
-      eventMask: 0x07FF,
-      eventMaskSupported: 0x07FF
+      eventMask: 0x0FFF,
+      eventMaskSupported: 0x0FFF,
+      // Percent of the hourly 1 % transmit budget; 0 disables the threshold.
+      dutyCycleWarn: 50,
+      dutyCycleAlarm: 80,
+      // Seconds to collect events into one notification; 0 sends each at once.
+      digestSeconds: 0
     },
     diagnostics: {
       checkmk: null,
@@ -615,12 +633,27 @@ export const useMonitoringStore = defineStore('monitoring', {
         this.prometheus.port = validPort(this.prometheus.port, 9100)
         this.syslog.port = validPort(this.syslog.port, 514)
         this.notify.smtpPort = validPort(this.notify.smtpPort, 587)
+        const statusRefresh = Number(this.mqtt.statusRefreshMinutes)
+        if (!Number.isInteger(statusRefresh) || statusRefresh < 0 || statusRefresh > 1440) {
+          this.mqtt.statusRefreshMinutes = 15
+        }
         if (![0, 1, 2].includes(Number(this.syslog.transport))) this.syslog.transport = 0
+        if (![0, 1, 2].includes(Number(this.syslog.format))) this.syslog.format = 0
         if (!Number.isInteger(Number(this.syslog.minSeverity)) ||
             Number(this.syslog.minSeverity) < 0 ||
             Number(this.syslog.minSeverity) > 7) {
           this.syslog.minSeverity = 6
         }
+        const rateLimit = Number(this.syslog.rateLimit)
+        if (!Number.isInteger(rateLimit) || rateLimit < 0 || rateLimit > 1000) this.syslog.rateLimit = 20
+        const rateBurst = Number(this.syslog.rateBurst)
+        if (!Number.isInteger(rateBurst) || rateBurst < 1 || rateBurst > 1000) this.syslog.rateBurst = 50
+        const dutyWarn = Number(this.notify.dutyCycleWarn)
+        if (!Number.isInteger(dutyWarn) || dutyWarn < 0 || dutyWarn > 100) this.notify.dutyCycleWarn = 50
+        const dutyAlarm = Number(this.notify.dutyCycleAlarm)
+        if (!Number.isInteger(dutyAlarm) || dutyAlarm < 0 || dutyAlarm > 100) this.notify.dutyCycleAlarm = 80
+        const digest = Number(this.notify.digestSeconds)
+        if (!Number.isInteger(digest) || digest < 0 || digest > 3600) this.notify.digestSeconds = 0
         if (![0, 1, 2].includes(Number(this.notify.smtpTls))) this.notify.smtpTls = 1
 
         // Firmware without the event selection reports neither field. Treat
@@ -630,7 +663,7 @@ export const useMonitoringStore = defineStore('monitoring', {
         const mask = Number(this.notify.eventMask)
         const supported = Number(this.notify.eventMaskSupported)
         this.notify.eventMaskSupported =
-          Number.isInteger(supported) && supported > 0 ? supported : 0x07FF
+          Number.isInteger(supported) && supported > 0 ? supported : 0x0FFF
         this.notify.eventMask =
           Number.isInteger(mask) && mask >= 0
             ? mask & this.notify.eventMaskSupported
@@ -160,10 +160,13 @@ test('monitoring repairs an empty-NVS CheckMK port before MQTT is saved', async
           haDiscoveryPrefix: 'homeassistant',
           tlsEnable: false,
           tlsSkipVerify: false,
-          commandEnabled: true
+          commandEnabled: true,
+          statusRefreshMinutes: 15,
+          stateDocument: false,
+          protocolV5: false
         },
         prometheus: { enabled: false, port: 9100, allowedHosts: '*' },
-        syslog: { enabled: false, server: '', port: 514, transport: 0, minSeverity: 6, hostname: '' },
+        syslog: { enabled: false, server: '', port: 514, transport: 0, minSeverity: 6, hostname: '', format: 0, rateLimit: 20, rateBurst: 50 },
         notify: { enabled: false, channels: 0, smtpPort: 587, smtpTls: 1, cooldownSeconds: 300 }
       })
     })